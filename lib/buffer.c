@@ -39,6 +39,10 @@ struct buffer
   
   /* Size of each buffer_data chunk. */
   size_t size;
+
+  /* Flushed chunks kept for reuse. */
+  struct buffer_data *free;
+  unsigned int nfree;
 };
 
 /* Data container. */
@@ -63,8 +67,26 @@ struct buffer_data
 #define BUFFER_SIZE_DEFAULT		4096
 
 
+/* Number of flushed chunks a buffer keeps for reuse. */
+#define BUFFER_FREE_MAX			16
+
 #define BUFFER_DATA_FREE(D) XFREE(MTYPE_BUFFER_DATA, (D))
 
+/* Return a chunk to the buffer's free list, or to the allocator if the
+   list is full. */
+static void
+buffer_data_recycle (struct buffer *b, struct buffer_data *d)
+{
+  if (b->nfree >= BUFFER_FREE_MAX)
+    {
+      BUFFER_DATA_FREE(d);
+      return;
+    }
+  d->next = b->free;
+  b->free = d;
+  b->nfree++;
+}
+
 /* Make new buffer. */
 struct buffer *
 buffer_new (size_t size)
@@ -93,7 +115,14 @@ buffer_new (size_t size)
 void
 buffer_free (struct buffer *b)
 {
+  struct buffer_data *data;
+
   buffer_reset(b);
+  while ((data = b->free) != NULL)
+    {
+      b->free = data->next;
+      BUFFER_DATA_FREE(data);
+    }
   XFREE (MTYPE_BUFFER, b);
 }
 
@@ -137,7 +166,7 @@ buffer_reset (struct buffer *b)
   for (data = b->head; data; data = next)
     {
       next = data->next;
-      BUFFER_DATA_FREE(data);
+      buffer_data_recycle (b, data);
     }
   b->head = b->tail = NULL;
 }
@@ -148,7 +177,13 @@ buffer_add (struct buffer *b)
 {
   struct buffer_data *d;
 
-  d = XMALLOC(MTYPE_BUFFER_DATA, offsetof(struct buffer_data, data[b->size]));
+  if ((d = b->free) != NULL)
+    {
+      b->free = d->next;
+      b->nfree--;
+    }
+  else
+    d = XMALLOC(MTYPE_BUFFER_DATA, offsetof(struct buffer_data, data[b->size]));
   d->cp = d->sp = 0;
   d->next = NULL;
 
@@ -199,6 +234,52 @@ buffer_putstr (struct buffer *b, const char *c)
   buffer_put(b, c, strlen(c));
 }
 
+/* Format straight into the free space of the tail chunk.  If the text
+   does not fit, it is formatted again into a fresh chunk; only text
+   longer than a whole chunk goes through a temporary copy. */
+int
+buffer_vprintf (struct buffer *b, const char *format, va_list args)
+{
+  struct buffer_data *data = b->tail;
+  va_list ap;
+  char *p;
+  int len;
+
+  if (data == NULL || data->cp == b->size)
+    data = buffer_add (b);
+
+  va_copy (ap, args);
+  len = vsnprintf ((char *)(data->data + data->cp), b->size - data->cp,
+		   format, ap);
+  va_end (ap);
+  if (len < 0)
+    return len;
+
+  if ((size_t) len < b->size - data->cp)
+    {
+      data->cp += len;
+      return len;
+    }
+
+  if ((size_t) len < b->size)
+    {
+      data = buffer_add (b);
+      va_copy (ap, args);
+      vsnprintf ((char *)data->data, b->size, format, ap);
+      va_end (ap);
+      data->cp = len;
+      return len;
+    }
+
+  p = XMALLOC (MTYPE_TMP, len + 1);
+  va_copy (ap, args);
+  vsnprintf (p, len + 1, format, ap);
+  va_end (ap);
+  buffer_put (b, p, len);
+  XFREE (MTYPE_TMP, p);
+  return len;
+}
+
 /* Keep flushing data to the fd until the buffer is empty or an error is
    encountered or the operation would block. */
 buffer_status_t
@@ -374,7 +455,7 @@ buffer_flush_window (struct buffer *b, int fd, int width, int height,
       struct buffer_data *del;
       if (!(b->head = (del = b->head)->next))
         b->tail = NULL;
-      BUFFER_DATA_FREE(del);
+      buffer_data_recycle (b, del);
     }
 
   if (iov != small_iov)
@@ -393,15 +474,14 @@ buffer_status_t
 buffer_flush_available(struct buffer *b, int fd)
 {
 
-/* These are just reasonable values to make sure a significant amount of
-data is written.  There's no need to go crazy and try to write it all
-in one shot. */
+/* Large enough that a multi-megabyte show output is written with a
+handful of writev calls, small enough to keep the iovec on the stack. */
 #ifdef IOV_MAX
-#define MAX_CHUNKS ((IOV_MAX >= 16) ? 16 : IOV_MAX)
+#define MAX_CHUNKS ((IOV_MAX >= 256) ? 256 : IOV_MAX)
 #else
-#define MAX_CHUNKS 16
+#define MAX_CHUNKS 256
 #endif
-#define MAX_FLUSH 131072
+#define MAX_FLUSH 1048576
 
   struct buffer_data *d;
   size_t written;
@@ -450,7 +530,7 @@ in one shot. */
       written -= (d->cp-d->sp);
       if (!(b->head = d->next))
         b->tail = NULL;
-      BUFFER_DATA_FREE(d);
+      buffer_data_recycle (b, d);
     }
 
   return b->head ? BUFFER_PENDING : BUFFER_EMPTY;
@@ -42,6 +42,9 @@ extern void buffer_put (struct buffer *, const void *, size_t);
 extern void buffer_putc (struct buffer *, u_char);
 /* Add a NUL-terminated string to the end of the buffer. */
 extern void buffer_putstr (struct buffer *, const char *);
+/* Format text directly into the end of the buffer.  Returns the length
+   of the text added, or a negative value on a formatting error. */
+extern int buffer_vprintf (struct buffer *, const char *, va_list);
 
 /* Combine all accumulated (and unflushed) data inside the buffer into a
    single NUL-terminated string allocated using XMALLOC(MTYPE_TMP).  Note
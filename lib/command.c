@@ -33,6 +33,7 @@ Boston, MA 02111-1307, USA.  */
 #include "vty.h"
 #include "command.h"
 #include "workqueue.h"
+#include "prefix.h"
 #ifdef ENABLE_OVSDB
 #include "lib_vtysh_ovsdb_if.h"
 #include "vty_utils.h"
@@ -51,6 +52,11 @@ vector cmdvec = NULL;
 struct cmd_token token_cr;
 char *command_cr = NULL;
 
+vector cmd_stats_vec = NULL;
+
+/* Statistics of the command being executed, for cmd_stats_commit() */
+static struct cmd_stats *cmd_stats_running;
+
 enum filter_type
 {
   FILTER_RELAXED,
@@ -429,7 +435,7 @@ format_parser_begin_keyword(struct format_parser_state *state)
   state->cp++;
   state->in_keyword = 1;
 
-  token = XCALLOC(MTYPE_CMD_TOKENS, sizeof(*token));
+  token = XCALLOC(MTYPE_CMD_TOKEN, sizeof(*token));
   token->type = TOKEN_KEYWORD;
   token->keyword = vector_init(VECTOR_MIN_SIZE);
 
@@ -455,7 +461,7 @@ format_parser_begin_multiple(struct format_parser_state *state)
   state->in_multiple = 1;
   state->just_read_word = 0;
 
-  token = XCALLOC(MTYPE_CMD_TOKENS, sizeof(*token));
+  token = XCALLOC(MTYPE_CMD_TOKEN, sizeof(*token));
   token->type = TOKEN_MULTIPLE;
   token->multiple = vector_init(VECTOR_MIN_SIZE);
 
@@ -562,7 +568,7 @@ format_parser_read_word(struct format_parser_state *state)
   memcpy(cmd, start, len);
   cmd[len] = '\0';
 
-  token = XCALLOC(MTYPE_CMD_TOKENS, sizeof(*token));
+  token = XCALLOC(MTYPE_CMD_TOKEN, sizeof(*token));
   token->type = TOKEN_TERMINAL;
   token->cmd = cmd;
   token->desc = format_parser_desc_str(state);
@@ -576,7 +582,10 @@ format_parser_read_word(struct format_parser_state *state)
       for (i = 0; i < (sizeof(dyn_cb_lookup)/sizeof(dyn_cb_lookup[0])); i++)
       {
         if(!strcmp(dyn_cb_lookup[i].funcname, token->dyn_cb))
+        {
           token->dyn_cb_func = dyn_cb_lookup[i].funcptr;
+          token->dyn_cb_per_index = dyn_cb_lookup[i].per_index;
+        }
       }
     }
   }
@@ -688,6 +697,27 @@ install_element (enum node_type ntype, struct cmd_element *cmd)
 #endif
 }
 
+/* Attach token trees that were parsed at build time, so that
+   install_element() need not parse the format strings of these commands.
+   An entry whose command string has changed since is left alone. */
+void
+cmd_tree_load (const struct cmd_tree_entry *image, unsigned int n)
+{
+  unsigned int i;
+  struct cmd_element *cmd;
+
+  for (i = 0; i < n; i++)
+    {
+      cmd = image[i].cmd;
+      if (cmd->tokens == NULL && cmd->string
+          && strcmp (cmd->string, image[i].string) == 0)
+        {
+          cmd->tokens = image[i].tokens;
+          cmd->precompiled = 1;
+        }
+    }
+}
+
 static const unsigned char itoa64[] =
 "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
 
@@ -949,10 +979,16 @@ cmd_ipv4_prefix_match (const char *str)
   const char *sp;
   int dots = 0;
   char buf[4];
+  struct prefix_ipv4 p;
 
   if (str == NULL)
     return partly_match;
 
+  /* Complete prefixes are the common case; the walk below is only
+     needed to tell partial input from garbage. */
+  if (str2prefix_ipv4_strict (str, &p) && strchr (str, '/'))
+    return exact_match;
+
   for (;;)
     {
       memset (buf, 0, sizeof (buf));
@@ -1066,10 +1102,14 @@ cmd_ipv6_prefix_match (const char *str)
   int mask;
   const char *sp = NULL;
   char *endptr = NULL;
+  struct prefix_ipv6 p;
 
   if (str == NULL)
     return partly_match;
 
+  if (str2prefix_ipv6_strict (str, &p) && strchr (str, '/'))
+    return exact_match;
+
   if (strspn (str, IPV6_PREFIX_STR) != strlen (str))
     return no_match;
 
@@ -2370,6 +2410,34 @@ cmd_describe_sort(vector matchvec)
         sizeof(void*), cmd_describe_cmp);
 }
 
+/* Whether token->desc already holds the dynamic help string of TOKEN for
+   the current IDL seqno and, when it depends on it, vty->index.  If not,
+   records them for the help string the caller is about to compute. */
+static int
+cmd_dyn_helpstr_memoized (struct cmd_token *token, struct vty *vty)
+{
+#ifdef ENABLE_OVSDB
+  const char *index = token->dyn_cb_per_index ? vty->index : NULL;
+  unsigned int seqno;
+
+  if (lib_vtysh_ovsdb_seqno == NULL)
+    return 0;
+
+  seqno = (*lib_vtysh_ovsdb_seqno) ();
+  if (token->dyn_memo_valid && token->dyn_memo_seqno == seqno
+      && (index == NULL
+	  || (token->dyn_memo_index && !strcmp (token->dyn_memo_index, index))))
+    return 1;
+
+  token->dyn_memo_valid = 1;
+  token->dyn_memo_seqno = seqno;
+  XFREE (MTYPE_CMD_TOKENS, token->dyn_memo_index);
+  if (index)
+    token->dyn_memo_index = XSTRDUP (MTYPE_CMD_TOKENS, index);
+#endif /* ENABLE_OVSDB */
+  return 0;
+}
+
 /* '?' describe command support. */
 static vector
 cmd_describe_command_real (vector vline, struct vty *vty, int *status)
@@ -2505,7 +2573,8 @@ cmd_describe_command_real (vector vline, struct vty *vty, int *status)
 
               string = cmd_entry_function_desc(command, token->cmd);
 
-              if (token->dyn_cb != NULL)
+              if (token->dyn_cb_func != NULL
+                  && !cmd_dyn_helpstr_memoized(token, vty))
               {
                 memset(dyn_helpstr, '\0', MAX_DYN_HELPSTR_LEN);
                 token->dyn_cb_func(token, vty, dyn_helpstr, MAX_DYN_HELPSTR_LEN);
@@ -2634,6 +2703,54 @@ cmd_complete_sort(vector matchvec)
         sizeof(void*), cmd_complete_cmp);
 }
 
+#ifdef ENABLE_OVSDB
+/* Appends the names lib_vtysh_ovsdb_complete() offers for the variable
+   token VARNAME at the last word of VLINE, and returns how many. */
+static unsigned int
+cmd_complete_variable (vector matchvec, vector vline, unsigned int index,
+		       const char *varname)
+{
+  const char * const *names;
+  const char *keyword = index > 0 ? vector_slot (vline, index - 1) : NULL;
+  const char *prefix = vector_slot (vline, index);
+  unsigned int i, n;
+
+  if (lib_vtysh_ovsdb_complete == NULL)
+    return 0;
+
+  n = (*lib_vtysh_ovsdb_complete) (keyword, varname, prefix ? prefix : "",
+				   &names);
+  /* There may be thousands of names, so append them past the last
+     active slot instead of searching for an empty one. */
+  for (i = 0; i < n; i++)
+    vector_set_index (matchvec, vector_active (matchvec),
+		      XSTRDUP (MTYPE_TMP, names[i]));
+  return n;
+}
+#endif /* ENABLE_OVSDB */
+
+/* Sort MATCHVEC and drop its duplicate strings. */
+static void
+cmd_complete_uniq (vector matchvec)
+{
+  unsigned int i, n = 0;
+  char *string;
+
+  cmd_complete_sort (matchvec);
+  for (i = 0; i < vector_active (matchvec); i++)
+    {
+      if ((string = vector_slot (matchvec, i)) == NULL)
+	break;
+      if (n > 0 && strcmp (vector_slot (matchvec, n - 1), string) == 0)
+	XFREE (MTYPE_TMP, string);
+      else
+	vector_slot (matchvec, n++) = string;
+    }
+  for (i = n; i < vector_active (matchvec); i++)
+    vector_slot (matchvec, i) = NULL;
+  matchvec->active = n;
+}
+
 /* Command line completion support. */
 static char **
 cmd_complete_command_real (vector vline, struct vty *vty, int *status)
@@ -2649,6 +2766,7 @@ cmd_complete_command_real (vector vline, struct vty *vty, int *status)
   int lcd;
   vector matches = NULL;
   vector match_vector;
+  unsigned int variables = 0;
 
   if (vector_active (vline) == 0)
     {
@@ -2725,11 +2843,24 @@ cmd_complete_command_real (vector vline, struct vty *vty, int *status)
 		  if ((string =
 		       cmd_entry_function (vector_slot (vline, index),
 					   token->cmd)))
-		    if (cmd_unique_string (matchvec, string))
-		      vector_set (matchvec, XSTRDUP (MTYPE_TMP, string));
+		    {
+		      if (cmd_unique_string (matchvec, string))
+			vector_set (matchvec, XSTRDUP (MTYPE_TMP, string));
+		    }
+#ifdef ENABLE_OVSDB
+		  /* Offer the names of existing objects for variables. */
+		  else if (token->cmd)
+		    variables += cmd_complete_variable (matchvec, vline, index,
+							token->cmd);
+#endif /* ENABLE_OVSDB */
 		}
       }
 
+  /* Names offered for more than one token, or equal to a keyword,
+     were not checked with cmd_unique_string(). */
+  if (variables)
+    cmd_complete_uniq (matchvec);
+
   /* We don't need cmd_vector any more. */
   vector_free (cmd_vector);
   cmd_matches_free(&matches);
@@ -2866,6 +2997,135 @@ node_parent ( enum node_type node )
   return ret;
 }
 
+/* Returns the statistics of 'cmd', allocating them on its first run.
+ * cmd_stats_vec is walked by the OVSDB thread, so the caller holds the
+ * OVSDB lock. */
+static struct cmd_stats *
+cmd_stats_get (struct cmd_element *cmd)
+{
+  if (cmd->stats == NULL)
+    {
+      cmd->stats = XCALLOC (MTYPE_CMD_STATS, sizeof (struct cmd_stats));
+      cmd->stats->cmd = cmd;
+      if (cmd_stats_vec == NULL)
+        cmd_stats_vec = vector_init (VECTOR_MIN_SIZE);
+      vector_set (cmd_stats_vec, cmd->stats);
+    }
+  return cmd->stats;
+}
+
+/* Frees the statistics of 'cmd', which is being uninstalled.  If 'cmd'
+ * is running, which it is when it uninstalls itself, cmd_execute_matched()
+ * frees them once it returns. */
+static void
+cmd_stats_free (struct cmd_element *cmd)
+{
+  unsigned int i;
+
+  if (cmd->stats == NULL)
+    return;
+
+  for (i = 0; i < vector_active (cmd_stats_vec); i++)
+    if (vector_slot (cmd_stats_vec, i) == cmd->stats)
+      {
+        vector_unset (cmd_stats_vec, i);
+        break;
+      }
+  if (cmd->stats->running)
+    cmd->stats->cmd = NULL;
+  else
+    XFREE (MTYPE_CMD_STATS, cmd->stats);
+  cmd->stats = NULL;
+}
+
+/* Accounts the time the running command spent committing a transaction */
+void
+cmd_stats_commit (unsigned long usec)
+{
+  if (cmd_stats_running)
+    usec_histogram_add (&cmd_stats_running->commit, usec);
+}
+
+void
+cmd_stats_clear (void)
+{
+  unsigned int i;
+  struct cmd_stats *stats;
+  struct cmd_element *cmd;
+  unsigned int running;
+
+  if (cmd_stats_vec == NULL)
+    return;
+
+  for (i = 0; i < vector_active (cmd_stats_vec); i++)
+    if ((stats = vector_slot (cmd_stats_vec, i)) != NULL)
+      {
+        cmd = stats->cmd;
+        running = stats->running;
+        memset (stats, 0, sizeof (struct cmd_stats));
+        stats->cmd = cmd;
+        stats->running = running;
+      }
+}
+
+/* Runs the matched command, which was parsed from 'start' to 'matched'.
+ * With the OVSDB lock taken, the statistics are also updated under it. */
+static int
+cmd_execute_matched (struct cmd_element *matched_element, struct vty *vty,
+                     int argc, const char *argv[], struct timeval start,
+                     struct timeval matched)
+{
+  struct cmd_stats *stats;
+  struct cmd_stats *outer = cmd_stats_running;
+  unsigned long long output_bytes = vty_out_bytes;
+  int locked = ((matched_element->attr) & CMD_ATTR_NOLOCK) == 0;
+  struct timeval running, end;
+  int ret;
+
+  if (locked)
+  {
+    VTYSH_OVSDB_LOCK;
+    quagga_gettime (QUAGGA_CLK_MONOTONIC, &running);
+    stats = cmd_stats_get (matched_element);
+    usec_histogram_add (&stats->lock_wait, timeval_elapsed (running, matched));
+    VLOG_DBG("Setting the latch");
+    latch_set(&ovsdb_latch);
+  }
+  else
+  {
+    /* Only the first run needs the lock, to register the statistics. */
+    if (matched_element->stats == NULL)
+    {
+      VTYSH_OVSDB_LOCK;
+      cmd_stats_get (matched_element);
+      VTYSH_OVSDB_UNLOCK;
+    }
+    stats = matched_element->stats;
+    running = matched;
+  }
+  usec_histogram_add (&stats->parse, timeval_elapsed (matched, start));
+  cmd_stats_running = stats;
+  stats->running++;
+
+  /* The handler may uninstall and free matched_element, as "no alias"
+   * does when run through that alias, so only 'stats' is used after. */
+  ret = (*matched_element->func) (matched_element, vty, 0, argc, argv);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &end);
+  usec_histogram_add (&stats->handler, timeval_elapsed (end, running));
+  stats->calls++;
+  if (ret != CMD_SUCCESS)
+    stats->errors++;
+  stats->output_bytes += vty_out_bytes - output_bytes;
+  cmd_stats_running = outer;
+  if (--stats->running == 0 && stats->cmd == NULL)
+    XFREE (MTYPE_CMD_STATS, stats);
+
+  if (locked)
+    VTYSH_OVSDB_UNLOCK;
+  return ret;
+}
+
 /* Execute command by argument vline vector. */
 static int
 cmd_execute_command_real (vector vline,
@@ -2885,6 +3145,9 @@ cmd_execute_command_real (vector vline,
   char *command;
   int ret;
   vector matches;
+  struct timeval start, matched;
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
 
   /* Make copy of command elements. */
   cmd_vector = vector_copy (cmd_node_vector (cmdvec, vty->node));
@@ -2976,20 +3239,11 @@ cmd_execute_command_real (vector vline,
     return CMD_SUCCESS_DAEMON;
   vty->buf = matched_element->string;
   vty->length = strlen(matched_element->string);
+
   /* Execute matched command. */
-  if(((matched_element->attr) & CMD_ATTR_NOLOCK) == 0)
-  {
-    VTYSH_OVSDB_LOCK;
-    VLOG_DBG("Setting the latch");
-    latch_set(&ovsdb_latch);
-    ret = (*matched_element->func) (matched_element, vty, 0, argc, argv);
-    VTYSH_OVSDB_UNLOCK;
-  }
-  else
-  {
-    ret = (*matched_element->func)(matched_element, vty, 0, argc, argv);
-  }
-  return ret;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &matched);
+  return cmd_execute_matched (matched_element, vty, argc, argv, start,
+                              matched);
 }
 
 /**
@@ -4103,6 +4357,15 @@ DEFUN (show_logging,
   	   (zl->record_priority ? "enabled" : "disabled"), VTY_NEWLINE);
   vty_out (vty, "Timestamp precision: %d%s",
 	   zl->timestamp_precision, VTY_NEWLINE);
+  {
+    unsigned long queued, dropped;
+
+    if (zlog_async_stats (&queued, &dropped))
+      vty_out (vty, "Asynchronous writer: %lu queued, %lu dropped%s",
+	       queued, dropped, VTY_NEWLINE);
+    else
+      vty_out (vty, "Asynchronous writer: disabled%s", VTY_NEWLINE);
+  }
 
   return CMD_SUCCESS;
 }
@@ -4687,8 +4950,9 @@ cmd_terminate_token(struct cmd_token *token)
   XFREE(MTYPE_CMD_TOKENS, token->cmd);
   XFREE(MTYPE_CMD_TOKENS, token->desc);
   XFREE(MTYPE_CMD_TOKENS, token->dyn_cb);
+  XFREE(MTYPE_CMD_TOKENS, token->dyn_memo_index);
 
-  XFREE(MTYPE_CMD_TOKENS, token);
+  XFREE(MTYPE_CMD_TOKEN, token);
 }
 
 struct cmd_element *
@@ -4696,9 +4960,19 @@ cmd_terminate_element(struct cmd_element *cmd)
 {
   unsigned int i;
 
+  cmd_stats_free (cmd);
+
   if (cmd->tokens == NULL)
     return cmd;
 
+  /* Static tokens from cmd_tree_load(), nothing to free. */
+  if (cmd->precompiled)
+    {
+      cmd->tokens = NULL;
+      cmd->precompiled = 0;
+      return NULL;
+    }
+
   for (i = 0; i < vector_active(cmd->tokens); i++)
     cmd_terminate_token(vector_slot(cmd->tokens, i));
 
@@ -4714,6 +4988,7 @@ cmd_terminate ()
   unsigned int i, j;
   struct cmd_node *cmd_node;
   struct cmd_element *cmd_element;
+  struct cmd_stats *stats;
   vector cmd_node_v;
 
   if (cmdvec)
@@ -4734,6 +5009,15 @@ cmd_terminate ()
       cmdvec = NULL;
     }
 
+  if (cmd_stats_vec)
+    {
+      for (i = 0; i < vector_active (cmd_stats_vec); i++)
+        if ((stats = vector_slot (cmd_stats_vec, i)) != NULL)
+          XFREE (MTYPE_CMD_STATS, stats);
+      vector_free (cmd_stats_vec);
+      cmd_stats_vec = NULL;
+    }
+
   if (command_cr)
     XFREE(MTYPE_CMD_TOKENS, command_cr);
   if (token_cr.desc)
@@ -30,6 +30,7 @@
 
 #include "vector.h"
 #include "vty.h"
+#include "histogram.h"
 #include "lib/route_types.h"
 
 
@@ -188,6 +189,32 @@ struct cmd_element
   vector tokens;		/* Vector of cmd_tokens */
   int attr;			/* Command attributes */
   const char *dyn_cb_str;       /* Callback funcname list for dynamic helpstr */
+  int precompiled;		/* tokens are static, from cmd_tree_load() */
+  struct cmd_stats *stats;	/* allocated on first execution */
+};
+
+/* Execution statistics of a command, kept by cmd_execute_command_real().
+ * Durations are in microseconds.
+ */
+struct cmd_stats
+{
+  struct cmd_element *cmd;		/* NULL once uninstalled while running */
+  unsigned int running;			/* executions under way */
+  unsigned long calls;
+  unsigned long errors;			/* calls not returning CMD_SUCCESS */
+  unsigned long long output_bytes;	/* written with vty_out() */
+  struct usec_histogram parse;		/* matching the line to the command */
+  struct usec_histogram lock_wait;	/* waiting for the OVSDB lock */
+  struct usec_histogram handler;	/* running the command */
+  struct usec_histogram commit;		/* per transaction the command commits */
+};
+
+/* Token tree of a command, parsed at build time by vtysh/cmdtree.pl. */
+struct cmd_tree_entry
+{
+  struct cmd_element *cmd;
+  const char *string;		/* Command string the tree was parsed from. */
+  vector tokens;
 };
 
 
@@ -216,6 +243,10 @@ struct cmd_token
   void (*dyn_cb_func)(struct cmd_token *token, struct vty *vty, \
                       char * const dyn_helpstr_ptr, int max_strlen);
                                  /* Command's dynamic callback func pointer. */
+  int dyn_cb_per_index;          /* Callback depends on vty->index. */
+  int dyn_memo_valid;            /* desc holds the callback's help string */
+  unsigned int dyn_memo_seqno;   /* for this IDL seqno */
+  char *dyn_memo_index;          /* and this vty->index. */
 };
 
 /* Return value of the commands. */
@@ -241,6 +272,11 @@ struct cmd_token
 #ifndef VTYSH_EXTRACT_PL  
 
 /* helper defines for end-user DEFUN* macros */
+#ifdef VTYSH_CMDTREE_PL
+/* What cmdtree.pl looks for in the preprocessed sources. */
+#define DEFUN_CMD_ELEMENT(funcname, cmdname, cmdstr, helpstr, attrs, dnum, dyn_cbstr) \
+  VTYSH_CMDTREE_ELEMENT(cmdname, cmdstr, helpstr, dyn_cbstr)
+#else
 #define DEFUN_CMD_ELEMENT(funcname, cmdname, cmdstr, helpstr, attrs, dnum, dyn_cbstr) \
   struct cmd_element cmdname = \
   { \
@@ -251,6 +287,7 @@ struct cmd_token
     .daemon = dnum, \
     .dyn_cb_str = dyn_cbstr, \
   };
+#endif /* VTYSH_CMDTREE_PL */
 
 #define DEFUN_CMD_FUNC_DECL(funcname) \
   static int funcname (struct cmd_element *, struct vty *, int, int, const char *[]);
@@ -621,6 +658,7 @@ struct cmd_token
 extern void install_node (struct cmd_node *, int (*) (struct vty *));
 extern void install_default (enum node_type);
 extern void install_element (enum node_type, struct cmd_element *);
+extern void cmd_tree_load (const struct cmd_tree_entry *, unsigned int);
 
 /* Concatenates argv[shift] through argv[argc-1] into a single NUL-terminated
    string with a space between each element (allocated using
@@ -639,6 +677,8 @@ extern int cmd_execute_command_strict (vector, struct vty *, struct cmd_element
 extern void cmd_init (int);
 extern void cmd_terminate (void);
 extern int cmd_try_execute_command (struct vty *vty, char *buf);
+extern void cmd_stats_commit (unsigned long usec);
+extern void cmd_stats_clear (void);
 extern struct cmd_element *cmd_terminate_element(struct cmd_element *cmd);
 extern void cmd_terminate_node_element (void *del_ptr, enum data_type del_type);
 
@@ -662,4 +702,7 @@ extern struct host host;
 
 /* "<cr>" global */
 extern char *command_cr;
+
+/* struct cmd_stats of the commands executed so far */
+extern vector cmd_stats_vec;
 #endif /* _ZEBRA_COMMAND_H */
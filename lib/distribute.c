@@ -610,12 +610,35 @@ ALIAS (no_distribute_list_prefix, no_ipv6_distribute_list_prefix_cmd,
        "Filter outgoing routing updates\n"
        "Interface name\n")
 
+/* Show the filters of one interface in one direction. */
+static void
+distribute_show_iface (struct hash_backet *mp, void *args[])
+{
+  struct vty *vty = args[0];
+  enum distribute_type type = *(enum distribute_type *) args[1];
+  struct distribute *dist = mp->data;
+
+  if (dist->ifname)
+    if (dist->list[type] || dist->prefix[type])
+      {
+	vty_out (vty, "    %s filtered by", dist->ifname);
+	if (dist->list[type])
+	  vty_out (vty, " %s", dist->list[type]);
+	if (dist->prefix[type])
+	  vty_out (vty, "%s (prefix-list) %s",
+		   dist->list[type] ? "," : "",
+		   dist->prefix[type]);
+	vty_out (vty, "%s", VTY_NEWLINE);
+      }
+}
+
 int
 config_show_distribute (struct vty *vty)
 {
-  unsigned int i;
-  struct hash_backet *mp;
   struct distribute *dist;
+  enum distribute_type type_out = DISTRIBUTE_OUT;
+  enum distribute_type type_in = DISTRIBUTE_IN;
+  void *args[2] = { vty, NULL };
 
   /* Output filter configuration. */
   dist = distribute_lookup (NULL);
@@ -633,23 +656,10 @@ config_show_distribute (struct vty *vty)
   else
     vty_out (vty, "  Outgoing update filter list for all interface is not set%s", VTY_NEWLINE);
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	dist = mp->data;
-	if (dist->ifname)
-	  if (dist->list[DISTRIBUTE_OUT] || dist->prefix[DISTRIBUTE_OUT])
-	    {
-	      vty_out (vty, "    %s filtered by", dist->ifname);
-	      if (dist->list[DISTRIBUTE_OUT])
-		vty_out (vty, " %s", dist->list[DISTRIBUTE_OUT]);
-	      if (dist->prefix[DISTRIBUTE_OUT])
-		vty_out (vty, "%s (prefix-list) %s",
-			 dist->list[DISTRIBUTE_OUT] ? "," : "",
-			 dist->prefix[DISTRIBUTE_OUT]);
-	      vty_out (vty, "%s", VTY_NEWLINE);
-	    }
-      }
+  args[1] = &type_out;
+  hash_iterate (disthash,
+		(void (*) (struct hash_backet *, void *)) distribute_show_iface,
+		args);
 
 
   /* Input filter configuration. */
@@ -668,78 +678,71 @@ config_show_distribute (struct vty *vty)
   else
     vty_out (vty, "  Incoming update filter list for all interface is not set%s", VTY_NEWLINE);
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	dist = mp->data;
-	if (dist->ifname)
-	  if (dist->list[DISTRIBUTE_IN] || dist->prefix[DISTRIBUTE_IN])
-	    {
-	      vty_out (vty, "    %s filtered by", dist->ifname);
-	      if (dist->list[DISTRIBUTE_IN])
-		vty_out (vty, " %s", dist->list[DISTRIBUTE_IN]);
-	      if (dist->prefix[DISTRIBUTE_IN])
-		vty_out (vty, "%s (prefix-list) %s",
-			 dist->list[DISTRIBUTE_IN] ? "," : "",
-			 dist->prefix[DISTRIBUTE_IN]);
-	      vty_out (vty, "%s", VTY_NEWLINE);
-	    }
-      }
+  args[1] = &type_in;
+  hash_iterate (disthash,
+		(void (*) (struct hash_backet *, void *)) distribute_show_iface,
+		args);
   return 0;
 }
 
+/* Write the distribute-list lines of one interface. */
+static void
+distribute_config_write_iface (struct hash_backet *mp, void *args[])
+{
+  struct vty *vty = args[0];
+  int *write = args[1];
+  struct distribute *dist;
+
+  dist = mp->data;
+
+  if (dist->list[DISTRIBUTE_IN])
+    {
+      vty_out (vty, " distribute-list %s in %s%s", 
+	       dist->list[DISTRIBUTE_IN],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+
+  if (dist->list[DISTRIBUTE_OUT])
+    {
+      vty_out (vty, " distribute-list %s out %s%s", 
+
+	       dist->list[DISTRIBUTE_OUT],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+
+  if (dist->prefix[DISTRIBUTE_IN])
+    {
+      vty_out (vty, " distribute-list prefix %s in %s%s",
+	       dist->prefix[DISTRIBUTE_IN],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+
+  if (dist->prefix[DISTRIBUTE_OUT])
+    {
+      vty_out (vty, " distribute-list prefix %s out %s%s",
+	       dist->prefix[DISTRIBUTE_OUT],
+	       dist->ifname ? dist->ifname : "",
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+}
+
 /* Configuration write function. */
 int
 config_write_distribute (struct vty *vty)
 {
-  unsigned int i;
-  struct hash_backet *mp;
   int write = 0;
+  void *args[2] = { vty, &write };
 
-  for (i = 0; i < disthash->size; i++)
-    for (mp = disthash->index[i]; mp; mp = mp->next)
-      {
-	struct distribute *dist;
-
-	dist = mp->data;
-
-	if (dist->list[DISTRIBUTE_IN])
-	  {
-	    vty_out (vty, " distribute-list %s in %s%s", 
-		     dist->list[DISTRIBUTE_IN],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->list[DISTRIBUTE_OUT])
-	  {
-	    vty_out (vty, " distribute-list %s out %s%s", 
-
-		     dist->list[DISTRIBUTE_OUT],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->prefix[DISTRIBUTE_IN])
-	  {
-	    vty_out (vty, " distribute-list prefix %s in %s%s",
-		     dist->prefix[DISTRIBUTE_IN],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (dist->prefix[DISTRIBUTE_OUT])
-	  {
-	    vty_out (vty, " distribute-list prefix %s out %s%s",
-		     dist->prefix[DISTRIBUTE_OUT],
-		     dist->ifname ? dist->ifname : "",
-		     VTY_NEWLINE);
-	    write++;
-	  }
-      }
+  hash_iterate (disthash,
+		(void (*) (struct hash_backet *, void *)) distribute_config_write_iface,
+		args);
   return write;
 }
 
@@ -3,17 +3,21 @@ extern void dyncb_helpstr_speeds(struct cmd_token *token, struct vty *vty, \
 extern void dyncb_helpstr_mtu(struct cmd_token *token, struct vty *vty, \
                               char * const helpstr, int max_strlen);
 
+/* A callback's help string is memoized in the token until the IDL seqno
+ * changes, or with per_index set, until vty->index names another object.
+ */
 struct dyn_cb_func
 {
   char * funcname;
   void (*funcptr)(struct cmd_token *token, struct vty *vty, \
                   char * const dyn_helpstr_ptr, int max_strlen);
+  int per_index;        /* Help string depends on the vty->index name. */
 };
 /* callback func lookup table for dynamic helpstr */
 struct dyn_cb_func dyn_cb_lookup[] =
 {
-  {"dyncb_helpstr_1G", dyncb_helpstr_speeds},
-  {"dyncb_helpstr_10G", dyncb_helpstr_speeds},
-  {"dyncb_helpstr_40G", dyncb_helpstr_speeds},
-  {"dyncb_helpstr_mtu", dyncb_helpstr_mtu},
+  {"dyncb_helpstr_1G", dyncb_helpstr_speeds, 1},
+  {"dyncb_helpstr_10G", dyncb_helpstr_speeds, 1},
+  {"dyncb_helpstr_40G", dyncb_helpstr_speeds, 1},
+  {"dyncb_helpstr_mtu", dyncb_helpstr_mtu, 0},
 };
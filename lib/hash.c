@@ -32,11 +32,10 @@ hash_create_size (unsigned int size, unsigned int (*hash_key) (void *),
   struct hash *hash;
 
   assert ((size & (size-1)) == 0);
-  hash = XMALLOC (MTYPE_HASH, sizeof (struct hash));
+  hash = XCALLOC (MTYPE_HASH, sizeof (struct hash));
   hash->index = XCALLOC (MTYPE_HASH_INDEX,
-			 sizeof (struct hash_backet *) * size);
+			 sizeof (struct hash_backet) * size);
   hash->size = size;
-  hash->no_expand = 0;
   hash->hash_key = hash_key;
   hash->hash_cmp = hash_cmp;
   hash->count = 0;
@@ -61,74 +60,150 @@ hash_alloc_intern (void *arg)
   return arg;
 }
 
-/* Expand hash if the chain length exceeds the threshold. */
-static void hash_expand (struct hash *hash)
+/* Find the slot holding data, or NULL.  Works on both the live and
+   the old table, released old slots keep their psl and are skipped. */
+static struct hash_backet *
+hash_slot_find (struct hash *hash, struct hash_backet *index,
+                unsigned int size, unsigned int key, void *data)
 {
-  unsigned int i, new_size, losers;
-  struct hash_backet *hb, *hbnext, **new_index;
+  struct hash_backet *hb;
+  unsigned int mask = size - 1;
+  unsigned int i = key & mask;
+  unsigned int psl;
 
-  new_size = hash->size * 2;
-  new_index = XCALLOC(MTYPE_HASH_INDEX, sizeof(struct hash_backet *) * new_size);
-  if (new_index == NULL)
-    return;
+  for (psl = 1; ; psl++)
+    {
+      hb = &index[i];
+      if (hb->psl < psl)
+	return NULL;
+      if (hb->data && hb->key == key && (*hash->hash_cmp) (hb->data, data))
+	return hb;
+      i = (i + 1) & mask;
+    }
+}
+
+/* Put data into the live table.  The caller knows it is not there. */
+static void
+hash_slot_insert (struct hash *hash, unsigned int key, void *data)
+{
+  struct hash_backet *hb;
+  struct hash_backet tmp;
+  unsigned int mask = hash->size - 1;
+  unsigned int i = key & mask;
+  unsigned int psl = 1;
 
-  for (i = 0; i < hash->size; i++)
-    for (hb = hash->index[i]; hb; hb = hbnext)
-      {
-	unsigned int h = hb->key & (new_size - 1);
-
-	hbnext = hb->next;
-	hb->next = new_index[h];
-	new_index[h] = hb;
-      }
-
-  /* Switch to new table */
-  XFREE(MTYPE_HASH_INDEX, hash->index);
-  hash->size = new_size;
-  hash->index = new_index;
-
-  /* Ideally, new index should have chains half as long as the original.
-     If expansion didn't help, then not worth expanding again,
-     the problem is the hash function. */
-  losers = 0;
-  for (i = 0; i < hash->size; i++)
+  for (;;)
     {
-      unsigned int len = 0;
-      for (hb = hash->index[i]; hb; hb = hb->next)
+      hb = &hash->index[i];
+      if (hb->psl == 0)
+	{
+	  hb->psl = psl;
+	  hb->key = key;
+	  hb->data = data;
+	  return;
+	}
+      /* Take the slot from a richer entry and carry it on instead. */
+      if (hb->psl < psl)
 	{
-	  if (++len > HASH_THRESHOLD/2)
-	    ++losers;
-	  if (len >= HASH_THRESHOLD)
-	    hash->no_expand = 1;
+	  tmp = *hb;
+	  hb->psl = psl;
+	  hb->key = key;
+	  hb->data = data;
+	  psl = tmp.psl;
+	  key = tmp.key;
+	  data = tmp.data;
 	}
+      i = (i + 1) & mask;
+      psl++;
+    }
+}
+
+/* Remove a live table slot by shifting the rest of its run back. */
+static void
+hash_slot_remove (struct hash *hash, struct hash_backet *hb)
+{
+  unsigned int mask = hash->size - 1;
+  unsigned int i = hb - hash->index;
+  struct hash_backet *next;
+
+  for (;;)
+    {
+      next = &hash->index[(i + 1) & mask];
+      if (next->psl <= 1)
+	break;
+      hash->index[i] = *next;
+      hash->index[i].psl--;
+      i = (i + 1) & mask;
     }
+  memset (&hash->index[i], 0, sizeof (struct hash_backet));
+}
+
+/* Move up to count old slots into the live table, and drop the old
+   table once it is empty. */
+static void
+hash_migrate (struct hash *hash, unsigned int count)
+{
+  struct hash_backet *hb;
+
+  while (hash->old_index && count--)
+    {
+      hb = &hash->old_index[hash->migrate++];
+      if (hb->data)
+	{
+	  hash_slot_insert (hash, hb->key, hb->data);
+	  hb->data = NULL;
+	  hash->old_count--;
+	}
 
-  if (losers > hash->count / 2)
-    hash->no_expand = 1;
+      if (hash->old_count == 0 || hash->migrate == hash->old_size)
+	{
+	  XFREE (MTYPE_HASH_INDEX, hash->old_index);
+	  hash->old_index = NULL;
+	  hash->old_size = 0;
+	  hash->old_count = 0;
+	  hash->migrate = 0;
+	}
+    }
 }
 
-/* Lookup and return hash backet in hash.  If there is no
-   corresponding hash backet and alloc_func is specified, create new
-   hash backet.  */
+/* Double the table.  Entries stay in the old table and are moved a
+   few slots per insert, so no single insert pays for the whole table.
+   The load limit leaves room for the old table to drain long before
+   the new one fills up. */
+static void
+hash_expand (struct hash *hash)
+{
+  /* Still draining the previous resize; finish it first. */
+  if (hash->old_index)
+    hash_migrate (hash, hash->old_size);
+
+  hash->old_index = hash->index;
+  hash->old_size = hash->size;
+  hash->old_count = hash->count;
+  hash->migrate = 0;
+
+  hash->size *= 2;
+  hash->index = XCALLOC (MTYPE_HASH_INDEX,
+			 sizeof (struct hash_backet) * hash->size);
+}
+
+/* Lookup and return data in hash.  If there is no corresponding data
+   and alloc_func is specified, create new entry.  */
 void *
 hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
 {
   unsigned int key;
-  unsigned int index;
   void *newdata;
-  unsigned int len;
   struct hash_backet *backet;
 
   key = (*hash->hash_key) (data);
-  index = key & (hash->size - 1);
-  len = 0;
 
-  for (backet = hash->index[index]; backet != NULL; backet = backet->next)
-    {
-      if (backet->key == key && (*hash->hash_cmp) (backet->data, data))
-	return backet->data;
-      ++len;
-    }
+  backet = hash_slot_find (hash, hash->index, hash->size, key, data);
+  if (backet == NULL && hash->old_index)
+    backet = hash_slot_find (hash, hash->old_index, hash->old_size,
+			     key, data);
+  if (backet)
+    return backet->data;
 
   if (alloc_func)
     {
@@ -136,19 +211,15 @@ hash_get (struct hash *hash, void *data, void * (*alloc_func) (void *))
       if (newdata == NULL)
 	return NULL;
 
-      if (len > HASH_THRESHOLD && !hash->no_expand)
-	{
-	  hash_expand (hash);
-	  index = key & (hash->size - 1);
-	}
+      if ((hash->count - hash->old_count + 1) * 100
+	  > (unsigned long) hash->size * HASH_LOAD_PERCENT)
+	hash_expand (hash);
 
-      backet = XMALLOC (MTYPE_HASH_BACKET, sizeof (struct hash_backet));
-      backet->data = newdata;
-      backet->key = key;
-      backet->next = hash->index[index];
-      hash->index[index] = backet;
+      hash_slot_insert (hash, key, newdata);
       hash->count++;
-      return backet->data;
+
+      hash_migrate (hash, HASH_MIGRATE_STEP);
+      return newdata;
     }
   return NULL;
 }
@@ -179,50 +250,69 @@ hash_release (struct hash *hash, void *data)
 {
   void *ret;
   unsigned int key;
-  unsigned int index;
   struct hash_backet *backet;
-  struct hash_backet *pp;
 
   key = (*hash->hash_key) (data);
-  index = key & (hash->size - 1);
 
-  for (backet = pp = hash->index[index]; backet; backet = backet->next)
+  backet = hash_slot_find (hash, hash->index, hash->size, key, data);
+  if (backet)
     {
-      if (backet->key == key && (*hash->hash_cmp) (backet->data, data)) 
-	{
-	  if (backet == pp) 
-	    hash->index[index] = backet->next;
-	  else 
-	    pp->next = backet->next;
+      ret = backet->data;
+      hash_slot_remove (hash, backet);
+      hash->count--;
+      return ret;
+    }
 
+  if (hash->old_index)
+    {
+      backet = hash_slot_find (hash, hash->old_index, hash->old_size,
+			       key, data);
+      if (backet)
+	{
+	  /* Keep psl so probes for later entries don't stop here. */
 	  ret = backet->data;
-	  XFREE (MTYPE_HASH_BACKET, backet);
+	  backet->data = NULL;
+	  hash->old_count--;
 	  hash->count--;
 	  return ret;
 	}
-      pp = backet;
     }
   return NULL;
 }
 
-/* Iterator function for hash.  */
+/* Iterator function for hash.  func may release the backet it is
+   handed.  The live table is walked downwards from an empty slot:
+   a release only shifts entries down from slots above, which have
+   been visited already, so nothing is skipped or seen twice. */
 void
 hash_iterate (struct hash *hash, 
 	      void (*func) (struct hash_backet *, void *), void *arg)
 {
   unsigned int i;
+  unsigned int mask;
+  unsigned int start;
   struct hash_backet *hb;
-  struct hash_backet *hbnext;
-
-  for (i = 0; i < hash->size; i++)
-    for (hb = hash->index[i]; hb; hb = hbnext)
-      {
-	/* get pointer to next hash backet here, in case (*func)
-	 * decides to delete hb by calling hash_release
-	 */
-	hbnext = hb->next;
+
+  for (i = 0; hash->old_index && i < hash->old_size; i++)
+    {
+      hb = &hash->old_index[i];
+      if (hb->data)
 	(*func) (hb, arg);
-      }
+    }
+
+  if (hash->count == 0)
+    return;
+
+  mask = hash->size - 1;
+  for (start = 0; hash->index[start].psl != 0; start++)
+    ;
+
+  for (i = (start - 1) & mask; i != start; i = (i - 1) & mask)
+    {
+      hb = &hash->index[i];
+      if (hb->data)
+	(*func) (hb, arg);
+    }
 }
 
 /* Clean up hash.  */
@@ -230,23 +320,27 @@ void
 hash_clean (struct hash *hash, void (*free_func) (void *))
 {
   unsigned int i;
-  struct hash_backet *hb;
-  struct hash_backet *next;
 
-  for (i = 0; i < hash->size; i++)
+  if (free_func)
     {
-      for (hb = hash->index[i]; hb; hb = next)
-	{
-	  next = hb->next;
-	      
-	  if (free_func)
-	    (*free_func) (hb->data);
+      for (i = 0; hash->old_index && i < hash->old_size; i++)
+	if (hash->old_index[i].data)
+	  (*free_func) (hash->old_index[i].data);
 
-	  XFREE (MTYPE_HASH_BACKET, hb);
-	  hash->count--;
-	}
-      hash->index[i] = NULL;
+      for (i = 0; i < hash->size; i++)
+	if (hash->index[i].data)
+	  (*free_func) (hash->index[i].data);
     }
+
+  if (hash->old_index)
+    XFREE (MTYPE_HASH_INDEX, hash->old_index);
+  hash->old_index = NULL;
+  hash->old_size = 0;
+  hash->old_count = 0;
+  hash->migrate = 0;
+
+  memset (hash->index, 0, sizeof (struct hash_backet) * hash->size);
+  hash->count = 0;
 }
 
 /* Free hash memory.  You may call hash_clean before call this
@@ -254,6 +348,8 @@ hash_clean (struct hash *hash, void (*free_func) (void *))
 void
 hash_free (struct hash *hash)
 {
+  if (hash->old_index)
+    XFREE (MTYPE_HASH_INDEX, hash->old_index);
   XFREE (MTYPE_HASH_INDEX, hash->index);
   XFREE (MTYPE_HASH, hash);
 }
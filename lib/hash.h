@@ -22,31 +22,42 @@ Boston, MA 02111-1307, USA.  */
 #define _ZEBRA_HASH_H
 
 /* Default hash table size.  */ 
-#define HASH_INITIAL_SIZE     256	/* initial number of backets. */
-#define HASH_THRESHOLD	      10	/* expand when backet. */
+#define HASH_INITIAL_SIZE     256	/* initial number of slots. */
+#define HASH_LOAD_PERCENT      75	/* grow when this full. */
+#define HASH_MIGRATE_STEP       8	/* old slots moved per insert. */
 
+/* Open addressing slot.  The table is probed linearly with Robin Hood
+   displacement, so psl never decreases along a run of occupied
+   slots and a lookup can stop as soon as it meets a smaller one. */
 struct hash_backet
 {
-  /* Linked list.  */
-  struct hash_backet *next;
+  /* Probe sequence length, 1 in the home slot, 0 if never used. */
+  unsigned int psl;
 
   /* Hash key. */
   unsigned int key;
 
-  /* Data.  */
+  /* Data, NULL in an empty slot.  */
   void *data;
 };
 
 struct hash
 {
-  /* Hash backet. */
-  struct hash_backet **index;
+  /* Hash slots. */
+  struct hash_backet *index;
 
   /* Hash table size. Must be power of 2 */
   unsigned int size;
 
-  /* If expansion failed. */
-  int no_expand;
+  /* Table being drained into index after a resize, NULL if none.
+     Released entries leave their psl behind so probing still stops
+     at the right place. */
+  struct hash_backet *old_index;
+  unsigned int old_size;
+  unsigned int old_count;
+
+  /* Next old slot to move. */
+  unsigned int migrate;
 
   /* Key make function. */
   unsigned int (*hash_key) (void *);
@@ -0,0 +1,165 @@
+/* Hash table microbenchmark.
+ * Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times hash_get (), hash_lookup () and hash_release () on scattered
+   32-bit keys, using nothing but the hash.h API, so that it can be linked
+   against any version of hash.c.  hash_bench.sh builds it against the
+   chained table and against the current one.
+
+   usage: hash_bench [entries...] */
+
+#include <zebra.h>
+
+#include "hash.h"
+#include "memory.h"
+
+struct entry
+{
+  unsigned int value;
+};
+
+/* hash.c is linked on its own, without memory.c and log.c. */
+void *
+zmalloc (int type, size_t size)
+{
+  return malloc (size);
+}
+
+void *
+zcalloc (int type, size_t size)
+{
+  return calloc (1, size);
+}
+
+void *
+zrealloc (int type, void *ptr, size_t size)
+{
+  return realloc (ptr, size);
+}
+
+void
+zfree (int type, void *ptr)
+{
+  free (ptr);
+}
+
+void
+_zlog_assert_failed (const char *assertion, const char *file,
+		     unsigned int line, const char *function)
+{
+  fprintf (stderr, "%s:%u: %s: assertion %s failed\n",
+	   file, line, function, assertion);
+  abort ();
+}
+
+static unsigned int
+entry_key (void *arg)
+{
+  unsigned int x = ((struct entry *) arg)->value;
+
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  return x;
+}
+
+static int
+entry_cmp (const void *a, const void *b)
+{
+  return ((const struct entry *) a)->value == ((const struct entry *) b)->value;
+}
+
+static double
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Inserts n entries, looks each up and releases every other one. */
+static void
+bench (unsigned int n)
+{
+  struct hash *hash = hash_create (entry_key, entry_cmp);
+  struct entry *entries = calloc (n, sizeof (struct entry));
+  struct entry key;
+  double start, insert, lookup, release, t, worst = 0;
+  unsigned int i;
+
+  /* Distinct keys, scattered by a multiplicative hash. */
+  for (i = 0; i < n; i++)
+    entries[i].value = i * 2654435761u;
+
+  start = now_ns ();
+  for (i = 0; i < n; i++)
+    {
+      t = now_ns ();
+      hash_get (hash, &entries[i], hash_alloc_intern);
+      t = now_ns () - t;
+      if (t > worst)
+	worst = t;
+    }
+  insert = now_ns () - start;
+
+  start = now_ns ();
+  for (i = 0; i < n; i++)
+    {
+      key.value = entries[i].value;
+      if (hash_lookup (hash, &key) == NULL)
+	{
+	  fprintf (stderr, "entry %u not found\n", i);
+	  exit (1);
+	}
+    }
+  lookup = now_ns () - start;
+
+  start = now_ns ();
+  for (i = 0; i < n; i += 2)
+    hash_release (hash, &entries[i]);
+  release = now_ns () - start;
+
+  printf ("N=%-8u insert %6.1f ns  lookup %6.1f ns  release %6.1f ns  "
+	  "worst insert %9.1f us\n", n, insert / n, lookup / n,
+	  release / ((n + 1) / 2), worst / 1000);
+
+  hash_clean (hash, NULL);
+  hash_free (hash);
+  free (entries);
+}
+
+int
+main (int argc, char **argv)
+{
+  int i;
+
+  if (argc < 2)
+    {
+      bench (1000);
+      bench (100000);
+      bench (1000000);
+      bench (4000000);
+    }
+  for (i = 1; i < argc; i++)
+    bench (strtoul (argv[i], NULL, 10));
+  return 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Compares the open addressing hash table of hash.c with the chained one
+# it replaced, by building hash_bench.c against each.
+# usage: lib/hash_bench.sh [old-revision [entries...]]
+#
+# Run from the top of a configured and built tree, in a git checkout.  The
+# old hash.c and hash.h are taken from old-revision, by default the one
+# before open addressing was introduced.  CC and CFLAGS are honoured.
+
+top=$(pwd)
+cc=${CC:-cc}
+cflags=${CFLAGS:--O2}
+old=$1
+[ $# -gt 0 ] && shift
+
+if [ -z "$old" ]; then
+    old=$(git log --reverse --format=%H -S HASH_MIGRATE_STEP -- lib/hash.h \
+          | head -n 1)~1
+fi
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' 0
+
+# hash_bench.c includes "hash.h" from its own directory, so the old
+# build gets a copy of it next to the old sources.
+mkdir "$tmp/old" &&
+git show "$old:lib/hash.c" > "$tmp/old/hash.c" &&
+git show "$old:lib/hash.h" > "$tmp/old/hash.h" &&
+cp lib/hash_bench.c "$tmp/old/" || exit 1
+
+build() {
+    $cc $cflags -DHAVE_CONFIG_H -I"$top" -I"$top/lib" -o "$1" "$2/hash_bench.c" \
+        "$2/hash.c" || exit 1
+}
+
+build "$tmp/chained" "$tmp/old"
+build "$tmp/open" lib
+
+echo "chained ($old):"
+"$tmp/chained" "$@"
+echo "open addressing:"
+"$tmp/open" "$@"
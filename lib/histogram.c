@@ -0,0 +1,59 @@
+/* Latency histograms.
+ * Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <zebra.h>
+
+#include "histogram.h"
+
+void
+usec_histogram_add (struct usec_histogram *h, unsigned long usec)
+{
+  int i = 0;
+
+  if (usec > 1)
+    i = (sizeof (unsigned long) * 8 - 1) - __builtin_clzl (usec);
+  if (i >= USEC_HISTOGRAM_BUCKETS)
+    i = USEC_HISTOGRAM_BUCKETS - 1;
+
+  h->bucket[i]++;
+  h->count++;
+  if (usec > h->max)
+    h->max = usec;
+}
+
+unsigned long
+usec_histogram_percentile (const struct usec_histogram *h, unsigned int pct)
+{
+  unsigned long want, seen = 0, bound;
+  int i;
+
+  if (h->count == 0)
+    return 0;
+
+  want = (h->count * pct + 99) / 100;
+  for (i = 0; i < USEC_HISTOGRAM_BUCKETS - 1; i++)
+    if ((seen += h->bucket[i]) >= want)
+      break;
+
+  bound = (i < (int) sizeof (unsigned long) * 8 - 1) ? (2UL << i) - 1
+                                                     : h->max;
+  return (bound < h->max) ? bound : h->max;
+}
@@ -0,0 +1,42 @@
+/* Latency histograms.
+ * Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _ZEBRA_HISTOGRAM_H
+#define _ZEBRA_HISTOGRAM_H
+
+/* log2 histogram of durations in microseconds:
+ * bucket[i] counts values in [2^i, 2^(i+1)), bucket[0] also counts 0.
+ */
+#define USEC_HISTOGRAM_BUCKETS 32
+struct usec_histogram
+{
+  unsigned long bucket[USEC_HISTOGRAM_BUCKETS];
+  unsigned long count;
+  unsigned long max;
+};
+
+extern void usec_histogram_add (struct usec_histogram *, unsigned long usec);
+
+/* Upper bound of the bucket holding the given percentile */
+extern unsigned long usec_histogram_percentile (const struct usec_histogram *,
+                                                unsigned int pct);
+
+#endif /* _ZEBRA_HISTOGRAM_H */
@@ -274,39 +274,45 @@ ALIAS (no_if_rmap,
        "Route map for output filtering\n"
        "Route map interface name\n")
 
+/* Write the route-map lines of one interface. */
+static void
+if_rmap_config_write_iface (struct hash_backet *mp, void *args[])
+{
+  struct vty *vty = args[0];
+  int *write = args[1];
+  struct if_rmap *if_rmap;
+
+  if_rmap = mp->data;
+
+  if (if_rmap->routemap[IF_RMAP_IN])
+    {
+      vty_out (vty, " route-map %s in %s%s", 
+	       if_rmap->routemap[IF_RMAP_IN],
+	       if_rmap->ifname,
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+
+  if (if_rmap->routemap[IF_RMAP_OUT])
+    {
+      vty_out (vty, " route-map %s out %s%s", 
+	       if_rmap->routemap[IF_RMAP_OUT],
+	       if_rmap->ifname,
+	       VTY_NEWLINE);
+      (*write)++;
+    }
+}
+
 /* Configuration write function. */
 int
 config_write_if_rmap (struct vty *vty)
 {
-  unsigned int i;
-  struct hash_backet *mp;
   int write = 0;
+  void *args[2] = { vty, &write };
 
-  for (i = 0; i < ifrmaphash->size; i++)
-    for (mp = ifrmaphash->index[i]; mp; mp = mp->next)
-      {
-	struct if_rmap *if_rmap;
-
-	if_rmap = mp->data;
-
-	if (if_rmap->routemap[IF_RMAP_IN])
-	  {
-	    vty_out (vty, " route-map %s in %s%s", 
-		     if_rmap->routemap[IF_RMAP_IN],
-		     if_rmap->ifname,
-		     VTY_NEWLINE);
-	    write++;
-	  }
-
-	if (if_rmap->routemap[IF_RMAP_OUT])
-	  {
-	    vty_out (vty, " route-map %s out %s%s", 
-		     if_rmap->routemap[IF_RMAP_OUT],
-		     if_rmap->ifname,
-		     VTY_NEWLINE);
-	    write++;
-	  }
-      }
+  hash_iterate (ifrmaphash,
+		(void (*) (struct hash_backet *, void *)) if_rmap_config_write_iface,
+		args);
   return write;
 }
 
@@ -27,3 +27,8 @@ int (*lib_vtysh_ovsdb_interface_match)(const char *str) = NULL;
 int (*lib_vtysh_ovsdb_port_match)(const char *str) = NULL;
 int (*lib_vtysh_ovsdb_vlan_match)(const char *str) = NULL;
 int (*lib_vtysh_ovsdb_mac_match)(const char *str) = NULL;
+unsigned int (*lib_vtysh_ovsdb_seqno)(void) = NULL;
+unsigned int (*lib_vtysh_ovsdb_complete)(const char *keyword,
+                                         const char *varname,
+                                         const char *prefix,
+                                         const char * const **names) = NULL;
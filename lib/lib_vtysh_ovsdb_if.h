@@ -27,5 +27,14 @@ extern int (*lib_vtysh_ovsdb_interface_match)(const char *str);
 extern int (*lib_vtysh_ovsdb_port_match)(const char *str);
 extern int (*lib_vtysh_ovsdb_vlan_match)(const char *str);
 extern int (*lib_vtysh_ovsdb_mac_match)(const char *str);
+extern unsigned int (*lib_vtysh_ovsdb_seqno)(void);
+
+/* Completion candidates for the variable token 'varname' following the
+ * word 'keyword' (NULL at the start of the line).  Points *names at the
+ * sorted names starting with 'prefix' and returns how many there are. */
+extern unsigned int (*lib_vtysh_ovsdb_complete)(const char *keyword,
+                                                const char *varname,
+                                                const char *prefix,
+                                                const char * const **names);
 
 #endif /* LIB_VTYSH_OVSDB_IF_H */
@@ -30,6 +30,10 @@
 #ifndef SUNOS_5
 #include <sys/un.h>
 #endif
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#include <poll.h>
+#endif
 /* for printstack on solaris */
 #ifdef HAVE_UCONTEXT_H
 #include <ucontext.h>
@@ -73,42 +77,42 @@ const char *zlog_priority[] =
 
 /* For time string format. */
 
-size_t
-quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
+/* Last rendered second, so strftime runs once per second. */
+struct timestamp_cache
 {
-  static struct {
-    time_t last;
-    size_t len;
-    char buf[28];
-  } cache;
-  struct timeval clock;
-
-  /* would it be sufficient to use global 'recent_time' here?  I fear not... */
-  gettimeofday(&clock, NULL);
+  time_t last;
+  size_t len;
+  char buf[28];
+};
 
+static size_t
+timestamp_render (int timestamp_precision, const struct timeval *clock,
+		  struct timestamp_cache *cache, char *buf, size_t buflen)
+{
   /* first, we update the cache if the time has changed */
-  if (cache.last != clock.tv_sec)
+  if (cache->last != clock->tv_sec)
     {
-      struct tm *tm;
-      cache.last = clock.tv_sec;
-      tm = localtime(&cache.last);
-      cache.len = strftime(cache.buf, sizeof(cache.buf),
-      			   "%Y/%m/%d %H:%M:%S", tm);
+      struct tm tm;
+      cache->last = clock->tv_sec;
+      localtime_r(&cache->last, &tm);
+      cache->len = strftime(cache->buf, sizeof(cache->buf),
+      			    "%Y/%m/%d %H:%M:%S", &tm);
     }
   /* note: it's not worth caching the subsecond part, because
      chances are that back-to-back calls are not sufficiently close together
      for the clock not to have ticked forward */
 
-  if (buflen > cache.len)
+  if (buflen > cache->len)
     {
-      memcpy(buf, cache.buf, cache.len);
+      memcpy(buf, cache->buf, cache->len);
       if ((timestamp_precision > 0) &&
-	  (buflen > cache.len+1+timestamp_precision))
+	  (buflen > cache->len+1+timestamp_precision))
 	{
 	  /* should we worry about locale issues? */
 	  static const int divisor[] = {0, 100000, 10000, 1000, 100, 10, 1};
+	  long usec = clock->tv_usec;
 	  int prec;
-	  char *p = buf+cache.len+1+(prec = timestamp_precision);
+	  char *p = buf+cache->len+1+(prec = timestamp_precision);
 	  *p-- = '\0';
 	  while (prec > 6)
 	    /* this is unlikely to happen, but protect anyway */
@@ -116,24 +120,35 @@ quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
 	      *p-- = '0';
 	      prec--;
 	    }
-	  clock.tv_usec /= divisor[prec];
+	  usec /= divisor[prec];
 	  do
 	    {
-	      *p-- = '0'+(clock.tv_usec % 10);
-	      clock.tv_usec /= 10;
+	      *p-- = '0'+(usec % 10);
+	      usec /= 10;
 	    }
 	  while (--prec > 0);
 	  *p = '.';
-	  return cache.len+1+timestamp_precision;
+	  return cache->len+1+timestamp_precision;
 	}
-      buf[cache.len] = '\0';
-      return cache.len;
+      buf[cache->len] = '\0';
+      return cache->len;
     }
   if (buflen > 0)
     buf[0] = '\0';
   return 0;
 }
 
+size_t
+quagga_timestamp(int timestamp_precision, char *buf, size_t buflen)
+{
+  static struct timestamp_cache cache;
+  struct timeval clock;
+
+  /* would it be sufficient to use global 'recent_time' here?  I fear not... */
+  gettimeofday(&clock, NULL);
+  return timestamp_render(timestamp_precision, &clock, &cache, buf, buflen);
+}
+
 /* Utility routine for current time printing. */
 static void
 time_print(FILE *fp, struct timestamp_control *ctl)
@@ -147,11 +162,489 @@ time_print(FILE *fp, struct timestamp_control *ctl)
 }
   
 
+#ifdef HAVE_LIBPTHREAD
+/* Asynchronous file and syslog output.
+ *
+ * vzlog() only takes the time, formats the message into a slot of a
+ * bounded ring and returns.  A writer thread renders the prefix and
+ * hands batches of records to the log file with writev() and to syslog.
+ * Producers claim slots with a CAS on the tail and publish them through
+ * a per-slot sequence number, so they never wait on each other or on the
+ * disk.  When the ring is full the message is dropped and counted.
+ *
+ * Stdout and terminal monitors are still written in place.  Assertion
+ * failures and fatal signals switch back to synchronous output. */
+
+#define ZLOG_RING_SIZE		1024	/* power of two */
+#define ZLOG_MSG_MAX		1024	/* longer messages are truncated */
+#define ZLOG_BATCH		64
+
+/* The writer wakes up on its own this often; producers only wake it
+   early for warnings and worse, or when the ring is filling up. */
+#define ZLOG_WRITER_INTERVAL	100	/* msec */
+#define ZLOG_WAKE_DEPTH		(ZLOG_RING_SIZE / 4)
+
+#define ZLOG_ASYNC_SYSLOG	(1 << 0)
+#define ZLOG_ASYNC_FILE		(1 << 1)
+
+struct zlog_record
+{
+  unsigned long seq;
+  struct zlog *zl;
+  struct timeval tv;
+  int priority;
+  int dests;
+  int len;
+  char msg[ZLOG_MSG_MAX];
+};
+
+enum
+{
+  ZLOG_ASYNC_IDLE = 0,		/* writer not started yet */
+  ZLOG_ASYNC_RUNNING,
+  ZLOG_ASYNC_SYNC,		/* stopped or failed, write in place */
+};
+
+static struct
+{
+  struct zlog_record *ring;
+  unsigned long tail;		/* next slot to claim */
+  unsigned long head;		/* next slot to write, under drain_lock */
+  unsigned long dropped;
+  unsigned long dropped_reported;
+  int state;
+  int sleeping;
+  int wakefd[2];
+  pthread_t thread;
+  pthread_mutex_t start_lock;
+  pthread_mutex_t drain_lock;	/* one consumer at a time */
+  pthread_mutex_t file_lock;	/* zl->fp against zlog_set_file() & co */
+} zlog_async =
+{
+  .wakefd = { -1, -1 },
+  .start_lock = PTHREAD_MUTEX_INITIALIZER,
+  .drain_lock = PTHREAD_MUTEX_INITIALIZER,
+  .file_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+#define ZLOG_FILE_LOCK()	pthread_mutex_lock (&zlog_async.file_lock)
+#define ZLOG_FILE_UNLOCK()	pthread_mutex_unlock (&zlog_async.file_lock)
+
+static int
+zlog_async_pending (void)
+{
+  struct zlog_record *rec;
+
+  rec = &zlog_async.ring[zlog_async.head & (ZLOG_RING_SIZE - 1)];
+  return __atomic_load_n (&rec->seq, __ATOMIC_SEQ_CST) == zlog_async.head + 1;
+}
+
+/* Write a batch of records.  Called with drain_lock held. */
+static void
+zlog_async_write (struct zlog_record **batch, int n)
+{
+  static struct timestamp_cache cache;
+  static char newline = '\n';
+  char hdr[ZLOG_BATCH][80];
+  struct iovec iov[ZLOG_BATCH * 3];
+  struct zlog *cur = NULL;
+  int i, len, niov = 0;
+
+  ZLOG_FILE_LOCK ();
+  for (i = 0; i < n; i++)
+    {
+      struct zlog_record *rec = batch[i];
+      struct zlog *zl = rec->zl;
+
+      if (rec->dests & ZLOG_ASYNC_SYSLOG)
+	syslog (rec->priority|zlog_default->facility, "%s", rec->msg);
+
+      if (!(rec->dests & ZLOG_ASYNC_FILE) || !zl->fp)
+	continue;
+      if (zl != cur)
+	{
+	  if (niov)
+	    while (writev (fileno (cur->fp), iov, niov) < 0 && errno == EINTR)
+	      ;
+	  niov = 0;
+	  cur = zl;
+	}
+
+      len = timestamp_render (zl->timestamp_precision, &rec->tv, &cache,
+			      hdr[i], sizeof (hdr[i]) - 1);
+      hdr[i][len++] = ' ';
+      if (zl->record_priority)
+	len += snprintf (hdr[i] + len, sizeof (hdr[i]) - len, "%s: ",
+			 zlog_priority[rec->priority]);
+      len += snprintf (hdr[i] + len, sizeof (hdr[i]) - len, "%s: ",
+		       zlog_proto_names[zl->protocol]);
+      iov[niov].iov_base = hdr[i];
+      iov[niov++].iov_len = MIN ((size_t) len, sizeof (hdr[i]) - 1);
+      iov[niov].iov_base = rec->msg;
+      iov[niov++].iov_len = rec->len;
+      iov[niov].iov_base = &newline;
+      iov[niov++].iov_len = 1;
+    }
+  if (niov)
+    while (writev (fileno (cur->fp), iov, niov) < 0 && errno == EINTR)
+      ;
+  ZLOG_FILE_UNLOCK ();
+}
+
+/* Write out everything queued so far, return the number of records.
+   Called with drain_lock held. */
+static int
+zlog_async_drain_locked (void)
+{
+  struct zlog_record *batch[ZLOG_BATCH];
+  unsigned long start, dropped;
+  int i, n, total = 0;
+
+  do
+    {
+      start = zlog_async.head;
+      for (n = 0; n < ZLOG_BATCH && zlog_async_pending (); n++)
+	{
+	  batch[n] = &zlog_async.ring[zlog_async.head & (ZLOG_RING_SIZE - 1)];
+	  __atomic_store_n (&zlog_async.head, zlog_async.head + 1,
+			    __ATOMIC_RELAXED);
+	}
+      if (n == 0)
+	break;
+      zlog_async_write (batch, n);
+      /* Hand the slots back to the producers, one lap later. */
+      for (i = 0; i < n; i++)
+	__atomic_store_n (&batch[i]->seq, start + i + ZLOG_RING_SIZE,
+			  __ATOMIC_RELEASE);
+      total += n;
+    }
+  while (n == ZLOG_BATCH);
+
+  dropped = __atomic_load_n (&zlog_async.dropped, __ATOMIC_RELAXED);
+  if (dropped != zlog_async.dropped_reported && zlog_default)
+    {
+      static struct zlog_record note;
+      struct zlog_record *rec = &note;
+
+      note.zl = zlog_default;
+      note.priority = LOG_WARNING;
+      note.dests = ZLOG_ASYNC_SYSLOG | ZLOG_ASYNC_FILE;
+      if (LOG_WARNING > zlog_default->maxlvl[ZLOG_DEST_SYSLOG])
+	note.dests &= ~ZLOG_ASYNC_SYSLOG;
+      if (LOG_WARNING > zlog_default->maxlvl[ZLOG_DEST_FILE])
+	note.dests &= ~ZLOG_ASYNC_FILE;
+      gettimeofday (&note.tv, NULL);
+      note.len = snprintf (note.msg, sizeof (note.msg),
+			   "%lu log messages dropped, log queue full",
+			   dropped - zlog_async.dropped_reported);
+      zlog_async.dropped_reported = dropped;
+      zlog_async_write (&rec, 1);
+    }
+  return total;
+}
+
+static int
+zlog_async_drain (void)
+{
+  int total;
+
+  pthread_mutex_lock (&zlog_async.drain_lock);
+  total = zlog_async_drain_locked ();
+  pthread_mutex_unlock (&zlog_async.drain_lock);
+  return total;
+}
+
+static void *
+zlog_async_writer (void *arg)
+{
+  struct pollfd pfd;
+  char buf[64];
+
+  pfd.fd = zlog_async.wakefd[0];
+  pfd.events = POLLIN;
+  while (__atomic_load_n (&zlog_async.state, __ATOMIC_ACQUIRE)
+	 != ZLOG_ASYNC_SYNC)
+    {
+      if (zlog_async_drain ())
+	continue;
+
+      /* Producers only write to the pipe when they see us sleeping. */
+      __atomic_store_n (&zlog_async.sleeping, 1, __ATOMIC_SEQ_CST);
+      pthread_mutex_lock (&zlog_async.drain_lock);
+      if (zlog_async_pending ())
+	{
+	  pthread_mutex_unlock (&zlog_async.drain_lock);
+	  __atomic_store_n (&zlog_async.sleeping, 0, __ATOMIC_SEQ_CST);
+	  continue;
+	}
+      pthread_mutex_unlock (&zlog_async.drain_lock);
+      poll (&pfd, 1, ZLOG_WRITER_INTERVAL);
+      __atomic_store_n (&zlog_async.sleeping, 0, __ATOMIC_SEQ_CST);
+      while (read (zlog_async.wakefd[0], buf, sizeof (buf)) > 0)
+	;
+    }
+  return NULL;
+}
+
+/* fork() keeps only the calling thread, so the queue is written out
+   before forking and the child starts its own writer on demand. */
+static void
+zlog_async_prepare (void)
+{
+  pthread_mutex_lock (&zlog_async.start_lock);
+  pthread_mutex_lock (&zlog_async.drain_lock);
+  zlog_async_drain_locked ();
+  ZLOG_FILE_LOCK ();
+}
+
+static void
+zlog_async_parent (void)
+{
+  ZLOG_FILE_UNLOCK ();
+  pthread_mutex_unlock (&zlog_async.drain_lock);
+  pthread_mutex_unlock (&zlog_async.start_lock);
+}
+
+static void
+zlog_async_child (void)
+{
+  zlog_async_parent ();
+  if (zlog_async.state == ZLOG_ASYNC_RUNNING)
+    {
+      zlog_async.state = ZLOG_ASYNC_IDLE;
+      zlog_async.sleeping = 0;
+      close (zlog_async.wakefd[0]);
+      close (zlog_async.wakefd[1]);
+      zlog_async.wakefd[0] = zlog_async.wakefd[1] = -1;
+    }
+}
+
+static int
+zlog_async_start (void)
+{
+  static int registered;
+  sigset_t all, old;
+  int state;
+  unsigned long i;
+
+  pthread_mutex_lock (&zlog_async.start_lock);
+  state = zlog_async.state;
+  if (state == ZLOG_ASYNC_IDLE)
+    {
+      /* Not XCALLOC: a failing allocation would log from here. */
+      if (!zlog_async.ring
+	  && (zlog_async.ring = calloc (ZLOG_RING_SIZE,
+					sizeof (struct zlog_record))))
+	for (i = 0; i < ZLOG_RING_SIZE; i++)
+	  zlog_async.ring[i].seq = i;
+
+      state = ZLOG_ASYNC_SYNC;
+      if (zlog_async.ring && pipe (zlog_async.wakefd) == 0)
+	{
+	  for (i = 0; i < 2; i++)
+	    {
+	      fcntl (zlog_async.wakefd[i], F_SETFL, O_NONBLOCK);
+	      fcntl (zlog_async.wakefd[i], F_SETFD, FD_CLOEXEC);
+	    }
+	  /* Signals stay with the daemon threads. */
+	  sigfillset (&all);
+	  pthread_sigmask (SIG_SETMASK, &all, &old);
+	  if (pthread_create (&zlog_async.thread, NULL, zlog_async_writer,
+			      NULL) == 0)
+	    state = ZLOG_ASYNC_RUNNING;
+	  else
+	    {
+	      close (zlog_async.wakefd[0]);
+	      close (zlog_async.wakefd[1]);
+	      zlog_async.wakefd[0] = zlog_async.wakefd[1] = -1;
+	    }
+	  pthread_sigmask (SIG_SETMASK, &old, NULL);
+	}
+      if (state == ZLOG_ASYNC_RUNNING && !registered)
+	{
+	  registered = 1;
+	  pthread_atfork (zlog_async_prepare, zlog_async_parent,
+			  zlog_async_child);
+	  atexit (zlog_async_flush);
+	}
+      __atomic_store_n (&zlog_async.state, state, __ATOMIC_RELEASE);
+    }
+  pthread_mutex_unlock (&zlog_async.start_lock);
+  return state;
+}
+
+/* Queue the syslog and file part of a message.  Returns 0 if there is
+   nothing to queue or no writer, and the caller must write it itself. */
+static int
+zlog_async_queue (struct zlog *zl, int priority, const char *format,
+		  va_list args)
+{
+  struct zlog_record *rec;
+  struct timeval tv;
+  unsigned long pos, seq;
+  int dests = 0, len;
+  va_list ac;
+
+  if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
+    dests |= ZLOG_ASYNC_SYSLOG;
+  if ((priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
+    dests |= ZLOG_ASYNC_FILE;
+  if (!dests)
+    return 0;
+  if (__atomic_load_n (&zlog_async.state, __ATOMIC_ACQUIRE)
+      != ZLOG_ASYNC_RUNNING
+      && zlog_async_start () != ZLOG_ASYNC_RUNNING)
+    return 0;
+
+  gettimeofday (&tv, NULL);
+  pos = __atomic_load_n (&zlog_async.tail, __ATOMIC_RELAXED);
+  for (;;)
+    {
+      rec = &zlog_async.ring[pos & (ZLOG_RING_SIZE - 1)];
+      seq = __atomic_load_n (&rec->seq, __ATOMIC_ACQUIRE);
+      if (seq == pos)
+	{
+	  if (__atomic_compare_exchange_n (&zlog_async.tail, &pos, pos + 1, 1,
+					   __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	    break;
+	}
+      else if ((long) (seq - pos) < 0)
+	{
+	  /* Full: the writer still owns this slot from the last lap. */
+	  __atomic_add_fetch (&zlog_async.dropped, 1, __ATOMIC_RELAXED);
+	  return 1;
+	}
+      else
+	pos = __atomic_load_n (&zlog_async.tail, __ATOMIC_RELAXED);
+    }
+
+  rec->zl = zl;
+  rec->tv = tv;
+  rec->priority = priority;
+  rec->dests = dests;
+  va_copy (ac, args);
+  len = vsnprintf (rec->msg, sizeof (rec->msg), format, ac);
+  va_end (ac);
+  rec->len = (len < 0) ? 0 : MIN ((size_t) len, sizeof (rec->msg) - 1);
+  rec->msg[rec->len] = '\0';
+  __atomic_store_n (&rec->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+  if ((priority <= LOG_WARNING
+       || pos - __atomic_load_n (&zlog_async.head, __ATOMIC_RELAXED)
+	  >= ZLOG_WAKE_DEPTH)
+      && __atomic_exchange_n (&zlog_async.sleeping, 0, __ATOMIC_SEQ_CST))
+    {
+      char c = 0;
+
+      if (write (zlog_async.wakefd[1], &c, 1) < 0)
+	{
+	  /* the writer polls with a timeout anyway */
+	}
+    }
+  return 1;
+}
+
+/* Write out what is queued, from the calling thread. */
+void
+zlog_async_flush (void)
+{
+  if (zlog_async.ring)
+    zlog_async_drain ();
+}
+
+/* Stop the writer: everything queued is written and later messages are
+   written synchronously again. */
+void
+zlog_async_stop (void)
+{
+  int state;
+
+  pthread_mutex_lock (&zlog_async.start_lock);
+  state = __atomic_exchange_n (&zlog_async.state, ZLOG_ASYNC_SYNC,
+			       __ATOMIC_SEQ_CST);
+  if (state == ZLOG_ASYNC_RUNNING
+      && !pthread_equal (pthread_self (), zlog_async.thread))
+    {
+      char c = 0;
+
+      if (write (zlog_async.wakefd[1], &c, 1) >= 0)
+	pthread_join (zlog_async.thread, NULL);
+    }
+  pthread_mutex_unlock (&zlog_async.start_lock);
+  zlog_async_flush ();
+}
+
+/* Number of queued and dropped messages; returns whether the writer runs. */
+int
+zlog_async_stats (unsigned long *queued, unsigned long *dropped)
+{
+  *queued = __atomic_load_n (&zlog_async.tail, __ATOMIC_RELAXED)
+	    - __atomic_load_n (&zlog_async.head, __ATOMIC_RELAXED);
+  *dropped = __atomic_load_n (&zlog_async.dropped, __ATOMIC_RELAXED);
+  return __atomic_load_n (&zlog_async.state, __ATOMIC_RELAXED)
+	 == ZLOG_ASYNC_RUNNING;
+}
+
+static char *str_append(char *dst, int len, const char *src);
+
+/* Dump what is still queued straight to fd on a fatal signal, without
+   timestamps (strftime is not async-signal-safe), and stop queueing. */
+static void
+zlog_async_dump_sigsafe (int fd)
+{
+  struct zlog_record *rec;
+  unsigned long pos;
+  char buf[ZLOG_MSG_MAX + 32];
+  char *s;
+
+  __atomic_store_n (&zlog_async.state, ZLOG_ASYNC_SYNC, __ATOMIC_SEQ_CST);
+  if (!zlog_async.ring || fd < 0)
+    return;
+  for (pos = __atomic_load_n (&zlog_async.head, __ATOMIC_RELAXED); ; pos++)
+    {
+      rec = &zlog_async.ring[pos & (ZLOG_RING_SIZE - 1)];
+      if (__atomic_load_n (&rec->seq, __ATOMIC_ACQUIRE) != pos + 1)
+	break;
+      if (!(rec->dests & ZLOG_ASYNC_FILE))
+	continue;
+      s = str_append (buf, sizeof (buf),
+		      zlog_proto_names[rec->zl->protocol]);
+      s = str_append (s, buf + sizeof (buf) - s, ": ");
+      s = str_append (s, buf + sizeof (buf) - s, rec->msg);
+      s = str_append (s, buf + sizeof (buf) - s, "\n");
+      write (fd, buf, s - buf);
+    }
+}
+#else /* HAVE_LIBPTHREAD */
+#define ZLOG_FILE_LOCK()
+#define ZLOG_FILE_UNLOCK()
+#define zlog_async_queue(zl, priority, format, args)	0
+#define zlog_async_dump_sigsafe(fd)
+
+void
+zlog_async_flush (void)
+{
+}
+
+void
+zlog_async_stop (void)
+{
+}
+
+int
+zlog_async_stats (unsigned long *queued, unsigned long *dropped)
+{
+  *queued = *dropped = 0;
+  return 0;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /* va_list version of zlog. */
 static void
 vzlog (struct zlog *zl, int priority, const char *format, va_list args)
 {
   struct timestamp_control tsctl;
+  int queued;
   tsctl.already_rendered = 0;
 
   /* If zlog is not specified, use default one. */
@@ -173,8 +666,11 @@ vzlog (struct zlog *zl, int priority, const char *format, va_list args)
     }
   tsctl.precision = zl->timestamp_precision;
 
+  /* Syslog and file output go to the writer thread when it runs. */
+  queued = zlog_async_queue (zl, priority, format, args);
+
   /* Syslog output */
-  if (priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
+  if (!queued && priority <= zl->maxlvl[ZLOG_DEST_SYSLOG])
     {
       va_list ac;
       va_copy(ac, args);
@@ -183,7 +679,7 @@ vzlog (struct zlog *zl, int priority, const char *format, va_list args)
     }
 
   /* File output. */
-  if ((priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
+  if (!queued && (priority <= zl->maxlvl[ZLOG_DEST_FILE]) && zl->fp)
     {
       va_list ac;
       time_print (zl->fp, &tsctl);
@@ -369,6 +865,10 @@ zlog_signal(int signo, const char *action
   char *msgstart = buf;
 #define LOC s,buf+sizeof(buf)-s
 
+  /* Messages still queued for the writer thread come first. */
+  if (logfile_fd >= 0)
+    zlog_async_dump_sigsafe(logfile_fd);
+
   time(&now);
   if (zlog_default)
     {
@@ -653,6 +1153,7 @@ void
 _zlog_assert_failed (const char *assertion, const char *file,
 		     unsigned int line, const char *function)
 {
+  zlog_async_stop();
   /* Force fallback file logging? */
   if (zlog_default && !zlog_default->fp &&
       ((logfile_fd = open_crashlog()) >= 0) &&
@@ -695,6 +1196,7 @@ openzlog (const char *progname, zlog_proto_t protocol,
 void
 closezlog (struct zlog *zl)
 {
+  zlog_async_flush();
   closelog();
 
   if (zl->fp != NULL)
@@ -737,10 +1239,12 @@ zlog_set_file (struct zlog *zl, const char *filename, int log_level)
     return 0;
 
   /* Set flags. */
+  ZLOG_FILE_LOCK();
   zl->filename = strdup (filename);
   zl->maxlvl[ZLOG_DEST_FILE] = log_level;
   zl->fp = fp;
   logfile_fd = fileno(fp);
+  ZLOG_FILE_UNLOCK();
 
   return 1;
 }
@@ -752,6 +1256,9 @@ zlog_reset_file (struct zlog *zl)
   if (zl == NULL)
     zl = zlog_default;
 
+  /* Queued messages still belong to the old file. */
+  zlog_async_flush();
+  ZLOG_FILE_LOCK();
   if (zl->fp)
     fclose (zl->fp);
   zl->fp = NULL;
@@ -761,6 +1268,7 @@ zlog_reset_file (struct zlog *zl)
   if (zl->filename)
     free (zl->filename);
   zl->filename = NULL;
+  ZLOG_FILE_UNLOCK();
 
   return 1;
 }
@@ -774,6 +1282,8 @@ zlog_rotate (struct zlog *zl)
   if (zl == NULL)
     zl = zlog_default;
 
+  zlog_async_flush();
+  ZLOG_FILE_LOCK();
   if (zl->fp)
     fclose (zl->fp);
   zl->fp = NULL;
@@ -792,6 +1302,7 @@ zlog_rotate (struct zlog *zl)
       umask(oldumask);
       if (zl->fp == NULL)
         {
+	  ZLOG_FILE_UNLOCK();
 	  zlog_err("Log rotate failed: cannot open file %s for append: %s",
 	  	   zl->filename, safe_strerror(save_errno));
 	  return -1;
@@ -799,6 +1310,7 @@ zlog_rotate (struct zlog *zl)
       logfile_fd = fileno(zl->fp);
       zl->maxlvl[ZLOG_DEST_FILE] = level;
     }
+  ZLOG_FILE_UNLOCK();
 
   return 1;
 }
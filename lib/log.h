@@ -135,6 +135,13 @@ extern void plog_debug (struct zlog *, const char *format, ...)
 
 extern void zlog_thread_info (int log_level);
 
+/* File and syslog output is handed to a writer thread when threads are
+   available.  Flush writes out what is queued from the calling thread,
+   stop does that and makes all later output synchronous. */
+extern void zlog_async_flush (void);
+extern void zlog_async_stop (void);
+extern int zlog_async_stats (unsigned long *queued, unsigned long *dropped);
+
 /* Set logging level for the given destination.  If the log_level
    argument is ZLOG_DISABLED, then the destination is disabled.
    This function should not be used for file logging (use zlog_set_file
@@ -22,17 +22,123 @@
 
 #include <zebra.h>
 /* malloc.h is generally obsolete, however GNU Libc mallinfo wants it. */
-#if !defined(HAVE_STDLIB_H) || (defined(GNU_LINUX) && defined(HAVE_MALLINFO))
+#if !defined(HAVE_STDLIB_H) || (defined(GNU_LINUX) && defined(HAVE_MALLINFO)) \
+    || defined(HAVE_MALLOC_USABLE_SIZE)
 #include <malloc.h>
-#endif /* !HAVE_STDLIB_H || HAVE_MALLINFO */
+#endif /* !HAVE_STDLIB_H || HAVE_MALLINFO || HAVE_MALLOC_USABLE_SIZE */
 
 #include "log.h"
 #include "memory.h"
+#include "linklist.h"
+#include "vector.h"
+#include "prefix.h"
+#include "table.h"
+#include "command.h"
 
-static void alloc_inc (int);
-static void alloc_dec (int);
+static void alloc_inc (int, size_t);
+static void alloc_dec (int, size_t);
 static void log_memstats(int log_priority);
 
+/* Size-class pool for a hot, fixed-size memory type.  Objects are
+   carved from slabs and recycled through a free list; slabs are never
+   handed back to malloc. */
+struct mpool
+{
+  int type;
+
+  /* Object size, rounded up to MPOOL_ALIGN. */
+  size_t size;
+
+  unsigned char lock;
+
+  /* Free objects, linked through their first word. */
+  void *free;
+
+  /* Unused tail of the newest slab. */
+  char *cur;
+  char *end;
+
+  unsigned long slabs;
+  unsigned long used;
+};
+
+#define MPOOL_SLAB_SIZE   16384
+#define MPOOL_ALIGN       8
+#define MPOOL_ROUND(size) (((size) + MPOOL_ALIGN - 1) & ~(MPOOL_ALIGN - 1))
+
+#define MPOOL_LOCK(pool) \
+  while (__atomic_test_and_set (&(pool)->lock, __ATOMIC_ACQUIRE))
+#define MPOOL_UNLOCK(pool) \
+  __atomic_clear (&(pool)->lock, __ATOMIC_RELEASE)
+
+static struct mpool mpools[] =
+{
+  { MTYPE_CMD_TOKEN,	MPOOL_ROUND (sizeof (struct cmd_token))		},
+  { MTYPE_LINK_NODE,	MPOOL_ROUND (sizeof (struct listnode))		},
+  { MTYPE_VECTOR,	MPOOL_ROUND (sizeof (struct _vector))		},
+  { MTYPE_ROUTE_NODE,	MPOOL_ROUND (sizeof (struct route_node))	},
+};
+
+/* Every allocation of these types must fit the pool object size. */
+static struct mpool * const mpool_of[MTYPE_MAX] =
+{
+  [MTYPE_CMD_TOKEN]	= &mpools[0],
+  [MTYPE_LINK_NODE]	= &mpools[1],
+  [MTYPE_VECTOR]	= &mpools[2],
+  [MTYPE_ROUTE_NODE]	= &mpools[3],
+};
+
+static void *
+mpool_alloc (struct mpool *pool)
+{
+  void *obj;
+
+  MPOOL_LOCK (pool);
+  if ((obj = pool->free) != NULL)
+    pool->free = *(void **) obj;
+  else
+    {
+      if (pool->cur == NULL || pool->cur + pool->size > pool->end)
+	{
+	  pool->cur = malloc (MPOOL_SLAB_SIZE);
+	  if (pool->cur == NULL)
+	    {
+	      MPOOL_UNLOCK (pool);
+	      return NULL;
+	    }
+	  pool->end = pool->cur + MPOOL_SLAB_SIZE;
+	  pool->slabs++;
+	}
+      obj = pool->cur;
+      pool->cur += pool->size;
+    }
+  pool->used++;
+  MPOOL_UNLOCK (pool);
+
+  return obj;
+}
+
+static void
+mpool_free (struct mpool *pool, void *obj)
+{
+  MPOOL_LOCK (pool);
+  *(void **) obj = pool->free;
+  pool->free = obj;
+  pool->used--;
+  MPOOL_UNLOCK (pool);
+}
+
+/* Bytes held by a malloc block, 0 if the allocator can't tell. */
+static size_t
+zsize (void *ptr)
+{
+#ifdef HAVE_MALLOC_USABLE_SIZE
+  return malloc_usable_size (ptr);
+#else
+  return 0;
+#endif /* HAVE_MALLOC_USABLE_SIZE */
+}
+
 static const struct message mstr [] =
 {
   { MTYPE_THREAD, "thread" },
@@ -67,13 +173,20 @@ void *
 zmalloc (int type, size_t size)
 {
   void *memory;
+  struct mpool *pool = mpool_of[type];
 
-  memory = malloc (size);
+  if (pool)
+    {
+      assert (size <= pool->size);
+      memory = mpool_alloc (pool);
+    }
+  else
+    memory = malloc (size);
 
   if (memory == NULL)
     zerror ("malloc", type, size);
 
-  alloc_inc (type);
+  alloc_inc (type, pool ? pool->size : zsize (memory));
 
   return memory;
 }
@@ -85,13 +198,22 @@ void *
 zcalloc (int type, size_t size)
 {
   void *memory;
+  struct mpool *pool = mpool_of[type];
 
-  memory = calloc (1, size);
+  if (pool)
+    {
+      assert (size <= pool->size);
+      memory = mpool_alloc (pool);
+      if (memory)
+	memset (memory, 0, size);
+    }
+  else
+    memory = calloc (1, size);
 
   if (memory == NULL)
     zerror ("calloc", type, size);
 
-  alloc_inc (type);
+  alloc_inc (type, pool ? pool->size : zsize (memory));
 
   return memory;
 }
@@ -100,19 +222,28 @@ zcalloc (int type, size_t size)
  * Given a pointer returned by zmalloc or zcalloc, free it and
  * return a pointer to a new size, basically acting like realloc().
  * Requires: ptr was returned by zmalloc, zcalloc, or zrealloc with the
- * same type.
+ * same type, and type is not a pooled type.
  * Effects: Returns a pointer to the new memory, or aborts.
  */
 void *
 zrealloc (int type, void *ptr, size_t size)
 {
   void *memory;
+  size_t old_size;
+
+  assert (mpool_of[type] == NULL);
 
+  old_size = ptr ? zsize (ptr) : 0;
   memory = realloc (ptr, size);
   if (memory == NULL)
     zerror ("realloc", type, size);
   if (ptr == NULL)
-    alloc_inc (type);
+    alloc_inc (type, zsize (memory));
+  else
+    {
+      alloc_dec (type, old_size);
+      alloc_inc (type, zsize (memory));
+    }
 
   return memory;
 }
@@ -126,9 +257,19 @@ zrealloc (int type, void *ptr, size_t size)
 void
 zfree (int type, void *ptr)
 {
-  if (ptr != NULL)
+  struct mpool *pool = mpool_of[type];
+
+  if (ptr == NULL)
+    return;
+
+  if (pool)
     {
-      alloc_dec (type);
+      alloc_dec (type, pool->size);
+      mpool_free (pool, ptr);
+    }
+  else
+    {
+      alloc_dec (type, zsize (ptr));
       free (ptr);
     }
 }
@@ -144,10 +285,12 @@ zstrdup (int type, const char *str)
 {
   void *dup;
 
+  assert (mpool_of[type] == NULL);
+
   dup = strdup (str);
   if (dup == NULL)
     zerror ("strdup", type, strlen (str));
-  alloc_inc (type);
+  alloc_inc (type, zsize (dup));
   return dup;
 }
 
@@ -156,6 +299,8 @@ static struct
 {
   const char *name;
   long alloc;
+  long bytes;
+  long peak;
   unsigned long t_malloc;
   unsigned long c_malloc;
   unsigned long t_calloc;
@@ -243,21 +388,36 @@ static struct
 {
   char *name;
   long alloc;
+  long bytes;
+  long peak;
 } mstat [MTYPE_MAX];
 #endif /* MEMORY_LOG */
 
-/* Increment allocation counter. */
+/* Increment allocation and byte counters.  The counters are updated
+   atomically, allocations happen on both the CLI and OVSDB threads. */
 static void
-alloc_inc (int type)
+alloc_inc (int type, size_t size)
 {
-  mstat[type].alloc++;
+  long bytes;
+  long peak;
+
+  __atomic_add_fetch (&mstat[type].alloc, 1, __ATOMIC_RELAXED);
+  bytes = __atomic_add_fetch (&mstat[type].bytes, (long) size,
+			      __ATOMIC_RELAXED);
+
+  peak = __atomic_load_n (&mstat[type].peak, __ATOMIC_RELAXED);
+  while (bytes > peak
+	 && !__atomic_compare_exchange_n (&mstat[type].peak, &peak, bytes, 1,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
 }
 
-/* Decrement allocation counter. */
+/* Decrement allocation and byte counters. */
 static void
-alloc_dec (int type)
+alloc_dec (int type, size_t size)
 {
-  mstat[type].alloc--;
+  __atomic_sub_fetch (&mstat[type].alloc, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch (&mstat[type].bytes, (long) size, __ATOMIC_RELAXED);
 }
 
 /* Looking up memory status from vty interface. */
@@ -333,6 +493,9 @@ show_memory_vty (struct vty *vty, struct memory_list *list)
 {
   struct memory_list *m;
   int needsep = 0;
+  int header = 0;
+  char live[MTYPE_MEMSTR_LEN];
+  char peak[MTYPE_MEMSTR_LEN];
 
   for (m = list; m->index >= 0; m++)
     if (m->index == 0)
@@ -345,12 +508,57 @@ show_memory_vty (struct vty *vty, struct memory_list *list)
       }
     else if (mstat[m->index].alloc)
       {
-	vty_out (vty, "%-30s: %10ld\r\n", m->format, mstat[m->index].alloc);
+	if (!header)
+	  {
+	    vty_out (vty, "%-30s: %10s %10s %10s\r\n",
+		     "Type", "Allocs", "Live", "Peak");
+	    header = 1;
+	  }
+	vty_out (vty, "%-30s: %10ld %10s %10s\r\n", m->format,
+		 mstat[m->index].alloc,
+		 mtype_memstr (live, MTYPE_MEMSTR_LEN, mstat[m->index].bytes),
+		 mtype_memstr (peak, MTYPE_MEMSTR_LEN, mstat[m->index].peak));
 	needsep = 1;
       }
   return needsep;
 }
 
+/* Name of a memory type, for places that only have the index. */
+static const char *
+mtype_name (int type)
+{
+  struct mlist *ml;
+  struct memory_list *m;
+
+  for (ml = mlists; ml->list; ml++)
+    for (m = ml->list; m->index >= 0; m++)
+      if (m->index == type)
+	return m->format;
+  return "Unknown";
+}
+
+static int
+show_memory_pools (struct vty *vty)
+{
+  struct mpool *pool;
+  unsigned long capacity;
+  char held[MTYPE_MEMSTR_LEN];
+
+  vty_out (vty, "Memory pools:%s", VTY_NEWLINE);
+  for (pool = mpools; pool < mpools + array_size (mpools); pool++)
+    {
+      capacity = pool->slabs * (MPOOL_SLAB_SIZE / pool->size);
+      vty_out (vty, "  %-28s: %4lu bytes, %8lu/%-8lu in use (%3lu%%), %s%s",
+	       mtype_name (pool->type), (unsigned long) pool->size,
+	       pool->used, capacity,
+	       capacity ? pool->used * 100 / capacity : 0,
+	       mtype_memstr (held, MTYPE_MEMSTR_LEN,
+			     pool->slabs * MPOOL_SLAB_SIZE),
+	       VTY_NEWLINE);
+    }
+  return 1;
+}
+
 #ifdef HAVE_MALLINFO
 static int
 show_memory_mallinfo (struct vty *vty)
@@ -405,6 +613,10 @@ DEFUN (show_memory_all,
 #ifdef HAVE_MALLINFO
   needsep = show_memory_mallinfo (vty);
 #endif /* HAVE_MALLINFO */
+
+  if (needsep)
+    show_separator (vty);
+  needsep = show_memory_pools (vty);
   
   for (ml = mlists; ml->list; ml++)
     {
@@ -572,6 +784,20 @@ memory_init (void)
   install_element (ENABLE_NODE, &show_memory_pim_cmd);
 }
 
+/* Install only the commands that describe the local process.  Used
+   by vtysh, which has no protocol daemons behind it to report on. */
+void
+memory_init_local (void)
+{
+  install_element (VIEW_NODE, &show_memory_cmd);
+  install_element (VIEW_NODE, &show_memory_all_cmd);
+  install_element (VIEW_NODE, &show_memory_lib_cmd);
+
+  install_element (ENABLE_NODE, &show_memory_cmd);
+  install_element (ENABLE_NODE, &show_memory_all_cmd);
+  install_element (ENABLE_NODE, &show_memory_lib_cmd);
+}
+
 /* Stats querying from users */
 /* Return a pointer to a human friendly string describing
  * the byte count passed in. E.g:
@@ -403,16 +403,279 @@ prefix_ipv4_free (struct prefix_ipv4 *p)
   prefix_free((struct prefix *)p);
 }
 
+/* Address and prefix text conversion.
+
+   These run for every route in show and sort paths, so they work in
+   place on the string and never allocate.  The parsers return a pointer
+   just past what they consumed, or NULL. */
+
+/* Decimal dotted quad without leading zeros, the form we print. */
+static const char *
+parse_ipv4 (const char *str, u_char *addr)
+{
+  unsigned int val;
+  int i, n;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (i && *str++ != '.')
+	return NULL;
+      val = 0;
+      for (n = 0; n < 4 && (unsigned int) (str[n] - '0') < 10; n++)
+	val = val * 10 + (str[n] - '0');
+      if (n == 0 || n > 3 || val > 255 || (n > 1 && *str == '0'))
+	return NULL;
+      addr[i] = val;
+      str += n;
+    }
+  return str;
+}
+
+#ifdef HAVE_IPV6
+static int
+hexval (int c)
+{
+  if ((unsigned int) (c - '0') < 10)
+    return c - '0';
+  c |= 0x20;
+  if ((unsigned int) (c - 'a') < 6)
+    return c - 'a' + 10;
+  return -1;
+}
+
+/* IPv6 text as accepted by inet_pton(), up to '\0' or '/'. */
+static const char *
+parse_ipv6 (const char *str, u_char *addr)
+{
+  u_char buf[16];
+  u_char *tp = buf, *colonp = NULL;
+  const u_char *endp = buf + 16;
+  const char *curtok;
+  unsigned int val = 0;
+  int digits = 0, d, n;
+
+  if (*str == ':' && *++str != ':')
+    return NULL;
+
+  curtok = str;
+  for (; *str != '\0' && *str != '/'; str++)
+    {
+      if ((d = hexval (*str)) >= 0)
+	{
+	  if (++digits > 4)
+	    return NULL;
+	  val = (val << 4) | d;
+	  continue;
+	}
+      if (*str == ':')
+	{
+	  curtok = str + 1;
+	  if (digits == 0)
+	    {
+	      if (colonp)
+		return NULL;
+	      colonp = tp;
+	      continue;
+	    }
+	  if (*curtok == '\0' || *curtok == '/' || tp + 2 > endp)
+	    return NULL;
+	  *tp++ = val >> 8;
+	  *tp++ = val;
+	  digits = 0;
+	  val = 0;
+	  continue;
+	}
+      if (*str == '.' && tp + 4 <= endp
+	  && (str = parse_ipv4 (curtok, tp)) != NULL
+	  && (*str == '\0' || *str == '/'))
+	{
+	  tp += 4;
+	  digits = 0;
+	  break;
+	}
+      return NULL;
+    }
+
+  if (digits)
+    {
+      if (tp + 2 > endp)
+	return NULL;
+      *tp++ = val >> 8;
+      *tp++ = val;
+    }
+  if (colonp)
+    {
+      if (tp == endp)
+	return NULL;
+      n = tp - colonp;
+      memmove (buf + 16 - n, colonp, n);
+      memset (colonp, 0, buf + 16 - n - colonp);
+      tp = buf + 16;
+    }
+  if (tp != endp)
+    return NULL;
+
+  memcpy (addr, buf, 16);
+  return str;
+}
+#endif /* HAVE_IPV6 */
+
+/* Prefix length after the '/', which must end the string. */
+static int
+parse_prefixlen (const char *str, int max)
+{
+  int val = 0;
+
+  if (*str == '\0')
+    return -1;
+  for (; *str != '\0'; str++)
+    {
+      if ((unsigned int) (*str - '0') >= 10)
+	return -1;
+      val = val * 10 + (*str - '0');
+      if (val > max)
+	return -1;
+    }
+  return val;
+}
+
+static char *
+format_ipv4 (const u_char *addr, char *buf)
+{
+  unsigned int v;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (i)
+	*buf++ = '.';
+      v = addr[i];
+      if (v >= 100)
+	{
+	  *buf++ = '0' + v / 100;
+	  v %= 100;
+	  *buf++ = '0' + v / 10;
+	}
+      else if (v >= 10)
+	*buf++ = '0' + v / 10;
+      *buf++ = '0' + v % 10;
+    }
+  *buf = '\0';
+  return buf;
+}
+
+/* Same output as glibc's inet_ntop(): the first longest run of two or
+   more zero words is compressed, and ::a.b.c.d / ::ffff:a.b.c.d keep
+   their dotted quad. */
+static char *
+format_ipv6 (const u_char *addr, char *buf)
+{
+  static const char hex[] = "0123456789abcdef";
+  unsigned int words[8], w;
+  int best = -1, bestlen = 0, cur = -1, curlen = 0;
+  int i;
+
+  for (i = 0; i < 8; i++)
+    {
+      words[i] = (addr[2 * i] << 8) | addr[2 * i + 1];
+      if (words[i] == 0)
+	{
+	  if (cur < 0)
+	    cur = i, curlen = 0;
+	  if (++curlen > bestlen)
+	    best = cur, bestlen = curlen;
+	}
+      else
+	cur = -1;
+    }
+  if (bestlen < 2)
+    best = -1;
+
+  for (i = 0; i < 8; i++)
+    {
+      if (i == best)
+	{
+	  *buf++ = ':';
+	  i += bestlen - 1;
+	  if (i == 7)
+	    *buf++ = ':';
+	  continue;
+	}
+      if (i)
+	*buf++ = ':';
+      if (i == 6 && best == 0
+	  && (bestlen == 6 || (bestlen == 5 && words[5] == 0xffff)))
+	return format_ipv4 (addr + 12, buf);
+      w = words[i];
+      if (w >= 0x1000)
+	*buf++ = hex[w >> 12];
+      if (w >= 0x100)
+	*buf++ = hex[(w >> 8) & 0xf];
+      if (w >= 0x10)
+	*buf++ = hex[(w >> 4) & 0xf];
+      *buf++ = hex[w & 0xf];
+    }
+  *buf = '\0';
+  return buf;
+}
+
+/* inet_ntop() for AF_INET and AF_INET6 without going through stdio. */
+const char *
+prefix_ntop (int family, const void *src, char *dst, size_t size)
+{
+  char buf[INET6_ADDRSTRLEN];
+  char *end;
+
+  if (family == AF_INET)
+    end = format_ipv4 (src, buf);
+  else if (family == AF_INET6)
+    end = format_ipv6 (src, buf);
+  else
+    return inet_ntop (family, src, dst, size);
+
+  if ((size_t) (end - buf) >= size)
+    {
+      errno = ENOSPC;
+      return NULL;
+    }
+  memcpy (dst, buf, end - buf + 1);
+  return dst;
+}
+
+/* Parse "A.B.C.D[/M]" in canonical form only.  Returns 1 on success. */
+int
+str2prefix_ipv4_strict (const char *str, struct prefix_ipv4 *p)
+{
+  const char *pnt;
+  int plen = IPV4_MAX_BITLEN;
+
+  if ((pnt = parse_ipv4 (str, (u_char *) &p->prefix)) == NULL)
+    return 0;
+  if (*pnt == '/')
+    plen = parse_prefixlen (pnt + 1, IPV4_MAX_PREFIXLEN);
+  else if (*pnt != '\0')
+    return 0;
+  if (plen < 0)
+    return 0;
+
+  p->family = AF_INET;
+  p->prefixlen = plen;
+  return 1;
+}
+
 /* When string format is invalid return 0. */
 int
 str2prefix_ipv4 (const char *str, struct prefix_ipv4 *p)
 {
   int ret;
   int plen;
-  char *pnt;
-  char *cp;
+  const char *pnt;
+  char buf[INET_ADDRSTRLEN + 16];
 
-  /* Find slash inside string. */
+  if (str2prefix_ipv4_strict (str, p))
+    return 1;
+
+  /* inet_aton() also takes the classic short, octal and hex forms. */
   pnt = strchr (str, '/');
 
   /* String doesn't contail slash. */
@@ -431,15 +694,15 @@ str2prefix_ipv4 (const char *str, struct prefix_ipv4 *p)
     }
   else
     {
-      cp = XMALLOC (MTYPE_TMP, (pnt - str) + 1);
-      strncpy (cp, str, pnt - str);
-      *(cp + (pnt - str)) = '\0';
-      ret = inet_aton (cp, &p->prefix);
-      XFREE (MTYPE_TMP, cp);
+      if ((size_t) (pnt - str) >= sizeof (buf))
+	return 0;
+      memcpy (buf, str, pnt - str);
+      buf[pnt - str] = '\0';
+      ret = inet_aton (buf, &p->prefix);
 
       /* Get prefix length. */
-      plen = (u_char) atoi (++pnt);
-      if (plen > IPV4_MAX_PREFIXLEN)
+      plen = parse_prefixlen (++pnt, IPV4_MAX_PREFIXLEN);
+      if (plen < 0)
 	return 0;
 
       p->family = AF_INET;
@@ -517,43 +780,33 @@ prefix_ipv6_free (struct prefix_ipv6 *p)
   prefix_free((struct prefix *)p);
 }
 
-/* If given string is valid return pin6 else return NULL */
+/* Parse "X:X::X:X[/M]".  IPv6 text has a single form, so this is
+   what str2prefix_ipv6() does too. */
 int
-str2prefix_ipv6 (const char *str, struct prefix_ipv6 *p)
+str2prefix_ipv6_strict (const char *str, struct prefix_ipv6 *p)
 {
-  char *pnt;
-  char *cp;
-  int ret;
+  const char *pnt;
+  int plen = IPV6_MAX_BITLEN;
 
-  pnt = strchr (str, '/');
+  if ((pnt = parse_ipv6 (str, p->prefix.s6_addr)) == NULL)
+    return 0;
 
   /* If string doesn't contain `/' treat it as host route. */
-  if (pnt == NULL) 
-    {
-      ret = inet_pton (AF_INET6, str, &p->prefix);
-      if (ret == 0)
-	return 0;
-      p->prefixlen = IPV6_MAX_BITLEN;
-    }
-  else 
-    {
-      int plen;
+  if (*pnt == '/')
+    plen = parse_prefixlen (pnt + 1, IPV6_MAX_BITLEN);
+  if (plen < 0)
+    return 0;
 
-      cp = XMALLOC (0, (pnt - str) + 1);
-      strncpy (cp, str, pnt - str);
-      *(cp + (pnt - str)) = '\0';
-      ret = inet_pton (AF_INET6, cp, &p->prefix);
-      free (cp);
-      if (ret == 0)
-	return 0;
-      plen = (u_char) atoi (++pnt);
-      if (plen > IPV6_MAX_BITLEN)
-	return 0;
-      p->prefixlen = plen;
-    }
   p->family = AF_INET6;
+  p->prefixlen = plen;
+  return 1;
+}
 
-  return ret;
+/* If given string is valid return pin6 else return NULL */
+int
+str2prefix_ipv6 (const char *str, struct prefix_ipv6 *p)
+{
+  return str2prefix_ipv6_strict (str, p);
 }
 
 /* Convert struct in6_addr netmask into integer.
@@ -764,9 +1017,36 @@ int
 prefix2str (const struct prefix *p, char *str, int size)
 {
   char buf[BUFSIZ];
+  char *end;
+  unsigned int plen = p->prefixlen;
 
-  inet_ntop (p->family, &p->u.prefix, buf, BUFSIZ);
-  snprintf (str, size, "%s/%d", buf, p->prefixlen);
+  if (p->family == AF_INET)
+    end = format_ipv4 (&p->u.prefix, buf);
+#ifdef HAVE_IPV6
+  else if (p->family == AF_INET6)
+    end = format_ipv6 (&p->u.prefix, buf);
+#endif /* HAVE_IPV6 */
+  else
+    {
+      inet_ntop (p->family, &p->u.prefix, buf, BUFSIZ);
+      snprintf (str, size, "%s/%d", buf, p->prefixlen);
+      return 0;
+    }
+
+  *end++ = '/';
+  if (plen >= 100)
+    *end++ = '0' + plen / 100;
+  if (plen >= 10)
+    *end++ = '0' + (plen / 10) % 10;
+  *end++ = '0' + plen % 10;
+
+  /* Truncate as snprintf() would. */
+  if (size <= 0)
+    return 0;
+  if (end - buf >= size)
+    end = buf + size - 1;
+  memcpy (str, buf, end - buf);
+  str[end - buf] = '\0';
   return 0;
 }
 
@@ -900,7 +1180,7 @@ inet6_ntoa (struct in6_addr addr)
 {
   static char buf[INET6_ADDRSTRLEN];
 
-  inet_ntop (AF_INET6, &addr, buf, INET6_ADDRSTRLEN);
+  format_ipv6 (addr.s6_addr, buf);
   return buf;
 }
 #endif /* HAVE_IPV6 */
@@ -170,6 +170,7 @@ extern const char *prefix_family_str (const struct prefix *);
 extern int prefix_blen (const struct prefix *);
 extern int str2prefix (const char *, struct prefix *);
 extern int prefix2str (const struct prefix *, char *, int);
+extern const char *prefix_ntop (int, const void *, char *, size_t);
 extern int prefix_match (const struct prefix *, const struct prefix *);
 extern int prefix_same (const struct prefix *, const struct prefix *);
 extern int prefix_cmp (const struct prefix *, const struct prefix *);
@@ -185,6 +186,7 @@ extern void prefix2sockunion (const struct prefix *, union sockunion *);
 extern struct prefix_ipv4 *prefix_ipv4_new (void);
 extern void prefix_ipv4_free (struct prefix_ipv4 *);
 extern int str2prefix_ipv4 (const char *, struct prefix_ipv4 *);
+extern int str2prefix_ipv4_strict (const char *, struct prefix_ipv4 *);
 extern void apply_mask_ipv4 (struct prefix_ipv4 *);
 
 #define PREFIX_COPY_IPV4(DST, SRC)	\
@@ -209,6 +211,7 @@ extern int netmask_str2prefix_str (const char *, const char *, char *);
 extern struct prefix_ipv6 *prefix_ipv6_new (void);
 extern void prefix_ipv6_free (struct prefix_ipv6 *);
 extern int str2prefix_ipv6 (const char *, struct prefix_ipv6 *);
+extern int str2prefix_ipv6_strict (const char *, struct prefix_ipv6 *);
 extern void apply_mask_ipv6 (struct prefix_ipv6 *);
 
 #define PREFIX_COPY_IPV6(DST, SRC)	\
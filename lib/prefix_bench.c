@@ -0,0 +1,213 @@
+/* Prefix parsing and formatting microbenchmark.
+ * Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+ *
+ * This file is part of GNU Zebra.
+ *
+ * GNU Zebra is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * GNU Zebra is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Zebra; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times str2prefix (), prefix2str () and the prefix matching of the
+   command parser over a corpus of prefixes, one per line.  It only uses
+   the prefix.h API and two functions, bench_ipv4_prefix_match () and
+   bench_ipv6_prefix_match (), that prefix_bench.sh extracts from
+   command.c, so that it can be linked against any version of those.
+
+   usage: prefix_bench -g [count]    print a corpus, half IPv4, half IPv6
+          prefix_bench corpus        time the functions over it */
+
+#include <zebra.h>
+
+#include "prefix.h"
+#include "memory.h"
+#include "log.h"
+
+extern int bench_ipv4_prefix_match (const char *);
+extern int bench_ipv6_prefix_match (const char *);
+
+/* prefix.c is linked on its own, without memory.c and log.c. */
+void *
+zmalloc (int type, size_t size)
+{
+  return malloc (size);
+}
+
+void *
+zcalloc (int type, size_t size)
+{
+  return calloc (1, size);
+}
+
+void *
+zrealloc (int type, void *ptr, size_t size)
+{
+  return realloc (ptr, size);
+}
+
+void
+zfree (int type, void *ptr)
+{
+  free (ptr);
+}
+
+char *
+zstrdup (int type, const char *str)
+{
+  return strdup (str);
+}
+
+void
+zlog (struct zlog *zl, int priority, const char *format, ...)
+{
+}
+
+void
+_zlog_assert_failed (const char *assertion, const char *file,
+		     unsigned int line, const char *function)
+{
+  fprintf (stderr, "%s:%u: %s: assertion %s failed\n",
+	   file, line, function, assertion);
+  abort ();
+}
+
+/* xorshift64, so that every run generates the same corpus. */
+static unsigned long long
+bench_random (void)
+{
+  static unsigned long long x = 88172645463325252ULL;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return x;
+}
+
+/* An IPv6 address with the zero runs and small groups of real ones. */
+static void
+bench_random_ipv6 (struct in6_addr *addr)
+{
+  unsigned char *a = (unsigned char *) addr;
+  unsigned int w;
+  int i, r;
+
+  for (i = 0; i < 16; i += 2)
+    {
+      r = bench_random () % 4;
+      w = r < 2 ? 0
+	  : r == 2 ? bench_random () % 16 : bench_random () & 0xffff;
+      a[i] = w >> 8;
+      a[i + 1] = w;
+    }
+  /* Some v4-mapped and v4-compatible addresses. */
+  if (bench_random () % 8 == 0)
+    {
+      memset (a, 0, 10);
+      a[10] = a[11] = (bench_random () & 1) ? 0xff : 0;
+    }
+}
+
+static void
+bench_generate (unsigned long count)
+{
+  char buf[INET6_ADDRSTRLEN];
+  struct in6_addr addr6;
+  unsigned long i;
+  unsigned int v;
+
+  for (i = 0; i < count; i++)
+    if (i & 1)
+      {
+	bench_random_ipv6 (&addr6);
+	inet_ntop (AF_INET6, &addr6, buf, sizeof buf);
+	printf ("%s/%d\n", buf, (int) (bench_random () % 129));
+      }
+    else
+      {
+	v = bench_random ();
+	printf ("%u.%u.%u.%u/%d\n", v >> 24, (v >> 16) & 255,
+		(v >> 8) & 255, v & 255, (int) (bench_random () % 33));
+      }
+}
+
+static double
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int
+main (int argc, char **argv)
+{
+  char (*corpus)[64] = NULL;
+  struct prefix *prefixes;
+  char buf[64];
+  size_t n = 0, size = 0, i;
+  double start;
+  long sink = 0;
+  FILE *fp;
+
+  if (argc > 1 && strcmp (argv[1], "-g") == 0)
+    {
+      bench_generate (argc > 2 ? strtoul (argv[2], NULL, 10) : 1000000);
+      return 0;
+    }
+  if (argc != 2 || (fp = fopen (argv[1], "r")) == NULL)
+    {
+      fprintf (stderr, "usage: %s -g [count] | %s corpus\n",
+	       argv[0], argv[0]);
+      return 1;
+    }
+
+  while (fgets (buf, sizeof buf, fp))
+    {
+      buf[strcspn (buf, "\n")] = '\0';
+      if (n == size)
+	{
+	  size = size ? size * 2 : 4096;
+	  corpus = realloc (corpus, size * sizeof *corpus);
+	}
+      strcpy (corpus[n++], buf);
+    }
+  fclose (fp);
+  if (n == 0)
+    return 1;
+  prefixes = calloc (n, sizeof *prefixes);
+
+  start = now_ns ();
+  for (i = 0; i < n; i++)
+    sink += str2prefix (corpus[i], &prefixes[i]);
+  printf ("str2prefix    %6.1f ns\n", (now_ns () - start) / n);
+
+  start = now_ns ();
+  for (i = 0; i < n; i++)
+    {
+      prefix2str (&prefixes[i], buf, sizeof buf);
+      sink += buf[1];
+    }
+  printf ("prefix2str    %6.1f ns\n", (now_ns () - start) / n);
+
+  start = now_ns ();
+  for (i = 0; i < n; i++)
+    sink += strchr (corpus[i], ':') ? bench_ipv6_prefix_match (corpus[i])
+				    : bench_ipv4_prefix_match (corpus[i]);
+  printf ("prefix match  %6.1f ns\n", (now_ns () - start) / n);
+
+  free (prefixes);
+  free (corpus);
+  return sink == 42;
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Compares str2prefix(), prefix2str() and the prefix matching of the
+# command parser with the versions that went through inet_pton(),
+# inet_ntop() and heap copies, by building prefix_bench.c against each.
+# usage: lib/prefix_bench.sh [old-revision [count]]
+#
+# Run from the top of a configured and built tree, in a git checkout.  The
+# old prefix.c, prefix.h and command.c are taken from old-revision, by
+# default the one before str2prefix_ipv4_strict() was introduced.  Both
+# builds time the same corpus of count prefixes, 1000000 by default.
+# CC and CFLAGS are honoured.
+
+top=$(pwd)
+cc=${CC:-cc}
+cflags=${CFLAGS:--O2}
+old=$1
+count=${2:-1000000}
+
+if [ -z "$old" ]; then
+    old=$(git log --reverse --format=%H -S str2prefix_ipv4_strict \
+          -- lib/prefix.h | head -n 1)~1
+fi
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' 0
+
+# cmd_ipv4_prefix_match() and cmd_ipv6_prefix_match() are static, so
+# they are copied out of command.c with what they need.
+extract() {
+    {
+        echo '#include <zebra.h>'
+        echo '#include "prefix.h"'
+        awk '/^enum match_type$/ { p = 1 } p { print } /^};/ { p = 0 }' "$1"
+        grep -E '^#define[ 	]+(IPV6_ADDR_STR|IPV6_PREFIX_STR|STATE_)' "$1"
+        awk '/^static enum match_type$/ { hold = $0; next }
+             /^cmd_ipv[46]_prefix_match \(/ { p = 1; print hold }
+             p { print }
+             /^}/ { p = 0 }
+             { hold = "" }' "$1"
+        echo 'int bench_ipv4_prefix_match (const char *s)'
+        echo '{ return cmd_ipv4_prefix_match (s); }'
+        echo 'int bench_ipv6_prefix_match (const char *s)'
+        echo '{ return cmd_ipv6_prefix_match (s); }'
+    } > "$2/match.c"
+}
+
+# prefix_bench.c and match.c include "prefix.h" from their own
+# directory, so each build gets its own copy.
+mkdir "$tmp/old" "$tmp/new" &&
+git show "$old:lib/prefix.c" > "$tmp/old/prefix.c" &&
+git show "$old:lib/prefix.h" > "$tmp/old/prefix.h" &&
+git show "$old:lib/command.c" > "$tmp/old/command.c" &&
+cp lib/prefix.c lib/prefix.h lib/command.c "$tmp/new/" || exit 1
+
+for v in old new; do
+    extract "$tmp/$v/command.c" "$tmp/$v" &&
+    cp lib/prefix_bench.c "$tmp/$v/" &&
+    $cc $cflags -DHAVE_CONFIG_H -I"$tmp/$v" -I"$top" -I"$top/lib" \
+        -o "$tmp/$v/prefix_bench" "$tmp/$v/prefix_bench.c" \
+        "$tmp/$v/prefix.c" "$tmp/$v/match.c" || exit 1
+done
+
+"$tmp/new/prefix_bench" -g "$count" > "$tmp/corpus" || exit 1
+
+echo "old ($old):"
+"$tmp/old/prefix_bench" "$tmp/corpus"
+echo "new:"
+"$tmp/new/prefix_bench" "$tmp/corpus"
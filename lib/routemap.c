@@ -24,6 +24,7 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "linklist.h"
 #include "memory.h"
 #include "vector.h"
+#include "hash.h"
 #include "prefix.h"
 #include "routemap.h"
 #include "command.h"
@@ -53,6 +54,37 @@ struct route_map_rule
   struct route_map_rule *prev;
 };
 
+/* Rule with its apply function and compiled value bound together. */
+struct route_map_bound_rule
+{
+  route_map_result_t (*func_apply)(void *, struct prefix *,
+				   route_map_object_t, void *);
+  void *value;
+};
+
+/* Compiled route map index.  Rules are copied into flat arrays and
+   the "call" and "on-match goto" targets are resolved, so applying an
+   index needs neither list walks nor name lookups.  A chain is valid
+   only while its generation matches route_map_generation. */
+struct route_map_chain
+{
+  unsigned int generation;
+
+  /* Match rules, cheap ones first where reordering is safe. */
+  struct route_map_bound_rule *match;
+  unsigned int match_count;
+
+  /* Set rules in configured order. */
+  struct route_map_bound_rule *set;
+  unsigned int set_count;
+
+  /* Resolved "call" target, NULL if it does not exist. */
+  struct route_map *nextrm;
+
+  /* Resolved "on-match goto" target, NULL if it runs off the end. */
+  struct route_map_index *goto_index;
+};
+
 #ifndef ENABLE_OVSDB
 /* Making route map list. */
 struct route_map_list
@@ -71,11 +103,40 @@ static struct route_map_list route_map_master = { NULL, NULL, NULL, NULL };
 struct route_map_list route_map_master = { NULL, NULL, NULL, NULL };
 #endif
 
+/* Route map name to route map. */
+static struct hash *route_map_master_hash;
+
+/* Bumped on every route map change; compiled chains with an older
+   generation are rebuilt on next use. */
+static unsigned int route_map_generation = 1;
+
+#define ROUTE_MAP_CHANGED() (route_map_generation++)
 
 static void
 route_map_rule_delete (struct route_map_rule_list *,
 		       struct route_map_rule *);
 
+#ifndef ENABLE_OVSDB
+static void route_map_index_delete (struct route_map_index *, int);
+#endif
+
+static unsigned int
+route_map_hash_key_make (void *p)
+{
+  const struct route_map *map = p;
+
+  return string_hash_make (map->name);
+}
+
+static int
+route_map_hash_cmp (const void *p1, const void *p2)
+{
+  const struct route_map *map1 = p1;
+  const struct route_map *map2 = p2;
+
+  return strcmp (map1->name, map2->name) == 0;
+}
+
 /* New route map allocation. Please note route map's name must be
    specified. */
 static struct route_map *
@@ -106,6 +167,9 @@ route_map_add (const char *name)
     list->head = map;
   list->tail = map;
 
+  hash_get (route_map_master_hash, map, hash_alloc_intern);
+  ROUTE_MAP_CHANGED ();
+
   /* Execute hook. */
   if (route_map_master.add_hook)
     (*route_map_master.add_hook) (name);
@@ -142,6 +206,9 @@ route_map_delete (struct route_map *map)
   else
     list->head = map->next;
 
+  hash_release (route_map_master_hash, map);
+  ROUTE_MAP_CHANGED ();
+
   XFREE (MTYPE_ROUTE_MAP, map);
 
   /* Execute deletion hook. */
@@ -157,12 +224,12 @@ route_map_delete (struct route_map *map)
 struct route_map *
 route_map_lookup_by_name (const char *name)
 {
-  struct route_map *map;
+  struct route_map key;
 
-  for (map = route_map_master.head; map; map = map->next)
-    if (strcmp (map->name, name) == 0)
-      return map;
-  return NULL;
+  /* temporary reference */
+  key.name = (char *)name;
+
+  return hash_lookup (route_map_master_hash, &key);
 }
 
 /* Lookup route map.  If there isn't route map create one and return
@@ -329,6 +396,10 @@ route_map_index_delete (struct route_map_index *index, int notify)
   if (index->nextrm)
     XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
 
+  if (index->chain)
+    XFREE (MTYPE_ROUTE_MAP_CHAIN, index->chain);
+  ROUTE_MAP_CHANGED ();
+
     /* Execute event hook. */
   if (route_map_master.event_hook && notify)
     (*route_map_master.event_hook) (RMAP_EVENT_INDEX_DELETED,
@@ -399,6 +470,8 @@ route_map_index_add (struct route_map *map, enum route_map_type type,
       point->prev = index;
     }
 
+  ROUTE_MAP_CHANGED ();
+
   /* Execute event hook. */
   if (route_map_master.event_hook)
     (*route_map_master.event_hook) (RMAP_EVENT_INDEX_ADDED,
@@ -490,6 +563,8 @@ route_map_rule_add (struct route_map_rule_list *list,
   else
     list->head = rule;
   list->tail = rule;
+
+  ROUTE_MAP_CHANGED ();
 }
 
 /* Delete rule from rule list. */
@@ -512,6 +587,8 @@ route_map_rule_delete (struct route_map_rule_list *list,
   else
     list->head = rule->next;
 
+  ROUTE_MAP_CHANGED ();
+
   XFREE (MTYPE_ROUTE_MAP_RULE, rule);
 }
 
@@ -754,32 +831,103 @@ route_map_delete_set (struct route_map_index *index, const char *set_name,
    We need to make sure our route-map processing matches the above
 */
 
+/* Copy a rule list into a flat array of bound rules. */
+static unsigned int
+route_map_chain_bind (struct route_map_bound_rule *bound,
+                      struct route_map_rule_list *list)
+{
+  struct route_map_rule *rule;
+  unsigned int n = 0;
+
+  for (rule = list->head; rule; rule = rule->next)
+    {
+      bound[n].func_apply = rule->cmd->func_apply;
+      bound[n].value = rule->value;
+      n++;
+    }
+  return n;
+}
+
+/* Return the compiled chain for the index, rebuilding it if any route
+   map changed since it was built. */
+static struct route_map_chain *
+route_map_index_chain (struct route_map_index *index)
+{
+  struct route_map_chain *chain;
+  struct route_map_rule *rule;
+  struct route_map_index *next;
+  unsigned int count = 0;
+
+  if (index->chain && index->chain->generation == route_map_generation)
+    return index->chain;
+
+  for (rule = index->match_list.head; rule; rule = rule->next)
+    count++;
+  for (rule = index->set_list.head; rule; rule = rule->next)
+    count++;
+
+  if (index->chain)
+    XFREE (MTYPE_ROUTE_MAP_CHAIN, index->chain);
+
+  /* Chain and both rule arrays share one allocation. */
+  chain = XCALLOC (MTYPE_ROUTE_MAP_CHAIN,
+                   sizeof (struct route_map_chain)
+                   + sizeof (struct route_map_bound_rule) * count);
+  chain->generation = route_map_generation;
+
+  chain->match = (struct route_map_bound_rule *) (chain + 1);
+  chain->match_count = route_map_chain_bind (chain->match, &index->match_list);
+
+  chain->set = chain->match + chain->match_count;
+  chain->set_count = route_map_chain_bind (chain->set, &index->set_list);
+
+  if (index->nextrm)
+    chain->nextrm = route_map_lookup_by_name (index->nextrm);
+
+  if (index->exitpolicy == RMAP_GOTO)
+    {
+      for (next = index->next; next; next = next->next)
+        if (next->pref >= index->nextpref)
+          break;
+      chain->goto_index = next;
+    }
+
+  index->chain = chain;
+  return chain;
+}
+
+/* Compile every index of the route map.  route_map_apply () does this
+   lazily, calling it up front just moves the cost out of the first
+   lookup. */
+void
+route_map_compile (struct route_map *map)
+{
+  struct route_map_index *index;
+
+  for (index = map->head; index; index = index->next)
+    route_map_index_chain (index);
+}
+
 static route_map_result_t
-route_map_apply_match (struct route_map_rule_list *match_list,
+route_map_apply_match (struct route_map_chain *chain,
                        struct prefix *prefix, route_map_object_t type,
                        void *object)
 {
-  route_map_result_t ret = RMAP_NOMATCH;
-  struct route_map_rule *match;
-
+  route_map_result_t ret = RMAP_MATCH;
+  unsigned int i;
 
   /* Check all match rule and if there is no match rule, go to the
      set statement. */
-  if (!match_list->head)
-    ret = RMAP_MATCH;
-  else
+  for (i = 0; i < chain->match_count; i++)
     {
-      for (match = match_list->head; match; match = match->next)
-        {
-          /* Try each match statement in turn, If any do not return
-             RMAP_MATCH, return, otherwise continue on to next match
-             statement. All match statements must match for end-result
-             to be a match. */
-          ret = (*match->cmd->func_apply) (match->value, prefix,
+      /* Try each match statement in turn, If any do not return
+         RMAP_MATCH, return, otherwise continue on to next match
+         statement. All match statements must match for end-result
+         to be a match. */
+      ret = (*chain->match[i].func_apply) (chain->match[i].value, prefix,
                                            type, object);
-          if (ret != RMAP_MATCH)
-            return ret;
-        }
+      if (ret != RMAP_MATCH)
+        return ret;
     }
   return ret;
 }
@@ -791,8 +939,10 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
 {
   static int recursion = 0;
   int ret = 0;
+  unsigned int i;
   struct route_map_index *index;
-  struct route_map_rule *set;
+  struct route_map_index *next;
+  struct route_map_chain *chain;
 
   if (recursion > RMAP_RECURSION_LIMIT)
     {
@@ -806,10 +956,13 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
   if (map == NULL)
     return RMAP_DENYMATCH;
 
-  for (index = map->head; index; index = index->next)
+  for (index = map->head; index; index = next)
     {
+      next = index->next;
+      chain = route_map_index_chain (index);
+
       /* Apply this index. */
-      ret = route_map_apply_match (&index->match_list, prefix, type, object);
+      ret = route_map_apply_match (chain, prefix, type, object);
 
       /* Now we apply the matrix from above */
       if (ret == RMAP_NOMATCH)
@@ -821,20 +974,18 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
             /* 'action' */
             {
               /* permit+match must execute sets */
-              for (set = index->set_list.head; set; set = set->next)
-                ret = (*set->cmd->func_apply) (set->value, prefix,
-                                               type, object);
+              for (i = 0; i < chain->set_count; i++)
+                ret = (*chain->set[i].func_apply) (chain->set[i].value,
+                                                   prefix, type, object);
 
               /* Call another route-map if available */
               if (index->nextrm)
                 {
-                  struct route_map *nextrm =
-                                    route_map_lookup_by_name (index->nextrm);
-
-                  if (nextrm) /* Target route-map found, jump to it */
+                  if (chain->nextrm) /* Target route-map found, jump to it */
                     {
                       recursion++;
-                      ret = route_map_apply (nextrm, prefix, type, object);
+                      ret = route_map_apply (chain->nextrm, prefix,
+                                             type, object);
                       recursion--;
                     }
 
@@ -850,22 +1001,11 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
                   case RMAP_NEXT:
                     continue;
                   case RMAP_GOTO:
-                    {
-                      /* Find the next clause to jump to */
-                      struct route_map_index *next = index->next;
-                      int nextpref = index->nextpref;
-
-                      while (next && next->pref < nextpref)
-                        {
-                          index = next;
-                          next = next->next;
-                        }
-                      if (next == NULL)
-                        {
-                          /* No clauses match! */
-                          return ret;
-                        }
-                    }
+                    /* No clauses match! */
+                    if (chain->goto_index == NULL)
+                      return ret;
+                    next = chain->goto_index;
+                    break;
                 }
             }
           else if (index->type == RMAP_DENY)
@@ -879,6 +1019,24 @@ route_map_apply (struct route_map *map, struct prefix *prefix,
   return RMAP_DENYMATCH;
 }
 
+/* Apply route map to each of count prefixes, storing one result per
+   prefix.  objects may be NULL when the match and set rules in use do
+   not need one.  The map is compiled once for the whole batch. */
+void
+route_map_apply_batch (struct route_map *map, struct prefix *prefixes,
+                       void **objects, route_map_result_t *results,
+                       unsigned int count, route_map_object_t type)
+{
+  unsigned int i;
+
+  if (map)
+    route_map_compile (map);
+
+  for (i = 0; i < count; i++)
+    results[i] = route_map_apply (map, &prefixes[i], type,
+                                  objects ? objects[i] : NULL);
+}
+
 void
 route_map_add_hook (void (*func) (const char *))
 {
@@ -903,6 +1061,9 @@ route_map_init (void)
   /* Make vector for match and set. */
   route_match_vec = vector_init (1);
   route_set_vec = vector_init (1);
+
+  route_map_master_hash = hash_create (route_map_hash_key_make,
+                                       route_map_hash_cmp);
 }
 
 void
@@ -912,6 +1073,10 @@ route_map_finish (void)
   route_match_vec = NULL;
   vector_free (route_set_vec);
   route_set_vec = NULL;
+
+  hash_clean (route_map_master_hash, NULL);
+  hash_free (route_map_master_hash);
+  route_map_master_hash = NULL;
 }
 
 /* VTY related functions. */
@@ -1066,7 +1231,10 @@ DEFUN (rmap_onmatch_next,
   index = vty->index;
 
   if (index)
-    index->exitpolicy = RMAP_NEXT;
+    {
+      index->exitpolicy = RMAP_NEXT;
+      ROUTE_MAP_CHANGED ();
+    }
 
   return CMD_SUCCESS;
 }
@@ -1083,7 +1251,10 @@ DEFUN (no_rmap_onmatch_next,
   index = vty->index;
 
   if (index)
-    index->exitpolicy = RMAP_EXIT;
+    {
+      index->exitpolicy = RMAP_EXIT;
+      ROUTE_MAP_CHANGED ();
+    }
 
   return CMD_SUCCESS;
 }
@@ -1116,6 +1287,7 @@ DEFUN (rmap_onmatch_goto,
 	{
 	  index->exitpolicy = RMAP_GOTO;
 	  index->nextpref = d;
+	  ROUTE_MAP_CHANGED ();
 	}
     }
   return CMD_SUCCESS;
@@ -1133,7 +1305,10 @@ DEFUN (no_rmap_onmatch_goto,
   index = vty->index;
 
   if (index)
-    index->exitpolicy = RMAP_EXIT;
+    {
+      index->exitpolicy = RMAP_EXIT;
+      ROUTE_MAP_CHANGED ();
+    }
 
   return CMD_SUCCESS;
 }
@@ -1197,6 +1372,7 @@ DEFUN (rmap_call,
       if (index->nextrm)
           XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
       index->nextrm = XSTRDUP (MTYPE_ROUTE_MAP_NAME, argv[0]);
+      ROUTE_MAP_CHANGED ();
     }
   return CMD_SUCCESS;
 }
@@ -1215,6 +1391,7 @@ DEFUN (no_rmap_call,
     {
       XFREE (MTYPE_ROUTE_MAP_NAME, index->nextrm);
       index->nextrm = NULL;
+      ROUTE_MAP_CHANGED ();
     }
 
   return CMD_SUCCESS;
@@ -100,6 +100,9 @@ enum
   RMAP_COMPILE_ERROR
 };
 
+/* Compiled form of a route map index, private to routemap.c. */
+struct route_map_chain;
+
 /* Route map rule list. */
 struct route_map_rule_list
 {
@@ -132,6 +135,9 @@ struct route_map_index
   struct route_map_rule_list match_list;
   struct route_map_rule_list set_list;
 
+  /* Flat rule arrays and resolved targets, see route_map_compile (). */
+  struct route_map_chain *chain;
+
   /* Make linked list. */
   struct route_map_index *next;
   struct route_map_index *prev;
@@ -192,6 +198,17 @@ extern route_map_result_t route_map_apply (struct route_map *map,
                                            route_map_object_t object_type,
                                            void *object);
 
+/* Compile every index of the route map into flat rule chains. */
+extern void route_map_compile (struct route_map *map);
+
+/* Apply route map to an array of prefixes and their objects. */
+extern void route_map_apply_batch (struct route_map *map,
+                                   struct prefix *prefixes,
+                                   void **objects,
+                                   route_map_result_t *results,
+                                   unsigned int count,
+                                   route_map_object_t object_type);
+
 extern void route_map_add_hook (void (*func) (const char *));
 extern void route_map_delete_hook (void (*func) (const char *));
 extern void route_map_event_hook (void (*func) (route_map_event_t, const char *));
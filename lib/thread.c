@@ -27,10 +27,14 @@
 #include "memory.h"
 #include "log.h"
 #include "hash.h"
-#include "pqueue.h"
 #include "command.h"
 #include "sigevent.h"
 
+#include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #if defined HAVE_SNMP && defined SNMP_AGENTX
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
@@ -84,24 +88,6 @@ timeval_adjust (struct timeval a)
   return a;
 }
 
-static struct timeval
-timeval_subtract (struct timeval a, struct timeval b)
-{
-  struct timeval ret;
-
-  ret.tv_usec = a.tv_usec - b.tv_usec;
-  ret.tv_sec = a.tv_sec - b.tv_sec;
-
-  return timeval_adjust (ret);
-}
-
-static long
-timeval_cmp (struct timeval a, struct timeval b)
-{
-  return (a.tv_sec == b.tv_sec
-	  ? a.tv_usec - b.tv_usec : a.tv_sec - b.tv_sec);
-}
-
 unsigned long
 timeval_elapsed (struct timeval a, struct timeval b)
 {
@@ -497,27 +483,508 @@ DEFUN(clear_thread_cpu,
   return CMD_SUCCESS;
 }
 
+/* Timer wheel.
+
+   Timers are kept in a hierarchical timing wheel with a tick of one
+   millisecond: a first level of 256 slots, one tick each, and four more
+   levels of 64 slots each spanning 2^8, 2^14, 2^20 and 2^26 ticks per
+   slot, which covers about 49 days.  Adding and cancelling a timer are
+   O(1); whenever the first level wraps, the current slot of the next
+   level is cascaded down into the lower levels.  Timers expiring in the
+   same tick run in the order they were added. */
+#define WHEEL_L0_BITS	8
+#define WHEEL_LN_BITS	6
+#define WHEEL_L0_SIZE	(1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE	(1 << WHEEL_LN_BITS)
+#define WHEEL_LEVELS	5
+#define WHEEL_SLOTS	(WHEEL_L0_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LN_SIZE)
+#define WHEEL_HORIZON	0xffffffffULL
+
+/* First slot and slot width (as a shift of ticks) of a level >= 1. */
+#define WHEEL_BASE(L)	(WHEEL_L0_SIZE + ((L) - 1) * WHEEL_LN_SIZE)
+#define WHEEL_SHIFT(L)	(WHEEL_L0_BITS + ((L) - 1) * WHEEL_LN_BITS)
+
+struct thread_wheel
+{
+  uint64_t tick;		/* next tick to expire, in msec */
+  unsigned int count;		/* timers in the wheel */
+  uint64_t busy[WHEEL_SLOTS / 64]; /* bitmap of non-empty slots */
+  struct thread_list slot[WHEEL_SLOTS];
+};
+
+/* Read and write threads of one file descriptor. */
+struct thread_fd
+{
+  struct thread *read;
+  struct thread *write;
+  int pollidx;			/* index in m->pollfds, or -1 */
+};
+
+/* Maximum number of descriptors taken from one epoll_wait(). */
+#define THREAD_EPOLL_EVENTS 64
+
+static void thread_list_add (struct thread_list *, struct thread *);
+static struct thread *thread_list_delete (struct thread_list *,
+					  struct thread *);
+
+/* Current relative time in ticks, rounded down. */
+static uint64_t
+thread_now_msec (void)
+{
+  return (uint64_t) relative_time.tv_sec * 1000
+	 + relative_time.tv_usec / 1000;
+}
+
+/* Tick at which a timer expires, rounded up so it never fires early. */
+static uint64_t
+thread_sands_msec (struct timeval sands)
+{
+  return (uint64_t) sands.tv_sec * 1000 + (sands.tv_usec + 999) / 1000;
+}
+
+/* First non-empty slot in [start, end) of a bitmap, or end. */
+static int thread_wheel_next (struct thread_wheel *, uint64_t *);
+
 static int
-thread_timer_cmp(void *a, void *b)
+thread_wheel_find (const uint64_t *busy, int start, int end)
+{
+  uint64_t word;
+  int i;
+
+  for (i = start; i < end; i = (i | 63) + 1)
+    {
+      word = busy[i / 64] >> (i % 64);
+      if (word)
+	{
+	  i += __builtin_ctzll (word);
+	  return i < end ? i : end;
+	}
+    }
+  return end;
+}
+
+static void
+thread_wheel_add (struct thread_wheel *w, struct thread *thread)
 {
-  struct thread *thread_a = a;
-  struct thread *thread_b = b;
+  uint64_t expires = thread_sands_msec (thread->u.sands);
+  uint64_t delta;
+  int level, slot;
+
+  if (expires < w->tick)
+    expires = w->tick;
+  delta = expires - w->tick;
+  if (delta > WHEEL_HORIZON)
+    {
+      delta = WHEEL_HORIZON;
+      expires = w->tick + delta;
+    }
 
-  long cmp = timeval_cmp(thread_a->u.sands, thread_b->u.sands);
+  if (delta < WHEEL_L0_SIZE)
+    slot = expires & (WHEEL_L0_SIZE - 1);
+  else
+    {
+      for (level = 1; level < WHEEL_LEVELS - 1; level++)
+	if (delta < (1ULL << WHEEL_SHIFT (level + 1)))
+	  break;
+      slot = WHEEL_BASE (level)
+	     + ((expires >> WHEEL_SHIFT (level)) & (WHEEL_LN_SIZE - 1));
+    }
 
-  if (cmp < 0)
-    return -1;
-  if (cmp > 0)
-    return 1;
-  return 0;
+  thread->index = slot;
+  thread_list_add (&w->slot[slot], thread);
+  w->busy[slot / 64] |= 1ULL << (slot % 64);
+  w->count++;
 }
 
 static void
-thread_timer_update(void *node, int actual_position)
+thread_wheel_delete (struct thread_wheel *w, struct thread *thread)
 {
-  struct thread *thread = node;
+  int slot = thread->index;
 
-  thread->index = actual_position;
+  assert (slot >= 0 && slot < WHEEL_SLOTS);
+  thread_list_delete (&w->slot[slot], thread);
+  if (w->slot[slot].count == 0)
+    w->busy[slot / 64] &= ~(1ULL << (slot % 64));
+  w->count--;
+  thread->index = -1;
+}
+
+/* Re-add the timers of the current slot of a level to the wheel, which
+   puts them in lower levels.  Returns the index of that slot. */
+static int
+thread_wheel_cascade (struct thread_wheel *w, int level)
+{
+  int idx = (w->tick >> WHEEL_SHIFT (level)) & (WHEEL_LN_SIZE - 1);
+  int slot = WHEEL_BASE (level) + idx;
+  struct thread_list list = w->slot[slot];
+  struct thread *thread, *next;
+
+  if (list.count == 0)
+    return idx;
+
+  w->slot[slot].head = w->slot[slot].tail = NULL;
+  w->slot[slot].count = 0;
+  w->busy[slot / 64] &= ~(1ULL << (slot % 64));
+  w->count -= list.count;
+
+  for (thread = list.head; thread; thread = next)
+    {
+      next = thread->next;
+      thread_wheel_add (w, thread);
+    }
+  return idx;
+}
+
+/* Move all timers expired by tick 'now' to the ready list. */
+static unsigned int
+thread_wheel_expire (struct thread_master *m, struct thread_wheel *w,
+		     uint64_t now)
+{
+  struct thread *thread;
+  unsigned int ready = 0;
+  uint64_t next;
+  int idx, level;
+
+  while (w->count && w->tick <= now)
+    {
+      idx = w->tick & (WHEEL_L0_SIZE - 1);
+      if (idx == 0)
+	for (level = 1; level < WHEEL_LEVELS; level++)
+	  if (thread_wheel_cascade (w, level) != 0)
+	    break;
+
+      while ((thread = w->slot[idx].head) != NULL)
+	{
+	  thread_list_delete (&w->slot[idx], thread);
+	  thread->index = -1;
+	  w->count--;
+	  thread->type = THREAD_READY;
+	  thread_list_add (&m->ready, thread);
+	  ready++;
+	}
+      w->busy[idx / 64] &= ~(1ULL << (idx % 64));
+
+      /* Skip the ticks with nothing to expire or cascade. */
+      w->tick++;
+      if (thread_wheel_next (w, &next) && next > w->tick)
+	w->tick = next < now + 1 ? next : now + 1;
+    }
+  if (w->tick <= now)
+    w->tick = now + 1;
+  return ready;
+}
+
+/* Earliest tick at which the wheel has work to do: the exact expiry
+   for timers in the first level, the next cascade otherwise. */
+static int
+thread_wheel_next (struct thread_wheel *w, uint64_t *next)
+{
+  uint64_t best = UINT64_MAX, word, t, span;
+  int idx, i, level;
+
+  if (w->count == 0)
+    return 0;
+
+  /* Cascades only happen when the first level wraps, so a timer in
+     the rest of this lap is always first. */
+  idx = w->tick & (WHEEL_L0_SIZE - 1);
+  i = thread_wheel_find (w->busy, idx, WHEEL_L0_SIZE);
+  if (i < WHEEL_L0_SIZE)
+    {
+      *next = w->tick + (i - idx);
+      return 1;
+    }
+  i = thread_wheel_find (w->busy, 0, idx);
+  if (i < idx)
+    best = w->tick + (WHEEL_L0_SIZE - idx) + i;
+
+  for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+      span = WHEEL_SHIFT (level) + WHEEL_LN_BITS;
+      for (word = w->busy[WHEEL_BASE (level) / 64]; word; word &= word - 1)
+	{
+	  i = __builtin_ctzll (word);
+	  t = (w->tick & ~((1ULL << span) - 1))
+	      | ((uint64_t) i << WHEEL_SHIFT (level));
+	  if (t < w->tick)
+	    t += 1ULL << span;
+	  if (t < best)
+	    best = t;
+	}
+    }
+  *next = best;
+  return 1;
+}
+
+static void
+thread_wheel_free (struct thread_master *m, struct thread_wheel *w)
+{
+  struct thread *t, *next;
+  int i;
+
+  for (i = 0; i < WHEEL_SLOTS; i++)
+    for (t = w->slot[i].head; t; t = next)
+      {
+	next = t->next;
+	XFREE (MTYPE_THREAD, t);
+	m->alloc--;
+      }
+  XFREE (MTYPE_THREAD_MASTER, w);
+}
+
+/* Descriptor bookkeeping.  m->fds maps a descriptor to its read and
+   write threads.  With epoll, descriptors are registered EPOLLONESHOT
+   and re-armed whenever their wanted events change, so a descriptor
+   closed and reused behind our back is simply added again.  Without
+   epoll, m->pollfds is the poll() set, kept dense by moving the last
+   entry into any hole. */
+static void
+thread_fd_grow (struct thread_master *m, int fd)
+{
+  int size = m->fds_size ? m->fds_size : 64;
+  int i;
+
+  while (size <= fd)
+    size *= 2;
+  m->fds = XREALLOC (MTYPE_THREAD_MASTER, m->fds,
+		     size * sizeof (struct thread_fd));
+  for (i = m->fds_size; i < size; i++)
+    {
+      m->fds[i].read = m->fds[i].write = NULL;
+      m->fds[i].pollidx = -1;
+    }
+  m->fds_size = size;
+}
+
+/* Tell the backend which events are now wanted on fd. */
+static void
+thread_fd_update (struct thread_master *m, int fd)
+{
+  struct thread_fd *tfd = &m->fds[fd];
+  short events = (tfd->read ? POLLIN : 0) | (tfd->write ? POLLOUT : 0);
+  int idx, last;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (m->epoll_fd >= 0)
+    {
+      struct epoll_event ev;
+
+      memset (&ev, 0, sizeof (ev));
+      ev.data.fd = fd;
+      ev.events = EPOLLONESHOT
+		  | (tfd->read ? EPOLLIN : 0) | (tfd->write ? EPOLLOUT : 0);
+
+      /* The descriptor may already be closed; nothing to undo then. */
+      if (! events)
+	epoll_ctl (m->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+      else if (epoll_ctl (m->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0
+	       && (errno != ENOENT
+		   || epoll_ctl (m->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0))
+	zlog_warn ("epoll_ctl() error on fd %d: %s", fd,
+		   safe_strerror (errno));
+      return;
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+
+  idx = tfd->pollidx;
+  if (events)
+    {
+      if (idx < 0)
+	{
+	  if (m->pollfds_count == m->pollfds_size)
+	    {
+	      m->pollfds_size = m->pollfds_size ? m->pollfds_size * 2 : 64;
+	      m->pollfds = XREALLOC (MTYPE_THREAD_MASTER, m->pollfds,
+				     m->pollfds_size * sizeof (struct pollfd));
+	    }
+	  idx = tfd->pollidx = m->pollfds_count++;
+	  m->pollfds[idx].fd = fd;
+	}
+      m->pollfds[idx].events = events;
+      m->pollfds[idx].revents = 0;
+    }
+  else if (idx >= 0)
+    {
+      last = --m->pollfds_count;
+      if (idx != last)
+	{
+	  m->pollfds[idx] = m->pollfds[last];
+	  m->fds[m->pollfds[idx].fd].pollidx = idx;
+	}
+      tfd->pollidx = -1;
+    }
+}
+
+/* Move the threads of a ready descriptor to the ready list. */
+static unsigned int
+thread_fd_ready (struct thread_master *m, int fd, int readable, int writable)
+{
+  struct thread_fd *tfd = &m->fds[fd];
+  struct thread *thread;
+  unsigned int ready = 0;
+
+  if (readable && (thread = tfd->read) != NULL)
+    {
+      tfd->read = NULL;
+      thread_list_delete (&m->read, thread);
+      thread->type = THREAD_READY;
+      thread_list_add (&m->ready, thread);
+      ready++;
+    }
+  if (writable && (thread = tfd->write) != NULL)
+    {
+      tfd->write = NULL;
+      thread_list_delete (&m->write, thread);
+      thread->type = THREAD_READY;
+      thread_list_add (&m->ready, thread);
+      ready++;
+    }
+  return ready;
+}
+
+/* Wait for I/O for at most timeout msec (-1 for ever).  Returns the
+   number of backend results to hand to thread_process_io(). */
+static int
+thread_wait_io (struct thread_master *m, int timeout)
+{
+#if defined HAVE_SNMP && defined SNMP_AGENTX
+  /* When SNMP is enabled, we may have to wait on additional fds.
+     snmp_select_info() adds them to an fd_set which we append to the
+     poll() set; with epoll we poll the epoll fd itself along with them.
+     The trick with snmp_select_info() is its last argument: we need to
+     set it to 0 if we have a timeout and use the provided new timer
+     only if it is still set to 0. */
+  if (agentx_enabled)
+    {
+      struct timeval snmp_timer_wait;
+      struct pollfd *pfd;
+      fd_set snmpfd;
+      int snmpblock = 1;
+      int fdsetsize = 0;
+      int own, npfd, num, fd, i;
+
+      FD_ZERO (&snmpfd);
+      if (timeout >= 0)
+	{
+	  snmpblock = 0;
+	  snmp_timer_wait.tv_sec = timeout / 1000;
+	  snmp_timer_wait.tv_usec = (timeout % 1000) * 1000;
+	}
+      snmp_select_info (&fdsetsize, &snmpfd, &snmp_timer_wait, &snmpblock);
+      if (snmpblock == 0)
+	timeout = snmp_timer_wait.tv_sec * 1000
+		  + (snmp_timer_wait.tv_usec + 999) / 1000;
+
+      own = m->epoll_fd >= 0 ? 1 : m->pollfds_count;
+      pfd = XMALLOC (MTYPE_TMP, (own + fdsetsize) * sizeof (struct pollfd));
+      if (m->epoll_fd >= 0)
+	{
+	  pfd[0].fd = m->epoll_fd;
+	  pfd[0].events = POLLIN;
+	}
+      else if (own)
+	memcpy (pfd, m->pollfds, own * sizeof (struct pollfd));
+      for (npfd = own, fd = 0; fd < fdsetsize; fd++)
+	if (FD_ISSET (fd, &snmpfd))
+	  {
+	    pfd[npfd].fd = fd;
+	    pfd[npfd++].events = POLLIN;
+	  }
+
+      num = poll (pfd, npfd, timeout);
+      if (num < 0)
+	{
+	  XFREE (MTYPE_TMP, pfd);
+	  return -1;
+	}
+
+      FD_ZERO (&snmpfd);
+      for (i = own; i < npfd; i++)
+	if (pfd[i].revents)
+	  FD_SET (pfd[i].fd, &snmpfd);
+      if (num > 0)
+	snmp_read (&snmpfd);
+      else
+	{
+	  snmp_timeout ();
+	  run_alarms ();
+	}
+      netsnmp_check_outstanding_agent_requests ();
+
+      num = 0;
+#ifdef HAVE_SYS_EPOLL_H
+      if (m->epoll_fd >= 0)
+	{
+	  if (pfd[0].revents)
+	    num = epoll_wait (m->epoll_fd, m->events, THREAD_EPOLL_EVENTS, 0);
+	}
+      else
+#endif /* HAVE_SYS_EPOLL_H */
+      for (i = 0; i < own; i++)
+	if ((m->pollfds[i].revents = pfd[i].revents) != 0)
+	  num++;
+
+      XFREE (MTYPE_TMP, pfd);
+      return num;
+    }
+#endif /* HAVE_SNMP && SNMP_AGENTX */
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (m->epoll_fd >= 0)
+    return epoll_wait (m->epoll_fd, m->events, THREAD_EPOLL_EVENTS, timeout);
+#endif /* HAVE_SYS_EPOLL_H */
+  return poll (m->pollfds, m->pollfds_count, timeout);
+}
+
+/* Move the threads of descriptors reported ready to the ready list. */
+static unsigned int
+thread_process_io (struct thread_master *m, int num)
+{
+  unsigned int ready = 0;
+  int i, fd;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (m->epoll_fd >= 0)
+    {
+      struct epoll_event *ev = m->events;
+      struct thread_fd *tfd;
+
+      for (i = 0; i < num; i++)
+	{
+	  fd = ev[i].data.fd;
+	  if (fd >= m->fds_size)
+	    continue;
+	  ready += thread_fd_ready (m, fd,
+				    ev[i].events & (EPOLLIN | EPOLLHUP
+						    | EPOLLERR),
+				    ev[i].events & (EPOLLOUT | EPOLLERR));
+	  /* One-shot: re-arm for whatever is still wanted. */
+	  tfd = &m->fds[fd];
+	  if (tfd->read || tfd->write)
+	    thread_fd_update (m, fd);
+	}
+      return ready;
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+
+  /* Entries may move down as descriptors are dropped from the set, so
+     walk it backwards. */
+  for (i = m->pollfds_count - 1; i >= 0 && num > 0; i--)
+    {
+      short revents = m->pollfds[i].revents;
+
+      if (! revents)
+	continue;
+      num--;
+      fd = m->pollfds[i].fd;
+      m->pollfds[i].revents = 0;
+      ready += thread_fd_ready (m, fd,
+				revents & (POLLIN | POLLHUP | POLLERR
+					   | POLLNVAL),
+				revents & (POLLOUT | POLLERR | POLLNVAL));
+      thread_fd_update (m, fd);
+    }
+  return ready;
 }
 
 /* Allocate new thread master.  */
@@ -533,11 +1000,23 @@ thread_master_create ()
 
   rv = XCALLOC (MTYPE_THREAD_MASTER, sizeof (struct thread_master));
 
-  /* Initialize the timer queues */
-  rv->timer = pqueue_create();
-  rv->background = pqueue_create();
-  rv->timer->cmp = rv->background->cmp = thread_timer_cmp;
-  rv->timer->update = rv->background->update = thread_timer_update;
+  /* Initialize the timer wheels */
+  quagga_get_relative (NULL);
+  rv->timer = XCALLOC (MTYPE_THREAD_MASTER, sizeof (struct thread_wheel));
+  rv->background = XCALLOC (MTYPE_THREAD_MASTER,
+			    sizeof (struct thread_wheel));
+  rv->timer->tick = rv->background->tick = thread_now_msec ();
+
+  rv->epoll_fd = -1;
+#ifdef HAVE_SYS_EPOLL_H
+  rv->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (rv->epoll_fd >= 0)
+    rv->events = XCALLOC (MTYPE_THREAD_MASTER,
+			  THREAD_EPOLL_EVENTS * sizeof (struct epoll_event));
+  else
+    zlog_warn ("epoll_create1() error: %s, falling back to poll()",
+	       safe_strerror (errno));
+#endif /* HAVE_SYS_EPOLL_H */
 
   return rv;
 }
@@ -600,29 +1079,26 @@ thread_list_free (struct thread_master *m, struct thread_list *list)
     }
 }
 
-static void
-thread_queue_free (struct thread_master *m, struct pqueue *queue)
-{
-  int i;
-
-  for (i = 0; i < queue->size; i++)
-    XFREE(MTYPE_THREAD, queue->array[i]);
-
-  m->alloc -= queue->size;
-  pqueue_delete(queue);
-}
-
 /* Stop thread scheduler. */
 void
 thread_master_free (struct thread_master *m)
 {
   thread_list_free (m, &m->read);
   thread_list_free (m, &m->write);
-  thread_queue_free (m, m->timer);
+  thread_wheel_free (m, m->timer);
   thread_list_free (m, &m->event);
   thread_list_free (m, &m->ready);
   thread_list_free (m, &m->unuse);
-  thread_queue_free (m, m->background);
+  thread_wheel_free (m, m->background);
+
+  if (m->epoll_fd >= 0)
+    close (m->epoll_fd);
+  if (m->events)
+    XFREE (MTYPE_THREAD_MASTER, m->events);
+  if (m->pollfds)
+    XFREE (MTYPE_THREAD_MASTER, m->pollfds);
+  if (m->fds)
+    XFREE (MTYPE_THREAD_MASTER, m->fds);
   
   XFREE (MTYPE_THREAD_MASTER, m);
 
@@ -701,16 +1177,21 @@ funcname_thread_add_read (struct thread_master *m,
 
   assert (m != NULL);
 
-  if (FD_ISSET (fd, &m->readfd))
+  assert (fd >= 0);
+
+  if (fd >= m->fds_size)
+    thread_fd_grow (m, fd);
+  else if (m->fds[fd].read)
     {
       zlog (NULL, LOG_WARNING, "There is already read fd [%d]", fd);
       return NULL;
     }
 
   thread = thread_get (m, THREAD_READ, func, arg, debugargpass);
-  FD_SET (fd, &m->readfd);
   thread->u.fd = fd;
   thread_list_add (&m->read, thread);
+  m->fds[fd].read = thread;
+  thread_fd_update (m, fd);
 
   return thread;
 }
@@ -725,16 +1206,21 @@ funcname_thread_add_write (struct thread_master *m,
 
   assert (m != NULL);
 
-  if (FD_ISSET (fd, &m->writefd))
+  assert (fd >= 0);
+
+  if (fd >= m->fds_size)
+    thread_fd_grow (m, fd);
+  else if (m->fds[fd].write)
     {
       zlog (NULL, LOG_WARNING, "There is already write fd [%d]", fd);
       return NULL;
     }
 
   thread = thread_get (m, THREAD_WRITE, func, arg, debugargpass);
-  FD_SET (fd, &m->writefd);
   thread->u.fd = fd;
   thread_list_add (&m->write, thread);
+  m->fds[fd].write = thread;
+  thread_fd_update (m, fd);
 
   return thread;
 }
@@ -748,7 +1234,7 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
 				  debugargdef)
 {
   struct thread *thread;
-  struct pqueue *queue;
+  struct thread_wheel *wheel;
   struct timeval alarm_time;
 
   assert (m != NULL);
@@ -756,16 +1242,18 @@ funcname_thread_add_timer_timeval (struct thread_master *m,
   assert (type == THREAD_TIMER || type == THREAD_BACKGROUND);
   assert (time_relative);
   
-  queue = ((type == THREAD_TIMER) ? m->timer : m->background);
+  wheel = ((type == THREAD_TIMER) ? m->timer : m->background);
   thread = thread_get (m, type, func, arg, debugargpass);
 
   /* Do we need jitter here? */
   quagga_get_relative (NULL);
+  if (wheel->count == 0)
+    wheel->tick = thread_now_msec ();
   alarm_time.tv_sec = relative_time.tv_sec + time_relative->tv_sec;
   alarm_time.tv_usec = relative_time.tv_usec + time_relative->tv_usec;
   thread->u.sands = timeval_adjust(alarm_time);
 
-  pqueue_enqueue(thread, queue);
+  thread_wheel_add (wheel, thread);
   return thread;
 }
 
@@ -854,22 +1342,25 @@ void
 thread_cancel (struct thread *thread)
 {
   struct thread_list *list = NULL;
-  struct pqueue *queue = NULL;
+  struct thread_wheel *wheel = NULL;
+  struct thread_master *m = thread->master;
   
   switch (thread->type)
     {
     case THREAD_READ:
-      assert (FD_ISSET (thread->u.fd, &thread->master->readfd));
-      FD_CLR (thread->u.fd, &thread->master->readfd);
+      assert (m->fds[thread->u.fd].read == thread);
+      m->fds[thread->u.fd].read = NULL;
+      thread_fd_update (m, thread->u.fd);
       list = &thread->master->read;
       break;
     case THREAD_WRITE:
-      assert (FD_ISSET (thread->u.fd, &thread->master->writefd));
-      FD_CLR (thread->u.fd, &thread->master->writefd);
+      assert (m->fds[thread->u.fd].write == thread);
+      m->fds[thread->u.fd].write = NULL;
+      thread_fd_update (m, thread->u.fd);
       list = &thread->master->write;
       break;
     case THREAD_TIMER:
-      queue = thread->master->timer;
+      wheel = thread->master->timer;
       break;
     case THREAD_EVENT:
       list = &thread->master->event;
@@ -878,18 +1369,16 @@ thread_cancel (struct thread *thread)
       list = &thread->master->ready;
       break;
     case THREAD_BACKGROUND:
-      queue = thread->master->background;
+      wheel = thread->master->background;
       break;
     default:
       return;
       break;
     }
 
-  if (queue)
+  if (wheel)
     {
-      assert(thread->index >= 0);
-      assert(thread == queue->array[thread->index]);
-      pqueue_remove_at(thread->index, queue);
+      thread_wheel_delete (wheel, thread);
     }
   else if (list)
     {
@@ -897,7 +1386,7 @@ thread_cancel (struct thread *thread)
     }
   else
     {
-      assert(!"Thread should be either in queue or list!");
+      assert(!"Thread should be either in wheel or list!");
     }
 
   thread->type = THREAD_UNUSED;
@@ -948,16 +1437,26 @@ thread_cancel_event (struct thread_master *m, void *arg)
   return ret;
 }
 
-static struct timeval *
-thread_timer_wait (struct pqueue *queue, struct timeval *timer_val)
+/* Milliseconds until the next timer of either wheel, -1 if none. */
+static int
+thread_timer_wait (struct thread_master *m)
 {
-  if (queue->size)
-    {
-      struct thread *next_timer = queue->array[0];
-      *timer_val = timeval_subtract (next_timer->u.sands, relative_time);
-      return timer_val;
-    }
-  return NULL;
+  uint64_t now = thread_now_msec ();
+  uint64_t next, next_bg;
+  int have, have_bg;
+
+  have = thread_wheel_next (m->timer, &next);
+  have_bg = thread_wheel_next (m->background, &next_bg);
+  if (have_bg && (!have || next_bg < next))
+    next = next_bg;
+  else if (!have)
+    return -1;
+
+  if (next <= now)
+    return 0;
+  if (next - now > INT_MAX)
+    return INT_MAX;
+  return next - now;
 }
 
 static struct thread *
@@ -970,52 +1469,6 @@ thread_run (struct thread_master *m, struct thread *thread,
   return fetch;
 }
 
-static int
-thread_process_fd (struct thread_list *list, fd_set *fdset, fd_set *mfdset)
-{
-  struct thread *thread;
-  struct thread *next;
-  int ready = 0;
-  
-  assert (list);
-  
-  for (thread = list->head; thread; thread = next)
-    {
-      next = thread->next;
-
-      if (FD_ISSET (THREAD_FD (thread), fdset))
-        {
-          assert (FD_ISSET (THREAD_FD (thread), mfdset));
-          FD_CLR(THREAD_FD (thread), mfdset);
-          thread_list_delete (list, thread);
-          thread_list_add (&thread->master->ready, thread);
-          thread->type = THREAD_READY;
-          ready++;
-        }
-    }
-  return ready;
-}
-
-/* Add all timers that have popped to the ready list. */
-static unsigned int
-thread_timer_process (struct pqueue *queue, struct timeval *timenow)
-{
-  struct thread *thread;
-  unsigned int ready = 0;
-  
-  while (queue->size)
-    {
-      thread = queue->array[0];
-      if (timeval_cmp (*timenow, thread->u.sands) < 0)
-        return ready;
-      pqueue_dequeue(queue);
-      thread->type = THREAD_READY;
-      thread_list_add (&thread->master->ready, thread);
-      ready++;
-    }
-  return ready;
-}
-
 /* process a list en masse, e.g. for event thread lists */
 static unsigned int
 thread_process (struct thread_list *list)
@@ -1041,22 +1494,11 @@ struct thread *
 thread_fetch (struct thread_master *m, struct thread *fetch)
 {
   struct thread *thread;
-  fd_set readfd;
-  fd_set writefd;
-  fd_set exceptfd;
-  struct timeval timer_val = { .tv_sec = 0, .tv_usec = 0 };
-  struct timeval timer_val_bg;
-  struct timeval *timer_wait = &timer_val;
-  struct timeval *timer_wait_bg;
+  int timeout = 0;
 
   while (1)
     {
       int num = 0;
-#if defined HAVE_SNMP && defined SNMP_AGENTX
-      struct timeval snmp_timer_wait;
-      int snmpblock = 0;
-      int fdsetsize;
-#endif
       
       /* Signals pre-empt everything */
       quagga_sigevent_process ();
@@ -1075,82 +1517,35 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
       /* Normal event are the next highest priority.  */
       thread_process (&m->event);
       
-      /* Structure copy.  */
-      readfd = m->readfd;
-      writefd = m->writefd;
-      exceptfd = m->exceptfd;
-      
-      /* Calculate select wait timer if nothing else to do */
+      /* Calculate the wait timeout if nothing else to do */
+      timeout = 0;
       if (m->ready.count == 0)
         {
           quagga_get_relative (NULL);
-          timer_wait = thread_timer_wait (m->timer, &timer_val);
-          timer_wait_bg = thread_timer_wait (m->background, &timer_val_bg);
-          
-          if (timer_wait_bg &&
-              (!timer_wait || (timeval_cmp (*timer_wait, *timer_wait_bg) > 0)))
-            timer_wait = timer_wait_bg;
+          timeout = thread_timer_wait (m);
         }
       
-#if defined HAVE_SNMP && defined SNMP_AGENTX
-      /* When SNMP is enabled, we may have to select() on additional
-	 FD. snmp_select_info() will add them to `readfd'. The trick
-	 with this function is its last argument. We need to set it to
-	 0 if timer_wait is not NULL and we need to use the provided
-	 new timer only if it is still set to 0. */
-      if (agentx_enabled)
-        {
-          fdsetsize = FD_SETSIZE;
-          snmpblock = 1;
-          if (timer_wait)
-            {
-              snmpblock = 0;
-              memcpy(&snmp_timer_wait, timer_wait, sizeof(struct timeval));
-            }
-          snmp_select_info(&fdsetsize, &readfd, &snmp_timer_wait, &snmpblock);
-          if (snmpblock == 0)
-            timer_wait = &snmp_timer_wait;
-        }
-#endif
-      num = select (FD_SETSIZE, &readfd, &writefd, &exceptfd, timer_wait);
+      num = thread_wait_io (m, timeout);
       
       /* Signals should get quick treatment */
       if (num < 0)
         {
           if (errno == EINTR)
             continue; /* signal received - process it */
-          zlog_warn ("select() error: %s", safe_strerror (errno));
+          zlog_warn ("%s() error: %s", m->epoll_fd >= 0 ? "epoll_wait" : "poll",
+                     safe_strerror (errno));
             return NULL;
         }
 
-#if defined HAVE_SNMP && defined SNMP_AGENTX
-      if (agentx_enabled)
-        {
-          if (num > 0)
-            snmp_read(&readfd);
-          else if (num == 0)
-            {
-              snmp_timeout();
-              run_alarms();
-            }
-          netsnmp_check_outstanding_agent_requests();
-        }
-#endif
-
       /* Check foreground timers.  Historically, they have had higher
          priority than I/O threads, so let's push them onto the ready
 	 list in front of the I/O threads. */
       quagga_get_relative (NULL);
-      thread_timer_process (m->timer, &relative_time);
+      thread_wheel_expire (m, m->timer, thread_now_msec ());
       
       /* Got IO, process it */
       if (num > 0)
-        {
-          /* Normal priority read thead. */
-          thread_process_fd (&m->read, &readfd, &m->readfd);
-          /* Write thead. */
-          thread_process_fd (&m->write, &writefd, &m->writefd);
-        }
+        thread_process_io (m, num);
 
 #if 0
       /* If any threads were made ready above (I/O or foreground timer),
@@ -1162,7 +1557,7 @@ thread_fetch (struct thread_master *m, struct thread *fetch)
 #endif
 
       /* Background timer/events, lowest priority */
-      thread_timer_process (m->background, &relative_time);
+      thread_wheel_expire (m, m->background, thread_now_msec ());
       
       if ((thread = thread_trim_head (&m->ready)) != NULL)
         return thread_run (m, thread, fetch);
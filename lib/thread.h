@@ -43,21 +43,27 @@ struct thread_list
   int count;
 };
 
-struct pqueue;
+struct thread_wheel;
+struct thread_fd;
+struct pollfd;
 
 /* Master of the theads. */
 struct thread_master
 {
   struct thread_list read;
   struct thread_list write;
-  struct pqueue *timer;
+  struct thread_wheel *timer;
   struct thread_list event;
   struct thread_list ready;
   struct thread_list unuse;
-  struct pqueue *background;
-  fd_set readfd;
-  fd_set writefd;
-  fd_set exceptfd;
+  struct thread_wheel *background;
+  struct thread_fd *fds;	/* read/write threads, indexed by fd */
+  int fds_size;
+  int epoll_fd;			/* -1 when poll() is used instead */
+  void *events;			/* epoll_wait() results */
+  struct pollfd *pollfds;	/* poll() set, when not using epoll */
+  int pollfds_count;
+  int pollfds_size;
   unsigned long alloc;
 };
 
@@ -78,7 +84,7 @@ struct thread
     int fd;			/* file descriptor in case of read/write. */
     struct timeval sands;	/* rest of time sands value. */
   } u;
-  int index;			/* used for timers to store position in queue */
+  int index;			/* used for timers to store slot in wheel */
   struct timeval real;
   struct cpu_thread_history *hist; /* cache pointer to cpu_history */
   const char *funcname;
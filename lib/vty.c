@@ -96,64 +96,33 @@ static u_char restricted_mode = 0;
 char integrate_default[] = SYSCONFDIR INTEGRATE_DEFAULT_CONFIG;
 
 
+/* Bytes written by vty_out(), for the command statistics. */
+unsigned long long vty_out_bytes;
+
 /* VTY standard output function. */
 int
 vty_out (struct vty *vty, const char *format, ...)
 {
   va_list args;
   int len = 0;
-  int size = 1024;
-  char buf[1024];
-  char *p = NULL;
+  int written;
 
   if (vty_shell (vty))
     {
       va_start (args, format);
-      vprintf (format, args);
+      written = vprintf (format, args);
       va_end (args);
     }
   else
     {
-      /* Try to write to initial buffer.  */
+      /* Format straight into the output buffer. */
       va_start (args, format);
-      len = vsnprintf (buf, sizeof buf, format, args);
+      written = len = buffer_vprintf (vty->obuf, format, args);
       va_end (args);
-
-      /* Initial buffer is not enough.  */
-      if (len < 0 || len >= size)
-	{
-	  while (1)
-	    {
-	      if (len > -1)
-		size = len + 1;
-	      else
-		size = size * 2;
-
-	      p = XREALLOC (MTYPE_VTY_OUT_BUF, p, size);
-	      if (! p)
-		return -1;
-
-	      va_start (args, format);
-	      len = vsnprintf (p, size, format, args);
-	      va_end (args);
-
-	      if (len > -1 && len < size)
-		break;
-	    }
-	}
-
-      /* When initial buffer is enough to store all output.  */
-      if (! p)
-	p = buf;
-
-      /* Pointer p must point out buffer. */
-      buffer_put (vty->obuf, (u_char *) p, len);
-
-      /* If p is not different with buf, it is allocated buffer.  */
-      if (p != buf)
-	XFREE (MTYPE_VTY_OUT_BUF, p);
     }
 
+  if (written > 0)
+    vty_out_bytes += written;
   return len;
 }
 
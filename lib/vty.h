@@ -229,6 +229,9 @@ do {                                                                          \
 /* Exported variables */
 extern char integrate_default[];
 
+/* Bytes written by vty_out() */
+extern unsigned long long vty_out_bytes;
+
 /* Prototypes. */
 extern void vty_init (struct thread_master *);
 extern void vty_init_vtysh (void);
@@ -25,6 +25,8 @@
 #include "vty.h"
 #include "command.h"
 #include <pthread.h>
+#include <string.h>
+#include <time.h>
 #include "vty_utils.h"
 #include "latch.h"
 
@@ -32,6 +34,99 @@ struct latch ovsdb_latch;
 
 pthread_mutex_t vtysh_ovsdb_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+struct vtysh_lock_stats vtysh_ovsdb_lock_stats[VTYSH_LOCK_N_THREADS];
+
+static pthread_t vtysh_ovsdb_thread;
+static int vtysh_ovsdb_thread_set;
+
+/* When the holder of vtysh_ovsdb_mutex took it */
+static struct timespec vtysh_ovsdb_lock_taken;
+
+/*
+ * Microseconds from a to b. Both threads take the lock, so this reads
+ * the clock directly rather than through the thread.c time cache.
+ */
+static unsigned long
+vtysh_lock_usec (const struct timespec *a, const struct timespec *b)
+{
+  long long usec = (b->tv_sec - a->tv_sec) * 1000000LL
+                   + (b->tv_nsec - a->tv_nsec) / 1000;
+
+  return usec > 0 ? usec : 0;
+}
+
+static struct vtysh_lock_stats *
+vtysh_lock_stats_self (void)
+{
+  if (vtysh_ovsdb_thread_set
+      && pthread_equal (pthread_self (), vtysh_ovsdb_thread))
+    return &vtysh_ovsdb_lock_stats[VTYSH_LOCK_OVSDB];
+  return &vtysh_ovsdb_lock_stats[VTYSH_LOCK_CLI];
+}
+
+/*
+ * Takes vtysh_ovsdb_mutex. An uncontended acquisition costs a trylock
+ * and a clock read.
+ */
+void
+vtysh_ovsdb_lock (void)
+{
+  struct vtysh_lock_stats *stats;
+  struct timespec start;
+  int contended = 0;
+
+  if (pthread_mutex_trylock (&vtysh_ovsdb_mutex) != 0)
+  {
+    contended = 1;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    pthread_mutex_lock (&vtysh_ovsdb_mutex);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &vtysh_ovsdb_lock_taken);
+
+  stats = vtysh_lock_stats_self ();
+  stats->acquired++;
+  if (contended)
+  {
+    stats->contended++;
+    usec_histogram_add (&stats->wait,
+                        vtysh_lock_usec (&start, &vtysh_ovsdb_lock_taken));
+  }
+}
+
+/*
+ * Releases vtysh_ovsdb_mutex.
+ */
+void
+vtysh_ovsdb_unlock (void)
+{
+  struct timespec now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  usec_histogram_add (&vtysh_lock_stats_self ()->hold,
+                      vtysh_lock_usec (&vtysh_ovsdb_lock_taken, &now));
+  pthread_mutex_unlock (&vtysh_ovsdb_mutex);
+}
+
+/*
+ * Marks the calling thread as vtysh_ovsdb_main_thread(), before it
+ * first takes the lock.
+ */
+void
+vtysh_ovsdb_lock_set_thread (void)
+{
+  vtysh_ovsdb_thread = pthread_self ();
+  vtysh_ovsdb_thread_set = 1;
+}
+
+/*
+ * Resets the lock statistics. The caller holds the lock.
+ */
+void
+vtysh_ovsdb_lock_stats_clear (void)
+{
+  memset (vtysh_ovsdb_lock_stats, 0, sizeof (vtysh_ovsdb_lock_stats));
+}
+
 /*
  * This command converts command string into a vector of cmd_tokens
  */
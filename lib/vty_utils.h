@@ -25,6 +25,8 @@
 #ifndef VTY_UTILS_H
 #define VTY_UTILS_H 1
 
+#include "histogram.h"
+
 extern struct latch ovsdb_latch;
 
 /* To serialize updates to OVSDB.
@@ -34,14 +36,40 @@ extern pthread_mutex_t vtysh_ovsdb_mutex;
 /* Macros to lock and unlock mutexes in a verbose manner. */
 #define VTYSH_OVSDB_LOCK { \
                 VLOG_DBG("%s(%d): VTYSH_OVSDB_LOCK: taking lock...", __FUNCTION__, __LINE__); \
-                pthread_mutex_lock(&vtysh_ovsdb_mutex); \
+                vtysh_ovsdb_lock(); \
 }
 
 #define VTYSH_OVSDB_UNLOCK { \
                 VLOG_DBG("%s(%d): VTYSH_OVSDB_UNLOCK: releasing lock...", __FUNCTION__, __LINE__); \
-                pthread_mutex_unlock(&vtysh_ovsdb_mutex); \
+                vtysh_ovsdb_unlock(); \
 }
 
+/* Threads contending for vtysh_ovsdb_mutex. */
+enum vtysh_lock_thread
+{
+  VTYSH_LOCK_CLI,		/* the CLI thread, and any other */
+  VTYSH_LOCK_OVSDB,		/* vtysh_ovsdb_main_thread() */
+  VTYSH_LOCK_N_THREADS
+};
+
+/* vtysh_ovsdb_mutex statistics of a thread, updated with the mutex held.
+ * Durations are in microseconds.
+ */
+struct vtysh_lock_stats
+{
+  unsigned long acquired;
+  unsigned long contended;	/* acquisitions that had to wait */
+  struct usec_histogram wait;	/* per contended acquisition */
+  struct usec_histogram hold;
+};
+
+extern struct vtysh_lock_stats vtysh_ovsdb_lock_stats[VTYSH_LOCK_N_THREADS];
+
+void vtysh_ovsdb_lock(void);
+void vtysh_ovsdb_unlock(void);
+void vtysh_ovsdb_lock_set_thread(void);
+void vtysh_ovsdb_lock_stats_clear(void);
+
 vector utils_cmd_parse_format(const char* string, const char* desc, const char *dyn_cb);
 
 void utils_format_parser_read_word(struct format_parser_state *state);
@@ -38,23 +38,39 @@ static struct list *work_queues = &_work_queues;
 
 #define WORK_QUEUE_MIN_GRANULARITY 1
 
-static struct work_queue_item *
-work_queue_item_new (struct work_queue *wq)
-{
-  struct work_queue_item *item;
-  assert (wq);
+/* Initial ring size, and the size above which an emptied ring is
+ * released rather than kept for the next burst.
+ */
+#define WORK_QUEUE_RING_MIN  16
+#define WORK_QUEUE_RING_KEEP 1024
 
-  item = XCALLOC (MTYPE_WORK_QUEUE_ITEM, 
-                  sizeof (struct work_queue_item));
-  
-  return item;
-}
+#define WQ_RING_INDEX(wq, i) (((wq)->head + (i)) & ((wq)->size - 1))
 
+/* Grow the item ring, unwrapping it to start at index 0 */
 static void
-work_queue_item_free (struct work_queue_item *item)
+work_queue_ring_grow (struct work_queue *wq)
 {
-  XFREE (MTYPE_WORK_QUEUE_ITEM, item);
-  return;
+  struct work_queue_item *items;
+  unsigned int size = wq->size ? wq->size * 2 : WORK_QUEUE_RING_MIN;
+  unsigned int first = wq->size - wq->head;
+
+  items = XMALLOC (MTYPE_WORK_QUEUE_ITEM,
+                   size * sizeof (struct work_queue_item));
+  if (wq->count)
+    {
+      if (first > wq->count)
+        first = wq->count;
+      memcpy (items, &wq->items[wq->head],
+              first * sizeof (struct work_queue_item));
+      memcpy (&items[first], wq->items,
+              (wq->count - first) * sizeof (struct work_queue_item));
+    }
+  if (wq->items)
+    XFREE (MTYPE_WORK_QUEUE_ITEM, wq->items);
+
+  wq->items = items;
+  wq->size = size;
+  wq->head = 0;
 }
 
 /* create new work queue */
@@ -72,16 +88,6 @@ work_queue_new (struct thread_master *m, const char *queue_name)
   new->master = m;
   SET_FLAG (new->flags, WQ_UNPLUGGED);
   
-  if ( (new->items = list_new ()) == NULL)
-    {
-      XFREE (MTYPE_WORK_QUEUE_NAME, new->name);
-      XFREE (MTYPE_WORK_QUEUE, new);
-      
-      return NULL;
-    }
-  
-  new->items->del = (void (*)(void *)) work_queue_item_free;  
-  
   listnode_add (work_queues, new);
   
   new->cycles.granularity = WORK_QUEUE_MIN_GRANULARITY;
@@ -98,8 +104,8 @@ work_queue_free (struct work_queue *wq)
   if (wq->thread != NULL)
     thread_cancel(wq->thread);
   
-  /* list_delete frees items via callback */
-  list_delete (wq->items);
+  if (wq->items)
+    XFREE (MTYPE_WORK_QUEUE_ITEM, wq->items);
   listnode_delete (work_queues, wq);
   
   XFREE (MTYPE_WORK_QUEUE_NAME, wq->name);
@@ -113,7 +119,7 @@ work_queue_schedule (struct work_queue *wq, unsigned int delay)
   /* if appropriate, schedule work queue thread */
   if ( CHECK_FLAG (wq->flags, WQ_UNPLUGGED)
        && (wq->thread == NULL)
-       && (listcount (wq->items) > 0) )
+       && (wq->count > 0) )
     {
       wq->thread = thread_add_background (wq->master, work_queue_run, 
                                           wq, delay);
@@ -130,42 +136,54 @@ work_queue_add (struct work_queue *wq, void *data)
   
   assert (wq);
 
-  if (!(item = work_queue_item_new (wq)))
-    {
-      zlog_err ("%s: unable to get new queue item", __func__);
-      return;
-    }
+  if (wq->count == wq->size)
+    work_queue_ring_grow (wq);
   
+  item = &wq->items[WQ_RING_INDEX (wq, wq->count)];
   item->data = data;
-  listnode_add (wq->items, item);
+  item->ran = 0;
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &item->queued);
+  wq->count++;
   
   work_queue_schedule (wq, wq->spec.hold);
   
   return;
 }
 
+/* remove the item at the head of the queue, accounting the time it
+ * was queued for up to 'now'
+ */
 static void
-work_queue_item_remove (struct work_queue *wq, struct listnode *ln)
+work_queue_item_remove (struct work_queue *wq, struct timeval *now)
 {
-  struct work_queue_item *item = listgetdata (ln);
+  struct work_queue_item *item = &wq->items[wq->head];
+  void *data = item->data;
 
-  assert (item && item->data);
+  assert (wq->count && data);
+
+  usec_histogram_add (&wq->delay, timercmp (now, &item->queued, >)
+                                  ? timeval_elapsed (*now, item->queued)
+                                  : 0);
+
+  item->data = NULL;
+  wq->head = WQ_RING_INDEX (wq, 1);
+  wq->count--;
 
   /* call private data deletion callback if needed */  
   if (wq->spec.del_item_data)
-    wq->spec.del_item_data (wq, item->data);
-
-  list_delete_node (wq->items, ln);
-  work_queue_item_free (item);
+    wq->spec.del_item_data (wq, data);
   
   return;
 }
 
+/* move the item at the head of the queue to the end */
 static void
-work_queue_item_requeue (struct work_queue *wq, struct listnode *ln)
+work_queue_item_requeue (struct work_queue *wq)
 {
-  LISTNODE_DETACH (wq->items, ln);
-  LISTNODE_ATTACH (wq->items, ln); /* attach to end of list */
+  struct work_queue_item item = wq->items[wq->head];
+
+  wq->head = WQ_RING_INDEX (wq, 1);
+  wq->items[WQ_RING_INDEX (wq, wq->count - 1)] = item;
 }
 
 DEFUN(show_work_queues,
@@ -193,9 +211,9 @@ DEFUN(show_work_queues,
  
   for (ALL_LIST_ELEMENTS_RO (work_queues, node, wq))
     {
-      vty_out (vty,"%c %8d %5d %8ld %7d %6d %6u %s%s",
+      vty_out (vty,"%c %8u %5d %8ld %7d %6d %6u %s%s",
                (CHECK_FLAG (wq->flags, WQ_UNPLUGGED) ? ' ' : 'P'),
-               listcount (wq->items),
+               wq->count,
                wq->spec.hold,
                wq->runs,
                wq->cycles.best, wq->cycles.granularity,
@@ -204,6 +222,26 @@ DEFUN(show_work_queues,
                wq->name,
                VTY_NEWLINE);
     }
+
+  vty_out (vty, "%s%26s %26s%s",
+           VTY_NEWLINE, "Queue delay (usec)", "Run time (usec)",
+           VTY_NEWLINE);
+  vty_out (vty, "%8s %8s %8s %8s %8s %8s %s%s",
+           "p50", "p99", "Max", "p50", "p99", "Max", "Name",
+           VTY_NEWLINE);
+
+  for (ALL_LIST_ELEMENTS_RO (work_queues, node, wq))
+    {
+      vty_out (vty, "%8lu %8lu %8lu %8lu %8lu %8lu %s%s",
+               usec_histogram_percentile (&wq->delay, 50),
+               usec_histogram_percentile (&wq->delay, 99),
+               wq->delay.max,
+               usec_histogram_percentile (&wq->runtime, 50),
+               usec_histogram_percentile (&wq->runtime, 99),
+               wq->runtime.max,
+               wq->name,
+               VTY_NEWLINE);
+    }
     
   return CMD_SUCCESS;
 }
@@ -234,6 +272,49 @@ work_queue_unplug (struct work_queue *wq)
   work_queue_schedule (wq, wq->spec.hold);
 }
 
+/* process up to 'todo' items with the batch work function */
+static unsigned int
+work_queue_run_batch (struct work_queue *wq, struct thread *thread,
+                      unsigned int todo, struct timeval *now,
+                      char *yielded)
+{
+  void *data[WORK_QUEUE_BATCH_MAX];
+  unsigned int max = wq->spec.batch;
+  unsigned int cycles = 0;
+  unsigned int i, n, done;
+
+  if (max == 0 || max > WORK_QUEUE_BATCH_MAX)
+    max = WORK_QUEUE_BATCH_MAX;
+
+  while (todo > 0)
+    {
+      n = (todo < max) ? todo : max;
+      for (i = 0; i < n; i++)
+        data[i] = wq->items[WQ_RING_INDEX (wq, i)].data;
+
+      done = wq->spec.batchfunc (wq, data, n);
+      if (done > n)
+        done = n;
+
+      for (i = 0; i < done; i++)
+        work_queue_item_remove (wq, now);
+      cycles += done;
+      todo -= done;
+
+      /* batch not completed, retry later */
+      if (done < n)
+        break;
+
+      if (todo > 0 && thread_should_yield (thread))
+        {
+          *yielded = 1;
+          break;
+        }
+    }
+
+  return cycles;
+}
+
 /* timer thread to process a work queue
  * will reschedule itself if required,
  * otherwise work_queue_item_add 
@@ -245,13 +326,16 @@ work_queue_run (struct thread *thread)
   struct work_queue_item *item;
   wq_item_status ret;
   unsigned int cycles = 0;
-  struct listnode *node, *nnode;
+  unsigned int todo;
+  struct timeval start, end;
   char yielded = 0;
 
   wq = THREAD_ARG (thread);
   wq->thread = NULL;
 
-  assert (wq && wq->items);
+  assert (wq);
+
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &start);
 
   /* calculate cycle granularity:
    * list iteration == 1 cycle
@@ -273,17 +357,29 @@ work_queue_run (struct thread *thread)
    if (wq->cycles.granularity == 0)
      wq->cycles.granularity = WORK_QUEUE_MIN_GRANULARITY;
 
-  for (ALL_LIST_ELEMENTS (wq->items, node, nnode, item))
+  /* each item queued at the start of the run is looked at once,
+   * items requeued or added meanwhile wait for the next run.
+   */
+  todo = wq->count;
+
+  if (wq->spec.batchfunc)
+    {
+      cycles = work_queue_run_batch (wq, thread, todo, &start, &yielded);
+      goto stats;
+    }
+
+  for (; todo > 0; todo--)
   {
-    assert (item && item->data);
+    item = &wq->items[wq->head];
+    assert (item->data);
     
     /* dont run items which are past their allowed retries */
     if (item->ran > wq->spec.max_retries)
       {
         /* run error handler, if any */
 	if (wq->spec.errorfunc)
-	  wq->spec.errorfunc (wq, item->data);
-	work_queue_item_remove (wq, node);
+	  wq->spec.errorfunc (wq, item);
+	work_queue_item_remove (wq, &start);
 	continue;
       }
 
@@ -291,6 +387,8 @@ work_queue_run (struct thread *thread)
     do
       {
         ret = wq->spec.workfunc (wq, item->data);
+        /* workfunc may have added items, moving the ring */
+        item = &wq->items[wq->head];
         item->ran++;
       }
     while ((ret == WQ_RETRY_NOW) 
@@ -312,7 +410,7 @@ work_queue_run (struct thread *thread)
       case WQ_REQUEUE:
 	{
 	  item->ran--;
-	  work_queue_item_requeue (wq, node);
+	  work_queue_item_requeue (wq);
 	  break;
 	}
       case WQ_RETRY_NOW:
@@ -326,7 +424,7 @@ work_queue_run (struct thread *thread)
       case WQ_SUCCESS:
       default:
 	{
-	  work_queue_item_remove (wq, node);
+	  work_queue_item_remove (wq, &start);
 	  break;
 	}
       }
@@ -371,16 +469,28 @@ stats:
   wq->runs++;
   wq->cycles.total += cycles;
 
+  quagga_gettime (QUAGGA_CLK_MONOTONIC, &end);
+  usec_histogram_add (&wq->runtime, timeval_elapsed (end, start));
+
 #if 0
   printf ("%s: cycles %d, new: best %d, worst %d\n",
             __func__, cycles, wq->cycles.best, wq->cycles.granularity);
 #endif
   
   /* Is the queue done yet? If it is, call the completion callback. */
-  if (listcount (wq->items) > 0)
+  if (wq->count > 0)
     work_queue_schedule (wq, 0);
-  else if (wq->spec.completion_func)
-    wq->spec.completion_func (wq);
+  else
+    {
+      /* don't hold on to the ring a large backlog needed */
+      if (wq->size > WORK_QUEUE_RING_KEEP)
+        {
+          XFREE (MTYPE_WORK_QUEUE_ITEM, wq->items);
+          wq->size = wq->head = 0;
+        }
+      if (wq->spec.completion_func)
+        wq->spec.completion_func (wq);
+    }
   
   return 0;
 }
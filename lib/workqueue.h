@@ -24,6 +24,8 @@
 #ifndef _QUAGGA_WORK_QUEUE_H
 #define _QUAGGA_WORK_QUEUE_H
 
+#include "histogram.h"
+
 /* Hold time for the initial schedule of a queue run, in  millisec */
 #define WORK_QUEUE_DEFAULT_HOLD  50 
 
@@ -40,11 +42,15 @@ typedef enum
                          * the particular item.. */
 } wq_item_status;
 
+/* Most items handed to a batch work function in one call */
+#define WORK_QUEUE_BATCH_MAX 64
+
 /* A single work queue item, unsurprisingly */
 struct work_queue_item
 {
   void *data;                           /* opaque data */
   unsigned short ran;			/* # of times item has been run */
+  struct timeval queued;		/* when item was added */
 };
 
 #define WQ_UNPLUGGED	(1 << 0) /* available for draining */
@@ -71,6 +77,19 @@ struct work_queue
      */
     wq_item_status (*workfunc) (struct work_queue *, void *);
 
+    /* batch work function, optional, used instead of workfunc:
+     * Called with the data of up to 'batch' items from the head of
+     * the queue, in order, and returns how many of those it completed.
+     * Completed items are removed as for WQ_SUCCESS. If fewer than
+     * given are completed, the run stops as for WQ_RETRY_LATER.
+     */
+    unsigned int (*batchfunc) (struct work_queue *, void **, unsigned int);
+
+    /* max items per batchfunc call, 0 or > WORK_QUEUE_BATCH_MAX means
+     * WORK_QUEUE_BATCH_MAX
+     */
+    unsigned int batch;
+
     /* error handling function, optional */
     void (*errorfunc) (struct work_queue *, struct work_queue_item *);
     
@@ -87,7 +106,10 @@ struct work_queue
   } spec;
   
   /* remaining fields should be opaque to users */
-  struct list *items;                 /* queue item list */
+  struct work_queue_item *items;      /* ring of queued items */
+  unsigned int size;                  /* ring size, a power of 2 */
+  unsigned int head;                  /* ring index of first item */
+  unsigned int count;                 /* items queued */
   unsigned long runs;                 /* runs count */
   
   struct {
@@ -95,6 +117,9 @@ struct work_queue
     unsigned int granularity;
     unsigned long total;
   } cycles;	/* cycle counts */
+
+  struct usec_histogram delay;	/* time items spent queued */
+  struct usec_histogram runtime;	/* time spent per run */
   
   /* private state */
   u_int16_t flags;		/* user set flag */
@@ -114,6 +139,9 @@ extern void work_queue_free (struct work_queue *);
 /* Add the supplied data as an item onto the workqueue */
 extern void work_queue_add (struct work_queue *, void *);
 
+/* number of items on the workqueue */
+#define work_queue_item_count(wq) ((wq)->count)
+
 /* plug the queue, ie prevent it from being drained / processed */
 extern void work_queue_plug (struct work_queue *wq);
 /* unplug the queue, allow it to be drained again */
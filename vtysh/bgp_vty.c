@@ -50,6 +50,13 @@
 #include "memory.h"
 #include "vtysh/vtysh_user.h"
 #include "ovsdb-idl.h"
+#include "hmap.h"
+#include "uuid.h"
+#ifdef HAVE_GNU_REGEX
+#include <regex.h>
+#else
+#include "lib/regex-gnu.h"
+#endif /* HAVE_GNU_REGEX */
 #include "lib/prefix.h"
 #include "lib/routemap.h"
 #include "lib/plist.h"
@@ -127,10 +134,17 @@ struct lookup_entry {
  * OVSDB BGP_Route table. These fields are owned by bgpd and shared
  * with CLI daemon.
  */
+typedef enum bgp_origin_e {
+    BGP_ORIGIN_IGP,
+    BGP_ORIGIN_EGP,
+    BGP_ORIGIN_INCOMPLETE
+} bgp_origin_t;
+
 typedef struct route_psd_bgp_s {
     int flags;                    /* Route status flags. */
     const char *aspath;           /* List of AS path number for a route. */
     const char *origin;           /* Indicates route is IBGP or EBGP. */
+    bgp_origin_t origin_code;     /* origin, decoded. */
     int local_pref;               /* Local preference path attribute. */
     bool internal;                /* Specifies route is internal or not. */
     bool ibgp;                    /* Specifies router is IBGP or EBGP. */
@@ -327,7 +341,7 @@ get_bgp_peer_group_with_bgp_router_and_name(const struct ovsrec_bgp_router *
 /*****************************************************************************/
 
 static void
-print_route_status(struct vty *vty, route_psd_bgp_t *ppsd)
+print_route_status(struct vty *vty, const route_psd_bgp_t *ppsd)
 {
     int64_t flags = ppsd->flags;
   /* Route status display. */
@@ -357,39 +371,438 @@ print_route_status(struct vty *vty, route_psd_bgp_t *ppsd)
         vty_out (vty, " ");
 }
 
+/*
+ * BGP RIB cache.
+ *
+ * bgp_rib_sync() decodes the path_attributes of every BGP_Route row
+ * into a route_psd_bgp_t once per change to the row and keeps the rows
+ * sorted by prefix and nexthop, so the show commands read fixed fields
+ * instead of looking attributes up by name for every row they print.
+ * AS paths and origins are interned: the many routes sharing an AS
+ * path point at one copy of it, which also holds the result of matching
+ * it against the filter of the running show command.  uptime and the
+ * sorted rows point into the IDL, so the cache is only good until the
+ * next IDL run; callers sync first.
+ *
+ * The sync also keeps RIB counters, adjusted by what each entry counted
+ * for before and after it is decoded, for "show ip bgp summary".  With
+ * the rows tracked by the IDL, only the changed ones are decoded and
+ * counted again; bgp_rib_refresh() does so on every IDL change, since the
+ * OVSDB thread then clears the tracked rows.
+ */
+enum bgp_rib_af {
+    BGP_RIB_AF_IPV4,
+    BGP_RIB_AF_IPV6,
+    BGP_RIB_N_AFS
+};
+
+/* Indexed by enum bgp_rib_af. */
+struct bgp_peer_counts {
+    unsigned int received[BGP_RIB_N_AFS]; /* Paths from the peer in the RIB. */
+    unsigned int accepted[BGP_RIB_N_AFS]; /* Of those, valid, not history. */
+};
+
+struct bgp_rib_counts {
+    unsigned int total;
+    unsigned int ipv4;
+    unsigned int ipv6;
+    unsigned int selected;
+    unsigned int multipath;
+};
+
+struct bgp_rib_entry {
+    struct hmap_node node;        /* In bgp_rib_entries, by row uuid. */
+    const struct ovsrec_bgp_route *row;
+    unsigned int generation;      /* Last bgp_rib_sync() that saw it. */
+    route_psd_bgp_t psd;
+
+    /* What the entry was counted as, the row may have changed since. */
+    int counted_flags;
+    bool counted_ipv4;
+    struct bgp_peer_counts *counted_peer;
+};
+
+/* An interned attribute string.  Routes point at str. */
+struct bgp_attr_str {
+    struct shash_node *node;      /* In bgp_attr_strs, named by str. */
+    unsigned int refcnt;
+    unsigned int match_seq;       /* bgp_match_seq that match is for. */
+    bool match;
+    char str[];
+};
+
+/* Interned attribute strings: string -> struct bgp_attr_str. */
+static struct shash bgp_attr_strs = SHASH_INITIALIZER(&bgp_attr_strs);
+
+/* Bumped by each filtered show command, to invalidate the match results
+ * cached in the interned strings. */
+static unsigned int bgp_match_seq;
+
+static struct hmap bgp_rib_entries = HMAP_INITIALIZER(&bgp_rib_entries);
+static struct bgp_rib_entry **bgp_rib_sorted;  /* By prefix, nexthop. */
+static size_t bgp_rib_count, bgp_rib_size;
+static bool bgp_rib_sorted_stale;
+static const struct ovsdb_idl_table_class *const bgp_rib_tables[] = {
+    &ovsrec_table_bgp_route,
+};
+static struct vtysh_idl_cache bgp_rib_cache =
+    VTYSH_IDL_CACHE_INITIALIZER(bgp_rib_tables);
+static unsigned int bgp_rib_generation;
+
+static struct bgp_rib_counts bgp_rib_counts;
+/* Peer address -> struct bgp_peer_counts. */
+static struct shash bgp_peer_counts = SHASH_INITIALIZER(&bgp_peer_counts);
+
+static struct bgp_attr_str *
+bgp_attr_str_from(const char *str)
+{
+    return CONTAINER_OF(str, struct bgp_attr_str, str);
+}
+
+static const char *
+bgp_attr_str_intern(const char *str)
+{
+    struct bgp_attr_str *attr;
+    size_t len;
+
+    if (!str) {
+        return NULL;
+    }
+    attr = shash_find_data(&bgp_attr_strs, str);
+    if (!attr) {
+        len = strlen(str);
+        attr = xzalloc(sizeof *attr + len + 1);
+        memcpy(attr->str, str, len + 1);
+        attr->node = shash_add_nocopy(&bgp_attr_strs, attr->str, attr);
+    }
+    attr->refcnt++;
+    return attr->str;
+}
+
+static void
+bgp_attr_str_unref(const char *str)
+{
+    struct bgp_attr_str *attr;
+
+    if (!str) {
+        return;
+    }
+    attr = bgp_attr_str_from(str);
+    if (--attr->refcnt == 0) {
+        /* The node's name is attr->str, so steal rather than delete. */
+        shash_steal(&bgp_attr_strs, attr->node);
+        free(attr);
+    }
+}
+
+/* Points *interned at str's interned copy, keeping the one it has if
+ * the string did not change. */
+static void
+bgp_attr_str_set(const char **interned, const char *str)
+{
+    if (*interned == str
+        || (*interned && str && !strcmp(*interned, str))) {
+        return;
+    }
+    bgp_attr_str_unref(*interned);
+    *interned = bgp_attr_str_intern(str);
+}
+
+static void
+bgp_rib_decode(const struct ovsrec_bgp_route *rib_row, route_psd_bgp_t *data)
+{
+    const struct smap_node *node;
+    const char *aspath = NULL, *origin = NULL;
+
+    data->flags = 0;
+    data->local_pref = 0;
+    data->internal = false;
+    data->ibgp = false;
+    data->uptime = NULL;
+
+    SMAP_FOR_EACH (node, &rib_row->path_attributes) {
+        if (!strcmp(node->key, OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_FLAGS)) {
+            data->flags = atoi(node->value);
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_AS_PATH)) {
+            aspath = node->value;
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_ORIGIN)) {
+            origin = node->value;
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_LOC_PREF)) {
+            data->local_pref = atoi(node->value);
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_INTERNAL)) {
+            data->internal = !strcmp(node->value, "true");
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_IBGP)) {
+            data->ibgp = !strcmp(node->value, "true");
+        } else if (!strcmp(node->key,
+                           OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_UPTIME)) {
+            data->uptime = node->value;
+        }
+    }
+
+    bgp_attr_str_set(&data->aspath, aspath);
+    bgp_attr_str_set(&data->origin, origin);
+    if (origin && *origin == 'i') {
+        data->origin_code = BGP_ORIGIN_IGP;
+    } else if (origin && *origin == 'e') {
+        data->origin_code = BGP_ORIGIN_EGP;
+    } else {
+        data->origin_code = BGP_ORIGIN_INCOMPLETE;
+    }
+}
+
+static struct bgp_rib_entry *
+bgp_rib_entry_find(const struct ovsrec_bgp_route *rib_row)
+{
+    struct bgp_rib_entry *entry;
+
+    HMAP_FOR_EACH_WITH_HASH (entry, node, uuid_hash(&rib_row->header_.uuid),
+                             &bgp_rib_entries) {
+        if (entry->row == rib_row) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static int
+bgp_rib_cmp(const void *a, const void *b)
+{
+    int res;
+    const struct ovsrec_bgp_route *rt1 =
+        (*(const struct bgp_rib_entry **)a)->row;
+    const struct ovsrec_bgp_route *rt2 =
+        (*(const struct bgp_rib_entry **)b)->row;
+    res = strcmp(rt1->prefix, rt2->prefix);
+    if (res == 0) {
+        /* compare nexthops. */
+        if (rt1->n_bgp_nexthops && rt2->n_bgp_nexthops) {
+            return (strcmp(rt1->bgp_nexthops[0]->ip_address,
+                           rt2->bgp_nexthops[0]->ip_address));
+        } else {
+            return res;
+        }
+    } else {
+        return res;
+    }
+}
+
+#define BGP_PATH_ACCEPTED(flags) \
+    (((flags) & (BGP_INFO_VALID | BGP_INFO_HISTORY)) == BGP_INFO_VALID)
+
+/* Takes entry out of the RIB counters. */
 static void
-bgp_get_rib_path_attributes(const struct ovsrec_bgp_route *rib_row,
-                            route_psd_bgp_t *data)
-{
-    assert(data);
-    memset(data, 0, sizeof(*data));
-
-    data->flags = smap_get_int(&rib_row->path_attributes,
-                               OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_FLAGS, 0);
-    data->aspath = smap_get(&rib_row->path_attributes,
-                            OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_AS_PATH);
-    data->origin = smap_get(&rib_row->path_attributes,
-                            OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_ORIGIN);
-    data->local_pref = smap_get_int(&rib_row->path_attributes,
-                                    OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_LOC_PREF,0);
-    const char *value;
-    value = smap_get(&rib_row->path_attributes,
-                     OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_INTERNAL);
-    if (!strcmp(value, "true")) {
-        data->internal = 1;
+bgp_rib_uncount(struct bgp_rib_entry *entry)
+{
+    struct bgp_peer_counts *peer = entry->counted_peer;
+    int af = entry->counted_ipv4 ? BGP_RIB_AF_IPV4 : BGP_RIB_AF_IPV6;
+
+    bgp_rib_counts.total--;
+    if (entry->counted_ipv4) {
+        bgp_rib_counts.ipv4--;
     } else {
-        data->internal = 0;
+        bgp_rib_counts.ipv6--;
+    }
+    if (entry->counted_flags & BGP_INFO_SELECTED) {
+        bgp_rib_counts.selected--;
+    }
+    if (entry->counted_flags & BGP_INFO_MULTIPATH) {
+        bgp_rib_counts.multipath--;
+    }
+    if (peer) {
+        peer->received[af]--;
+        if (BGP_PATH_ACCEPTED(entry->counted_flags)) {
+            peer->accepted[af]--;
+        }
+    }
+    entry->counted_peer = NULL;
+}
+
+/* Adds entry, as its row is now, to the RIB counters. */
+static void
+bgp_rib_count_entry(struct bgp_rib_entry *entry)
+{
+    const struct ovsrec_bgp_route *rib_row = entry->row;
+    struct bgp_peer_counts *peer = NULL;
+    int af;
+
+    entry->counted_flags = entry->psd.flags;
+    entry->counted_ipv4 = !strcmp(rib_row->address_family,
+                                  OVSREC_ROUTE_ADDRESS_FAMILY_IPV4);
+    af = entry->counted_ipv4 ? BGP_RIB_AF_IPV4 : BGP_RIB_AF_IPV6;
+
+    bgp_rib_counts.total++;
+    if (entry->counted_ipv4) {
+        bgp_rib_counts.ipv4++;
+    } else {
+        bgp_rib_counts.ipv6++;
+    }
+    if (entry->counted_flags & BGP_INFO_SELECTED) {
+        bgp_rib_counts.selected++;
+    }
+    if (entry->counted_flags & BGP_INFO_MULTIPATH) {
+        bgp_rib_counts.multipath++;
+    }
+    if (rib_row->peer) {
+        peer = shash_find_data(&bgp_peer_counts, rib_row->peer);
+        if (!peer) {
+            peer = xzalloc(sizeof *peer);
+            shash_add(&bgp_peer_counts, rib_row->peer, peer);
+        }
+        peer->received[af]++;
+        if (BGP_PATH_ACCEPTED(entry->counted_flags)) {
+            peer->accepted[af]++;
+        }
     }
-    value = smap_get(&rib_row->path_attributes,
-                     OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_IBGP);
-    if (!strcmp(value, "true")) {
-        data->ibgp = 1;
+    entry->counted_peer = peer;
+}
+
+/* Decodes rib_row into its entry, which is created if it has none, and
+ * counts it as it is now. */
+static void
+bgp_rib_entry_update(const struct ovsrec_bgp_route *rib_row)
+{
+    struct bgp_rib_entry *entry = bgp_rib_entry_find(rib_row);
+
+    if (!entry) {
+        entry = xzalloc(sizeof *entry);
+        entry->row = rib_row;
+        hmap_insert(&bgp_rib_entries, &entry->node,
+                    uuid_hash(&rib_row->header_.uuid));
     } else {
-        data->ibgp = 0;
+        bgp_rib_uncount(entry);
+    }
+    entry->generation = bgp_rib_generation;
+    bgp_rib_decode(rib_row, &entry->psd);
+    bgp_rib_count_entry(entry);
+}
+
+static void
+bgp_rib_entry_destroy(struct bgp_rib_entry *entry)
+{
+    hmap_remove(&bgp_rib_entries, &entry->node);
+    bgp_rib_uncount(entry);
+    bgp_attr_str_unref(entry->psd.aspath);
+    bgp_attr_str_unref(entry->psd.origin);
+    free(entry);
+}
+
+#ifdef OVSREC_BGP_ROUTE_FOR_EACH_TRACKED
+/* Applies to the RIB cache the BGP_Route rows inserted, modified or
+ * deleted after 'seqno'.  Deleted rows stay tracked, and readable, until
+ * the OVSDB thread clears them after bgp_rib_refresh(). */
+static void
+bgp_rib_apply_tracked(unsigned int seqno)
+{
+    const struct ovsrec_bgp_route *rib_row;
+    struct bgp_rib_entry *entry;
+
+    OVSREC_BGP_ROUTE_FOR_EACH_TRACKED (rib_row, idl) {
+        if (ovsdb_idl_row_get_seqno(&rib_row->header_,
+                                    OVSDB_IDL_CHANGE_DELETE) > seqno) {
+            entry = bgp_rib_entry_find(rib_row);
+            if (entry) {
+                bgp_rib_entry_destroy(entry);
+            }
+        } else if (ovsdb_idl_row_get_seqno(&rib_row->header_,
+                                           OVSDB_IDL_CHANGE_INSERT) > seqno
+                   || ovsdb_idl_row_get_seqno(&rib_row->header_,
+                                              OVSDB_IDL_CHANGE_MODIFY)
+                      > seqno) {
+            bgp_rib_entry_update(rib_row);
+        }
+    }
+}
+#endif
+
+/* Brings the entries and counters of the RIB cache up to date with the
+ * IDL.  Once built, only the rows that changed since are decoded again,
+ * if the IDL tracks them. */
+static void
+bgp_rib_apply(void)
+{
+    const struct ovsrec_bgp_route *rib_row = NULL;
+    struct bgp_rib_entry *entry, *next;
+    struct shash_node *node, *next_node;
+#ifdef OVSREC_BGP_ROUTE_FOR_EACH_TRACKED
+    unsigned int seqno = bgp_rib_cache.seqno;
+    bool valid = bgp_rib_cache.valid;
+#endif
+
+    if (vtysh_idl_cache_check(&bgp_rib_cache)) {
+        return;
+    }
+    bgp_rib_sorted_stale = true;
+
+#ifdef OVSREC_BGP_ROUTE_FOR_EACH_TRACKED
+    if (valid) {
+        bgp_rib_apply_tracked(seqno);
+    } else
+#endif
+    {
+        bgp_rib_generation++;
+        OVSREC_BGP_ROUTE_FOR_EACH(rib_row, idl) {
+            bgp_rib_entry_update(rib_row);
+        }
+        HMAP_FOR_EACH_SAFE (entry, next, node, &bgp_rib_entries) {
+            if (entry->generation != bgp_rib_generation) {
+                bgp_rib_entry_destroy(entry);
+            }
+        }
+    }
+
+    /* Forget peers that no longer have any paths. */
+    SHASH_FOR_EACH_SAFE (node, next_node, &bgp_peer_counts) {
+        struct bgp_peer_counts *peer = node->data;
+
+        if (!peer->received[BGP_RIB_AF_IPV4]
+            && !peer->received[BGP_RIB_AF_IPV6]) {
+            free(peer);
+            shash_delete(&bgp_peer_counts, node);
+        }
+    }
+}
+
+/* Applies the BGP_Route changes the IDL tracks to the RIB cache, if it
+ * was built, before the OVSDB thread clears them.  The caller must hold
+ * the OVSDB lock. */
+void
+bgp_rib_refresh(void)
+{
+#ifdef OVSREC_BGP_ROUTE_FOR_EACH_TRACKED
+    if (bgp_rib_cache.valid) {
+        bgp_rib_apply();
     }
-    data->uptime = smap_get(&rib_row->path_attributes,
-                            OVSDB_BGP_ROUTE_PATH_ATTRIBUTES_UPTIME);
-    return;
+#endif
+}
+
+/* Brings the RIB cache up to date with the IDL, sorting its entries again
+ * if any changed. */
+static void
+bgp_rib_sync(void)
+{
+    struct bgp_rib_entry *entry;
+
+    bgp_rib_apply();
+    if (!bgp_rib_sorted_stale) {
+        return;
+    }
+    bgp_rib_sorted_stale = false;
+
+    bgp_rib_count = 0;
+    HMAP_FOR_EACH (entry, node, &bgp_rib_entries) {
+        if (bgp_rib_count >= bgp_rib_size) {
+            bgp_rib_sorted = x2nrealloc(bgp_rib_sorted, &bgp_rib_size,
+                                        sizeof *bgp_rib_sorted);
+        }
+        bgp_rib_sorted[bgp_rib_count++] = entry;
+    }
+    qsort(bgp_rib_sorted, bgp_rib_count, sizeof *bgp_rib_sorted,
+          bgp_rib_cmp);
 }
 
 /*
@@ -412,11 +825,11 @@ bgp_peer_lookup(const struct ovsrec_bgp_router *bgp_row, const char *peer_id)
 
 
 static const char*
-bgp_get_origin_long_str(const char *c)
+bgp_get_origin_long_str(bgp_origin_t origin)
 {
-    if (*c == 'i')
+    if (origin == BGP_ORIGIN_IGP)
         return "IGP";
-    else if (*c == 'e')
+    else if (origin == BGP_ORIGIN_EGP)
         return "EGP";
     else
         return "incomplete";
@@ -463,137 +876,186 @@ bgp_get_peer_weight(const struct ovsrec_bgp_router *bgp_row,
     }
 }
 
-static int
-bgp_get_rib_count(void)
+/*
+ * Route filters for the "show ip bgp" views.
+ *
+ * A view prints the routes its filter matches in one pass over the
+ * sorted RIB.  AS path tests are made on the interned
+ * strings, and their results are kept there for the rest of the pass:
+ * each distinct AS path is matched once however many routes share it.
+ */
+struct bgp_route_filter {
+    regex_t *aspath_re;           /* AS path regular expression. */
+    int local_match;              /* aspath_re on a route without AS path,
+                                   * -1 until tested. */
+    const char *peer;             /* Neighbor the path was learned from. */
+};
+
+/* Compiles an AS path regular expression.  As in Quagga, '_' matches
+ * the start or end of the path or a separator between AS numbers. */
+static regex_t *
+bgp_aspath_regcomp(const char *regstr)
+{
+    static const char magic[] = "(^|[,{}() ]|$)";
+    size_t magic_len = strlen(magic);
+    regex_t *regex;
+    const char *p;
+    char *re, *q;
+    size_t n = 0;
+
+    for (p = regstr; *p; p++) {
+        n += (*p == '_') ? magic_len : 1;
+    }
+    q = re = xmalloc(n + 1);
+    for (p = regstr; *p; p++) {
+        if (*p == '_') {
+            memcpy(q, magic, magic_len);
+            q += magic_len;
+        } else {
+            *q++ = *p;
+        }
+    }
+    *q = '\0';
+
+    regex = xmalloc(sizeof *regex);
+    if (regcomp(regex, re, REG_EXTENDED | REG_NOSUB)) {
+        free(regex);
+        regex = NULL;
+    }
+    free(re);
+    return regex;
+}
+
+static void
+bgp_aspath_regfree(regex_t *regex)
 {
-    int count = 0;
-    const struct ovsrec_bgp_route *rib_row = NULL;
-    OVSREC_BGP_ROUTE_FOR_EACH(rib_row, idl) {
-        count++;
+    if (regex) {
+        regfree(regex);
+        free(regex);
     }
-    return count;
 }
 
-static int
-bgp_rib_cmp(void *a, void *b)
+static bool
+bgp_aspath_filter_match(struct bgp_route_filter *filter, const char *aspath)
 {
-    int res;
-    struct ovsrec_bgp_route *rt1 = (struct ovsrec_bgp_route *)a;
-    struct ovsrec_bgp_route *rt2 = (struct ovsrec_bgp_route *)b;
-    res = strcmp(rt1->prefix, rt2->prefix);
-    if (res == 0) {
-        /* compare nexthops. */
-        if (rt1->bgp_nexthops[0] && rt2->bgp_nexthops[0]) {
-            return (strcmp(rt1->bgp_nexthops[0]->ip_address,
-                           rt2->bgp_nexthops[0]->ip_address));
-        } else {
-            return res;
+    struct bgp_attr_str *attr;
+
+    if (!aspath) {
+        if (filter->local_match < 0) {
+            filter->local_match = !regexec(filter->aspath_re, "",
+                                           0, NULL, 0);
         }
-    } else {
-        return res;
+        return filter->local_match;
+    }
+    attr = bgp_attr_str_from(aspath);
+    if (attr->match_seq != bgp_match_seq) {
+        attr->match = !regexec(filter->aspath_re, aspath, 0, NULL, 0);
+        attr->match_seq = bgp_match_seq;
     }
+    return attr->match;
 }
 
-static void
-bgp_rib_sort_init(struct ovsrec_bgp_route **rib_sorted, int count)
+static bool
+bgp_route_filter_match(struct bgp_route_filter *filter,
+                       const struct bgp_rib_entry *entry)
 {
-    int kk = 0;
-    const struct ovsrec_bgp_route *rib_row = NULL;
-    assert(*rib_sorted == NULL);
-    *rib_sorted = (struct ovsrec_bgp_route *)calloc(count,
-                                             sizeof(struct ovsrec_bgp_route));
-    OVSREC_BGP_ROUTE_FOR_EACH(rib_row, idl) {
-        memcpy((*rib_sorted)+kk, rib_row, sizeof(struct ovsrec_bgp_route));
-        kk++;
+    if (!filter) {
+        return true;
+    }
+    if (filter->peer
+        && (!entry->row->peer || strcmp(entry->row->peer, filter->peer))) {
+        return false;
+    }
+    if (filter->aspath_re
+        && !bgp_aspath_filter_match(filter, entry->psd.aspath)) {
+        return false;
     }
-    qsort((void *)*rib_sorted, count, sizeof(struct ovsrec_bgp_route),
-          (void *)bgp_rib_cmp);
+    return true;
 }
 
+/* Prints one route of the "show ip bgp" table. */
 static void
-bgp_rib_sort_fin(struct ovsrec_bgp_route **rib_sorted)
+show_route(struct vty *vty, const struct ovsrec_bgp_router *bgp_row,
+           const struct bgp_rib_entry *entry)
 {
-    if (*rib_sorted) {
-        free(*rib_sorted);
-        *rib_sorted = NULL;
+    const struct ovsrec_bgp_route *rib_row = entry->row;
+    const route_psd_bgp_t *ppsd = &entry->psd;
+    const struct ovsrec_bgp_nexthop *nexthop_row = NULL;
+    int ii = 0, def_metric = 0;
+    int len = 0;
+
+    print_route_status(vty, ppsd);
+    len = strlen(rib_row->prefix);
+    vty_out(vty, "%s", rib_row->prefix);
+    if (len < NET_BUFSZ)
+        vty_out (vty, "%*s", NET_BUFSZ-len-1, " ");
+    /* Nexthop. */
+    if (!strcmp(rib_row->address_family,
+                OVSREC_ROUTE_ADDRESS_FAMILY_IPV4)) {
+        /* Get the nexthop list. */
+        VLOG_DBG("No. of next hops : %d", (int)rib_row->n_bgp_nexthops);
+        for (ii = 0; ii < rib_row->n_bgp_nexthops; ii++) {
+            if (ii != 0) {
+                vty_out (vty, VTY_NEWLINE);
+                vty_out (vty, "%*s", NET_BUFSZ, " ");
+            }
+            nexthop_row = rib_row->bgp_nexthops[ii];
+            vty_out (vty, "%-19s", nexthop_row->ip_address);
+        }
+        if (!rib_row->n_bgp_nexthops)
+            vty_out (vty, "%-19s", "0.0.0.0");
+        if (rib_row->n_metric)
+            vty_out (vty, "%7d", (int)*rib_row->metric);
+        else
+            vty_out (vty, "%7d", def_metric);
+        /* Print local preference. */
+        vty_out (vty, "%7d", ppsd->local_pref);
+        /* Print weight for non-static routes. */
+        vty_out (vty, "%7d ", bgp_get_peer_weight(bgp_row,
+                                                  rib_row,
+                                                  rib_row->peer));
+        /* Print AS path. */
+        if (ppsd->aspath) {
+            vty_out(vty, "%s", ppsd->aspath);
+            vty_out(vty, " ");
+        }
+        /* Print origin. */
+        if (ppsd->origin)
+            vty_out(vty, "%s", ppsd->origin);
+    } else {
+        /* TODO: Add ipv6 later. */
+        VLOG_INFO("Address family not supported yet\n");
     }
+    vty_out (vty, VTY_NEWLINE);
 }
 
-/* Function to print route status code.*/
+/* Prints the routes of the local RIB that filter matches, all of them
+ * if filter is NULL. */
 static void show_routes(struct vty *vty,
-                        const struct ovsrec_bgp_router *bgp_row)
+                        const struct ovsrec_bgp_router *bgp_row,
+                        struct bgp_route_filter *filter)
 {
-    const struct ovsrec_bgp_route *rib_row = NULL;
-    int ii = 0, def_metric = 0, kk = 0;
-    const struct ovsrec_bgp_nexthop *nexthop_row = NULL;
-    route_psd_bgp_t psd, *ppsd = NULL;
-    struct ovsrec_bgp_route *rib_sorted = NULL;
-    int count = bgp_get_rib_count();
+    const struct bgp_rib_entry *entry;
+    size_t kk;
+    int count = 0;
 
-    ppsd = &psd;
-    bgp_rib_sort_init(&rib_sorted, count);
+    bgp_rib_sync();
+    bgp_match_seq++;
 
     /* Read BGP routes from BGP local RIB. */
-    for (kk = 0; kk < count; kk++) {
-        rib_row = &rib_sorted[kk];
-        bgp_get_rib_path_attributes(rib_row, ppsd);
-        print_route_status(vty, ppsd);
-        if (rib_row->prefix) {
-            int len = 0;
-            len = strlen(rib_row->prefix);
-            vty_out(vty, "%s", rib_row->prefix);
-            if (len < NET_BUFSZ)
-                vty_out (vty, "%*s", NET_BUFSZ-len-1, " ");
-            /* Nexthop. */
-            if (!strcmp(rib_row->address_family,
-                        OVSREC_ROUTE_ADDRESS_FAMILY_IPV4)) {
-                /* Get the nexthop list. */
-                VLOG_DBG("No. of next hops : %d", (int)rib_row->n_bgp_nexthops);
-                for (ii = 0; ii < rib_row->n_bgp_nexthops; ii++) {
-                    if (ii != 0) {
-                        vty_out (vty, VTY_NEWLINE);
-                        vty_out (vty, "%*s", NET_BUFSZ, " ");
-                    }
-                    nexthop_row = rib_row->bgp_nexthops[ii];
-                    vty_out (vty, "%-19s", nexthop_row->ip_address);
-                }
-                if (!rib_row->n_bgp_nexthops)
-                    vty_out (vty, "%-19s", "0.0.0.0");
-                if (rib_row->n_metric)
-                    vty_out (vty, "%7d", (int)*rib_row->metric);
-                else
-                    vty_out (vty, "%7d", def_metric);
-                /* Print local preference. */
-                vty_out (vty, "%7d", ppsd->local_pref);
-                /* Print weight for non-static routes. */
-                vty_out (vty, "%7d ", bgp_get_peer_weight(bgp_row,
-                                                          rib_row,
-                                                          rib_row->peer));
-                /* Print AS path. */
-                if (ppsd->aspath) {
-                    vty_out(vty, "%s", ppsd->aspath);
-                    vty_out(vty, " ");
-                }
-                /* Print origin. */
-                if (ppsd->origin)
-                    vty_out(vty, "%s", ppsd->origin);
-            } else {
-                /* TODO: Add ipv6 later. */
-                VLOG_INFO("Address family not supported yet\n");
-            }
-            vty_out (vty, VTY_NEWLINE);
+    for (kk = 0; kk < bgp_rib_count; kk++) {
+        entry = bgp_rib_sorted[kk];
+        if (entry->row->prefix && bgp_route_filter_match(filter, entry)) {
+            show_route(vty, bgp_row, entry);
+            count++;
         }
     }
     vty_out(vty, "Total number of entries %d\n", count);
-    bgp_rib_sort_fin(&rib_sorted);
 }
 
-DEFUN(vtysh_show_ip_bgp,
-      vtysh_show_ip_bgp_cmd,
-      "show ip bgp",
-      SHOW_STR
-      IP_STR
-      BGP_STR)
+/* Prints the "show ip bgp" table of the routes filter matches. */
+static int
+bgp_show_routes_filtered(struct vty *vty, struct bgp_route_filter *filter)
 {
     const struct ovsrec_bgp_router *bgp_row = NULL;
 
@@ -614,28 +1076,92 @@ DEFUN(vtysh_show_ip_bgp,
         vty_out (vty, "Router-id not configured\n");
     }
     vty_out (vty, BGP_SHOW_HEADER, VTY_NEWLINE);
-    show_routes(vty, bgp_row);
+    show_routes(vty, bgp_row, filter);
     return CMD_SUCCESS;
 }
 
+DEFUN(vtysh_show_ip_bgp,
+      vtysh_show_ip_bgp_cmd,
+      "show ip bgp",
+      SHOW_STR
+      IP_STR
+      BGP_STR)
+{
+    return bgp_show_routes_filtered(vty, NULL);
+}
+
+DEFUN(vtysh_show_ip_bgp_regexp,
+      vtysh_show_ip_bgp_regexp_cmd,
+      "show ip bgp regexp .LINE",
+      SHOW_STR
+      IP_STR
+      BGP_STR
+      "Display routes matching the AS path regular expression\n"
+      "A regular-expression to match the BGP AS paths\n")
+{
+    struct bgp_route_filter filter;
+    char *regstr;
+    int ret;
+
+    memset(&filter, 0, sizeof filter);
+    filter.local_match = -1;
+
+    regstr = argv_concat(argv, argc, 0);
+    filter.aspath_re = bgp_aspath_regcomp(regstr);
+    if (!filter.aspath_re) {
+        vty_out(vty, "%% Can't compile regexp %s%s", regstr, VTY_NEWLINE);
+        XFREE(MTYPE_TMP, regstr);
+        return CMD_WARNING;
+    }
+    XFREE(MTYPE_TMP, regstr);
+
+    ret = bgp_show_routes_filtered(vty, &filter);
+    bgp_aspath_regfree(filter.aspath_re);
+    return ret;
+}
+
+DEFUN(vtysh_show_ip_bgp_neighbor_routes,
+      vtysh_show_ip_bgp_neighbor_routes_cmd,
+      "show ip bgp neighbors (A.B.C.D|X:X::X:X) routes",
+      SHOW_STR
+      IP_STR
+      BGP_STR
+      "Detailed information on TCP and BGP neighbor connections\n"
+      "Neighbor to display information about\n"
+      "Neighbor to display information about\n"
+      "Display routes learned from neighbor\n")
+{
+    const struct ovsrec_bgp_router *bgp_row = NULL;
+    struct bgp_route_filter filter;
+
+    bgp_row = ovsrec_bgp_router_first(idl);
+    if (bgp_row && !bgp_peer_lookup(bgp_row, argv[0])) {
+        vty_out(vty, "%% No such neighbor%s", VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    memset(&filter, 0, sizeof filter);
+    filter.peer = argv[0];
+    return bgp_show_routes_filtered(vty, &filter);
+}
+
 static void
 bgp_get_paths_count_for_prefix(const char *ip, int *count, int *best)
 {
-    const struct ovsrec_bgp_route *rib_row;
-    route_psd_bgp_t psd, *ppsd = NULL;
+    const struct bgp_rib_entry *entry;
+    size_t ii;
 
     assert(ip);
     assert(count);
     assert(best);
-    ppsd = &psd;
     *count = *best = 0;
     /* Get all routes matching this prefix. */
-    OVSREC_BGP_ROUTE_FOR_EACH(rib_row, idl) {
-        bgp_get_rib_path_attributes(rib_row, ppsd);
-        if (rib_row->prefix
-            && strcmp(rib_row->prefix, ip) == 0) {
+    for (ii = 0; ii < bgp_rib_count; ii++) {
+        entry = bgp_rib_sorted[ii];
+        if (entry->row->prefix
+            && strcmp(entry->row->prefix, ip) == 0) {
             (*count)++;
-            if (ppsd->flags & BGP_INFO_SELECTED)
+            if (entry->psd.flags & BGP_INFO_SELECTED)
                 (*best)++;
         }
     }
@@ -644,16 +1170,16 @@ bgp_get_paths_count_for_prefix(const char *ip, int *count, int *best)
 static int
 show_route_detail(struct vty *vty,
                   const struct ovsrec_bgp_router *bgp_row,
-                  const struct ovsrec_bgp_route *rib_row,
+                  const struct bgp_rib_entry *entry,
                   boolean print_header)
 {
     int ret;
     int count, best;
-    route_psd_bgp_t psd, *ppsd = NULL;
+    const struct ovsrec_bgp_route *rib_row = entry->row;
+    const route_psd_bgp_t *ppsd = &entry->psd;
     struct prefix p;
     boolean static_route = 0;
     const char *str;
-    ppsd = &psd;
     count = best = 0;
 
     ret = str2prefix(rib_row->prefix, &p);
@@ -661,7 +1187,6 @@ show_route_detail(struct vty *vty,
         vty_out (vty, "address is malformed%s", VTY_NEWLINE);
         return CMD_WARNING;
     }
-    bgp_get_rib_path_attributes(rib_row, ppsd);
 
     if (print_header) {
         vty_out (vty, "BGP routing table entry for %s%s",
@@ -677,7 +1202,7 @@ show_route_detail(struct vty *vty,
     }
     /* Print protocol specific info. */
     /* Line1 display AS-path, Aggregator.*/
-    str = (*ppsd->aspath) ? ppsd->aspath : "Local";
+    str = (ppsd->aspath && *ppsd->aspath) ? ppsd->aspath : "Local";
     vty_out (vty, "AS: %s", str);
     if (ppsd->flags & BGP_INFO_REMOVED)
         vty_out (vty, ", (removed)");
@@ -708,7 +1233,7 @@ show_route_detail(struct vty *vty,
     vty_out (vty, "%s", VTY_NEWLINE);
     /* Line 3 display Origin, Med, Locpref, Weight, valid,
        Int/Ext/Local, Atomic, best. */
-    vty_out (vty, "      Origin %s", bgp_get_origin_long_str(ppsd->origin));
+    vty_out (vty, "      Origin %s", bgp_get_origin_long_str(ppsd->origin_code));
     int metric = (rib_row->n_metric) ? *rib_row->metric : 0;
     vty_out (vty, ", metric %d", metric);
     vty_out (vty, ", localpref %d", ppsd->local_pref);
@@ -742,11 +1267,10 @@ bgp_show_route(char *vrf_name, struct vty *vty, const char *view_name,
 {
     const struct ovsrec_bgp_router *bgp_row = NULL;
     const struct ovsrec_bgp_route *rib_row = NULL;
-    struct ovsrec_bgp_route *rib_sorted = NULL;
     struct prefix match;
-    int cmpLen = 0, found = 0, ret, ii = 0;
+    int cmpLen = 0, found = 0, ret;
+    size_t ii = 0;
     boolean print_header = 0;
-    int count = bgp_get_rib_count();
 
     bgp_row = ovsrec_bgp_router_first(idl);
     if (!bgp_row) {
@@ -762,19 +1286,18 @@ bgp_show_route(char *vrf_name, struct vty *vty, const char *view_name,
         return CMD_WARNING;
     }
 
-    bgp_rib_sort_init(&rib_sorted, count);
-    for (ii = 0; ii < count; ii++) {
-        rib_row = &rib_sorted[ii];
+    bgp_rib_sync();
+    for (ii = 0; ii < bgp_rib_count; ii++) {
+        rib_row = bgp_rib_sorted[ii]->row;
         if (rib_row->prefix && strncmp(rib_row->prefix, ip_str, cmpLen) == 0) {
             if (!found) {
                 found = 1;
                 print_header = 1;
             }
-            show_route_detail(vty, bgp_row, rib_row, print_header);
+            show_route_detail(vty, bgp_row, bgp_rib_sorted[ii], print_header);
             print_header = 0;
         }
     }
-    bgp_rib_sort_fin(&rib_sorted);
     if(!found) {
         vty_out (vty, "%% Network not in table%s", VTY_NEWLINE);
         return CMD_WARNING;
@@ -7254,10 +7777,14 @@ cli_bgp_show_summary_vty_execute(struct vty *vty, int afi, int safi)
     const struct ovsrec_bgp_router *bgp_router_context = NULL;
     const struct ovsrec_bgp_neighbor *ovs_bgp_neighbor = NULL;
     struct ovsdb_idl_txn *txn;
+    const struct bgp_peer_counts *peer_counts = NULL;
+    static const struct bgp_peer_counts no_counts;
+    int af = (afi == AFI_IP6) ? BGP_RIB_AF_IPV6 : BGP_RIB_AF_IPV4;
     int i = 0, len = 0, j = 0;
     char timebuf[BGP_UPTIME_LEN];
     static char header[] =
-                "Neighbor             AS MsgRcvd MsgSent Up/Down  State\n";
+                "Neighbor             AS MsgRcvd MsgSent Up/Down  State"
+                "        PfxRcd  PfxAcc\n";
 
     /* Start of transaction. */
     START_DB_TXN(txn);
@@ -7270,7 +7797,11 @@ cli_bgp_show_summary_vty_execute(struct vty *vty, int afi, int safi)
                 bgp_router_context->router_id,
                 ovs_vrf->key_bgp_routers[0]);
 
-    vty_out(vty, "RIB entries %d\n", bgp_get_rib_count());
+    bgp_rib_sync();
+    vty_out(vty, "RIB entries %d\n", (int)bgp_rib_counts.total);
+    vty_out(vty, "RIB paths: IPv4 %u, IPv6 %u, best %u, multipath %u\n",
+            bgp_rib_counts.ipv4, bgp_rib_counts.ipv6,
+            bgp_rib_counts.selected, bgp_rib_counts.multipath);
 
     vty_out(vty, "Peers %d\n\n", bgp_get_peer_count(bgp_router_context));
 
@@ -7298,8 +7829,15 @@ cli_bgp_show_summary_vty_execute(struct vty *vty, int afi, int safi)
             (get_statistics_from_neighbor(ovs_bgp_neighbor,
              BGP_PEER_UPTIME), timebuf, BGP_UPTIME_LEN));
 
-        vty_out(vty, "%12s\n", smap_get(&ovs_bgp_neighbor->status,
+        vty_out(vty, "%12s", smap_get(&ovs_bgp_neighbor->status,
                 BGP_PEER_STATE));
+
+        peer_counts = shash_find_data(&bgp_peer_counts,
+                                      bgp_router_context->key_bgp_neighbors[j]);
+        if (!peer_counts)
+            peer_counts = &no_counts;
+        vty_out(vty, "%8u%8u\n", peer_counts->received[af],
+                peer_counts->accepted[af]);
     }
 
     END_DB_TXN(txn);
@@ -8377,6 +8915,8 @@ bgp_vty_init(void)
     install_element(ENABLE_NODE, &vtysh_show_ip_bgp_cmd);
     install_element(ENABLE_NODE, &vtysh_show_ip_bgp_route_cmd);
     install_element(ENABLE_NODE, &vtysh_show_ip_bgp_prefix_cmd);
+    install_element(ENABLE_NODE, &vtysh_show_ip_bgp_regexp_cmd);
+    install_element(ENABLE_NODE, &vtysh_show_ip_bgp_neighbor_routes_cmd);
 
     /* Install bgp top node. */
     install_node(&bgp_ipv4_unicast_node, NULL);
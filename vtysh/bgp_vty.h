@@ -88,5 +88,6 @@ cli_command_result (enum ovsdb_idl_txn_status status)
 
 void bgp_vty_init (void);
 void policy_vty_init(void);
+void bgp_rib_refresh(void);
 
 #endif /* _BGP_VTY_H */
@@ -25,6 +25,10 @@
  *
  ***************************************************************************/
 #include <sys/un.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
 #include <setjmp.h>
 #include <sys/wait.h>
 #include <pwd.h>
@@ -42,6 +46,8 @@
 #include "openvswitch/vlog.h"
 #include "openswitch-idl.h"
 #include "prefix.h"
+#include "shash.h"
+#include "dynamic-string.h"
 #include "vtysh/vtysh_ovsdb_if.h"
 #include "vtysh/vtysh_ovsdb_config.h"
 #include "dhcp_tftp_vty.h"
@@ -49,6 +55,14 @@
 VLOG_DEFINE_THIS_MODULE (vtysh_dhcp_tftp_cli);
 extern struct ovsdb_idl *idl;
 
+/* Leases are read from the lease file of the running dnsmasq, as given
+ * by its --dhcp-leasefile option or else its configuration file, and by
+ * default DHCP_LEASE_FILE.  A server run with --leasefile-ro keeps no
+ * lease file, and the leases are then taken from the output of
+ * DHCP_LEASE_SCRIPT, which prints them in the same format. */
+#define DHCP_SERVER_NAME "dnsmasq"
+#define DHCP_SERVER_CONF "/etc/dnsmasq.conf"
+#define DHCP_LEASE_FILE "/var/lib/misc/dnsmasq.leases"
 #define DHCP_LEASE_SCRIPT "/usr/bin/dhcp_leases"
 
 bool is_tag_or_name_valid (char *tag)
@@ -217,67 +231,438 @@ bool is_valid_broadcast_addr(char *start_ip,char *netmask,char *broadcast_ip)
     }
 }
 
-static int show_dhcp_leases(void)
+/* A lease of the DHCP server lease file.  The strings point into
+ * dhcp_lease_buf, where the file is read and split in place. */
+struct dhcp_lease {
+    time_t expiry;                      /* 0 for an infinite lease. */
+    const char *mac_addr;               /* The IAID of a DHCPv6 lease. */
+    const char *ip_addr;
+    const char *hostname;
+    const char *client_id;
+    struct dhcp_lease *next_same_mac;   /* Next lease with 'mac_addr'. */
+};
+
+/* The DHCP server last found, and its command line and lease file.  The
+ * lease file is NULL if the server keeps none. */
+static pid_t dhcp_server_pid;
+static struct ds dhcp_server_cmdline = DS_EMPTY_INITIALIZER;
+static char *dhcp_lease_file;
+
+/* Leases of dhcp_lease_file, reread only when the file changes.  Leases
+ * from DHCP_LEASE_SCRIPT are never valid, and read for every command. */
+static bool dhcp_lease_valid;
+static ino_t dhcp_lease_ino;
+static off_t dhcp_lease_size;
+static struct timespec dhcp_lease_mtime;
+static char *dhcp_lease_buf;
+static struct dhcp_lease *dhcp_leases;          /* In file order. */
+static size_t dhcp_lease_count;
+static size_t dhcp_lease_incomplete;
+static struct dhcp_lease **dhcp_leases_by_expiry;
+static struct shash dhcp_leases_by_ip = SHASH_INITIALIZER(&dhcp_leases_by_ip);
+static struct shash dhcp_leases_by_mac =
+    SHASH_INITIALIZER(&dhcp_leases_by_mac);
+
+static void
+dhcp_leases_clear(void)
 {
-    char cmd_buff[256];
-    char time[256], mac_addr[256], ip_addr[256];
-    char hostname[256], client_id[1024];
-    FILE *leasestream;
-    unsigned long lease_expiry;
-    time_t lease_time;
-    char *expiry_str;
-    int length;
-    bool print_header = 1;
+    shash_clear(&dhcp_leases_by_ip);
+    shash_clear(&dhcp_leases_by_mac);
+    free(dhcp_leases_by_expiry);
+    free(dhcp_leases);
+    free(dhcp_lease_buf);
+    dhcp_leases_by_expiry = NULL;
+    dhcp_leases = NULL;
+    dhcp_lease_buf = NULL;
+    dhcp_lease_count = 0;
+    dhcp_lease_incomplete = 0;
+    dhcp_lease_valid = false;
+}
 
-    strcpy(cmd_buff, DHCP_LEASE_SCRIPT);
-    strcat(cmd_buff, " show");
-
-    leasestream = popen(cmd_buff, "r");
-
-    if (leasestream) {
-        while (fscanf(leasestream, "%s", time)!= EOF) {
-            if (fscanf(leasestream, "%s %s %s %s",
-                       mac_addr, ip_addr, hostname, client_id) != 4) {
-                /*
-                 * We should always have mac_addr, ip_addr, hostname and
-                 * client-id for each entry in leases db. If not, log error
-                 * and break out of the loop.
-                 */
-                VLOG_ERR("DHCP leases entry is incomplete in leases DB.");
-                vty_out(vty, "DHCP leases entry is incomplete in leases DB.%s",
-                              VTY_NEWLINE);
-                break;
-            }
+static int
+dhcp_lease_expiry_cmp(const void *a_, const void *b_)
+{
+    const struct dhcp_lease *a = *(const struct dhcp_lease **) a_;
+    const struct dhcp_lease *b = *(const struct dhcp_lease **) b_;
 
-            if (print_header) {
-                vty_out(vty, "Expiry Time                MAC Address   "
-                             "      IP Address                   "
-                             "                 Hostname and Client-id%s",
-                              VTY_NEWLINE);
-                vty_out(vty, "-----------------------------------------"
-                             "-----------------------------------"
-                             "---------------------------------------%s",
-                              VTY_NEWLINE);
-                print_header = 0;
-            }
+    if (a->expiry != b->expiry) {
+        return a->expiry < b->expiry ? -1 : 1;
+    }
+    /* Leases expiring together stay in file order. */
+    return a < b ? -1 : a > b;
+}
+
+/* Splits the 'n' bytes of dhcp_lease_buf into leases.  Each line holds
+ * "expiry mac-address ip-address hostname client-id"; the "duid" line
+ * holding the DUID of the DHCPv6 server is skipped. */
+static void
+dhcp_leases_parse(size_t n)
+{
+    char *end = dhcp_lease_buf + n;
+    char *line, *next;
+    size_t i, lines = 1;
 
-            lease_expiry = atol(time);
-            lease_time = (time_t)lease_expiry;
-            expiry_str = ctime(&lease_time);
+    for (line = dhcp_lease_buf; line < end; line++) {
+        lines += *line == '\n';
+    }
+    dhcp_leases = xmalloc(lines * sizeof *dhcp_leases);
+
+    for (line = dhcp_lease_buf; line < end; line = next) {
+        char *eol = memchr(line, '\n', end - line);
+        char *fields[5], *token, *save_ptr = NULL;
+        struct dhcp_lease *lease;
+        int n_fields = 0;
+
+        if (eol) {
+            *eol = '\0';
+            next = eol + 1;
+        } else {
+            next = end;
+        }
 
-            length = strlen(expiry_str) - 1;
-            if (length >= 0 && expiry_str[length] == '\n') {
-                expiry_str[length] = '\0';
+        for (token = strtok_r(line, " \t\r", &save_ptr);
+             token && n_fields < 5;
+             token = strtok_r(NULL, " \t\r", &save_ptr)) {
+            fields[n_fields++] = token;
+        }
+        if (n_fields == 0 || !strcmp(fields[0], "duid")) {
+            continue;
+        }
+        if (n_fields < 5) {
+            /*
+             * We should always have mac_addr, ip_addr, hostname and
+             * client-id for each entry in leases db. If not, log error
+             * and skip the entry.
+             */
+            VLOG_ERR("DHCP leases entry is incomplete in leases DB.");
+            dhcp_lease_incomplete++;
+            continue;
+        }
+
+        lease = &dhcp_leases[dhcp_lease_count++];
+        lease->expiry = (time_t) strtoul(fields[0], NULL, 10);
+        lease->mac_addr = fields[1];
+        lease->ip_addr = fields[2];
+        lease->hostname = fields[3];
+        lease->client_id = fields[4];
+    }
+
+    /* Built backwards, so that each MAC address chain is in file order. */
+    dhcp_leases_by_expiry = xmalloc((dhcp_lease_count + 1)
+                                    * sizeof *dhcp_leases_by_expiry);
+    for (i = dhcp_lease_count; i-- > 0; ) {
+        struct dhcp_lease *lease = &dhcp_leases[i];
+
+        shash_replace(&dhcp_leases_by_ip, lease->ip_addr, lease);
+        lease->next_same_mac = shash_replace(&dhcp_leases_by_mac,
+                                             lease->mac_addr, lease);
+        dhcp_leases_by_expiry[i] = lease;
+    }
+    qsort(dhcp_leases_by_expiry, dhcp_lease_count,
+          sizeof *dhcp_leases_by_expiry, dhcp_lease_expiry_cmp);
+}
+
+/* Reads the leases printed by DHCP_LEASE_SCRIPT, for servers that keep no
+ * lease file. */
+static void
+dhcp_leases_read_script(void)
+{
+    size_t n = 0, size = 0;
+    FILE *stream;
+
+    stream = popen(DHCP_LEASE_SCRIPT " show", "r");
+    if (!stream) {
+        return;
+    }
+    do {
+        if (size - n < 4096) {
+            size = size * 2 + 4096;
+            dhcp_lease_buf = xrealloc(dhcp_lease_buf, size + 1);
+        }
+        n += fread(dhcp_lease_buf + n, 1, size - n, stream);
+    } while (!feof(stream) && !ferror(stream));
+    pclose(stream);
+    dhcp_lease_buf[n] = '\0';
+
+    dhcp_leases_parse(n);
+}
+
+/* Reads the command line of process 'pid' into 'ds', its arguments each
+ * followed by a null byte.  Returns true if it is the DHCP server. */
+static bool
+dhcp_server_read_cmdline(pid_t pid, struct ds *ds)
+{
+    char path[64];
+    const char *name;
+    FILE *stream;
+    int c;
+
+    snprintf(path, sizeof path, "/proc/%ld/cmdline", (long) pid);
+    stream = fopen(path, "r");
+    if (!stream) {
+        return false;
+    }
+    ds_clear(ds);
+    while ((c = getc(stream)) != EOF) {
+        ds_put_char(ds, c);
+    }
+    fclose(stream);
+
+    name = strrchr(ds_cstr(ds), '/');
+    name = name ? name + 1 : ds_cstr(ds);
+    return !strcmp(name, DHCP_SERVER_NAME);
+}
+
+/* Returns the pid of the DHCP server with its command line in 'ds', or 0
+ * if it is not running. */
+static pid_t
+dhcp_server_find(struct ds *ds)
+{
+    struct dirent *de;
+    pid_t pid = 0;
+    DIR *dir;
+
+    dir = opendir("/proc");
+    if (!dir) {
+        return 0;
+    }
+    while (!pid && (de = readdir(dir)) != NULL) {
+        pid_t candidate = strtol(de->d_name, NULL, 10);
+
+        if (candidate > 0 && dhcp_server_read_cmdline(candidate, ds)) {
+            pid = candidate;
+        }
+    }
+    closedir(dir);
+    return pid;
+}
+
+/* Returns the lease file set by 'stream', a dnsmasq configuration file,
+ * as a string the caller must free, "" for leasefile-ro, or NULL if it
+ * sets none. */
+static char *
+dhcp_server_parse_conf(FILE *stream)
+{
+    struct ds line = DS_EMPTY_INITIALIZER;
+    char *file = NULL;
+    char *s;
+
+    while (!file && !ds_get_line(&line, stream)) {
+        s = ds_cstr(&line);
+        s += strspn(s, " \t");
+        s[strcspn(s, " \t\r")] = '\0';
+
+        if (!strncmp(s, "dhcp-leasefile=", 15)) {
+            file = xstrdup(s + 15);
+        } else if (!strcmp(s, "leasefile-ro")) {
+            file = xstrdup("");
+        }
+    }
+    ds_destroy(&line);
+    return file;
+}
+
+/* Returns the lease file given by the 'n' bytes of 'args', the command
+ * line of the DHCP server, or by its configuration file, as a string the
+ * caller must free.  Returns "" if the server keeps no lease file. */
+static char *
+dhcp_server_lease_file(const char *args, size_t n)
+{
+    const char *conf_file = DHCP_SERVER_CONF;
+    const char *end = args + n;
+    const char *arg, *next;
+    char *file = NULL;
+    FILE *stream;
+
+    /* The first argument is the program. */
+    for (arg = args + strlen(args) + 1; arg < end; arg = next) {
+        next = arg + strlen(arg) + 1;
+        if (!strncmp(arg, "--dhcp-leasefile=", 17)) {
+            arg += 17;
+        } else if (!strncmp(arg, "-l", 2) && arg[2]) {
+            arg += 2;
+        } else if ((!strcmp(arg, "--dhcp-leasefile") || !strcmp(arg, "-l"))
+                   && next < end) {
+            arg = next;
+            next += strlen(next) + 1;
+        } else if (!strcmp(arg, "--leasefile-ro")) {
+            arg = "";
+        } else {
+            if (!strncmp(arg, "--conf-file=", 12)) {
+                conf_file = arg + 12;
+            } else if (!strncmp(arg, "-C", 2) && arg[2]) {
+                conf_file = arg + 2;
+            } else if ((!strcmp(arg, "--conf-file") || !strcmp(arg, "-C"))
+                       && next < end) {
+                conf_file = next;
+                next += strlen(next) + 1;
             }
+            continue;
+        }
+        if (!file) {
+            file = xstrdup(arg);
+        }
+    }
 
-            vty_out(vty, "%-26s %-19s %-45s %s       %s%s",
-                          expiry_str, mac_addr, ip_addr,
-                          hostname, client_id,
-                          VTY_NEWLINE);
+    if (!file) {
+        stream = fopen(conf_file, "r");
+        if (stream) {
+            file = dhcp_server_parse_conf(stream);
+            fclose(stream);
+        }
+    }
+    return file ? file : xstrdup(DHCP_LEASE_FILE);
+}
+
+/* Sets dhcp_lease_file to that of the running DHCP server.  Its command
+ * line is read every time, to notice a restart with other options, but
+ * the process table and the configuration file only when it changed.
+ * While the server is not running, the lease file it used last is kept. */
+static void
+dhcp_lease_file_sync(void)
+{
+    struct ds cmdline = DS_EMPTY_INITIALIZER;
+    pid_t pid = dhcp_server_pid;
+
+    if (!pid || !dhcp_server_read_cmdline(pid, &cmdline)) {
+        pid = dhcp_server_find(&cmdline);
+    }
+
+    if (!pid) {
+        if (!dhcp_lease_file) {
+            dhcp_lease_file = xstrdup(DHCP_LEASE_FILE);
+        }
+    } else if (!dhcp_lease_file || pid != dhcp_server_pid
+               || cmdline.length != dhcp_server_cmdline.length
+               || memcmp(ds_cstr(&cmdline), ds_cstr(&dhcp_server_cmdline),
+                         cmdline.length)) {
+        dhcp_leases_clear();
+        free(dhcp_lease_file);
+        dhcp_lease_file = dhcp_server_lease_file(ds_cstr(&cmdline),
+                                                 cmdline.length);
+        ds_swap(&cmdline, &dhcp_server_cmdline);
+    }
+    dhcp_server_pid = pid;
+    ds_destroy(&cmdline);
+}
+
+/* Brings the lease index up to date with the lease file of the DHCP
+ * server, or with DHCP_LEASE_SCRIPT if the server keeps none.  The file
+ * is read again only if its name, inode, size or modification time
+ * changed. */
+static void
+dhcp_leases_sync(void)
+{
+    struct stat st;
+    size_t n = 0;
+    ssize_t retval;
+    int fd;
+
+    dhcp_lease_file_sync();
+    if (!dhcp_lease_file[0] || stat(dhcp_lease_file, &st)) {
+        dhcp_leases_clear();
+        dhcp_leases_read_script();
+        return;
+    }
+    if (dhcp_lease_valid
+        && st.st_ino == dhcp_lease_ino
+        && st.st_size == dhcp_lease_size
+        && st.st_mtim.tv_sec == dhcp_lease_mtime.tv_sec
+        && st.st_mtim.tv_nsec == dhcp_lease_mtime.tv_nsec) {
+        return;
+    }
+
+    dhcp_leases_clear();
+    fd = open(dhcp_lease_file, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st)) {
+        close(fd);
+        return;
+    }
+
+    /* The server rewrites the file in place, so it is read rather than
+     * mapped: a mapping of a file truncated under it faults. */
+    dhcp_lease_buf = xmalloc(st.st_size + 1);
+    while (n < (size_t) st.st_size) {
+        retval = read(fd, dhcp_lease_buf + n, st.st_size - n);
+        if (retval < 0 && errno == EINTR) {
+            continue;
+        }
+        if (retval <= 0) {
+            break;
+        }
+        n += retval;
+    }
+    close(fd);
+    dhcp_lease_buf[n] = '\0';
+
+    dhcp_leases_parse(n);
+
+    dhcp_lease_ino = st.st_ino;
+    dhcp_lease_size = st.st_size;
+    dhcp_lease_mtime = st.st_mtim;
+    dhcp_lease_valid = true;
+}
+
+/* Returns the index in dhcp_leases_by_expiry of the first lease that
+ * expires after 't'. */
+static size_t
+dhcp_leases_expiring_after(time_t t)
+{
+    size_t lo = 0, hi = dhcp_lease_count;
 
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (dhcp_leases_by_expiry[mid]->expiry <= t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
+    }
+    return lo;
+}
+
+static void
+print_dhcp_lease(const struct dhcp_lease *lease, bool *print_header)
+{
+    char expiry_str[32];
+    int length;
 
-        pclose(leasestream);
+    if (*print_header) {
+        vty_out(vty, "Expiry Time                MAC Address   "
+                     "      IP Address                   "
+                     "                 Hostname and Client-id%s",
+                      VTY_NEWLINE);
+        vty_out(vty, "-----------------------------------------"
+                     "-----------------------------------"
+                     "---------------------------------------%s",
+                      VTY_NEWLINE);
+        *print_header = false;
+    }
+
+    if (!ctime_r(&lease->expiry, expiry_str)) {
+        expiry_str[0] = '\0';
+    }
+    length = strlen(expiry_str) - 1;
+    if (length >= 0 && expiry_str[length] == '\n') {
+        expiry_str[length] = '\0';
+    }
+
+    vty_out(vty, "%-26s %-19s %-45s %s       %s%s",
+                  expiry_str, lease->mac_addr, lease->ip_addr,
+                  lease->hostname, lease->client_id,
+                  VTY_NEWLINE);
+}
+
+static int
+print_dhcp_leases_end(bool print_header)
+{
+    if (dhcp_lease_incomplete) {
+        vty_out(vty, "DHCP leases entry is incomplete in leases DB.%s",
+                      VTY_NEWLINE);
     }
 
     if (print_header) {
@@ -290,6 +675,84 @@ static int show_dhcp_leases(void)
     return CMD_SUCCESS;
 }
 
+static int show_dhcp_leases(void)
+{
+    bool print_header = true;
+    size_t i;
+
+    dhcp_leases_sync();
+    for (i = 0; i < dhcp_lease_count; i++) {
+        print_dhcp_lease(&dhcp_leases[i], &print_header);
+    }
+
+    return print_dhcp_leases_end(print_header);
+}
+
+static int show_dhcp_leases_by_ip(const char *ip_addr)
+{
+    bool print_header = true;
+    const struct dhcp_lease *lease;
+    char addr_str[INET6_ADDRSTRLEN];
+    struct in6_addr addr;
+    int family = strchr(ip_addr, ':') ? AF_INET6 : AF_INET;
+
+    /* The server writes addresses in their inet_ntop() form. */
+    if (inet_pton(family, ip_addr, &addr) == 1
+        && inet_ntop(family, &addr, addr_str, sizeof addr_str)) {
+        ip_addr = addr_str;
+    }
+
+    dhcp_leases_sync();
+    lease = shash_find_data(&dhcp_leases_by_ip, ip_addr);
+    if (lease) {
+        print_dhcp_lease(lease, &print_header);
+    }
+
+    return print_dhcp_leases_end(print_header);
+}
+
+static int show_dhcp_leases_by_mac(const char *mac_addr)
+{
+    bool print_header = true;
+    const struct dhcp_lease *lease;
+    char mac_str[32];
+    unsigned int b[6];
+
+    /* The server writes MAC addresses as lower case hex pairs. */
+    if (sscanf(mac_addr, "%x:%x:%x:%x:%x:%x",
+               &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+        snprintf(mac_str, sizeof mac_str, "%02x:%02x:%02x:%02x:%02x:%02x",
+                 b[0] & 0xff, b[1] & 0xff, b[2] & 0xff,
+                 b[3] & 0xff, b[4] & 0xff, b[5] & 0xff);
+        mac_addr = mac_str;
+    }
+
+    dhcp_leases_sync();
+    for (lease = shash_find_data(&dhcp_leases_by_mac, mac_addr); lease;
+         lease = lease->next_same_mac) {
+        print_dhcp_lease(lease, &print_header);
+    }
+
+    return print_dhcp_leases_end(print_header);
+}
+
+static int show_dhcp_leases_expiring(unsigned long seconds)
+{
+    bool print_header = true;
+    size_t i, end;
+
+    dhcp_leases_sync();
+
+    /* Infinite leases, with an expiry of 0, sort first and are skipped. */
+    i = dhcp_leases_expiring_after(0);
+    end = dhcp_leases_expiring_after(time(NULL) + (time_t) seconds);
+    for (; i < end; i++) {
+        print_dhcp_lease(dhcp_leases_by_expiry[i], &print_header);
+    }
+
+    return print_dhcp_leases_end(print_header);
+}
+
 
 static int show_dhcp_range(void)
 {
@@ -699,6 +1162,402 @@ static const struct ovsrec_vrf* dhcp_server_vrf_lookup(const char *vrf_name)
     return NULL;
 }
 
+/*
+ * Index of the DHCP server ranges and static hosts of the default VRF,
+ * for the conflict checks of new entries.  It is rebuilt from the
+ * DHCP_Server row when one of its tables changes, except that the entries
+ * this CLI adds or deletes are applied to it in place.
+ */
+enum {
+    DHCP_AF_IPV4,
+    DHCP_AF_IPV6,
+    DHCP_N_AF
+};
+
+/* An address as a 16 byte big endian number, so that memcmp() orders
+ * the addresses of a family numerically. */
+struct dhcp_addr {
+    uint8_t b[16];
+};
+
+/* A range in the interval tree of its address family: a treap ordered by
+ * start address, where each node also holds the largest end address of
+ * its subtree. */
+struct dhcp_range_node {
+    struct dhcp_range_node *left, *right;
+    long priority;
+    int family;
+    struct dhcp_addr start, end;
+    struct dhcp_addr max_end;
+    const char *name;                   /* Key in dhcp_range_names. */
+    char *tags;                         /* See dhcp_range_tags(). */
+};
+
+static const struct ovsdb_idl_table_class *const dhcp_index_tables[] = {
+    &ovsrec_table_vrf, &ovsrec_table_dhcp_server,
+    &ovsrec_table_dhcpsrv_range, &ovsrec_table_dhcpsrv_static_host,
+};
+static struct vtysh_idl_cache dhcp_index_cache =
+    VTYSH_IDL_CACHE_INITIALIZER(dhcp_index_tables);
+static struct dhcp_range_node *dhcp_ranges[DHCP_N_AF];
+static struct shash dhcp_range_names = SHASH_INITIALIZER(&dhcp_range_names);
+/* Static host addresses, see dhcp_addr_key(). */
+static struct shash dhcp_hosts = SHASH_INITIALIZER(&dhcp_hosts);
+
+/* Parses 'str' into 'addr'.  Returns its DHCP_AF_* family, or -1 if it is
+ * not an address. */
+static int
+dhcp_addr_parse(const char *str, struct dhcp_addr *addr)
+{
+    memset(addr, 0, sizeof *addr);
+    if (inet_pton(AF_INET, str, &addr->b[12]) == 1) {
+        return DHCP_AF_IPV4;
+    }
+    if (inet_pton(AF_INET6, str, addr->b) == 1) {
+        return DHCP_AF_IPV6;
+    }
+    return -1;
+}
+
+/* Formats the address of 'str' in its inet_ntop() form into 'key', so
+ * that different spellings of an address match. */
+static int
+dhcp_addr_key(const char *str, char key[INET6_ADDRSTRLEN])
+{
+    struct dhcp_addr addr;
+    int family = dhcp_addr_parse(str, &addr);
+
+    if (family == DHCP_AF_IPV4) {
+        inet_ntop(AF_INET, &addr.b[12], key, INET6_ADDRSTRLEN);
+    } else if (family == DHCP_AF_IPV6) {
+        inet_ntop(AF_INET6, addr.b, key, INET6_ADDRSTRLEN);
+    }
+    return family;
+}
+
+static int
+dhcp_tag_cmp(const void *a_, const void *b_)
+{
+    const char *const *a = a_;
+    const char *const *b = b_;
+
+    return strcmp(*a, *b);
+}
+
+/* The tags of a range as one string: its set tag, then its sorted match
+ * tags.  dnsmasq picks a range for a client by its match tags, so ranges
+ * only conflict when they overlap with the same tags. */
+static char *
+dhcp_range_tags(const char *set_tag, char **match_tags, size_t n_match_tags)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    char **sorted;
+    size_t i;
+
+    sorted = xmalloc(n_match_tags * sizeof *sorted);
+    for (i = 0; i < n_match_tags; i++) {
+        sorted[i] = match_tags[i];
+    }
+    qsort(sorted, n_match_tags, sizeof *sorted, dhcp_tag_cmp);
+    ds_put_cstr(&ds, set_tag ? set_tag : "");
+    for (i = 0; i < n_match_tags; i++) {
+        ds_put_format(&ds, "%c%s", i ? ',' : ';', sorted[i]);
+    }
+    free(sorted);
+    return ds_steal_cstr(&ds);
+}
+
+/* dhcp_range_tags() of a comma separated list of match tags, which may be
+ * NULL. */
+static char *
+dhcp_range_tags_str(const char *set_tag, const char *match_tags)
+{
+    char *list = match_tags ? xstrdup(match_tags) : NULL;
+    char **tags = NULL;
+    char *save_ptr = NULL;
+    char *token, *key;
+    size_t n = 0, allocated = 0;
+
+    for (token = list ? strtok_r(list, ",", &save_ptr) : NULL; token;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        if (n >= allocated) {
+            tags = x2nrealloc(tags, &allocated, sizeof *tags);
+        }
+        tags[n++] = token;
+    }
+    key = dhcp_range_tags(set_tag, tags, n);
+    free(tags);
+    free(list);
+    return key;
+}
+
+static int
+dhcp_range_cmp(const struct dhcp_range_node *a,
+               const struct dhcp_range_node *b)
+{
+    int cmp = memcmp(&a->start, &b->start, sizeof a->start);
+
+    if (cmp) {
+        return cmp;
+    }
+    /* Ranges with the same start are kept apart by address. */
+    return a < b ? -1 : a > b;
+}
+
+static void
+dhcp_range_update(struct dhcp_range_node *node)
+{
+    node->max_end = node->end;
+    if (node->left
+        && memcmp(&node->left->max_end, &node->max_end,
+                  sizeof node->max_end) > 0) {
+        node->max_end = node->left->max_end;
+    }
+    if (node->right
+        && memcmp(&node->right->max_end, &node->max_end,
+                  sizeof node->max_end) > 0) {
+        node->max_end = node->right->max_end;
+    }
+}
+
+static struct dhcp_range_node *
+dhcp_range_insert(struct dhcp_range_node *root, struct dhcp_range_node *node)
+{
+    struct dhcp_range_node *child;
+
+    if (!root) {
+        dhcp_range_update(node);
+        return node;
+    }
+
+    if (dhcp_range_cmp(node, root) < 0) {
+        root->left = dhcp_range_insert(root->left, node);
+        if (root->left->priority > root->priority) {
+            child = root->left;
+            root->left = child->right;
+            dhcp_range_update(root);
+            child->right = root;
+            root = child;
+        }
+    } else {
+        root->right = dhcp_range_insert(root->right, node);
+        if (root->right->priority > root->priority) {
+            child = root->right;
+            root->right = child->left;
+            dhcp_range_update(root);
+            child->left = root;
+            root = child;
+        }
+    }
+    dhcp_range_update(root);
+    return root;
+}
+
+/* Joins the treaps 'a' and 'b', where all of 'a' orders before 'b'. */
+static struct dhcp_range_node *
+dhcp_range_join(struct dhcp_range_node *a, struct dhcp_range_node *b)
+{
+    if (!a || !b) {
+        return a ? a : b;
+    }
+
+    if (a->priority > b->priority) {
+        a->right = dhcp_range_join(a->right, b);
+        dhcp_range_update(a);
+        return a;
+    } else {
+        b->left = dhcp_range_join(a, b->left);
+        dhcp_range_update(b);
+        return b;
+    }
+}
+
+static struct dhcp_range_node *
+dhcp_range_remove(struct dhcp_range_node *root, struct dhcp_range_node *node)
+{
+    if (!root) {
+        return NULL;
+    }
+
+    if (root == node) {
+        return dhcp_range_join(root->left, root->right);
+    } else if (dhcp_range_cmp(node, root) < 0) {
+        root->left = dhcp_range_remove(root->left, node);
+    } else {
+        root->right = dhcp_range_remove(root->right, node);
+    }
+    dhcp_range_update(root);
+    return root;
+}
+
+/* Returns a range under 'node' that overlaps 'start' to 'end' and has the
+ * tags 'tags', or NULL.  Only the subtrees that can hold an overlapping
+ * range are visited. */
+static const struct dhcp_range_node *
+dhcp_range_find_overlap(const struct dhcp_range_node *node,
+                        const struct dhcp_addr *start,
+                        const struct dhcp_addr *end, const char *tags)
+{
+    const struct dhcp_range_node *found;
+
+    /* No range of the subtree reaches 'start'. */
+    if (!node || memcmp(&node->max_end, start, sizeof *start) < 0) {
+        return NULL;
+    }
+
+    found = dhcp_range_find_overlap(node->left, start, end, tags);
+    if (found) {
+        return found;
+    }
+
+    /* This range, and all those to its right, start after 'end'. */
+    if (memcmp(&node->start, end, sizeof *end) > 0) {
+        return NULL;
+    }
+    if (memcmp(start, &node->end, sizeof *start) <= 0
+        && !strcmp(node->tags, tags)) {
+        return node;
+    }
+    return dhcp_range_find_overlap(node->right, start, end, tags);
+}
+
+static void
+dhcp_range_free(struct dhcp_range_node *node)
+{
+    if (node) {
+        dhcp_range_free(node->left);
+        dhcp_range_free(node->right);
+        free(node->tags);
+        free(node);
+    }
+}
+
+/* Adds range 'name' from 'start_ip_address' to 'end_ip_address', which
+ * may be NULL for a range of one address, with the dhcp_range_tags()
+ * 'tags'. */
+static void
+dhcp_index_add_range(const char *name, const char *start_ip_address,
+                     const char *end_ip_address, const char *tags)
+{
+    struct dhcp_range_node *node = xzalloc(sizeof *node);
+    int family = dhcp_addr_parse(start_ip_address, &node->start);
+
+    if (!end_ip_address) {
+        node->end = node->start;
+    } else if (dhcp_addr_parse(end_ip_address, &node->end) != family) {
+        family = -1;
+    }
+    if (family < 0 || shash_find(&dhcp_range_names, name)) {
+        free(node);
+        return;
+    }
+
+    node->priority = random();
+    node->family = family;
+    node->tags = xstrdup(tags);
+    dhcp_ranges[family] = dhcp_range_insert(dhcp_ranges[family], node);
+    node->name = shash_add(&dhcp_range_names, name, node)->name;
+}
+
+static void
+dhcp_index_remove_range(const char *name)
+{
+    struct dhcp_range_node *node = shash_find_and_delete(&dhcp_range_names,
+                                                         name);
+
+    if (node) {
+        int family = node->family;
+
+        dhcp_ranges[family] = dhcp_range_remove(dhcp_ranges[family], node);
+        free(node->tags);
+        free(node);
+    }
+}
+
+/* Adds a static host with 'ip_address'. */
+static void
+dhcp_index_add_host(const char *ip_address)
+{
+    char key[INET6_ADDRSTRLEN];
+
+    if (dhcp_addr_key(ip_address, key) >= 0) {
+        shash_add_once(&dhcp_hosts, key, NULL);
+    }
+}
+
+static void
+dhcp_index_remove_host(const char *ip_address)
+{
+    char key[INET6_ADDRSTRLEN];
+
+    if (dhcp_addr_key(ip_address, key) >= 0) {
+        shash_find_and_delete(&dhcp_hosts, key);
+    }
+}
+
+static void
+dhcp_index_clear(void)
+{
+    int family;
+
+    shash_clear(&dhcp_hosts);
+    shash_clear(&dhcp_range_names);
+    for (family = 0; family < DHCP_N_AF; family++) {
+        dhcp_range_free(dhcp_ranges[family]);
+        dhcp_ranges[family] = NULL;
+    }
+}
+
+/* Brings the index up to date with 'dhcp_server_row', which may be NULL
+ * if the VRF has no DHCP server configuration. */
+static void
+dhcp_index_sync(const struct ovsrec_dhcp_server *dhcp_server_row)
+{
+    const struct ovsrec_dhcpsrv_range *range_row;
+    char *tags;
+    size_t i;
+
+    if (vtysh_idl_cache_check(&dhcp_index_cache)) {
+        return;
+    }
+
+    dhcp_index_clear();
+    for (i = 0; dhcp_server_row && i < dhcp_server_row->n_ranges; i++) {
+        range_row = dhcp_server_row->ranges[i];
+        tags = dhcp_range_tags(range_row->set_tag, range_row->match_tags,
+                               range_row->n_match_tags);
+        dhcp_index_add_range(range_row->name, range_row->start_ip_address,
+                             range_row->end_ip_address, tags);
+        free(tags);
+    }
+    for (i = 0; dhcp_server_row && i < dhcp_server_row->n_static_hosts;
+         i++) {
+        dhcp_index_add_host(dhcp_server_row->static_hosts[i]->ip_address);
+    }
+}
+
+/* Called after this CLI committed the insertion or deletion of one range
+ * or static host, which it already applied to the index.  ovsdb-server
+ * sends the update for a transaction before its reply, so the index stays
+ * valid if that row is the only one of those tables that changed since
+ * the index was last current. */
+static void
+dhcp_index_committed(void)
+{
+    size_t n_ranges, n_hosts;
+
+    n_ranges = vtysh_idl_cache_changed_rows(&dhcp_index_cache,
+                                            &ovsrec_table_dhcpsrv_range);
+    n_hosts = vtysh_idl_cache_changed_rows(&dhcp_index_cache,
+                                           &ovsrec_table_dhcpsrv_static_host);
+    if (dhcp_index_cache.valid && n_ranges != SIZE_MAX
+        && n_hosts != SIZE_MAX && n_ranges + n_hosts == 1) {
+        vtysh_idl_cache_update(&dhcp_index_cache);
+    } else {
+        vtysh_idl_cache_invalidate(&dhcp_index_cache);
+    }
+}
+
 static int tftp_server_enable_disable(bool enable)
 {
     const struct ovsrec_system *ovs_row = NULL;
@@ -1672,13 +2531,13 @@ static int dhcp_server_add_static_host(
     const struct ovsrec_vrf *vrf_row = NULL;
     struct ovsrec_dhcp_server *dhcp_server_row = NULL;
     struct ovsrec_dhcpsrv_static_host *dhcpsrv_static_host_row = NULL;
-    struct ovsrec_dhcpsrv_static_host *dhcpsrv_static_host_temp = NULL;
     struct ovsdb_idl_txn *status_txn = NULL;
     struct ovsrec_dhcpsrv_static_host **d_static_host = NULL;
+    char ip_key[INET6_ADDRSTRLEN];
     size_t i;
     char *tags, *token, *macs;
     char **set_tags, **mac_list;
-    int num_tags, num_macs;
+    int num_tags, num_macs, family;
 
     enum ovsdb_idl_txn_status status;
 
@@ -1701,28 +2560,26 @@ static int dhcp_server_add_static_host(
             return CMD_OVSDB_FAILURE;
     }
 
+    dhcp_index_sync(vrf_row->dhcp_server);
+    family = dhcp_addr_key(static_host_params->ip_address, ip_key);
+    if (family >= 0 && shash_find(&dhcp_hosts, ip_key)) {
+        vty_out(vty, "Static host with IP address \"%s\" is "
+                     "already configured. "
+                     "Please use different IP address or delete the "
+                     "existing config and reconfigure.%s",
+                      static_host_params->ip_address, VTY_NEWLINE);
+        VLOG_ERR( "Static host with IP address \"%s\" is "
+                  "already configured.",
+                   static_host_params->ip_address);
+        cli_do_config_abort(status_txn);
+        return (CMD_SUCCESS);
+    }
+
     if (!vrf_row->dhcp_server) {
         dhcp_server_row = ovsrec_dhcp_server_insert(status_txn);
         ovsrec_vrf_set_dhcp_server(vrf_row, dhcp_server_row);
     } else {
         dhcp_server_row = vrf_row->dhcp_server;
-        for (i = 0; i < dhcp_server_row->n_static_hosts; i++) {
-            dhcpsrv_static_host_temp = dhcp_server_row->static_hosts[i];
-            if (strcmp(dhcpsrv_static_host_temp->ip_address,
-                       static_host_params->ip_address) == 0) {
-                vty_out(vty, "Static host with IP address \"%s\" is "
-                             "already configured. "
-                             "Please use different IP address or delete the "
-                             "existing config and reconfigure.%s",
-                              static_host_params->ip_address, VTY_NEWLINE);
-                VLOG_ERR( "Static host with IP address \"%s\" is "
-                          "already configured.",
-                           static_host_params->ip_address);
-                cli_do_config_abort(status_txn);
-                return (CMD_SUCCESS);
-            }
-        }
-
     }
 
     dhcpsrv_static_host_row = ovsrec_dhcpsrv_static_host_insert(status_txn);
@@ -1838,6 +2695,8 @@ static int dhcp_server_add_static_host(
     status = cli_do_config_finish(status_txn);
 
     if (status == TXN_SUCCESS) {
+        dhcp_index_add_host(static_host_params->ip_address);
+        dhcp_index_committed();
         VLOG_INFO("%s The command succeeded and "
                   "dhcp-static-host \"%s\" was added "
                   "successfully.\n", __func__,
@@ -1911,6 +2770,7 @@ static int dhcp_server_delete_static_host(
             return CMD_SUCCESS;
     }
 
+    dhcp_index_sync(dhcp_server_row);
     for (i = 0; i < dhcp_server_row->n_static_hosts; i++) {
         dhcpsrv_static_host_temp = dhcp_server_row->static_hosts[i];
         if (strcmp(dhcpsrv_static_host_temp->ip_address,
@@ -1949,6 +2809,8 @@ static int dhcp_server_delete_static_host(
     status = cli_do_config_finish(status_txn);
 
     if (status == TXN_SUCCESS) {
+        dhcp_index_remove_host(static_host_params->ip_address);
+        dhcp_index_committed();
         VLOG_INFO("%s The command succeeded and static host config with "
                   "IP address \"%s\" was deleted "
                   "successfully.\n", __func__,
@@ -2020,6 +2882,7 @@ static int dhcp_server_delete_range(dhcp_srv_range_params_t *range_params)
             return CMD_SUCCESS;
     }
 
+    dhcp_index_sync(dhcp_server_row);
     for (i = 0; i < dhcp_server_row->n_ranges; i++) {
         dhcpsrv_range_temp = dhcp_server_row->ranges[i];
         if (strcmp(dhcpsrv_range_temp->name, range_params->name) == 0) {
@@ -2057,6 +2920,8 @@ static int dhcp_server_delete_range(dhcp_srv_range_params_t *range_params)
     status = cli_do_config_finish(status_txn);
 
     if (status == TXN_SUCCESS) {
+        dhcp_index_remove_range(range_params->name);
+        dhcp_index_committed();
         VLOG_INFO("%s The command succeeded and dhcp-range \"%s\" was deleted "
                   "successfully.\n", __func__, range_params->name);
         return CMD_SUCCESS;
@@ -2080,13 +2945,14 @@ static int dhcp_server_add_range(dhcp_srv_range_params_t *range_params)
     const struct ovsrec_vrf *vrf_row = NULL;
     struct ovsrec_dhcp_server *dhcp_server_row = NULL;
     struct ovsrec_dhcpsrv_range *dhcpsrv_range_row = NULL;
-    struct ovsrec_dhcpsrv_range *dhcpsrv_range_temp = NULL;
     struct ovsdb_idl_txn *status_txn = NULL;
     struct ovsrec_dhcpsrv_range **d_range = NULL;
+    const struct dhcp_range_node *overlap;
+    struct dhcp_addr start_addr, end_addr;
     size_t i;
-    char *tags, *token;
+    char *tags, *token, *range_tags;
     char **m_tags;
-    int num_tags;
+    int num_tags, family;
 
     enum ovsdb_idl_txn_status status;
 
@@ -2109,27 +2975,48 @@ static int dhcp_server_add_range(dhcp_srv_range_params_t *range_params)
             return CMD_OVSDB_FAILURE;
     }
 
+    dhcp_index_sync(vrf_row->dhcp_server);
+    if (shash_find(&dhcp_range_names, range_params->name)) {
+        vty_out(vty, "IP address range with name \"%s\" is "
+                     "already configured. "
+                     "Please use different name or delete the "
+                     "existing config and reconfigure.%s",
+                      range_params->name, VTY_NEWLINE);
+        VLOG_ERR( "IP address range with name \"%s\" "
+                  "is already configured.",
+                   range_params->name);
+        cli_do_config_abort(status_txn);
+        return (CMD_SUCCESS);
+    }
+
+    family = dhcp_addr_parse(range_params->start_ip_address, &start_addr);
+    if (range_params->end_ip_address == NULL
+        || dhcp_addr_parse(range_params->end_ip_address, &end_addr) < 0) {
+        end_addr = start_addr;
+    }
+    range_tags = dhcp_range_tags_str(range_params->set_tag,
+                                     range_params->match_tags);
+    overlap = family < 0 ? NULL
+              : dhcp_range_find_overlap(dhcp_ranges[family], &start_addr,
+                                        &end_addr, range_tags);
+    if (overlap) {
+        vty_out(vty, "IP address range overlaps with the range \"%s\", "
+                     "which has the same tags. "
+                     "Please use different addresses or delete the "
+                     "existing config and reconfigure.%s",
+                      overlap->name, VTY_NEWLINE);
+        VLOG_ERR( "IP address range \"%s\" overlaps with the range "
+                  "\"%s\".", range_params->name, overlap->name);
+        free(range_tags);
+        cli_do_config_abort(status_txn);
+        return (CMD_SUCCESS);
+    }
+
     if (!vrf_row->dhcp_server) {
         dhcp_server_row = ovsrec_dhcp_server_insert(status_txn);
         ovsrec_vrf_set_dhcp_server(vrf_row, dhcp_server_row);
     } else {
         dhcp_server_row = vrf_row->dhcp_server;
-        for (i = 0; i < dhcp_server_row->n_ranges; i++) {
-            dhcpsrv_range_temp = dhcp_server_row->ranges[i];
-            if (strcmp(dhcpsrv_range_temp->name, range_params->name) == 0) {
-                vty_out(vty, "IP address range with name \"%s\" is "
-                             "already configured. "
-                             "Please use different name or delete the "
-                             "existing config and reconfigure.%s",
-                              range_params->name, VTY_NEWLINE);
-                VLOG_ERR( "IP address range with name \"%s\" "
-                          "is already configured.",
-                           range_params->name);
-                cli_do_config_abort(status_txn);
-                return (CMD_SUCCESS);
-            }
-        }
-
     }
 
     dhcpsrv_range_row = ovsrec_dhcpsrv_range_insert(status_txn);
@@ -2217,10 +3104,18 @@ static int dhcp_server_add_range(dhcp_srv_range_params_t *range_params)
     status = cli_do_config_finish(status_txn);
 
     if (status == TXN_SUCCESS) {
+        dhcp_index_add_range(range_params->name,
+                             range_params->start_ip_address,
+                             range_params->end_ip_address, range_tags);
+        free(range_tags);
+        dhcp_index_committed();
         VLOG_INFO("%s The command succeeded and dhcp-range \"%s\" was added "
                   "successfully.\n", __func__, range_params->name);
         return CMD_SUCCESS;
-    } else if (status == TXN_UNCHANGED) {
+    }
+
+    free(range_tags);
+    if (status == TXN_UNCHANGED) {
         VLOG_ERR("%s The command resulted in no change. "
                  "Check if dhcp-range\"%s\" "
                  "is already present", __func__, range_params->name);
@@ -2305,6 +3200,46 @@ DEFUN(cli_dhcp_leases_show,
     return show_dhcp_leases();
 }
 
+DEFUN(cli_dhcp_leases_show_ip,
+      cli_dhcp_leases_show_ip_cmd,
+      "show dhcp-server leases ip (A.B.C.D|X:X::X:X)",
+      SHOW_STR
+      "Display DHCP Server Configuration\n"
+      "Show DHCP leases maintained by DHCP server.\n"
+      "Show the lease of an IP address\n"
+      "IPv4 address\n"
+      "IPv6 address\n"
+      )
+{
+    return show_dhcp_leases_by_ip(argv[0]);
+}
+
+DEFUN(cli_dhcp_leases_show_mac,
+      cli_dhcp_leases_show_mac_cmd,
+      "show dhcp-server leases mac MAC",
+      SHOW_STR
+      "Display DHCP Server Configuration\n"
+      "Show DHCP leases maintained by DHCP server.\n"
+      "Show the leases of a MAC address\n"
+      "MAC address (xx:xx:xx:xx:xx:xx)\n"
+      )
+{
+    return show_dhcp_leases_by_mac(argv[0]);
+}
+
+DEFUN(cli_dhcp_leases_show_expiring,
+      cli_dhcp_leases_show_expiring_cmd,
+      "show dhcp-server leases expiring-within <1-4294967295>",
+      SHOW_STR
+      "Display DHCP Server Configuration\n"
+      "Show DHCP leases maintained by DHCP server.\n"
+      "Show the leases expiring within a time\n"
+      "Time in seconds\n"
+      )
+{
+    return show_dhcp_leases_expiring(strtoul(argv[0], NULL, 10));
+}
+
 DEFUN(cli_show_tftp_server,
       cli_show_tftp_server_cmd,
       "show tftp-server",
@@ -3424,6 +4359,9 @@ void
 dhcp_tftp_vty_init (void)
 {
     install_element (ENABLE_NODE, &cli_dhcp_leases_show_cmd);
+    install_element (ENABLE_NODE, &cli_dhcp_leases_show_ip_cmd);
+    install_element (ENABLE_NODE, &cli_dhcp_leases_show_mac_cmd);
+    install_element (ENABLE_NODE, &cli_dhcp_leases_show_expiring_cmd);
 
     install_element(DHCP_SERVER_NODE, &cli_dhcp_server_range_add_cmd);
     install_element(DHCP_SERVER_NODE, &cli_dhcp_server_range_delete_cmd);
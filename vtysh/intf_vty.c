@@ -49,6 +49,7 @@
 #include "vtysh/mgmt_intf_vty.h"
 #include "vtysh/vtysh_ovsdb_intf_context.h"
 #include "lacp_vty.h"
+#include "timeval.h"
 
 VLOG_DEFINE_THIS_MODULE(vtysh_interface_cli);
 extern struct ovsdb_idl *idl;
@@ -207,49 +208,141 @@ DEFUN_NO_FORM (cli_intf_shutdown,
         "Enable/disable an interface\n");
 
 
-void
-dyncb_helpstr_speeds(struct cmd_token *token, struct vty *vty, \
-                     char * const helpstr, int max_strlen)
+/*
+ * Interface capabilities for the dynamic help strings.
+ *
+ * The hw_intf_info "speeds" of every interface split once, and split
+ * again only when the value changes.  intf_caps_sync() rebuilds the
+ * index when the Interface table changes.
+ */
+struct intf_caps
 {
-    const struct ovsrec_interface * row = NULL;
-    const char *speeds_list = NULL;
-    char * tmp = NULL;
-    int len = 0;
-    row = ovsrec_interface_first(idl);
-    if (!row)
+    char *speeds_raw;           /* "speeds" value last split, or NULL. */
+    char *speeds_buf;           /* Split copy of speeds_raw. */
+    const char **speeds;
+    size_t n_speeds;
+    unsigned int generation;    /* Last sync that saw the interface. */
+};
+
+/* Interface name -> struct intf_caps. */
+static struct shash intf_caps_index = SHASH_INITIALIZER(&intf_caps_index);
+static const struct ovsdb_idl_table_class *const intf_caps_tables[] = {
+    &ovsrec_table_interface,
+};
+static struct vtysh_idl_cache intf_caps_cache =
+    VTYSH_IDL_CACHE_INITIALIZER(intf_caps_tables);
+static unsigned int intf_caps_generation;
+
+static void
+intf_caps_clear(struct intf_caps *caps)
+{
+    free(caps->speeds_raw);
+    free(caps->speeds_buf);
+    free(caps->speeds);
+    caps->speeds_raw = NULL;
+    caps->speeds_buf = NULL;
+    caps->speeds = NULL;
+    caps->n_speeds = 0;
+}
+
+static void
+intf_caps_update(struct intf_caps *caps, const char *speeds_list)
+{
+    size_t allocated = 0;
+    char *save_ptr = NULL;
+    char *tmp;
+
+    if (speeds_list == NULL ? caps->speeds_raw == NULL
+        : caps->speeds_raw != NULL && !strcmp(caps->speeds_raw, speeds_list))
     {
-        VLOG_ERR(OVSDB_ROW_FETCH_ERROR);
-        return NULL;
+        return;
     }
 
+    intf_caps_clear(caps);
+    if (speeds_list == NULL)
+        return;
+
+    caps->speeds_raw = xstrdup(speeds_list);
+    caps->speeds_buf = xstrdup(speeds_list);
+    for (tmp = strtok_r(caps->speeds_buf, ",", &save_ptr); tmp != NULL;
+         tmp = strtok_r(NULL, ",", &save_ptr))
+    {
+        if (caps->n_speeds >= allocated)
+            caps->speeds = x2nrealloc(caps->speeds, &allocated,
+                                      sizeof *caps->speeds);
+        caps->speeds[caps->n_speeds++] = tmp;
+    }
+}
+
+/* The caller must hold the OVSDB lock. */
+static void
+intf_caps_sync(void)
+{
+    const struct ovsrec_interface *row = NULL;
+    struct intf_caps *caps;
+    struct shash_node *node, *next;
+
+    if (vtysh_idl_cache_check(&intf_caps_cache))
+        return;
+    intf_caps_generation++;
+
     OVSREC_INTERFACE_FOR_EACH(row, idl)
     {
-        if(strcmp(row->name, vty->index) != 0)
-            continue;
+        caps = shash_find_data(&intf_caps_index, row->name);
+        if (!caps)
+        {
+            caps = xzalloc(sizeof *caps);
+            shash_add(&intf_caps_index, row->name, caps);
+        }
+        caps->generation = intf_caps_generation;
+        intf_caps_update(caps, smap_get(&row->hw_intf_info, "speeds"));
+    }
 
-        speeds_list = smap_get(&row->hw_intf_info, "speeds");
-        if (speeds_list != NULL)
+    SHASH_FOR_EACH_SAFE(node, next, &intf_caps_index)
+    {
+        caps = node->data;
+        if (caps->generation != intf_caps_generation)
         {
-            char * cur_state = calloc(strlen(speeds_list) + 1, sizeof(char));
-            strcpy(cur_state, speeds_list);
-            tmp = strtok(cur_state, ",");
-            while (tmp != NULL)
+            intf_caps_clear(caps);
+            free(caps);
+            shash_delete(&intf_caps_index, node);
+        }
+    }
+}
+
+void
+dyncb_helpstr_speeds(struct cmd_token *token, struct vty *vty, \
+                     char * const helpstr, int max_strlen)
+{
+    const struct intf_caps *caps;
+    const char *help = NULL;
+    size_t i;
+
+    /* The describe path runs without the lock, and the memo is read from
+       the Interface rows the OVSDB thread updates. */
+    VTYSH_OVSDB_LOCK;
+    intf_caps_sync();
+    caps = shash_find_data(&intf_caps_index, vty->index);
+    if (caps && caps->speeds_raw == NULL)
+    {
+        help = "Mb/s not configured";
+    }
+    else if (caps)
+    {
+        help = "Mb/s not supported";
+        for (i = 0; i < caps->n_speeds; i++)
+        {
+            if (strcmp(caps->speeds[i], token->cmd) == 0)
             {
-                if (strcmp(tmp, token->cmd) == 0)
-                {
-                    snprintf(helpstr, max_strlen, "Mb/s supported");
-                    free(cur_state);
-                    return;
-                }
-                tmp = strtok(NULL, ",");
+                help = "Mb/s supported";
+                break;
             }
-            snprintf(helpstr, max_strlen, "Mb/s not supported");
-            free(cur_state);
         }
-        else
-            snprintf(helpstr, max_strlen, "Mb/s not configured");
     }
-    return;
+    VTYSH_OVSDB_UNLOCK;
+
+    if (help)
+        snprintf(helpstr, max_strlen, "%s", help);
 }
 
 /*
@@ -1042,16 +1135,14 @@ vty_out (vty, "interface %s %s", row->name, VTY_NEWLINE);\
  *  Function : parse_vlan
  *  Responsibility : Used for VLAN related config
  *  Parameters :
- *      const char *if_name           : Name of interface
+ *      const struct ovsrec_port *port_row : Port of the interface
  *      struct vty* vty               : Used for ouput
  */
 static int
-parse_vlan(const char *if_name, struct vty* vty)
+parse_vlan(const struct ovsrec_port *port_row, struct vty* vty)
 {
-    const struct ovsrec_port *port_row;
     int i;
 
-    port_row = port_find(if_name);
     if (port_row == NULL)
     {
         return 0;
@@ -1111,27 +1202,27 @@ parse_vlan(const char *if_name, struct vty* vty)
  *  Function : parse_l3config
  *  Responsibility : Used for L3 related config
  *  Parameters :
- *      const char *if_name           : Name of interface
+ *      const struct intf_join *join  : Join entry of the interface
  *      struct vty* vty               : Used for ouput
  */
 static int
-parse_l3config(const char *if_name, struct vty *vty)
+parse_l3config(const struct intf_join *join, struct vty *vty)
 {
     const struct ovsrec_port *port_row;
     const struct ovsrec_vrf *vrf_row;
     size_t i;
 
-    port_row = port_find(if_name);
+    port_row = join->port;
     if (!port_row) {
         return 0;
     }
-    if (check_iface_in_bridge(if_name)) {
+    if (join->in_bridge) {
         vty_out(vty, "%3s%s%s", "", "no routing", VTY_NEWLINE);
-        parse_vlan(if_name, vty);
+        parse_vlan(port_row, vty);
     }
-    if (check_iface_in_vrf(if_name)) {
-        vrf_row = port_match_in_vrf(port_row);
-        if (display_l3_info(port_row, vrf_row)) {
+    if (join->in_vrf) {
+        vrf_row = join->vrf;
+        if (vrf_row && display_l3_info(port_row, vrf_row)) {
             if (strcmp(vrf_row->name, DEFAULT_VRF_NAME) != 0) {
                 vty_out(vty, "%3s%s%s%s", "", "vrf attach ", vrf_row->name,
                         VTY_NEWLINE);
@@ -1160,31 +1251,18 @@ parse_l3config(const char *if_name, struct vty *vty)
 }
 
 static int
-print_interface_lag(const char *if_name, struct vty *vty, bool *bPrinted)
+print_interface_lag(const char *if_name, const struct intf_join *join,
+                    struct vty *vty, bool *bPrinted)
 {
-    const struct ovsrec_port *port_row = NULL;
-    const struct ovsrec_interface *if_row = NULL;
-    int k=0;
-
-    OVSREC_PORT_FOR_EACH(port_row, idl)
+    if (join->lag)
     {
-        if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
+        if (!(*bPrinted))
         {
-            for (k = 0; k < port_row->n_interfaces; k++)
-            {
-                if_row = port_row->interfaces[k];
-                if(strncmp(if_name, if_row->name, MAX_IFNAME_LENGTH) == 0)
-                {
-                    if (!(*bPrinted))
-                    {
-                        *bPrinted = true;
-                        vty_out (vty, "interface %s %s", if_name, VTY_NEWLINE);
-                    }
-                    vty_out(vty, "%3s%s %s%s", "", "lag",
-                            &port_row->name[LAG_PORT_NAME_PREFIX_LENGTH], VTY_NEWLINE);
-                }
-            }
+            *bPrinted = true;
+            vty_out (vty, "interface %s %s", if_name, VTY_NEWLINE);
         }
+        vty_out(vty, "%3s%s %s%s", "", "lag",
+                &join->lag->name[LAG_PORT_NAME_PREFIX_LENGTH], VTY_NEWLINE);
     }
     return 0;
 }
@@ -1226,7 +1304,7 @@ parse_lacp_othercfg(const struct smap *ifrow_config, const char *if_name,
 }
 
 static int
-parse_lag(struct vty *vty)
+parse_lag(struct vty *vty, const struct shash *join)
 {
     const char *data = NULL;
     const struct ovsrec_port *port_row = NULL;
@@ -1238,10 +1316,10 @@ parse_lag(struct vty *vty)
             /* Print the LAG port name because lag port is present. */
             vty_out (vty, "interface lag %s%s", &port_row->name[LAG_PORT_NAME_PREFIX_LENGTH], VTY_NEWLINE);
 
-            if (check_port_in_bridge(port_row->name))
+            if (intf_join_find(join, port_row->name)->port_in_bridge)
             {
                 vty_out (vty, "%3s%s%s", "", "no routing", VTY_NEWLINE);
-                parse_vlan(port_row->name, vty);
+                parse_vlan(port_row, vty);
             }
 
             data = port_row->lacp;
@@ -1284,8 +1362,13 @@ cli_show_run_interface_exec (struct cmd_element *self, struct vty *vty,
         int flags, int argc, const char *argv[])
 {
     const struct ovsrec_interface *row = NULL;
+    const struct intf_join *join;
     const char *cur_state =NULL;
     bool bPrinted = false;
+    struct shash intf_join;
+
+    shash_init(&intf_join);
+    intf_join_build(&intf_join, idl);
 
     OVSREC_INTERFACE_FOR_EACH(row, idl)
     {
@@ -1385,16 +1468,17 @@ cli_show_run_interface_exec (struct cmd_element *self, struct vty *vty,
             vty_out(vty, "   split %s", VTY_NEWLINE);
         }
 
-        if (port_find(row->name))
+        join = intf_join_find(&intf_join, row->name);
+        if (join->port)
         {
             PRINT_INT_HEADER_IN_SHOW_RUN;
         }
 
-        parse_l3config(row->name, vty);
+        parse_l3config(join, vty);
 
         parse_lacp_othercfg(&row->other_config, row->name, vty, &bPrinted);
 
-        print_interface_lag(row->name, vty, &bPrinted);
+        print_interface_lag(row->name, join, vty, &bPrinted);
 
         if (bPrinted)
         {
@@ -1402,8 +1486,9 @@ cli_show_run_interface_exec (struct cmd_element *self, struct vty *vty,
         }
     }
 
-    parse_lag(vty);
+    parse_lag(vty, &intf_join);
 
+    intf_join_destroy(&intf_join);
     return CMD_SUCCESS;
 }
 
@@ -1756,24 +1841,24 @@ int cli_show_xvr_exec (struct cmd_element *self, struct vty *vty,
   | Function : show_ip_addresses
   | Responsibility : Used to show ip addresses for L3 interfaces
   | Parameters :
-  |     const char *if_name           : Name of interface
+  |     const struct intf_join *join  : Join entry of the interface
   |     struct vty* vty               : Used for ouput
   -----------------------------------------------------------------------------*/
 static int
-show_ip_addresses(const char *if_name, struct vty *vty)
+show_ip_addresses(const struct intf_join *join, struct vty *vty)
 {
     const struct ovsrec_port *port_row;
     const struct ovsrec_vrf *vrf_row;
     size_t i;
 
-    port_row = port_find(if_name);
+    port_row = join->port;
     if (!port_row) {
         return 0;
     }
 
-    if (check_iface_in_vrf(if_name)) {
-        vrf_row = port_match_in_vrf(port_row);
-        if (display_l3_info(port_row, vrf_row)) {
+    if (join->in_vrf) {
+        vrf_row = join->vrf;
+        if (vrf_row && display_l3_info(port_row, vrf_row)) {
             if (port_row->ip4_address) {
                 vty_out(vty, " IPv4 address %s%s", port_row->ip4_address,
                         VTY_NEWLINE);
@@ -1838,6 +1923,7 @@ show_lacp_interfaces_brief (struct vty *vty, const char *argv[])
 
         /* Speed calculation: Adding speed of all aggregated interfaces*/
         lag_speed = 0;
+        memset(lag_statistics, 0, sizeof lag_statistics);
         for (interface_index = 0; interface_index < lag_port->n_interfaces; interface_index++)
         {
             if_row = lag_port->interfaces[interface_index];
@@ -1862,15 +1948,93 @@ show_lacp_interfaces_brief (struct vty *vty, const char *argv[])
     }
 }
 
+/* Statistics keys used by the show commands.  They are resolved to
+ * an intf_stat index once, so a row's statistics map is read in a
+ * single pass instead of one ovsdb_datum_find_key per counter.
+ */
+enum intf_stat {
+    INTF_STAT_RX_PACKETS,
+    INTF_STAT_RX_BYTES,
+    INTF_STAT_TX_PACKETS,
+    INTF_STAT_TX_BYTES,
+    INTF_STAT_RX_DROPPED,
+    INTF_STAT_RX_FRAME_ERR,
+    INTF_STAT_RX_OVER_ERR,
+    INTF_STAT_RX_CRC_ERR,
+    INTF_STAT_RX_ERRORS,
+    INTF_STAT_TX_DROPPED,
+    INTF_STAT_COLLISIONS,
+    INTF_STAT_TX_ERRORS,
+    INTF_STAT_MAX
+};
+
+static const char *intf_stat_keys[INTF_STAT_MAX] = {
+    "rx_packets",
+    "rx_bytes",
+    "tx_packets",
+    "tx_bytes",
+    "rx_dropped",
+    "rx_frame_err",
+    "rx_over_err",
+    "rx_crc_err",
+    "rx_errors",
+    "tx_dropped",
+    "collisions",
+    "tx_errors"
+};
+
+/* Statistics key -> intf_stat index + 1. */
+static struct shash intf_stat_index = SHASH_INITIALIZER(&intf_stat_index);
+
+/*
+ * Reads the known counters of an interface into stats.  Missing
+ * counters read as 0.  Returns false if the row has no statistics.
+ */
+static bool
+intf_stats_get(const struct ovsrec_interface *ifrow,
+               int64_t stats[INTF_STAT_MAX])
+{
+    const struct ovsdb_datum *datum;
+    intptr_t stat;
+    size_t i;
+
+    memset(stats, 0, INTF_STAT_MAX * sizeof stats[0]);
+
+    if (shash_is_empty(&intf_stat_index))
+    {
+        for (i = 0; i < INTF_STAT_MAX; i++)
+        {
+            shash_add(&intf_stat_index, intf_stat_keys[i],
+                      (void *)(intptr_t)(i + 1));
+        }
+    }
+
+    datum = ovsrec_interface_get_statistics(ifrow,
+            OVSDB_TYPE_STRING, OVSDB_TYPE_INTEGER);
+    if (NULL == datum)
+    {
+        return false;
+    }
+
+    for (i = 0; i < datum->n; i++)
+    {
+        stat = (intptr_t)shash_find_data(&intf_stat_index,
+                                         datum->keys[i].string);
+        if (stat)
+        {
+            stats[stat - 1] = datum->values[i].integer;
+        }
+    }
+    return true;
+}
+
 void
-show_lacp_interfaces (struct vty *vty, char* interface_statistics_keys[],
-                      const char *argv[])
+show_lacp_interfaces (struct vty *vty, const char *argv[])
 {
     const struct ovsrec_port *lag_port = NULL;
     const struct ovsrec_interface *if_row = NULL;
     const char *aggregate_mode = NULL;
     const struct ovsdb_datum *datum;
-    unsigned int index;
 
     int64_t lag_speed = 0;
 
@@ -1880,12 +2044,11 @@ show_lacp_interfaces (struct vty *vty, char* interface_statistics_keys[],
 
     // Array to keep the statistics for each lag while adding the
     // stats for each interface in the lag.
-    int lag_statistics [12] = {0};
+    int64_t lag_statistics[INTF_STAT_MAX];
+    int64_t if_statistics[INTF_STAT_MAX];
 
     OVSREC_PORT_FOR_EACH(lag_port, idl)
     {
-        union ovsdb_atom atom;
-
         if ((NULL != argv[0]) && (0 != strcmp(argv[0],lag_port->name)))
         {
             continue;
@@ -1901,6 +2064,7 @@ show_lacp_interfaces (struct vty *vty, char* interface_statistics_keys[],
 
 
         lag_speed = 0;
+        memset(lag_statistics, 0, sizeof lag_statistics);
         for (interface_index = 0; interface_index < lag_port->n_interfaces; interface_index++)
         {
             if_row = lag_port->interfaces[interface_index];
@@ -1912,15 +2076,12 @@ show_lacp_interfaces (struct vty *vty, char* interface_statistics_keys[],
                 lag_speed += datum->keys[0].integer;
             }
 
-            datum = ovsrec_interface_get_statistics(if_row,
-                                OVSDB_TYPE_STRING, OVSDB_TYPE_INTEGER);
+            intf_stats_get(if_row, if_statistics);
 
             // Adding statistic value for each interface in the lag
-            for (stat_index = 0; stat_index < sizeof(lag_statistics)/sizeof(int); stat_index++)
+            for (stat_index = 0; stat_index < INTF_STAT_MAX; stat_index++)
             {
-                atom.string = interface_statistics_keys[stat_index];
-                index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-                lag_statistics[stat_index] += (index == UINT_MAX)? 0 : datum->values[index].integer;
+                lag_statistics[stat_index] += if_statistics[stat_index];
             }
         }
         vty_out(vty, "%s", VTY_NEWLINE);
@@ -1929,27 +2090,27 @@ show_lacp_interfaces (struct vty *vty, char* interface_statistics_keys[],
             vty_out(vty, " Aggregate mode : %s %s", aggregate_mode, VTY_NEWLINE);
         vty_out(vty, " Speed %ld Mb/s %s",lag_speed/1000000 , VTY_NEWLINE);
         vty_out(vty, " RX%s", VTY_NEWLINE);
-        vty_out(vty, "   %10ld input packets  ", lag_statistics[0]);
-        vty_out(vty, "   %10ld bytes  ",lag_statistics[1]);
+        vty_out(vty, "   %10ld input packets  ", lag_statistics[INTF_STAT_RX_PACKETS]);
+        vty_out(vty, "   %10ld bytes  ",lag_statistics[INTF_STAT_RX_BYTES]);
         vty_out(vty, "%s", VTY_NEWLINE);
 
-        vty_out(vty, "   %10ld input error    ",lag_statistics[8]);
-        vty_out(vty, "   %10ld dropped  ",lag_statistics[4]);
+        vty_out(vty, "   %10ld input error    ",lag_statistics[INTF_STAT_RX_ERRORS]);
+        vty_out(vty, "   %10ld dropped  ",lag_statistics[INTF_STAT_RX_DROPPED]);
         vty_out(vty, "%s", VTY_NEWLINE);
 
-        vty_out(vty, "   %10ld CRC/FCS  ",lag_statistics[7]);
+        vty_out(vty, "   %10ld CRC/FCS  ",lag_statistics[INTF_STAT_RX_CRC_ERR]);
         vty_out(vty, "%s", VTY_NEWLINE);
         vty_out(vty, " TX%s", VTY_NEWLINE);
 
-        vty_out(vty, "   %10ld output packets ",lag_statistics[2]);
-        vty_out(vty, "   %10ld bytes  ",lag_statistics[3]);
+        vty_out(vty, "   %10ld output packets ",lag_statistics[INTF_STAT_TX_PACKETS]);
+        vty_out(vty, "   %10ld bytes  ",lag_statistics[INTF_STAT_TX_BYTES]);
         vty_out(vty, "%s", VTY_NEWLINE);
 
-        vty_out(vty, "   %10ld input error    ",lag_statistics[11]);
-        vty_out(vty, "   %10ld dropped  ",lag_statistics[9]);
+        vty_out(vty, "   %10ld input error    ",lag_statistics[INTF_STAT_TX_ERRORS]);
+        vty_out(vty, "   %10ld dropped  ",lag_statistics[INTF_STAT_TX_DROPPED]);
         vty_out(vty, "%s", VTY_NEWLINE);
 
-        vty_out(vty, "   %10ld collision  ",lag_statistics[10]);
+        vty_out(vty, "   %10ld collision  ",lag_statistics[INTF_STAT_COLLISIONS]);
         vty_out(vty, "%s", VTY_NEWLINE);
         vty_out(vty, "%s", VTY_NEWLINE);
     }
@@ -1964,25 +2125,11 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
     const char *cur_state =NULL;
     struct shash sorted_interfaces;
     const struct shash_node **nodes;
+    struct shash intf_join;
     int idx, count;
 
     const struct ovsdb_datum *datum;
-    static char *interface_statistics_keys [] = {
-        "rx_packets",
-        "rx_bytes",
-        "tx_packets",
-        "tx_bytes",
-        "rx_dropped",
-        "rx_frame_err",
-        "rx_over_err",
-        "rx_crc_err",
-        "rx_errors",
-        "tx_dropped",
-        "collisions",
-        "tx_errors"
-    };
-
-    unsigned int index;
+    int64_t stats[INTF_STAT_MAX];
     int64_t intVal = 0;
 
     if (brief)
@@ -2000,6 +2147,11 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
     }
 
     shash_init(&sorted_interfaces);
+    shash_init(&intf_join);
+    if (!brief)
+    {
+        intf_join_build(&intf_join, idl);
+    }
 
     OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
     {
@@ -2012,8 +2164,6 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
 
     for (idx = 0; idx < count; idx++)
     {
-        union ovsdb_atom atom;
-
         ifrow = (const struct ovsrec_interface *)nodes[idx]->data;
 
         if ((NULL != argv[0]) && (0 != strcmp(argv[0],ifrow->name)))
@@ -2094,7 +2244,7 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
                     ifrow->mac_in_use, VTY_NEWLINE);
 
             /* Displaying ipv4 and ipv6 primary and secondary addresses*/
-            show_ip_addresses(ifrow->name, vty);
+            show_ip_addresses(intf_join_find(&intf_join, ifrow->name), vty);
 
             datum = ovsrec_interface_get_mtu(ifrow, OVSDB_TYPE_INTEGER);
             if ((NULL!=datum) && (datum->n >0))
@@ -2169,65 +2319,34 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
                         "output flow-control is off%s",VTY_NEWLINE);
             }
 
-            datum = ovsrec_interface_get_statistics(ifrow,
-                    OVSDB_TYPE_STRING, OVSDB_TYPE_INTEGER);
-
-            if (NULL==datum) continue;
+            if (!intf_stats_get(ifrow, stats)) continue;
 
             vty_out(vty, " RX%s", VTY_NEWLINE);
-
-            atom.string = interface_statistics_keys[0];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
             vty_out(vty, "   %10ld input packets  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
-            atom.string = interface_statistics_keys[1];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld bytes  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+                    stats[INTF_STAT_RX_PACKETS]);
+            vty_out(vty, "   %10ld bytes  ", stats[INTF_STAT_RX_BYTES]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
-            atom.string = interface_statistics_keys[8];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
             vty_out(vty, "   %10ld input error    ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
-            atom.string = interface_statistics_keys[4];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld dropped  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+                    stats[INTF_STAT_RX_ERRORS]);
+            vty_out(vty, "   %10ld dropped  ", stats[INTF_STAT_RX_DROPPED]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
-            atom.string = interface_statistics_keys[7];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld CRC/FCS  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+            vty_out(vty, "   %10ld CRC/FCS  ", stats[INTF_STAT_RX_CRC_ERR]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
             vty_out(vty, " TX%s", VTY_NEWLINE);
-
-            atom.string = interface_statistics_keys[2];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
             vty_out(vty, "   %10ld output packets ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
-            atom.string = interface_statistics_keys[3];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld bytes  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+                    stats[INTF_STAT_TX_PACKETS]);
+            vty_out(vty, "   %10ld bytes  ", stats[INTF_STAT_TX_BYTES]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
-            atom.string = interface_statistics_keys[11];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
             vty_out(vty, "   %10ld input error    ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
-            atom.string = interface_statistics_keys[9];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld dropped  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+                    stats[INTF_STAT_TX_ERRORS]);
+            vty_out(vty, "   %10ld dropped  ", stats[INTF_STAT_TX_DROPPED]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
-            atom.string = interface_statistics_keys[10];
-            index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-            vty_out(vty, "   %10ld collision  ",
-                    (index == UINT_MAX)? 0 : datum->values[index].integer);
+            vty_out(vty, "   %10ld collision  ", stats[INTF_STAT_COLLISIONS]);
             vty_out(vty, "%s", VTY_NEWLINE);
 
             vty_out(vty, "%s", VTY_NEWLINE);
@@ -2240,6 +2359,7 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
     }
 
     shash_destroy(&sorted_interfaces);
+    intf_join_destroy(&intf_join);
     free(nodes);
 
     if(brief)
@@ -2248,7 +2368,7 @@ cli_show_interface_exec (struct cmd_element *self, struct vty *vty,
     }
     else
     {
-        show_lacp_interfaces(vty, interface_statistics_keys, argv);
+        show_lacp_interfaces(vty, argv);
     }
 
     return CMD_SUCCESS;
@@ -2321,6 +2441,372 @@ DEFUN (cli_intf_show_intferface_ifname_br,
     return rc;
 }
 
+/*
+ * Interface rate sampler.
+ *
+ * intf_rates_sample() is called from the OVSDB thread whenever the IDL
+ * changes and keeps a ring of timestamped counter snapshots for every
+ * interface.  Rates are computed from the ring, so no command has to
+ * wait or poll for a second reading.
+ */
+#define INTF_RATE_RING_SIZE     160     /* Snapshots kept per interface. */
+#define INTF_RATE_MIN_GAP       2000    /* Minimum msec between snapshots. */
+
+struct intf_stat_sample {
+    long long int msec;
+    int64_t stats[INTF_STAT_MAX];
+};
+
+struct intf_rate_ring {
+    unsigned int head;          /* Slot the next snapshot goes to. */
+    unsigned int count;         /* Snapshots in the ring. */
+    unsigned int generation;    /* Last intf_rates_sample() that saw it. */
+    bool has_baseline;          /* baseline is valid. */
+    struct intf_stat_sample baseline; /* "show interface counters delta". */
+    struct intf_stat_sample samples[INTF_RATE_RING_SIZE];
+};
+
+/* Interface name -> struct intf_rate_ring. */
+static struct shash intf_rate_rings = SHASH_INITIALIZER(&intf_rate_rings);
+static unsigned int intf_rate_generation;
+
+static const struct {
+    const char *name;
+    long long int msec;
+} intf_rate_windows[] = {
+    { "5 sec", 5 * 1000 },
+    { "1 min", 60 * 1000 },
+    { "5 min", 300 * 1000 },
+};
+
+/* Returns the i'th newest snapshot of ring, 0 being the newest. */
+static struct intf_stat_sample *
+intf_rate_ring_get(struct intf_rate_ring *ring, unsigned int i)
+{
+    return &ring->samples[(ring->head + INTF_RATE_RING_SIZE - 1 - i)
+                          % INTF_RATE_RING_SIZE];
+}
+
+static void
+intf_rate_ring_add(struct intf_rate_ring *ring, long long int now,
+                   const int64_t stats[INTF_STAT_MAX])
+{
+    struct intf_stat_sample *newest;
+    int i;
+
+    if (ring->count)
+    {
+        newest = intf_rate_ring_get(ring, 0);
+        if (!memcmp(newest->stats, stats, sizeof newest->stats))
+        {
+            return;
+        }
+
+        /* Counters went backwards, the interface was reset. */
+        for (i = 0; i < INTF_STAT_MAX; i++)
+        {
+            if (stats[i] < newest->stats[i])
+            {
+                ring->count = 0;
+                ring->has_baseline = false;
+                break;
+            }
+        }
+
+        /* The newest snapshot is still too close to the one before,
+         * refresh it in place instead of adding another. */
+        if (ring->count > 1
+            && newest->msec - intf_rate_ring_get(ring, 1)->msec
+               < INTF_RATE_MIN_GAP)
+        {
+            newest->msec = now;
+            memcpy(newest->stats, stats, sizeof newest->stats);
+            return;
+        }
+    }
+
+    newest = &ring->samples[ring->head];
+    newest->msec = now;
+    memcpy(newest->stats, stats, sizeof newest->stats);
+    ring->head = (ring->head + 1) % INTF_RATE_RING_SIZE;
+    if (ring->count < INTF_RATE_RING_SIZE)
+    {
+        ring->count++;
+    }
+}
+
+/*
+ * Records a snapshot of every interface's counters and forgets the
+ * interfaces that are gone.  Called with the OVSDB lock held.
+ */
+void
+intf_rates_sample(void)
+{
+    const struct ovsrec_interface *ifrow = NULL;
+    struct intf_rate_ring *ring;
+    struct shash_node *node, *next;
+    int64_t stats[INTF_STAT_MAX];
+    long long int now = time_msec();
+
+    intf_rate_generation++;
+
+    OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+    {
+        if (strcmp(ifrow->type, OVSREC_INTERFACE_TYPE_INTERNAL) == 0
+            || !intf_stats_get(ifrow, stats))
+        {
+            continue;
+        }
+
+        ring = shash_find_data(&intf_rate_rings, ifrow->name);
+        if (NULL == ring)
+        {
+            ring = xzalloc(sizeof *ring);
+            shash_add(&intf_rate_rings, ifrow->name, ring);
+        }
+        ring->generation = intf_rate_generation;
+        intf_rate_ring_add(ring, now, stats);
+    }
+
+    SHASH_FOR_EACH_SAFE (node, next, &intf_rate_rings)
+    {
+        ring = node->data;
+        if (ring->generation != intf_rate_generation)
+        {
+            free(ring);
+            shash_delete(&intf_rate_rings, node);
+        }
+    }
+}
+
+/*
+ * Finds the newest snapshot at least window msec older than the newest
+ * one, or the oldest snapshot if the ring does not reach back that far.
+ * Returns NULL if there are fewer than two snapshots.
+ */
+static struct intf_stat_sample *
+intf_rate_ring_since(struct intf_rate_ring *ring, long long int window)
+{
+    struct intf_stat_sample *newest, *sample = NULL;
+    unsigned int i;
+
+    if (ring->count < 2)
+    {
+        return NULL;
+    }
+
+    newest = intf_rate_ring_get(ring, 0);
+    for (i = 1; i < ring->count; i++)
+    {
+        sample = intf_rate_ring_get(ring, i);
+        if (newest->msec - sample->msec >= window)
+        {
+            break;
+        }
+    }
+    return sample;
+}
+
+static void
+show_interface_rates(struct vty *vty, const char *name,
+                     struct intf_rate_ring *ring)
+{
+    struct intf_stat_sample *newest, *old;
+    long long int span;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(intf_rate_windows); i++)
+    {
+        vty_out(vty, " %-12s %-7s", i ? "" : name, intf_rate_windows[i].name);
+
+        old = ring ? intf_rate_ring_since(ring, intf_rate_windows[i].msec)
+                   : NULL;
+        if (NULL == old)
+        {
+            vty_out(vty, " %12s %12s %12s %12s%s", "--", "--", "--", "--",
+                    VTY_NEWLINE);
+            continue;
+        }
+
+        newest = intf_rate_ring_get(ring, 0);
+        span = newest->msec - old->msec;
+        vty_out(vty, " %12.3f %12.1f %12.3f %12.1f%s",
+                (newest->stats[INTF_STAT_RX_BYTES]
+                 - old->stats[INTF_STAT_RX_BYTES]) * 8.0 / (span * 1000.0),
+                (newest->stats[INTF_STAT_RX_PACKETS]
+                 - old->stats[INTF_STAT_RX_PACKETS]) * 1000.0 / span,
+                (newest->stats[INTF_STAT_TX_BYTES]
+                 - old->stats[INTF_STAT_TX_BYTES]) * 8.0 / (span * 1000.0),
+                (newest->stats[INTF_STAT_TX_PACKETS]
+                 - old->stats[INTF_STAT_TX_PACKETS]) * 1000.0 / span,
+                VTY_NEWLINE);
+    }
+}
+
+static int
+cli_show_interface_rates_exec(struct vty *vty, const char *if_name)
+{
+    const struct ovsrec_interface *ifrow = NULL;
+    struct shash sorted_interfaces;
+    const struct shash_node **nodes;
+    int idx, count;
+
+    shash_init(&sorted_interfaces);
+
+    OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+    {
+        if (strcmp(ifrow->type, OVSREC_INTERFACE_TYPE_INTERNAL) == 0)
+        {
+            continue;
+        }
+        if ((NULL != if_name) && (0 != strcmp(if_name, ifrow->name)))
+        {
+            continue;
+        }
+        shash_add(&sorted_interfaces, ifrow->name, (void *)ifrow);
+    }
+
+    count = shash_count(&sorted_interfaces);
+    if (count == 0)
+    {
+        shash_destroy(&sorted_interfaces);
+        if (NULL != if_name)
+        {
+            vty_out(vty, "Interface %s does not exist%s", if_name,
+                    VTY_NEWLINE);
+            return CMD_WARNING;
+        }
+        return CMD_SUCCESS;
+    }
+
+    nodes = sort_interface(&sorted_interfaces);
+
+    vty_out(vty, "%s", VTY_NEWLINE);
+    vty_out(vty, " Interface    Window       RX Mb/s     RX pkt/s"
+            "      TX Mb/s     TX pkt/s%s", VTY_NEWLINE);
+    vty_out(vty, " ----------------------------------------------------"
+            "--------------------------%s", VTY_NEWLINE);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        show_interface_rates(vty, nodes[idx]->name,
+                             shash_find_data(&intf_rate_rings,
+                                             nodes[idx]->name));
+    }
+    vty_out(vty, "%s", VTY_NEWLINE);
+
+    shash_destroy(&sorted_interfaces);
+    free(nodes);
+
+    return CMD_SUCCESS;
+}
+
+DEFUN (cli_intf_show_interface_rates,
+        cli_intf_show_interface_rates_cmd,
+        "show interface rates",
+        SHOW_STR
+        INTERFACE_STR
+        "Show traffic rates over the last 5 seconds, 1 and 5 minutes\n")
+{
+    return cli_show_interface_rates_exec(vty, NULL);
+}
+
+DEFUN (cli_intf_show_interface_ifname_rates,
+        cli_intf_show_interface_ifname_rates_cmd,
+        "show interface IFNAME rates",
+        SHOW_STR
+        INTERFACE_STR
+        IFNAME_STR
+        "Show traffic rates over the last 5 seconds, 1 and 5 minutes\n")
+{
+    return cli_show_interface_rates_exec(vty, argv[0]);
+}
+
+/*
+ * Shows how much each counter moved since the previous
+ * "show interface counters delta", or since sampling started.
+ */
+DEFUN (cli_intf_show_interface_counters_delta,
+        cli_intf_show_interface_counters_delta_cmd,
+        "show interface counters delta",
+        SHOW_STR
+        INTERFACE_STR
+        "Show interface counters\n"
+        "Show counter changes since the last invocation\n")
+{
+    const struct ovsrec_interface *ifrow = NULL;
+    struct intf_rate_ring *ring;
+    struct intf_stat_sample now, *since;
+    struct shash sorted_interfaces;
+    const struct shash_node **nodes;
+    int idx, count;
+
+    shash_init(&sorted_interfaces);
+
+    OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+    {
+        if (strcmp(ifrow->type, OVSREC_INTERFACE_TYPE_INTERNAL) != 0)
+        {
+            shash_add(&sorted_interfaces, ifrow->name, (void *)ifrow);
+        }
+    }
+
+    nodes = sort_interface(&sorted_interfaces);
+    count = shash_count(&sorted_interfaces);
+
+    vty_out(vty, "%s", VTY_NEWLINE);
+    vty_out(vty, " Interface     Secs   RX packets     RX bytes RX err RX drop"
+            "   TX packets     TX bytes TX err TX drop%s", VTY_NEWLINE);
+    vty_out(vty, " ----------------------------------------------------"
+            "--------------------------------------------------%s",
+            VTY_NEWLINE);
+
+    now.msec = time_msec();
+    for (idx = 0; idx < count; idx++)
+    {
+        ifrow = (const struct ovsrec_interface *)nodes[idx]->data;
+        ring = shash_find_data(&intf_rate_rings, ifrow->name);
+
+        if (!intf_stats_get(ifrow, now.stats) || NULL == ring
+            || ring->count == 0)
+        {
+            continue;
+        }
+
+        since = ring->has_baseline ? &ring->baseline
+                                   : intf_rate_ring_get(ring, ring->count - 1);
+
+        vty_out(vty, " %-12s %5lld %12ld %12ld %6ld %7ld %12ld %12ld %6ld %7ld%s",
+                ifrow->name, (now.msec - since->msec) / 1000,
+                now.stats[INTF_STAT_RX_PACKETS]
+                - since->stats[INTF_STAT_RX_PACKETS],
+                now.stats[INTF_STAT_RX_BYTES]
+                - since->stats[INTF_STAT_RX_BYTES],
+                now.stats[INTF_STAT_RX_ERRORS]
+                - since->stats[INTF_STAT_RX_ERRORS],
+                now.stats[INTF_STAT_RX_DROPPED]
+                - since->stats[INTF_STAT_RX_DROPPED],
+                now.stats[INTF_STAT_TX_PACKETS]
+                - since->stats[INTF_STAT_TX_PACKETS],
+                now.stats[INTF_STAT_TX_BYTES]
+                - since->stats[INTF_STAT_TX_BYTES],
+                now.stats[INTF_STAT_TX_ERRORS]
+                - since->stats[INTF_STAT_TX_ERRORS],
+                now.stats[INTF_STAT_TX_DROPPED]
+                - since->stats[INTF_STAT_TX_DROPPED],
+                VTY_NEWLINE);
+
+        ring->baseline = now;
+        ring->has_baseline = true;
+    }
+    vty_out(vty, "%s", VTY_NEWLINE);
+
+    shash_destroy(&sorted_interfaces);
+    free(nodes);
+
+    return CMD_SUCCESS;
+}
+
 #ifdef ENABLE_OVSDB
 /* Function : check_internal_vlan
  * Description : Checks if interface vlan is being created for
@@ -2713,6 +3199,9 @@ intf_vty_init (void)
     /* Show commands */
     install_element (ENABLE_NODE, &cli_intf_show_intferface_ifname_cmd);
     install_element (ENABLE_NODE, &cli_intf_show_intferface_ifname_br_cmd);
+    install_element (ENABLE_NODE, &cli_intf_show_interface_rates_cmd);
+    install_element (ENABLE_NODE, &cli_intf_show_interface_ifname_rates_cmd);
+    install_element (ENABLE_NODE, &cli_intf_show_interface_counters_delta_cmd);
     install_element (ENABLE_NODE, &cli_intf_show_run_intf_cmd);
     install_element (ENABLE_NODE, &cli_intf_show_run_intf_if_cmd);
     install_element (ENABLE_NODE, &cli_intf_show_run_intf_mgmt_cmd);
@@ -52,6 +52,284 @@ VLOG_DEFINE_THIS_MODULE(vtysh_lacp_cli);
 extern struct ovsdb_idl *idl;
 int maximum_lag_interfaces = 0;
 
+/*
+ * LAG membership index.
+ *
+ * Ports and interfaces by name, the LAG each interface belongs to, and
+ * the actor/partner fields of every interface's lacp_status decoded
+ * once, re-decoded only when those values change.  lacp_index_sync()
+ * rebuilds the index when the Interface or Port table changes; the row
+ * pointers in it stay valid until the next IDL run, so callers must
+ * sync first, with the OVSDB lock held.
+ */
+enum lacp_status_field
+{
+  LACP_FIELD_STATE,
+  LACP_FIELD_KEY,
+  LACP_FIELD_PORT_ID,
+  LACP_FIELD_SYSTEM_ID,
+  LACP_FIELD_MAX
+};
+
+static const char *lacp_actor_keys[LACP_FIELD_MAX] = {
+  INTERFACE_LACP_STATUS_MAP_ACTOR_STATE,
+  INTERFACE_LACP_STATUS_MAP_ACTOR_KEY,
+  INTERFACE_LACP_STATUS_MAP_ACTOR_PORT_ID,
+  INTERFACE_LACP_STATUS_MAP_ACTOR_SYSTEM_ID
+};
+
+static const char *lacp_partner_keys[LACP_FIELD_MAX] = {
+  INTERFACE_LACP_STATUS_MAP_PARTNER_STATE,
+  INTERFACE_LACP_STATUS_MAP_PARTNER_KEY,
+  INTERFACE_LACP_STATUS_MAP_PARTNER_PORT_ID,
+  INTERFACE_LACP_STATUS_MAP_PARTNER_SYSTEM_ID
+};
+
+/* Actor or partner details of an interface.  The decoded fields are
+ * NULL when the side has no state in lacp_status. */
+struct lacp_side_info
+{
+  char *raw[LACP_FIELD_MAX];       /* lacp_status values last decoded. */
+  char *port_ids;                  /* Split copy of the port id. */
+  char *system_ids;                /* Split copy of the system id. */
+  char state_buf[LACP_STATUS_FIELD_COUNT + 1];
+  const char *state;
+  const char *key;
+  const char *port_priority;
+  const char *port_id;
+  const char *system_priority;
+  const char *system_id;
+};
+
+struct lacp_intf_info
+{
+  const struct ovsrec_interface *row;
+  const struct ovsrec_port *lag;   /* LAG the interface is part of. */
+  unsigned int generation;         /* Last sync that saw it. */
+  struct lacp_side_info actor;
+  struct lacp_side_info partner;
+};
+
+/* Interface name -> struct lacp_intf_info. */
+static struct shash lacp_intfs = SHASH_INITIALIZER(&lacp_intfs);
+/* Port name -> const struct ovsrec_port. */
+static struct shash lacp_ports = SHASH_INITIALIZER(&lacp_ports);
+/* LAG ports, in IDL order. */
+static const struct ovsrec_port **lacp_lags;
+static size_t lacp_n_lags, lacp_lags_size;
+static const struct ovsdb_idl_table_class *const lacp_index_tables[] = {
+  &ovsrec_table_interface, &ovsrec_table_port,
+};
+static struct vtysh_idl_cache lacp_index_cache =
+  VTYSH_IDL_CACHE_INITIALIZER(lacp_index_tables);
+static unsigned int lacp_index_generation;
+
+static char *
+get_lacp_state(const char *state)
+{
+   /* +1 for the event where all flags are ON then we have a place to store \0 */
+   static char ret_state[LACP_STATUS_FIELD_COUNT+1]={0};
+   int n = 0;
+
+   memset(ret_state, 0, LACP_STATUS_FIELD_COUNT+1);
+   if(state == NULL) return ret_state;
+   ret_state[n++] = state[0]? 'A':'P';
+   ret_state[n++] = state[1]? 'S':'L';
+   ret_state[n++] = state[2]? 'F':'I';
+   ret_state[n++] = state[3]? 'N':'O';
+   if (state[4]) ret_state[n++] = 'C';
+   if (state[5]) ret_state[n++] = 'D';
+   if (state[6]) ret_state[n++] = 'E';
+   if (state[7]) ret_state[n++] = 'X';
+
+   return ret_state;
+}
+
+
+void
+parse_id_from_db (char *str, char **value1, char **value2)
+{
+  *value1 = strsep(&str, ",");
+  *value2 = strsep(&str, ",");
+}
+
+/*
+ * Expected format from DB (e.g):
+ * "Actv:1,TmOut:1,Aggr:1,Sync:1,Col:1,Dist:1,Def:0,Exp:0"
+ * Expected output (e.g):
+ * [1,1,1,1,1,1,0,0]
+ * Returns the number of fields read
+ *
+ */
+
+int
+parse_state_from_db(const char *str, char *ret_str)
+{
+ int flags[LACP_STATUS_FIELD_COUNT];
+ int i, n;
+
+ n = sscanf(str, "%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d",
+            &flags[0], &flags[1], &flags[2], &flags[3], &flags[4], &flags[5],
+            &flags[6], &flags[7]);
+ for (i = 0; i < n; i++)
+   ret_str[i] = flags[i];
+ return n;
+}
+
+static void
+lacp_side_clear(struct lacp_side_info *side)
+{
+  int i;
+
+  for (i = 0; i < LACP_FIELD_MAX; i++)
+    free(side->raw[i]);
+  free(side->port_ids);
+  free(side->system_ids);
+  memset(side, 0, sizeof *side);
+}
+
+static bool
+lacp_value_equal(const char *a, const char *b)
+{
+  if (!a || !b)
+    return a == b;
+  return strcmp(a, b) == 0;
+}
+
+/* Re-decodes one side of the interface's lacp_status if it changed. */
+static void
+lacp_side_update(struct lacp_side_info *side, const struct smap *status,
+                 const char *keys[LACP_FIELD_MAX])
+{
+  const char *values[LACP_FIELD_MAX];
+  char lacp_state_ovsdb[LACP_STATUS_FIELD_COUNT];
+  char *priority, *id;
+  bool changed = false;
+  int i;
+
+  for (i = 0; i < LACP_FIELD_MAX; i++)
+  {
+    values[i] = smap_get(status, keys[i]);
+    if (!lacp_value_equal(values[i], side->raw[i]))
+      changed = true;
+  }
+  if (!changed)
+    return;
+
+  lacp_side_clear(side);
+  for (i = 0; i < LACP_FIELD_MAX; i++)
+    side->raw[i] = values[i] ? xstrdup(values[i]) : NULL;
+
+  if (!values[LACP_FIELD_STATE])
+    return;
+
+  if (parse_state_from_db(values[LACP_FIELD_STATE], lacp_state_ovsdb) == LACP_STATUS_FIELD_COUNT)
+  {
+    strcpy(side->state_buf, get_lacp_state(lacp_state_ovsdb));
+    side->state = side->state_buf;
+  }
+  side->key = side->raw[LACP_FIELD_KEY];
+  /*
+   * The system and port priority are kept in the lacp_status column as part of the id fields separated by commas
+   * e.g port_id = 1,18 where 1 = priority and 18 = id
+   */
+  if (values[LACP_FIELD_PORT_ID])
+  {
+    side->port_ids = xstrdup(values[LACP_FIELD_PORT_ID]);
+    parse_id_from_db(side->port_ids, &priority, &id);
+    side->port_priority = priority;
+    side->port_id = id;
+  }
+  if (values[LACP_FIELD_SYSTEM_ID])
+  {
+    side->system_ids = xstrdup(values[LACP_FIELD_SYSTEM_ID]);
+    parse_id_from_db(side->system_ids, &priority, &id);
+    side->system_priority = priority;
+    side->system_id = id;
+  }
+}
+
+static bool
+lacp_is_lag_name(const char *name)
+{
+  return strncmp(name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0;
+}
+
+static void
+lacp_index_sync(void)
+{
+  const struct ovsrec_interface *if_row = NULL;
+  const struct ovsrec_port *port_row = NULL;
+  struct lacp_intf_info *info;
+  struct shash_node *node, *next;
+  int k;
+
+  if (vtysh_idl_cache_check(&lacp_index_cache))
+    return;
+  lacp_index_generation++;
+
+  OVSREC_INTERFACE_FOR_EACH(if_row, idl)
+  {
+    info = shash_find_data(&lacp_intfs, if_row->name);
+    if (!info)
+    {
+      info = xzalloc(sizeof *info);
+      shash_add(&lacp_intfs, if_row->name, info);
+    }
+    info->row = if_row;
+    info->lag = NULL;
+    info->generation = lacp_index_generation;
+    lacp_side_update(&info->actor, &if_row->lacp_status, lacp_actor_keys);
+    lacp_side_update(&info->partner, &if_row->lacp_status, lacp_partner_keys);
+  }
+
+  SHASH_FOR_EACH_SAFE(node, next, &lacp_intfs)
+  {
+    info = node->data;
+    if (info->generation != lacp_index_generation)
+    {
+      lacp_side_clear(&info->actor);
+      lacp_side_clear(&info->partner);
+      free(info);
+      shash_delete(&lacp_intfs, node);
+    }
+  }
+
+  shash_clear(&lacp_ports);
+  lacp_n_lags = 0;
+  OVSREC_PORT_FOR_EACH(port_row, idl)
+  {
+    shash_add(&lacp_ports, port_row->name, port_row);
+    if (!lacp_is_lag_name(port_row->name))
+      continue;
+
+    if (lacp_n_lags >= lacp_lags_size)
+      lacp_lags = x2nrealloc(lacp_lags, &lacp_lags_size, sizeof *lacp_lags);
+    lacp_lags[lacp_n_lags++] = port_row;
+
+    for (k = 0; k < port_row->n_interfaces; k++)
+    {
+      info = shash_find_data(&lacp_intfs, port_row->interfaces[k]->name);
+      if (info && !info->lag)
+        info->lag = port_row;
+    }
+  }
+}
+
+static const struct ovsrec_port *
+lacp_port_lookup(const char *name)
+{
+  lacp_index_sync();
+  return shash_find_data(&lacp_ports, name);
+}
+
+static struct lacp_intf_info *
+lacp_intf_lookup(const char *name)
+{
+  lacp_index_sync();
+  return shash_find_data(&lacp_intfs, name);
+}
+
 static int
 delete_lag(const char *lag_name)
 {
@@ -67,13 +345,7 @@ delete_lag(const char *lag_name)
   bool port_found = false;
 
   /* Return if LAG port doesn't exit */
-  OVSREC_PORT_FOR_EACH(lag_port_row, idl)
-  {
-    if (strcmp(lag_port_row->name, lag_name) == 0)
-    {
-       port_found = true;
-    }
-  }
+  port_found = (lacp_port_lookup(lag_name) != NULL);
 
   if(!port_found)
   {
@@ -206,14 +478,8 @@ lacp_set_mode(const char *lag_name, const char *mode_to_set, const char *present
     return CMD_OVSDB_FAILURE;
   }
 
-  OVSREC_PORT_FOR_EACH(port_row, idl)
-  {
-    if (strcmp(port_row->name, lag_name) == 0)
-    {
-      port_found = true;
-      break;
-    }
-  }
+  port_row = lacp_port_lookup(lag_name);
+  port_found = (port_row != NULL);
 
   if(!port_found)
   {
@@ -290,14 +556,8 @@ lacp_set_hash(const char *lag_name, const char *hash)
     cli_do_config_abort(txn);
     return CMD_OVSDB_FAILURE;
   }
-  OVSREC_PORT_FOR_EACH(port_row, idl)
-  {
-    if (strcmp(port_row->name, lag_name) == 0)
-    {
-      port_found = true;
-      break;
-    }
-  }
+  port_row = lacp_port_lookup(lag_name);
+  port_found = (port_row != NULL);
 
   if(!port_found)
   {
@@ -373,14 +633,8 @@ lacp_set_fallback(const char *lag_name, const char *fallback_status)
     return CMD_OVSDB_FAILURE;
   }
 
-  OVSREC_PORT_FOR_EACH(port_row, idl)
-  {
-    if (strcmp(port_row->name, lag_name) == 0)
-    {
-      port_found = true;
-      break;
-    }
-  }
+  port_row = lacp_port_lookup(lag_name);
+  port_found = (port_row != NULL);
 
   if(!port_found)
   {
@@ -452,14 +706,8 @@ lacp_set_heartbeat_rate(const char *lag_name, const char *rate)
     return CMD_OVSDB_FAILURE;
   }
 
-  OVSREC_PORT_FOR_EACH(port_row, idl)
-  {
-    if (strcmp(port_row->name, lag_name) == 0)
-    {
-      port_found = true;
-      break;
-    }
-  }
+  port_row = lacp_port_lookup(lag_name);
+  port_found = (port_row != NULL);
 
   if(!port_found)
   {
@@ -615,6 +863,7 @@ DEFUN (cli_lacp_set_no_global_sys_priority_shortform,
 static int
 lacp_intf_set_port_id(const char *if_name, const char *port_id_val)
 {
+   const struct lacp_intf_info *info = NULL;
    const struct ovsrec_interface * row = NULL;
    struct ovsdb_idl_txn* status_txn = NULL;
    enum ovsdb_idl_txn_status status;
@@ -635,17 +884,15 @@ lacp_intf_set_port_id(const char *if_name, const char *port_id_val)
       return CMD_OVSDB_FAILURE;
    }
 
-   OVSREC_INTERFACE_FOR_EACH(row, idl)
+   info = lacp_intf_lookup(if_name);
+   if(info)
    {
-      if(strcmp(row->name, if_name) == 0)
-      {
-         smap_clone(&smap, &row->other_config);
-         smap_replace(&smap, INTERFACE_OTHER_CONFIG_MAP_LACP_PORT_ID, port_id_val);
+      row = info->row;
+      smap_clone(&smap, &row->other_config);
+      smap_replace(&smap, INTERFACE_OTHER_CONFIG_MAP_LACP_PORT_ID, port_id_val);
 
-         ovsrec_interface_set_other_config(row, &smap);
-         smap_destroy(&smap);
-         break;
-      }
+      ovsrec_interface_set_other_config(row, &smap);
+      smap_destroy(&smap);
    }
 
    status = cli_do_config_finish(status_txn);
@@ -674,6 +921,7 @@ DEFUN (cli_lacp_intf_set_port_id,
 static int
 lacp_intf_set_port_priority(const char *if_name, const char *port_priority_val)
 {
+   const struct lacp_intf_info *info = NULL;
    const struct ovsrec_interface * row = NULL;
    struct ovsdb_idl_txn* status_txn = NULL;
    enum ovsdb_idl_txn_status status;
@@ -694,17 +942,15 @@ lacp_intf_set_port_priority(const char *if_name, const char *port_priority_val)
       return CMD_OVSDB_FAILURE;
    }
 
-   OVSREC_INTERFACE_FOR_EACH(row, idl)
+   info = lacp_intf_lookup(if_name);
+   if(info)
    {
-      if(strcmp(row->name, if_name) == 0)
-      {
-         smap_clone(&smap, &row->other_config);
-         smap_replace(&smap, INTERFACE_OTHER_CONFIG_MAP_LACP_PORT_PRIORITY, port_priority_val);
+      row = info->row;
+      smap_clone(&smap, &row->other_config);
+      smap_replace(&smap, INTERFACE_OTHER_CONFIG_MAP_LACP_PORT_PRIORITY, port_priority_val);
 
-         ovsrec_interface_set_other_config(row, &smap);
-         smap_destroy(&smap);
-         break;
-      }
+      ovsrec_interface_set_other_config(row, &smap);
+      smap_destroy(&smap);
    }
 
    status = cli_do_config_finish(status_txn);
@@ -855,33 +1101,29 @@ remove_port_reference (const struct ovsrec_port *port_row)
 static int
 lacp_add_intf_to_lag(const char *if_name, const char *lag_number)
 {
-   const struct ovsrec_interface *row = NULL;
    const struct ovsrec_interface *interface_row = NULL;
    struct ovsdb_idl_txn* status_txn = NULL;
    enum ovsdb_idl_txn_status status;
    char lag_name[LAG_NAME_LENGTH]={0};
    const struct ovsrec_port *port_row = NULL;
    bool port_found = false;
-   const struct ovsrec_interface *if_row = NULL;
+   const struct lacp_intf_info *info = NULL;
    const struct ovsrec_port *port_row_found = NULL;
    struct ovsrec_interface **interfaces;
    const struct ovsrec_port *lag_port = NULL;
-   int i=0, k=0, n=0;
+   int i=0, n=0;
 
    snprintf(lag_name, LAG_NAME_LENGTH, "%s%s", LAG_PORT_NAME_PREFIX, lag_number);
 
    /* Check if the LAG port is present or not. */
-   OVSREC_PORT_FOR_EACH(lag_port, idl)
+   lag_port = lacp_port_lookup(lag_name);
+   if (lag_port)
    {
-     if (strcmp(lag_port->name, lag_name) == 0)
+     port_found = true;
+     if(lag_port->n_interfaces == MAX_INTF_TO_LAG)
      {
-       port_found = true;
-       if(lag_port->n_interfaces == MAX_INTF_TO_LAG)
-       {
-         vty_out(vty, "Cannot add more interfaces to LAG. Maximum interface count is reached.\n");
-         return CMD_SUCCESS;
-       }
-       break;
+       vty_out(vty, "Cannot add more interfaces to LAG. Maximum interface count is reached.\n");
+       return CMD_SUCCESS;
      }
    }
    if(!port_found)
@@ -902,58 +1144,32 @@ lacp_add_intf_to_lag(const char *if_name, const char *lag_number)
     * This can happen if the interface is attached to VLAN.
     * Remove the port reference from VRF and Bridge before.
     */
-   OVSREC_PORT_FOR_EACH(port_row, idl)
+   port_row = lacp_port_lookup(if_name);
+   if(port_row)
    {
-     if(strcmp(port_row->name, if_name) == 0)
-     {
-        remove_port_reference(port_row);
-        ovsrec_port_delete(port_row);
-        break;
-     }
+      remove_port_reference(port_row);
+      ovsrec_port_delete(port_row);
    }
 
    /* Fetch the interface row to "interface_row" variable. */
-   OVSREC_INTERFACE_FOR_EACH(row, idl)
+   info = lacp_intf_lookup(if_name);
+   if(info)
    {
-      if(strcmp(row->name, if_name) == 0)
+      interface_row = info->row;
+
+      /* If the interface is already part of the LAG port specified
+       * in CLI then return with SUCCESS.
+       * If it is part of any other LAG then remove the reference
+       * from that LAG port. */
+      if(info->lag == lag_port)
       {
-         interface_row = row;
-         break;
+         vty_out(vty, "Interface %s is already part of %s.\n", if_name, lag_port->name);
+         cli_do_config_abort(status_txn);
+         return CMD_SUCCESS;
       }
+      port_row_found = info->lag;
    }
 
-   /* Search if the interface is part of any LAG or not.
-    * If it is part of LAG port which is is specified in CLI then
-    * return with SUCCESS.
-    * If it is part of any other LAG then exit and remove the
-    * reference from that LAG port.*/
-   OVSREC_PORT_FOR_EACH(port_row, idl)
-   {
-     if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
-     {
-        for (k = 0; k < port_row->n_interfaces; k++)
-        {
-           if_row = port_row->interfaces[k];
-           if(strcmp(if_name, if_row->name) == 0)
-           {
-              if (strcmp(port_row->name, lag_name) == 0)
-              {
-                 vty_out(vty, "Interface %s is already part of %s.\n", if_name, port_row->name);
-                 cli_do_config_abort(status_txn);
-                 return CMD_SUCCESS;
-              }
-              else
-              {
-                 /* Unlink interface from "port_row_found" port entry. */
-                 port_row_found = port_row;
-                 goto exit_loop;
-              }
-           }
-        }
-     }
-   }
-
-exit_loop:
    if(port_row_found)
    {
        /* Unlink the interface from the Port row found*/
@@ -1004,7 +1220,6 @@ DEFUN (cli_lacp_add_intf_to_lag,
 static int
 lacp_remove_intf_from_lag(const char *if_name, const char *lag_number)
 {
-   const struct ovsrec_interface *row = NULL;
    const struct ovsrec_interface *interface_row = NULL;
    const struct ovsrec_interface *if_row = NULL;
    struct ovsdb_idl_txn* status_txn = NULL;
@@ -1020,21 +1235,20 @@ lacp_remove_intf_from_lag(const char *if_name, const char *lag_number)
    snprintf(lag_name, LAG_NAME_LENGTH, "%s%s", LAG_PORT_NAME_PREFIX, lag_number);
 
    /* Check if the LAG port is present in DB. */
-   OVSREC_PORT_FOR_EACH(lag_port, idl)
+   lag_port = lacp_port_lookup(lag_name);
+   if (lag_port)
    {
-     if (strcmp(lag_port->name, lag_name) == 0)
+     for (k = 0; k < lag_port->n_interfaces; k++)
      {
-       for (k = 0; k < lag_port->n_interfaces; k++)
+       if_row = lag_port->interfaces[k];
+       if(strcmp(if_name, if_row->name) == 0)
        {
-         if_row = lag_port->interfaces[k];
-         if(strcmp(if_name, if_row->name) == 0)
-         {
-           interface_found = true;
-         }
+         interface_row = if_row;
+         interface_found = true;
+         break;
        }
-       port_found = true;
-       break;
      }
+     port_found = true;
    }
 
    if(!port_found)
@@ -1056,16 +1270,6 @@ lacp_remove_intf_from_lag(const char *if_name, const char *lag_number)
       return CMD_OVSDB_FAILURE;
    }
 
-   /* Fetch the interface row to "interface_row" */
-   OVSREC_INTERFACE_FOR_EACH(row, idl)
-   {
-      if(strcmp(row->name, if_name) == 0)
-      {
-         interface_row = row;
-         break;
-      }
-   }
-
    /* Unlink the interface from the Port row found*/
    interfaces = xmalloc(sizeof *lag_port->interfaces * (lag_port->n_interfaces-1));
    for(i = n = 0; i < lag_port->n_interfaces; i++)
@@ -1150,7 +1354,7 @@ lacp_show_aggregates(const char *lag_name)
    const char *aggregate_mode = NULL;
    const char *hash = NULL;
    bool show_all = false;
-   bool port_found = false;
+   size_t i = 0, n_lags = 0;
    int k = 0;
 
    if(strncmp("all", lag_name, 3) == 0)
@@ -1158,52 +1362,58 @@ lacp_show_aggregates(const char *lag_name)
       show_all = true;
    }
 
-   OVSREC_PORT_FOR_EACH(lag_port, idl)
+   lacp_index_sync();
+   if(show_all)
    {
-      if(((strncmp(lag_port->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0) && show_all)
-          || (strcmp(lag_port->name, lag_name) == 0))
+      n_lags = lacp_n_lags;
+   }
+   else
+   {
+      lag_port = shash_find_data(&lacp_ports, lag_name);
+      if(!lag_port)
       {
-         vty_out(vty, "%s", VTY_NEWLINE);
-         vty_out(vty, "%s%s%s","Aggregate-name        : ", lag_port->name, VTY_NEWLINE);
-         vty_out(vty, "%s","Aggregated-interfaces : ");
-         for (k = 0; k < lag_port->n_interfaces; k++)
-         {
-            if_row = lag_port->interfaces[k];
-            vty_out(vty, "%s ", if_row->name);
-         }
-         vty_out(vty, "%s", VTY_NEWLINE);
-         heartbeat_rate = smap_get(&lag_port->other_config, "lacp-time");
-         if(heartbeat_rate)
-            vty_out(vty, "%s%s%s", "Heartbeat rate        : ",heartbeat_rate, VTY_NEWLINE);
-         else
-            vty_out(vty, "%s%s%s", "Heartbeat rate        : ",PORT_OTHER_CONFIG_LACP_TIME_SLOW, VTY_NEWLINE);
-
-         fallback = smap_get_bool(&lag_port->other_config, "lacp-fallback-ab", false);
-         vty_out(vty, "%s%s%s", "Fallback              : ",(fallback)?"true":"false", VTY_NEWLINE);
-
-         hash = smap_get(&lag_port->other_config, "bond_mode");
-         if(hash)
-            vty_out(vty, "%s%s%s", "Hash                  : ",hash, VTY_NEWLINE);
-         else
-            vty_out(vty, "%s%s%s", "Hash                  : ","l3-src-dst", VTY_NEWLINE);
-
-         aggregate_mode = lag_port->lacp;
-         if(aggregate_mode)
-            vty_out(vty, "%s%s%s", "Aggregate mode        : ",aggregate_mode, VTY_NEWLINE);
-         else
-            vty_out(vty, "%s%s%s", "Aggregate mode        : ","off", VTY_NEWLINE);
-         vty_out(vty, "%s", VTY_NEWLINE);
-
-         if(!show_all)
-         {
-            port_found = true;
-            break;
-         }
+         vty_out(vty, "Specified LAG port doesn't exist.\n");
+         return CMD_SUCCESS;
       }
+      n_lags = 1;
    }
 
-   if(!show_all && !port_found)
-      vty_out(vty, "Specified LAG port doesn't exist.\n");
+   for (i = 0; i < n_lags; i++)
+   {
+      if(show_all)
+         lag_port = lacp_lags[i];
+
+      vty_out(vty, "%s", VTY_NEWLINE);
+      vty_out(vty, "%s%s%s","Aggregate-name        : ", lag_port->name, VTY_NEWLINE);
+      vty_out(vty, "%s","Aggregated-interfaces : ");
+      for (k = 0; k < lag_port->n_interfaces; k++)
+      {
+         if_row = lag_port->interfaces[k];
+         vty_out(vty, "%s ", if_row->name);
+      }
+      vty_out(vty, "%s", VTY_NEWLINE);
+      heartbeat_rate = smap_get(&lag_port->other_config, "lacp-time");
+      if(heartbeat_rate)
+         vty_out(vty, "%s%s%s", "Heartbeat rate        : ",heartbeat_rate, VTY_NEWLINE);
+      else
+         vty_out(vty, "%s%s%s", "Heartbeat rate        : ",PORT_OTHER_CONFIG_LACP_TIME_SLOW, VTY_NEWLINE);
+
+      fallback = smap_get_bool(&lag_port->other_config, "lacp-fallback-ab", false);
+      vty_out(vty, "%s%s%s", "Fallback              : ",(fallback)?"true":"false", VTY_NEWLINE);
+
+      hash = smap_get(&lag_port->other_config, "bond_mode");
+      if(hash)
+         vty_out(vty, "%s%s%s", "Hash                  : ",hash, VTY_NEWLINE);
+      else
+         vty_out(vty, "%s%s%s", "Hash                  : ","l3-src-dst", VTY_NEWLINE);
+
+      aggregate_mode = lag_port->lacp;
+      if(aggregate_mode)
+         vty_out(vty, "%s%s%s", "Aggregate mode        : ",aggregate_mode, VTY_NEWLINE);
+      else
+         vty_out(vty, "%s%s%s", "Aggregate mode        : ","off", VTY_NEWLINE);
+      vty_out(vty, "%s", VTY_NEWLINE);
+   }
 
    return CMD_SUCCESS;
 }
@@ -1229,66 +1439,45 @@ DEFUN (cli_lacp_show_aggregates,
   return lacp_show_aggregates(argv[0]);
 }
 
-static char *
-get_lacp_state(const char *state)
-{
-   /* +1 for the event where all flags are ON then we have a place to store \0 */
-   static char ret_state[LACP_STATUS_FIELD_COUNT+1]={0};
-   int n = 0;
-
-   memset(ret_state, 0, LACP_STATUS_FIELD_COUNT+1);
-   if(state == NULL) return ret_state;
-   ret_state[n++] = state[0]? 'A':'P';
-   ret_state[n++] = state[1]? 'S':'L';
-   ret_state[n++] = state[2]? 'F':'I';
-   ret_state[n++] = state[3]? 'N':'O';
-   if (state[4]) ret_state[n++] = 'C';
-   if (state[5]) ret_state[n++] = 'D';
-   if (state[6]) ret_state[n++] = 'E';
-   if (state[7]) ret_state[n++] = 'X';
-
-   return ret_state;
-}
-
-
-void
-parse_id_from_db (char *str, char **value1, char **value2)
+static void
+lacp_show_lag_members(const char *columns, bool partner)
 {
-  *value1 = strsep(&str, ",");
-  *value2 = strsep(&str, ",");
-}
+   const struct ovsrec_port *lag_port = NULL;
+   const struct ovsrec_interface *if_row = NULL;
+   const struct lacp_intf_info *info = NULL;
+   const struct lacp_side_info *side = NULL;
+   static const struct lacp_side_info no_side;
+   size_t i = 0;
+   int k = 0;
 
-/*
- * Expected format from DB (e.g):
- * "Actv:1,TmOut:1,Aggr:1,Sync:1,Col:1,Dist:1,Def:0,Exp:0"
- * Expected output (e.g):
- * [1,1,1,1,1,1,0,0]
- * Returns the number of fields read
- *
- */
+   for (i = 0; i < lacp_n_lags; i++)
+   {
+      lag_port = lacp_lags[i];
+      vty_out(vty, "Aggregate-name : %s%s", lag_port->name, VTY_NEWLINE);
 
-int
-parse_state_from_db(const char *str, char *ret_str)
-{
- return sscanf(str, "%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d%*[^01]%d",
-               &ret_str[0], &ret_str[1], &ret_str[2], &ret_str[3], &ret_str[4], &ret_str[5],
-               &ret_str[6], &ret_str[7]);
+      for (k = 0; k < lag_port->n_interfaces; k++)
+      {
+         if_row = lag_port->interfaces[k];
+         info = shash_find_data(&lacp_intfs, if_row->name);
+         side = info ? (partner ? &info->partner : &info->actor) : &no_side;
+         vty_out(vty, columns,
+                    if_row->name,
+                    side->port_id ? side->port_id : " ",
+                    side->port_priority ? side->port_priority : " ",
+                    side->key ? side->key : " ",
+                    side->state ? side->state : " ",
+                    side->system_id ? side->system_id : " ",
+                    side->system_priority ? side->system_priority : " ");
+         vty_out(vty,"%s", VTY_NEWLINE);
+      }
+      if(k == 0)
+        vty_out(vty, "No interfaces are attached to %s%s", lag_port->name, VTY_NEWLINE);
+   }
 }
 
 static int
 lacp_show_interfaces_all()
 {
-   const struct ovsrec_port *lag_port = NULL;
-   const struct ovsrec_interface *if_row = NULL;
-   int k = 0;
-   char lacp_state_ovsdb[LACP_STATUS_FIELD_COUNT];
-   memset(lacp_state_ovsdb, 0, LACP_STATUS_FIELD_COUNT);
-   const char *lacp_state = NULL;
-   const char *key = NULL, *port_priority = NULL, *port_id = NULL;
-   char *port_priority_id_ovsdb = NULL, *system_priority_id_ovsdb = NULL;
-   const char *system_id = NULL, *system_priority = NULL;
-   const char *data_in_db = NULL;
-
    const char columns[] = "%-12s %-8s %-10s %-6s %-10s %-18s %-8s";
 
    vty_out(vty,"%s", VTY_NEWLINE);
@@ -1302,6 +1491,8 @@ lacp_show_interfaces_all()
    vty_out(vty, "X - State m/c expired              E - Default neighbor state");
    vty_out(vty,"%s%s", VTY_NEWLINE, VTY_NEWLINE);
 
+   lacp_index_sync();
+
    vty_out(vty, "Actor details of all interfaces:%s",VTY_NEWLINE);
    vty_out(vty, "------------------------------------------------------------------------------");
    vty_out(vty,"%s", VTY_NEWLINE);
@@ -1310,54 +1501,7 @@ lacp_show_interfaces_all()
    vty_out(vty, "------------------------------------------------------------------------------");
    vty_out(vty,"%s", VTY_NEWLINE);
 
-   OVSREC_PORT_FOR_EACH(lag_port, idl)
-   {
-      if(strncmp(lag_port->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
-      {
-         vty_out(vty, "Aggregate-name : %s%s", lag_port->name, VTY_NEWLINE);
-
-         for (k = 0; k < lag_port->n_interfaces; k++)
-         {
-            if_row = lag_port->interfaces[k];
-            port_id = port_priority = key = lacp_state = system_id = system_priority = NULL;
-            if (data_in_db = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_STATE))
-            {
-              if (parse_state_from_db(data_in_db, lacp_state_ovsdb) == LACP_STATUS_FIELD_COUNT)
-              {
-                lacp_state = get_lacp_state(lacp_state_ovsdb);
-              }
-              key = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_KEY);
-              /*
-              * The system and port priority are kept in the lacp_status column as part of the id fields separated by commas
-              * e.g port_id = 1,18 where 1 = priority and 18 = id
-              */
-              port_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_PORT_ID));
-              parse_id_from_db(port_priority_id_ovsdb, &port_priority, &port_id);
-              system_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_SYSTEM_ID));
-              parse_id_from_db(system_priority_id_ovsdb, &system_priority, &system_id);
-            }
-            vty_out(vty, columns,
-                       if_row->name,
-                       port_id ? port_id : " ",
-                       port_priority ? port_priority : " ",
-                       key ? key : " ",
-                       lacp_state ? lacp_state : " ",
-                       system_id ? system_id : " ",
-                       system_priority ? system_priority : " ");
-            vty_out(vty,"%s", VTY_NEWLINE);
-            if (port_priority_id_ovsdb){
-                free(port_priority_id_ovsdb);
-                port_priority_id_ovsdb = NULL;
-            }
-            if (system_priority_id_ovsdb){
-                free(system_priority_id_ovsdb);
-                system_priority_id_ovsdb = NULL;
-            }
-         }
-         if(k == 0)
-           vty_out(vty, "No interfaces are attached to %s%s", lag_port->name, VTY_NEWLINE);
-      }
-   }
+   lacp_show_lag_members(columns, false);
    vty_out(vty,"%s%s", VTY_NEWLINE, VTY_NEWLINE);
 
    vty_out(vty, "Partner details of all interfaces:%s",VTY_NEWLINE);
@@ -1370,50 +1514,7 @@ lacp_show_interfaces_all()
    vty_out(vty, "------------------------------------------------------------------------------");
    vty_out(vty,"%s", VTY_NEWLINE);
 
-   OVSREC_PORT_FOR_EACH(lag_port, idl)
-   {
-      if(strncmp(lag_port->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
-      {
-         vty_out(vty, "Aggregate-name : %s%s", lag_port->name, VTY_NEWLINE);
-
-         for (k = 0; k < lag_port->n_interfaces; k++)
-         {
-            if_row = lag_port->interfaces[k];
-            port_id = port_priority = key = lacp_state = system_id = system_priority = NULL;
-            if (data_in_db = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_STATE))
-            {
-              if (parse_state_from_db(data_in_db, lacp_state_ovsdb) == LACP_STATUS_FIELD_COUNT)
-              {
-                lacp_state = get_lacp_state(lacp_state_ovsdb);
-              }
-              key = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_KEY);
-              port_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_PORT_ID));
-              parse_id_from_db(port_priority_id_ovsdb, &port_priority, &port_id);
-              system_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_SYSTEM_ID));
-              parse_id_from_db(system_priority_id_ovsdb, &system_priority, &system_id);
-            }
-            vty_out(vty, columns,
-                       if_row->name,
-                       port_id ? port_id : " ",
-                       port_priority ? port_priority : " ",
-                       key ? key : " ",
-                       lacp_state ? lacp_state : " ",
-                       system_id ? system_id : " ",
-                       system_priority ? system_priority : " ");
-            vty_out(vty,"%s", VTY_NEWLINE);
-            if (port_priority_id_ovsdb){
-                free(port_priority_id_ovsdb);
-                port_priority_id_ovsdb = NULL;
-            }
-            if (system_priority_id_ovsdb){
-                free(system_priority_id_ovsdb);
-                system_priority_id_ovsdb = NULL;
-            }
-        }
-         if(k == 0)
-           vty_out(vty, "No interfaces are attached to %s%s", lag_port->name, VTY_NEWLINE);
-      }
-   }
+   lacp_show_lag_members(columns, true);
 
    return CMD_SUCCESS;
 }
@@ -1431,19 +1532,10 @@ DEFUN (cli_lacp_show_all_interfaces,
 static int
 lacp_show_interfaces(const char *if_name)
 {
-   const struct ovsrec_port *port_row = NULL;
-   const struct ovsrec_interface *if_row = NULL;
-   int k = 0;
-   char a_lacp_state_ovsdb[LACP_STATUS_FIELD_COUNT] = {0};
-   char p_lacp_state_ovsdb[LACP_STATUS_FIELD_COUNT] = {0};
-   const char *a_lacp_state = NULL, *p_lacp_state = NULL;
-   const char *a_key = NULL, *a_system_id = NULL, *a_system_priority = NULL, *a_port_id = NULL, *a_port_priority = NULL;
-   const char *p_key = NULL, *p_system_id = NULL, *p_system_priority = NULL, *p_port_id = NULL, *p_port_priority = NULL;
-   char *a_port_priority_id_ovsdb = NULL, *a_system_priority_id_ovsdb = NULL;
-   char *p_port_priority_id_ovsdb = NULL, *p_system_priority_id_ovsdb = NULL;
-   const char *data_in_db = NULL;
+   const struct lacp_intf_info *info = NULL;
+   static const struct lacp_side_info no_side;
+   const struct lacp_side_info *a = &no_side, *p = &no_side;
    const char *columns = "%-18s | %-18s | %-18s %s";
-   bool port_row_round = false;
 
    vty_out(vty,"%s", VTY_NEWLINE);
    vty_out(vty, "State abbreviations :%s", VTY_NEWLINE);
@@ -1456,44 +1548,16 @@ lacp_show_interfaces(const char *if_name)
    vty_out(vty, "X - State m/c expired              E - Default neighbor state");
    vty_out(vty,"%s%s", VTY_NEWLINE, VTY_NEWLINE);
 
-   OVSREC_PORT_FOR_EACH(port_row, idl)
+   info = lacp_intf_lookup(if_name);
+   if (info && info->lag && info->actor.raw[LACP_FIELD_STATE])
    {
-     if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
-     {
-        for (k = 0; k < port_row->n_interfaces; k++)
-        {
-           if_row = port_row->interfaces[k];
-           if(strcmp(if_name, if_row->name) == 0)
-           {
-             a_port_id = a_port_priority = a_key = a_lacp_state = a_system_id = a_system_priority = NULL;
-             p_port_id = p_port_priority = p_key = p_lacp_state = p_system_id = p_system_priority = NULL;
-             if (data_in_db = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_STATE))
-             {
-               /*get_lacp_state() returns a static char*, unless copied it will be overwritten by partner state*/
-               if (parse_state_from_db(data_in_db, a_lacp_state_ovsdb) == LACP_STATUS_FIELD_COUNT) a_lacp_state = strdup(get_lacp_state(a_lacp_state_ovsdb));
-               a_key = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_KEY);
-               a_port_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_PORT_ID));
-               parse_id_from_db(a_port_priority_id_ovsdb, &a_port_priority, &a_port_id);
-               a_system_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_ACTOR_SYSTEM_ID));
-               parse_id_from_db(a_system_priority_id_ovsdb, &a_system_priority, &a_system_id);
-
-               data_in_db = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_STATE);
-               if (parse_state_from_db(data_in_db, p_lacp_state_ovsdb) == LACP_STATUS_FIELD_COUNT) p_lacp_state = strdup(get_lacp_state(p_lacp_state_ovsdb));
-               p_key = smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_KEY);
-               p_port_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_PORT_ID));
-               parse_id_from_db(p_port_priority_id_ovsdb, &p_port_priority, &p_port_id);
-               p_system_priority_id_ovsdb = strdup(smap_get(&if_row->lacp_status, INTERFACE_LACP_STATUS_MAP_PARTNER_SYSTEM_ID));
-               parse_id_from_db(p_system_priority_id_ovsdb, &p_system_priority, &p_system_id);
-             }
-             port_row_round = true;
-             goto Exit;
-           }
-        }
-     }
+     /* Partner details are only shown alongside the actor's. */
+     a = &info->actor;
+     p = &info->partner;
    }
-Exit:
+
    vty_out(vty,"%s",VTY_NEWLINE);
-   vty_out(vty, "Aggregate-name : %s%s", port_row_round?port_row->name:" ", VTY_NEWLINE);
+   vty_out(vty, "Aggregate-name : %s%s", (info && info->lag)?info->lag->name:" ", VTY_NEWLINE);
    vty_out(vty, "-------------------------------------------------");
    vty_out(vty,"%s",VTY_NEWLINE);
    vty_out(vty, "                       Actor             Partner");
@@ -1501,24 +1565,18 @@ Exit:
    vty_out(vty, "-------------------------------------------------");
    vty_out(vty,"%s",VTY_NEWLINE);
    vty_out(vty,columns,
-               "Port-id", a_port_id?a_port_id:" ", p_port_id?p_port_id:" ", VTY_NEWLINE);
+               "Port-id", a->port_id?a->port_id:" ", p->port_id?p->port_id:" ", VTY_NEWLINE);
    vty_out(vty,columns,
-               "Port-priority", a_port_priority?a_port_priority:" ", p_port_priority?p_port_priority:" ", VTY_NEWLINE);
+               "Port-priority", a->port_priority?a->port_priority:" ", p->port_priority?p->port_priority:" ", VTY_NEWLINE);
    vty_out(vty,columns,
-               "Key", a_key?a_key:" ", p_key?p_key:" ", VTY_NEWLINE);
+               "Key", a->key?a->key:" ", p->key?p->key:" ", VTY_NEWLINE);
    vty_out(vty,columns,
-               "State", a_lacp_state?a_lacp_state:" ", p_lacp_state?p_lacp_state:" ", VTY_NEWLINE);
+               "State", a->state?a->state:" ", p->state?p->state:" ", VTY_NEWLINE);
    vty_out(vty,columns,
-               "System-id",a_system_id?a_system_id:" ", p_system_id?p_system_id:" ", VTY_NEWLINE);
+               "System-id",a->system_id?a->system_id:" ", p->system_id?p->system_id:" ", VTY_NEWLINE);
    vty_out(vty,columns,
-               "System-priority",a_system_priority?a_system_priority:" ", p_system_priority?p_system_priority:" ", VTY_NEWLINE);
+               "System-priority",a->system_priority?a->system_priority:" ", p->system_priority?p->system_priority:" ", VTY_NEWLINE);
    vty_out(vty,"%s",VTY_NEWLINE);
-   free(a_port_priority_id_ovsdb);
-   free(p_port_priority_id_ovsdb);
-   free(a_system_priority_id_ovsdb);
-   free(p_system_priority_id_ovsdb);
-   free(a_lacp_state);
-   free(p_lacp_state);
    return CMD_SUCCESS;
 }
 
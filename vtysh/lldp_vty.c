@@ -26,6 +26,11 @@
 #include <setjmp.h>
 #include <sys/wait.h>
 #include <pwd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -39,10 +44,12 @@
 #include "ovsdb-idl.h"
 #include "lldp_vty.h"
 #include "smap.h"
+#include "util.h"
 #include "openvswitch/vlog.h"
 #include "openswitch-idl.h"
 #include "vtysh/vtysh_ovsdb_if.h"
 #include "vtysh/vtysh_ovsdb_config.h"
+#include "lib/vty_utils.h"
 
 VLOG_DEFINE_THIS_MODULE(vtysh_lldp_cli);
 extern struct ovsdb_idl *idl;
@@ -66,18 +73,6 @@ typedef struct lldp_stats
   struct lldp_stats *next;
 }lldp_intf_stats;
 
-typedef struct
-{
-  char name[INTF_NAME_SIZE];
-  int insert_count;
-  int delete_count;
-  int drop_count;
-  int ageout_count;
-  char  chassis_id[LLDP_MAX_BUF_SIZE];
-  char  port_id[LLDP_MAX_BUF_SIZE];
-  char  chassis_ttl[LLDP_STR_CHASSIS_TLV_LENGTH];
-}lldp_neighbor_info;
-
 
 /* Sets the LLDP global status.
    Takes true/false argument   */
@@ -1117,34 +1112,321 @@ DEFUN (cli_lldp_show_statistics,
   return CMD_SUCCESS;
 }
 
-/* qsort comparator function.
- * This may need to be modified depending on the format of interface name
+/*
+ * LLDP neighbor cache.
+ *
+ * One entry per interface, keyed by name, with the neighbor fields and
+ * counters pulled out of lldp_neighbor_info and lldp_statistics in a
+ * single pass.  lldp_neighbors_sync() refreshes it whenever the IDL
+ * seqno moves and records every neighbor that appears, changes or goes
+ * away in a small event ring that "monitor lldp neighbors" reads.
  */
-static inline int compare_intf(const void*a, const void* b)
+enum lldp_nbr_field
 {
-    lldp_neighbor_info* s1 = (lldp_neighbor_info*)a;
-    lldp_neighbor_info* s2 = (lldp_neighbor_info*)b;
-    uint i1=0,i2=0,i3=0,i4=0;
+  LLDP_NBR_CHASSIS_ID,
+  LLDP_NBR_PORT_ID,
+  LLDP_NBR_TTL,
+  LLDP_NBR_CAP_AVAILABLE,
+  LLDP_NBR_CAP_ENABLED,
+  LLDP_NBR_CHASSIS_NAME,
+  LLDP_NBR_CHASSIS_DESC,
+  LLDP_NBR_MGMT_IP,
+  LLDP_NBR_FIELD_MAX
+};
+
+static const char *lldp_nbr_field_keys[LLDP_NBR_FIELD_MAX] = {
+  "chassis_id",
+  "port_id",
+  "chassis_ttl",
+  "chassis_capability_available",
+  "chassis_capability_enabled",
+  "chassis_name",
+  "chassis_description",
+  "mgmt_ip_list"
+};
+
+enum lldp_nbr_stat
+{
+  LLDP_NBR_INSERT,
+  LLDP_NBR_DELETE,
+  LLDP_NBR_DROP,
+  LLDP_NBR_AGEOUT,
+  LLDP_NBR_STAT_MAX
+};
+
+static const char *lldp_nbr_stat_keys[LLDP_NBR_STAT_MAX] = {
+  INTERFACE_STATISTICS_LLDP_INSERT_COUNT,
+  INTERFACE_STATISTICS_LLDP_DELETE_COUNT,
+  INTERFACE_STATISTICS_LLDP_DROP_COUNT,
+  INTERFACE_STATISTICS_LLDP_AGEOUT_COUNT
+};
+
+struct lldp_nbr
+{
+  char *name;                        /* Local interface name. */
+  int sort_key[2];                   /* "%d-%d" of name. */
+  bool system;                       /* Interface type is "system". */
+  unsigned int generation;           /* Last sync that saw it. */
+  int64_t stats[LLDP_NBR_STAT_MAX];
+  char *fields[LLDP_NBR_FIELD_MAX];  /* NULL when not advertised. */
+};
+
+typedef enum
+{
+  LLDP_NBR_ADDED,
+  LLDP_NBR_CHANGED,
+  LLDP_NBR_DELETED,
+  LLDP_NBR_AGED_OUT
+} lldp_nbr_event_type;
+
+static const char *lldp_nbr_event_names[] = {
+  "Added", "Changed", "Deleted", "Aged-out"
+};
+
+#define LLDP_NBR_EVENT_RING 256
+
+struct lldp_nbr_event
+{
+  unsigned int seq;
+  lldp_nbr_event_type type;
+  time_t time;
+  char port[INTF_NAME_SIZE];
+  char *chassis_id;
+  char *port_id;
+};
+
+/* Interface name -> struct lldp_nbr. */
+static struct shash lldp_nbrs = SHASH_INITIALIZER(&lldp_nbrs);
+static struct lldp_nbr **lldp_nbrs_sorted;  /* lldp_nbrs in port order. */
+static size_t lldp_nbrs_n_sorted;
+static bool lldp_nbrs_resort;               /* Membership changed. */
+static const struct ovsdb_idl_table_class *const lldp_nbrs_tables[] = {
+  &ovsrec_table_interface,
+};
+static struct vtysh_idl_cache lldp_nbrs_cache =
+  VTYSH_IDL_CACHE_INITIALIZER(lldp_nbrs_tables);
+static unsigned int lldp_nbrs_generation;
+
+static struct lldp_nbr_event lldp_nbr_events[LLDP_NBR_EVENT_RING];
+static unsigned int lldp_nbr_event_seq;     /* Seq of the newest event. */
+
+static void
+lldp_nbr_event_add(const struct lldp_nbr *nbr, lldp_nbr_event_type type,
+                   char * const fields[LLDP_NBR_FIELD_MAX])
+{
+  struct lldp_nbr_event *ev;
+
+  lldp_nbr_event_seq++;
+  ev = &lldp_nbr_events[lldp_nbr_event_seq % LLDP_NBR_EVENT_RING];
+  free(ev->chassis_id);
+  free(ev->port_id);
+
+  ev->seq = lldp_nbr_event_seq;
+  ev->type = type;
+  ev->time = time(NULL);
+  strncpy(ev->port, nbr->name, INTF_NAME_SIZE - 1);
+  ev->port[INTF_NAME_SIZE - 1] = '\0';
+  ev->chassis_id = xstrdup(fields[LLDP_NBR_CHASSIS_ID]
+                           ? fields[LLDP_NBR_CHASSIS_ID] : "");
+  ev->port_id = xstrdup(fields[LLDP_NBR_PORT_ID]
+                        ? fields[LLDP_NBR_PORT_ID] : "");
+}
+
+static bool
+lldp_nbr_field_equal(const char *a, const char *b)
+{
+  if (!a || !b)
+    return a == b;
+  return !strcmp(a, b);
+}
+
+/* Brings one cache entry up to date with ifrow and logs the change, if
+ * the neighbor on that port came, went or changed. */
+static void
+lldp_nbr_update(struct lldp_nbr *nbr, const struct ovsrec_interface *ifrow)
+{
+  const char *fields[LLDP_NBR_FIELD_MAX];
+  struct smap_node *node;
+  int64_t old_ageout = nbr->stats[LLDP_NBR_AGEOUT];
+  bool had, has, changed = false;
+  size_t i;
+  int j;
+
+  memset(fields, 0, sizeof fields);
+  SMAP_FOR_EACH(node, &ifrow->lldp_neighbor_info)
+  {
+    for (j = 0; j < LLDP_NBR_FIELD_MAX; j++)
+    {
+      if (!strcmp(node->key, lldp_nbr_field_keys[j]))
+      {
+        fields[j] = node->value;
+        break;
+      }
+    }
+  }
 
-    /* For sorting number with 21-1 etc. name */
-    sscanf(s1->name,"%d-%d",&i1,&i2);
-    sscanf(s2->name,"%d-%d",&i3,&i4);
+  memset(nbr->stats, 0, sizeof nbr->stats);
+  for (i = 0; i < ifrow->n_lldp_statistics; i++)
+  {
+    for (j = 0; j < LLDP_NBR_STAT_MAX; j++)
+    {
+      if (!strcmp(ifrow->key_lldp_statistics[i], lldp_nbr_stat_keys[j]))
+      {
+        nbr->stats[j] = ifrow->value_lldp_statistics[i];
+        break;
+      }
+    }
+  }
 
-    if(i1 == i3)
+  for (j = 0; j < LLDP_NBR_FIELD_MAX; j++)
+  {
+    if (!lldp_nbr_field_equal(nbr->fields[j], fields[j]))
     {
-        if(i2 == i4)
-            return 0;
-        else if(i2 < i4)
-            return -1;
-        else
-            return 1;
+      changed = true;
+      break;
     }
-    else if (i1 < i3)
-        return -1;
-    else
-        return 1;
+  }
+  if (!changed)
+    return;
 
-    return 0;
+  had = nbr->fields[LLDP_NBR_CHASSIS_ID] != NULL;
+  has = fields[LLDP_NBR_CHASSIS_ID] != NULL;
+  if (had && !has)
+    lldp_nbr_event_add(nbr, nbr->stats[LLDP_NBR_AGEOUT] > old_ageout
+                            ? LLDP_NBR_AGED_OUT : LLDP_NBR_DELETED,
+                       nbr->fields);
+
+  for (j = 0; j < LLDP_NBR_FIELD_MAX; j++)
+  {
+    free(nbr->fields[j]);
+    nbr->fields[j] = fields[j] ? xstrdup(fields[j]) : NULL;
+  }
+
+  if (has)
+    lldp_nbr_event_add(nbr, had ? LLDP_NBR_CHANGED : LLDP_NBR_ADDED,
+                       nbr->fields);
+}
+
+static void
+lldp_nbr_free(struct lldp_nbr *nbr)
+{
+  int j;
+
+  for (j = 0; j < LLDP_NBR_FIELD_MAX; j++)
+    free(nbr->fields[j]);
+  free(nbr->name);
+  free(nbr);
+}
+
+/*
+ * Syncs the neighbor cache with the IDL if the Interface table changed
+ * since the last call.  Called from the OVSDB thread and from the show
+ * commands, always with the OVSDB lock held.
+ */
+void
+lldp_neighbors_sync(void)
+{
+  const struct ovsrec_interface *ifrow = NULL;
+  struct shash_node *node, *next;
+  struct lldp_nbr *nbr;
+
+  if (vtysh_idl_cache_check(&lldp_nbrs_cache))
+    return;
+  lldp_nbrs_generation++;
+
+  OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+  {
+    nbr = shash_find_data(&lldp_nbrs, ifrow->name);
+    if (!nbr)
+    {
+      nbr = xzalloc(sizeof *nbr);
+      nbr->name = xstrdup(ifrow->name);
+      /* For sorting number with 21-1 etc. name */
+      sscanf(nbr->name, "%d-%d", &nbr->sort_key[0], &nbr->sort_key[1]);
+      shash_add(&lldp_nbrs, nbr->name, nbr);
+      lldp_nbrs_resort = true;
+    }
+    nbr->generation = lldp_nbrs_generation;
+    nbr->system = !strcmp(ifrow->type, OVSREC_INTERFACE_TYPE_SYSTEM);
+    lldp_nbr_update(nbr, ifrow);
+  }
+
+  SHASH_FOR_EACH_SAFE(node, next, &lldp_nbrs)
+  {
+    nbr = node->data;
+    if (nbr->generation == lldp_nbrs_generation)
+      continue;
+    if (nbr->fields[LLDP_NBR_CHASSIS_ID])
+      lldp_nbr_event_add(nbr, LLDP_NBR_DELETED, nbr->fields);
+    shash_delete(&lldp_nbrs, node);
+    lldp_nbr_free(nbr);
+    lldp_nbrs_resort = true;
+  }
+}
+
+/* qsort comparator function.
+ * This may need to be modified depending on the format of interface name
+ */
+static int
+compare_nbr(const void *a, const void *b)
+{
+  const struct lldp_nbr *n1 = *(const struct lldp_nbr **)a;
+  const struct lldp_nbr *n2 = *(const struct lldp_nbr **)b;
+
+  if (n1->sort_key[0] != n2->sort_key[0])
+    return n1->sort_key[0] < n2->sort_key[0] ? -1 : 1;
+  if (n1->sort_key[1] != n2->sort_key[1])
+    return n1->sort_key[1] < n2->sort_key[1] ? -1 : 1;
+  return strcmp(n1->name, n2->name);
+}
+
+/* Returns the cache entries in port order, sorting only when an
+ * interface was added or removed since the last call. */
+static struct lldp_nbr **
+lldp_neighbors_sorted(size_t *n)
+{
+  struct shash_node *node;
+  size_t i = 0;
+
+  lldp_neighbors_sync();
+  if (lldp_nbrs_resort)
+  {
+    lldp_nbrs_n_sorted = shash_count(&lldp_nbrs);
+    lldp_nbrs_sorted = xrealloc(lldp_nbrs_sorted,
+                                (lldp_nbrs_n_sorted + 1)
+                                * sizeof *lldp_nbrs_sorted);
+    SHASH_FOR_EACH(node, &lldp_nbrs)
+      lldp_nbrs_sorted[i++] = node->data;
+    qsort(lldp_nbrs_sorted, lldp_nbrs_n_sorted, sizeof *lldp_nbrs_sorted,
+          compare_nbr);
+    lldp_nbrs_resort = false;
+  }
+  *n = lldp_nbrs_n_sorted;
+  return lldp_nbrs_sorted;
+}
+
+static const char *
+lldp_nbr_field(const struct lldp_nbr *nbr, enum lldp_nbr_field field)
+{
+  return nbr->fields[field] ? nbr->fields[field] : "";
+}
+
+static void
+lldp_show_nbr_detail(struct vty *vty, const struct lldp_nbr *nbr)
+{
+  vty_out (vty, "Port                           : %s%s", nbr->name, VTY_NEWLINE);
+  vty_out(vty, "Neighbor entries               : %ld\n", (long)nbr->stats[LLDP_NBR_INSERT]);
+  vty_out(vty, "Neighbor entries deleted       : %ld\n", (long)nbr->stats[LLDP_NBR_DELETE]);
+  vty_out(vty, "Neighbor entries dropped       : %ld\n", (long)nbr->stats[LLDP_NBR_DROP]);
+  vty_out(vty, "Neighbor entries age-out       : %ld\n", (long)nbr->stats[LLDP_NBR_AGEOUT]);
+  vty_out(vty, "Neighbor Chassis-Name          : %s\n", lldp_nbr_field(nbr, LLDP_NBR_CHASSIS_NAME));
+  vty_out(vty, "Neighbor Chassis-Description   : %s\n", lldp_nbr_field(nbr, LLDP_NBR_CHASSIS_DESC));
+  vty_out(vty, "Neighbor Chassis-ID            : %s\n", lldp_nbr_field(nbr, LLDP_NBR_CHASSIS_ID));
+  vty_out(vty, "Neighbor Management-Address    : %s\n", lldp_nbr_field(nbr, LLDP_NBR_MGMT_IP));
+  vty_out(vty, "Chassis Capabilities Available : %s\n", lldp_nbr_field(nbr, LLDP_NBR_CAP_AVAILABLE));
+  vty_out(vty, "Chassis Capabilities Enabled   : %s\n", lldp_nbr_field(nbr, LLDP_NBR_CAP_ENABLED));
+  vty_out(vty, "Neighbor Port-ID               : %s\n", lldp_nbr_field(nbr, LLDP_NBR_PORT_ID));
+  vty_out(vty, "TTL                            : %s\n", lldp_nbr_field(nbr, LLDP_NBR_TTL));
 }
 
 DEFUN (cli_lldp_show_neighbor_info,
@@ -1154,32 +1436,19 @@ DEFUN (cli_lldp_show_neighbor_info,
        SHOW_LLDP_STR
        "Show global LLDP neighbor information\n")
 {
-  const struct ovsrec_interface *ifrow = NULL;
   const struct ovsrec_subsystem *row = NULL;
-  lldp_neighbor_info *nbr_info = NULL;
-  uint  iter = 0, nIntf = 0;
-  const struct ovsdb_datum *datum = NULL;
-  static char *lldp_interface_neighbor_info_keys [] = {
-    INTERFACE_STATISTICS_LLDP_INSERT_COUNT,
-    INTERFACE_STATISTICS_LLDP_DELETE_COUNT,
-    INTERFACE_STATISTICS_LLDP_DROP_COUNT,
-    INTERFACE_STATISTICS_LLDP_AGEOUT_COUNT,
-    "chassis_id",
-    "port_id",
-    "chassis_ttl"
-  };
+  struct lldp_nbr **nbrs;
+  size_t iter, n_nbrs;
   unsigned int total_insert_count = 0;
   unsigned int total_delete_count = 0;
   unsigned int total_drop_count = 0;
   unsigned int total_ageout_count = 0;
-  unsigned int index = 0;
 
   row = ovsrec_subsystem_first(idl);
 
   if(row)
   {
-     nIntf = row->n_interfaces;
-     if(!nIntf)
+     if(!row->n_interfaces)
      {
         VLOG_ERR(OVSDB_LLDP_INTF_ROW_FETCH_ERROR);
         return CMD_OVSDB_FAILURE;
@@ -1191,65 +1460,16 @@ DEFUN (cli_lldp_show_neighbor_info,
       return CMD_OVSDB_FAILURE;
   }
 
-  nbr_info = xcalloc(nIntf, sizeof (lldp_neighbor_info));
-
-  OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+  nbrs = lldp_neighbors_sorted(&n_nbrs);
+  for (iter = 0; iter < n_nbrs; iter++)
   {
-    union ovsdb_atom atom;
-
-   if(ifrow && (0 != strcmp(ifrow->type, OVSREC_INTERFACE_TYPE_SYSTEM)))
-   {
-      /* Skipping internal interfaces */
+    /* Skipping internal interfaces */
+    if (!nbrs[iter]->system)
       continue;
-   }
-  /*
-   * If for some reason the n_interfaces doesnt comply with
-   * OVSREC_INTERFACE_FOR_EACH rows.
-  */
-   if(iter >= nIntf)
-    break;
-
-    strncpy(nbr_info[iter].name, ifrow->name, INTF_NAME_SIZE);
-    datum = ovsrec_interface_get_lldp_statistics(ifrow, OVSDB_TYPE_STRING, OVSDB_TYPE_INTEGER);
-
-    atom.string = lldp_interface_neighbor_info_keys[0];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    nbr_info[iter].insert_count = (index == UINT_MAX)? 0 : datum->values[index].integer ;
-    total_insert_count += nbr_info[iter].insert_count;
-
-    atom.string = lldp_interface_neighbor_info_keys[1];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    nbr_info[iter].delete_count = (index == UINT_MAX)? 0 : datum->values[index].integer ;
-    total_delete_count += nbr_info[iter].delete_count;
-
-    atom.string = lldp_interface_neighbor_info_keys[2];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    nbr_info[iter].drop_count = (index == UINT_MAX)? 0 : datum->values[index].integer ;
-    total_drop_count += nbr_info[iter].drop_count;
-
-    atom.string = lldp_interface_neighbor_info_keys[3];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    nbr_info[iter].ageout_count = (index == UINT_MAX)? 0 : datum->values[index].integer;
-    total_ageout_count += nbr_info[iter].ageout_count;
-
-    datum = ovsrec_interface_get_lldp_neighbor_info(ifrow, OVSDB_TYPE_STRING, OVSDB_TYPE_STRING);
-
-    atom.string = lldp_interface_neighbor_info_keys[4];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    if(index != UINT_MAX)
-       strncpy(nbr_info[iter].chassis_id, datum->values[index].string, 256);
-
-    atom.string = lldp_interface_neighbor_info_keys[5];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    if(index != UINT_MAX)
-       strncpy(nbr_info[iter].port_id, datum->values[index].string, 256);
-
-    atom.string = lldp_interface_neighbor_info_keys[6];
-    index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-    if(index != UINT_MAX)
-      strncpy(nbr_info[iter].chassis_ttl, datum->values[index].string, 256);
-
-    iter++;
+    total_insert_count += nbrs[iter]->stats[LLDP_NBR_INSERT];
+    total_delete_count += nbrs[iter]->stats[LLDP_NBR_DELETE];
+    total_drop_count += nbrs[iter]->stats[LLDP_NBR_DROP];
+    total_ageout_count += nbrs[iter]->stats[LLDP_NBR_AGEOUT];
   }
 
   vty_out(vty, "\n");
@@ -1265,30 +1485,48 @@ DEFUN (cli_lldp_show_neighbor_info,
   vty_out(vty, "%-10s","TTL");
   vty_out(vty, "%s", VTY_NEWLINE);
 
-  qsort((void*)nbr_info,nIntf,sizeof(lldp_neighbor_info),compare_intf);
-
-  iter = 0;
-  while(iter < nIntf)
+  for (iter = 0; iter < n_nbrs; iter++)
   {
-    vty_out (vty, "%-15s", nbr_info[iter].name);
-    vty_out (vty, "%-25s", nbr_info[iter].chassis_id);
-    vty_out (vty, "%-25s", nbr_info[iter].port_id);
-    vty_out (vty, "%-10s", nbr_info[iter].chassis_ttl);
+    if (!nbrs[iter]->system)
+      continue;
+    vty_out (vty, "%-15s", nbrs[iter]->name);
+    vty_out (vty, "%-25s", lldp_nbr_field(nbrs[iter], LLDP_NBR_CHASSIS_ID));
+    vty_out (vty, "%-25s", lldp_nbr_field(nbrs[iter], LLDP_NBR_PORT_ID));
+    vty_out (vty, "%-10s", lldp_nbr_field(nbrs[iter], LLDP_NBR_TTL));
     printf("\n");
-    iter++;
-  }
-
-  if(nbr_info)
-  {
-    free(nbr_info);
-    nbr_info = NULL;
   }
 
   return CMD_SUCCESS;
 }
 
+DEFUN (cli_lldp_show_neighbor_info_detail,
+       lldp_show_neighbor_info_detail_cmd,
+       "show lldp neighbor-info detail",
+       SHOW_STR
+       SHOW_LLDP_STR
+       "Show global LLDP neighbor information\n"
+       "Show neighbor details for every port with a neighbor\n")
+{
+  struct lldp_nbr **nbrs;
+  size_t iter, n_nbrs;
+  bool first = true;
+
+  nbrs = lldp_neighbors_sorted(&n_nbrs);
+  for (iter = 0; iter < n_nbrs; iter++)
+  {
+    if (!nbrs[iter]->system || !nbrs[iter]->fields[LLDP_NBR_CHASSIS_ID])
+      continue;
+    if (!first)
+      vty_out(vty, "%s", VTY_NEWLINE);
+    first = false;
+    lldp_show_nbr_detail(vty, nbrs[iter]);
+  }
 
+  if (first)
+    vty_out(vty, "No LLDP neighbors%s", VTY_NEWLINE);
 
+  return CMD_SUCCESS;
+}
 
 DEFUN (cli_lldp_show_intf_neighbor_info,
        lldp_show_intf_neighbor_info_cmd,
@@ -1298,97 +1536,112 @@ DEFUN (cli_lldp_show_intf_neighbor_info,
        "Show global LLDP neighbor information\n"
        "Specify the interface name")
 {
-  const struct ovsrec_interface *ifrow = NULL;
-  bool port_found = false;
-  const struct ovsdb_datum *datum = NULL;
-  static char *lldp_interface_neighbor_info_keys [] = {
-    INTERFACE_STATISTICS_LLDP_INSERT_COUNT,
-    INTERFACE_STATISTICS_LLDP_DELETE_COUNT,
-    INTERFACE_STATISTICS_LLDP_DROP_COUNT,
-    INTERFACE_STATISTICS_LLDP_AGEOUT_COUNT,
-    "chassis_id",
-    "port_id",
-    "chassis_ttl",
-    "chassis_capability_available",
-    "chassis_capability_enabled",
-    "chassis_name",
-    "chassis_description",
-    "mgmt_ip_list"
-  };
-
-  unsigned int index;
+  struct lldp_nbr *nbr;
 
-  OVSREC_INTERFACE_FOR_EACH(ifrow, idl)
+  lldp_neighbors_sync();
+  nbr = shash_find_data(&lldp_nbrs, argv[0]);
+  if(!nbr)
   {
-     if(0 == strcmp(argv[0],ifrow->name))
-     {
-        union ovsdb_atom atom;
-
-        port_found = true;
-        vty_out (vty, "Port                           : %s%s", ifrow->name, VTY_NEWLINE);
-
-        datum = ovsrec_interface_get_lldp_statistics(ifrow, OVSDB_TYPE_STRING, OVSDB_TYPE_INTEGER);
-        atom.string = lldp_interface_neighbor_info_keys[0];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor entries               : %ld\n",(index == UINT_MAX)? 0 : datum->values[index].integer);
-
-        atom.string = lldp_interface_neighbor_info_keys[1];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor entries deleted       : %ld\n",(index == UINT_MAX)? 0 : datum->values[index].integer);
-
-        atom.string = lldp_interface_neighbor_info_keys[2];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor entries dropped       : %ld\n",(index == UINT_MAX)? 0 : datum->values[index].integer);
-
-        atom.string = lldp_interface_neighbor_info_keys[3];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor entries age-out       : %ld\n",(index == UINT_MAX)? 0 : datum->values[index].integer);
-
-        datum = ovsrec_interface_get_lldp_neighbor_info(ifrow, OVSDB_TYPE_STRING, OVSDB_TYPE_STRING);
-
-        atom.string = lldp_interface_neighbor_info_keys[9];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor Chassis-Name          : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
-
-        atom.string = lldp_interface_neighbor_info_keys[10];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor Chassis-Description   : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+    VLOG_ERR("Wrong interface name");
+    return CMD_WARNING;
+  }
 
-        atom.string = lldp_interface_neighbor_info_keys[4];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor Chassis-ID            : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+  lldp_show_nbr_detail(vty, nbr);
+  return CMD_SUCCESS;
+}
 
-        atom.string = lldp_interface_neighbor_info_keys[11];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor Management-Address    : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+static volatile sig_atomic_t lldp_monitor_stop;
 
-        atom.string = lldp_interface_neighbor_info_keys[7];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Chassis Capabilities Available : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+static void
+lldp_monitor_sigint(int sig)
+{
+  lldp_monitor_stop = 1;
+}
 
-        atom.string = lldp_interface_neighbor_info_keys[8];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Chassis Capabilities Enabled   : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+/* Prints the events logged after *seq and advances it. */
+static void
+lldp_monitor_print(struct vty *vty, unsigned int *seq)
+{
+  const struct lldp_nbr_event *ev;
+  char tod[16];
 
-        atom.string = lldp_interface_neighbor_info_keys[5];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "Neighbor Port-ID               : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
+  if (lldp_nbr_event_seq - *seq > LLDP_NBR_EVENT_RING)
+  {
+    vty_out(vty, "(%u events lost)%s",
+            lldp_nbr_event_seq - *seq - LLDP_NBR_EVENT_RING, VTY_NEWLINE);
+    *seq = lldp_nbr_event_seq - LLDP_NBR_EVENT_RING;
+  }
 
-        atom.string = lldp_interface_neighbor_info_keys[6];
-        index = ovsdb_datum_find_key(datum, &atom, OVSDB_TYPE_STRING);
-        vty_out(vty, "TTL                            : %s\n",(index == UINT_MAX)? "" : datum->values[index].string);
-        break;
-     }
+  while (*seq != lldp_nbr_event_seq)
+  {
+    (*seq)++;
+    ev = &lldp_nbr_events[*seq % LLDP_NBR_EVENT_RING];
+    strftime(tod, sizeof tod, "%H:%M:%S", localtime(&ev->time));
+    vty_out (vty, "%-10s", tod);
+    vty_out (vty, "%-10s", lldp_nbr_event_names[ev->type]);
+    vty_out (vty, "%-15s", ev->port);
+    vty_out (vty, "%-25s", ev->chassis_id);
+    vty_out (vty, "%-25s", ev->port_id);
+    vty_out (vty, "%s", VTY_NEWLINE);
   }
+}
 
-  if(!port_found)
+DEFUN_NOLOCK (cli_lldp_monitor_neighbors,
+              lldp_monitor_neighbors_cmd,
+              "monitor lldp neighbors",
+              "Watch for changes\n"
+              "Watch LLDP\n"
+              "Print LLDP neighbors as they are added, changed or aged out\n")
+{
+  struct sigaction sa, old_sa;
+  struct pollfd pfd;
+  unsigned int seq;
+  char buf[64];
+
+  VTYSH_OVSDB_LOCK;
+  lldp_neighbors_sync();
+  seq = lldp_nbr_event_seq;
+  VTYSH_OVSDB_UNLOCK;
+
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler = lldp_monitor_sigint;
+  sigemptyset(&sa.sa_mask);
+  lldp_monitor_stop = 0;
+  sigaction(SIGINT, &sa, &old_sa);
+
+  vty_out(vty, "Monitoring LLDP neighbors, press Enter or Ctrl-C to stop%s",
+          VTY_NEWLINE);
+  vty_out(vty, "%-10s","Time");
+  vty_out(vty, "%-10s","Event");
+  vty_out(vty, "%-15s","Local Port");
+  vty_out(vty, "%-25s","Neighbor Chassis-ID");
+  vty_out(vty, "%-25s","Neighbor Port-ID");
+  vty_out(vty, "%s", VTY_NEWLINE);
+  fflush(stdout);
+
+  while (!lldp_monitor_stop)
   {
-    VLOG_ERR("Wrong interface name");
-    return CMD_WARNING;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 1000) > 0)
+    {
+      /* Swallow the line that stopped us. */
+      ignore(read(STDIN_FILENO, buf, sizeof buf));
+      break;
+    }
+
+    /* The OVSDB thread syncs the cache on IDL changes, this only
+     * covers a sync that is still pending. */
+    VTYSH_OVSDB_LOCK;
+    lldp_neighbors_sync();
+    lldp_monitor_print(vty, &seq);
+    VTYSH_OVSDB_UNLOCK;
+    fflush(stdout);
   }
 
+  sigaction(SIGINT, &old_sa, NULL);
   return CMD_SUCCESS;
-
 }
 
 static char *
@@ -1935,4 +2188,6 @@ lldp_vty_init (void)
   install_element (INTERFACE_NODE, &lldp_if_no_lldp_tx_cmd);
   install_element (INTERFACE_NODE, &lldp_if_no_lldp_rx_cmd);
   install_element (ENABLE_NODE, &lldp_show_neighbor_info_cmd);
+  install_element (ENABLE_NODE, &lldp_show_neighbor_info_detail_cmd);
+  install_element (ENABLE_NODE, &lldp_monitor_neighbors_cmd);
 }
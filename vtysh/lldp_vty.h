@@ -37,5 +37,7 @@
 #define INTF_NAME_SIZE 20
 void
 lldp_vty_init (void);
+void
+lldp_neighbors_sync (void);
 
 #endif /* _LLDP_VTY_H */
@@ -25,6 +25,9 @@
 #define _PING_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netdb.h>
 
 #define PING_STR            "Ping Utility\n"
 #define PING_IP             "Enter IP address of the device to ping\n"
@@ -60,24 +63,31 @@
 "Enter interval value in the range in seconds. (Default: 1 second)\n"
 #define INPUT_COUNT \
 "Enter Repetition value in the range. (Default: 5)\n"
+#define PING_SWEEP \
+"Ping many targets at once and report per-target statistics\n"
+#define PING_SWEEP_PREFIX \
+"Ping every host address of a prefix\n"
+#define PING_SWEEP_HOSTS \
+"Ping a list of addresses\n"
+#define INPUT_SWEEP_PREFIX \
+"Enter IPv4 prefix of at most 1024 hosts (/22 or longer)\n"
+#define INPUT_SWEEP_HOSTS \
+"Enter comma separated IPv4 or IPv6 addresses\n"
+#define INPUT_SWEEP_COUNT \
+"Enter Repetition value in the range. (Default: 1)\n"
 
 #define PING_MAX_HOSTNAME_LENGTH 256
 #define MAX_PATTERN_LENGTH       16
+#define PING_SWEEP_MAX_TARGETS   1024
 
 /* ping options default values */
 #define PING_DEF_TIMEOUT        2
 #define PING_DEF_COUNT          5
 #define PING_DEF_SIZE           100
+#define PING_DEF_INTERVAL       1
 
-/* default ping cmd */
-#define PING4_DEF_CMD       "ping"
-
-/* ping6 : use -n to suppress lookup of symbolic names.
-Display numeric output only */
-#define PING6_DEF_CMD       "ping6 -n"
-
-/* cmd to execute in namespace swns */
-#define SWNS_EXEC            "/sbin/ip netns exec swns"
+/* namespace the front panel interfaces live in */
+#define SWNS_NETNS_PATH      "/var/run/netns/swns"
 
 /* enum for type of arguments passed through cli */
 typedef enum {
@@ -107,10 +117,36 @@ typedef struct pingEntry_t {
     bool recordRoute;
 } pingEntry;
 
+/* round trip statistics of one target, in milliseconds */
+typedef struct pingStats_t {
+    uint32_t sent;
+    uint32_t received;
+    double minRtt;
+    double maxRtt;
+    double sumRtt;
+    double sumRtt2;
+} pingStats;
+
+/* targets and options of a ping sweep */
+typedef struct pingSweepEntry_t {
+    uint32_t nTargets;
+    struct sockaddr_storage *targets;
+    pingStats *stats;               /* nTargets entries, filled by ping_sweep */
+    uint16_t pingDataSize;
+    uint8_t pingTimeout;
+    uint8_t pingInterval;
+    uint16_t pingRepetitions;
+} pingSweepEntry;
+
 /* prototypes of functions */
 void printPingOutput (char *);
 int decodeParam (const char*, pingArguments, pingEntry *);
 bool ping_main (pingEntry *, void (*fPtr)(char *));
+bool ping_sweep (pingSweepEntry *);
+double ping_stats_mdev (const pingStats *);
+int ping_netns_socket (int, int, int);
+int ping_netns_getaddrinfo (const char *, const struct addrinfo *,
+                            struct addrinfo **);
 void ping_vty_init (void);
 
 #endif /* _PING_H */
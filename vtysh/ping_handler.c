@@ -22,27 +22,726 @@
  * Purpose: Implemtation of ping and ping6 functionality.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
 #include "ping.h"
 #include "openvswitch/vlog.h"
 
 VLOG_DEFINE_THIS_MODULE(ping_handler);
 
+/* Size of the IP options area. */
+#define PING_IPOPT_LEN          40
+
+/* Sweep probes sent back to back before yielding to the receive side. */
+#define PING_SWEEP_BURST        64
+
+/* One open echo socket. */
+typedef struct pingSocket_t {
+    int fd;
+    int family;
+    bool isRaw;         /* SOCK_RAW: we see foreign ICMP and set the id. */
+    uint16_t ident;     /* echo identifier, raw sockets only. */
+} pingSocket;
+
+/* What came back for one of our echo requests. */
+typedef struct pingReply_t {
+    bool isError;               /* ICMP error quoting our request. */
+    uint8_t icmpType;
+    uint8_t icmpCode;
+    uint16_t seq;
+    int ttl;                    /* -1 when unknown. */
+    int len;                    /* ICMP length. */
+    struct sockaddr_storage from;
+    uint8_t ipopt[PING_IPOPT_LEN];
+    int ipoptLen;
+} pingReply;
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_now
+| Responsibility : Monotonic clock in milliseconds
+| Return : current time in milliseconds
+----------------------------------------------------------------------------------------*/
+static double ping_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_netns_enter
+| Responsibility : Move the calling thread to the "swns" namespace, as the
+|                  interfaces visible in vtysh are from "swns".  Stays in
+|                  the current namespace when swns does not exist.
+| Parameters : int *selfFd : set to the namespace to come back to, -1 if
+|                            the thread did not move
+| Return : true on success, false with errno set
+----------------------------------------------------------------------------------------*/
+static bool ping_netns_enter (int *selfFd)
+{
+    int nsFd, err;
+    char path[64];
+
+    *selfFd = -1;
+    nsFd = open(SWNS_NETNS_PATH, O_RDONLY | O_CLOEXEC);
+    if (nsFd < 0)
+        return true;
+
+    /* setns() moves only this thread, so come back to its namespace. */
+    snprintf(path, sizeof path, "/proc/self/task/%ld/ns/net",
+             (long) syscall(SYS_gettid));
+    *selfFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (*selfFd < 0 || setns(nsFd, CLONE_NEWNET) < 0)
+    {
+        err = errno;
+        VLOG_ERR("Failed to enter namespace %s: %s", SWNS_NETNS_PATH,
+                 strerror(err));
+        if (*selfFd >= 0)
+            close(*selfFd);
+        close(nsFd);
+        errno = err;
+        return false;
+    }
+    close(nsFd);
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_netns_leave
+| Responsibility : Undo ping_netns_enter(), keeping errno
+| Parameters : int selfFd : as set by ping_netns_enter()
+----------------------------------------------------------------------------------------*/
+static void ping_netns_leave (int selfFd)
+{
+    int err = errno;
+
+    if (selfFd < 0)
+        return;
+    if (setns(selfFd, CLONE_NEWNET) < 0)
+        VLOG_ERR("Failed to leave namespace %s: %s", SWNS_NETNS_PATH,
+                 strerror(errno));
+    close(selfFd);
+    errno = err;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_netns_socket
+| Responsibility : Open a socket in the "swns" namespace.  Only the calling
+|                  thread switches namespace, and only while the socket is
+|                  created.
+| Parameters : domain, type, protocol : as for socket()
+| Return : socket descriptor, -1 on error with errno set
+----------------------------------------------------------------------------------------*/
+int ping_netns_socket (int domain, int type, int protocol)
+{
+    int selfFd, sock;
+
+    if (!ping_netns_enter(&selfFd))
+        return -1;
+    sock = socket(domain, type | SOCK_CLOEXEC, protocol);
+    ping_netns_leave(selfFd);
+    return sock;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_netns_getaddrinfo
+| Responsibility : getaddrinfo() from the "swns" namespace, so that names
+|                  resolve through the name servers reachable from there
+| Parameters : node, hints, res : as for getaddrinfo()
+| Return : as getaddrinfo(), EAI_SYSTEM if the namespace can not be entered
+----------------------------------------------------------------------------------------*/
+int ping_netns_getaddrinfo (const char *node, const struct addrinfo *hints,
+                            struct addrinfo **res)
+{
+    int selfFd, rc;
+
+    if (!ping_netns_enter(&selfFd))
+        return EAI_SYSTEM;
+    rc = getaddrinfo(node, NULL, hints, res);
+    ping_netns_leave(selfFd);
+    return rc;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_open
+| Responsibility : Open an echo socket, an unprivileged ICMP datagram socket
+|                  if the kernel allows it, a raw socket otherwise
+| Parameters : pingSocket *s : socket to fill
+|              int family : AF_INET or AF_INET6
+| Return : true on success
+----------------------------------------------------------------------------------------*/
+static bool ping_open (pingSocket *s, int family)
+{
+    int proto = (family == AF_INET) ? IPPROTO_ICMP : IPPROTO_ICMPV6;
+    int on = 1;
+
+    s->family = family;
+    s->isRaw = false;
+    s->ident = getpid() & 0xffff;
+    s->fd = ping_netns_socket(family, SOCK_DGRAM, proto);
+    if (s->fd < 0)
+    {
+        s->isRaw = true;
+        s->fd = ping_netns_socket(family, SOCK_RAW, proto);
+    }
+    if (s->fd < 0)
+    {
+        VLOG_ERR("Failed to open ICMP socket: %s", strerror(errno));
+        return false;
+    }
+
+    /* Datagram sockets get the ICMP errors for their requests on the
+       error queue, see ping_recv_err(). */
+    if (family == AF_INET)
+    {
+        setsockopt(s->fd, IPPROTO_IP, IP_RECVTTL, &on, sizeof on);
+        if (!s->isRaw)
+        {
+            setsockopt(s->fd, IPPROTO_IP, IP_RECVOPTS, &on, sizeof on);
+            setsockopt(s->fd, IPPROTO_IP, IP_RECVERR, &on, sizeof on);
+        }
+    }
+    else
+    {
+        setsockopt(s->fd, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &on, sizeof on);
+        if (!s->isRaw)
+            setsockopt(s->fd, IPPROTO_IPV6, IPV6_RECVERR, &on, sizeof on);
+        else
+        {
+            struct icmp6_filter filter;
+
+            ICMP6_FILTER_SETBLOCKALL(&filter);
+            ICMP6_FILTER_SETPASS(ICMP6_ECHO_REPLY, &filter);
+            ICMP6_FILTER_SETPASS(ICMP6_DST_UNREACH, &filter);
+            ICMP6_FILTER_SETPASS(ICMP6_TIME_EXCEEDED, &filter);
+            setsockopt(s->fd, IPPROTO_ICMPV6, ICMP6_FILTER, &filter,
+                       sizeof filter);
+        }
+    }
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_checksum
+| Responsibility : Internet checksum
+| Parameters : const void *data, int len : bytes to sum
+| Return : checksum in network order
+----------------------------------------------------------------------------------------*/
+static uint16_t ping_checksum (const void *data, int len)
+{
+    const uint16_t *w = data;
+    uint32_t sum = 0;
+
+    for (; len > 1; len -= 2)
+        sum += *w++;
+    if (len)
+        sum += *(const uint8_t *) w;
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum += sum >> 16;
+    return ~sum;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_fill
+| Responsibility : Fill the echo payload, with the data-fill pattern if any
+| Parameters : uint8_t *data, int len : payload
+|              const char *pattern : hex digits, NULL for the default fill
+----------------------------------------------------------------------------------------*/
+static void ping_fill (uint8_t *data, int len, const char *pattern)
+{
+    uint8_t bytes[MAX_PATTERN_LENGTH / 2 + 1];
+    int n = 0, i;
+    unsigned int byte;
+
+    for (i = 0; pattern && pattern[i] && pattern[i + 1]
+                && i < MAX_PATTERN_LENGTH; i += 2)
+    {
+        if (sscanf(&pattern[i], "%2x", &byte) != 1)
+            break;
+        bytes[n++] = byte;
+    }
+
+    for (i = 0; i < len; i++)
+        data[i] = n ? bytes[i % n] : (uint8_t) i;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_send
+| Responsibility : Send one echo request
+| Parameters : pingSocket *s : socket
+|              const struct sockaddr *to, socklen_t tolen : target
+|              uint16_t seq : sequence number
+|              uint8_t *packet, int len : ICMP header room plus payload
+| Return : true on success
+----------------------------------------------------------------------------------------*/
+static bool ping_send (pingSocket *s, const struct sockaddr *to,
+                       socklen_t tolen, uint16_t seq, uint8_t *packet, int len)
+{
+    if (s->family == AF_INET)
+    {
+        struct icmphdr *icmp = (struct icmphdr *) packet;
+
+        icmp->type = ICMP_ECHO;
+        icmp->code = 0;
+        icmp->un.echo.id = htons(s->ident);
+        icmp->un.echo.sequence = htons(seq);
+        icmp->checksum = 0;
+        icmp->checksum = ping_checksum(packet, len);
+    }
+    else
+    {
+        struct icmp6_hdr *icmp6 = (struct icmp6_hdr *) packet;
+
+        /* The kernel fills in the ICMPv6 checksum. */
+        icmp6->icmp6_type = ICMP6_ECHO_REQUEST;
+        icmp6->icmp6_code = 0;
+        icmp6->icmp6_cksum = 0;
+        icmp6->icmp6_id = htons(s->ident);
+        icmp6->icmp6_seq = htons(seq);
+    }
+
+    if (sendto(s->fd, packet, len, 0, to, tolen) != len)
+    {
+        VLOG_DBG("sendto failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_recv_err
+| Responsibility : Read one ICMP error from the error queue of a datagram
+|                  socket.  The queued datagram is the request that caused it.
+| Parameters : pingSocket *s : datagram socket
+|              pingReply *r : decoded error
+| Return : 1 for an ICMP error, 0 for anything else, -1 if nothing to read
+----------------------------------------------------------------------------------------*/
+static int ping_recv_err (pingSocket *s, pingReply *r)
+{
+    uint8_t buf[ICMP_MINLEN], control[512];
+    struct iovec iov = { buf, sizeof buf };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    struct sock_extended_err *ee = NULL;
+    ssize_t n;
+
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+
+    n = recvmsg(s->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+    if (n < 0)
+        return -1;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)
+            || (cmsg->cmsg_level == IPPROTO_IPV6
+                && cmsg->cmsg_type == IPV6_RECVERR))
+            ee = (struct sock_extended_err *) CMSG_DATA(cmsg);
+
+    if (!ee || n < ICMP_MINLEN
+        || (ee->ee_origin != SO_EE_ORIGIN_ICMP
+            && ee->ee_origin != SO_EE_ORIGIN_ICMP6))
+        return 0;
+
+    memset(&r->from, 0, sizeof r->from);
+    memcpy(&r->from, SO_EE_OFFENDER(ee),
+           s->family == AF_INET ? sizeof (struct sockaddr_in)
+                                : sizeof (struct sockaddr_in6));
+    r->icmpType = ee->ee_type;
+    r->icmpCode = ee->ee_code;
+    r->seq = ntohs(*(const uint16_t *) (buf + 6));
+    r->len = n;
+    r->ttl = -1;
+    r->ipoptLen = 0;
+    r->isError = true;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_recv
+| Responsibility : Read one datagram and decode it if it answers one of our
+|                  echo requests
+| Parameters : pingSocket *s : socket
+|              pingReply *r : decoded reply
+| Return : 1 for a reply of ours, 0 for anything else, -1 if nothing to read
+----------------------------------------------------------------------------------------*/
+static int ping_recv (pingSocket *s, pingReply *r)
+{
+    uint8_t buf[65536 + 256], control[512];
+    struct iovec iov = { buf, sizeof buf };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    const uint8_t *icmp;
+    const uint8_t *quoted;
+    ssize_t n;
+    int hlen;
+    uint16_t id;
+
+    memset(&msg, 0, sizeof msg);
+    msg.msg_name = &r->from;
+    msg.msg_namelen = sizeof r->from;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+
+    n = recvmsg(s->fd, &msg, MSG_DONTWAIT);
+    if (n < 0)
+        return s->isRaw ? -1 : ping_recv_err(s, r);
+
+    r->ttl = -1;
+    r->ipoptLen = 0;
+    r->isError = false;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TTL)
+            r->ttl = *(int *) CMSG_DATA(cmsg);
+        else if (cmsg->cmsg_level == IPPROTO_IPV6
+                 && cmsg->cmsg_type == IPV6_HOPLIMIT)
+            r->ttl = *(int *) CMSG_DATA(cmsg);
+        else if (cmsg->cmsg_level == IPPROTO_IP
+                 && cmsg->cmsg_type == IP_OPTIONS)
+        {
+            r->ipoptLen = cmsg->cmsg_len - CMSG_LEN(0);
+            if (r->ipoptLen > PING_IPOPT_LEN)
+                r->ipoptLen = PING_IPOPT_LEN;
+            memcpy(r->ipopt, CMSG_DATA(cmsg), r->ipoptLen);
+        }
+    }
+
+    icmp = buf;
+    if (s->family == AF_INET && s->isRaw)
+    {
+        /* Raw IPv4 sockets get the IP header too. */
+        const struct iphdr *ip = (const struct iphdr *) buf;
+
+        hlen = ip->ihl * 4;
+        if (n < hlen + ICMP_MINLEN)
+            return 0;
+        r->ttl = ip->ttl;
+        r->ipoptLen = hlen - (int) sizeof *ip;
+        memcpy(r->ipopt, buf + sizeof *ip, r->ipoptLen);
+        icmp += hlen;
+        n -= hlen;
+    }
+    if (n < ICMP_MINLEN)
+        return 0;
+
+    r->icmpType = icmp[0];
+    r->icmpCode = icmp[1];
+    r->len = n;
+
+    if ((s->family == AF_INET && r->icmpType == ICMP_ECHOREPLY)
+        || (s->family == AF_INET6 && r->icmpType == ICMP6_ECHO_REPLY))
+    {
+        id = ntohs(*(const uint16_t *) (icmp + 4));
+        r->seq = ntohs(*(const uint16_t *) (icmp + 6));
+        return (!s->isRaw || id == s->ident) ? 1 : 0;
+    }
+
+    /* ICMP errors quote the request that caused them.  Datagram sockets
+       only see their own traffic and get errors from ping_recv_err(), so
+       this is for raw sockets. */
+    if (!s->isRaw)
+        return 0;
+
+    if (s->family == AF_INET
+        && (r->icmpType == ICMP_DEST_UNREACH
+            || r->icmpType == ICMP_TIME_EXCEEDED))
+    {
+        const struct iphdr *inner = (const struct iphdr *) (icmp + 8);
+
+        if (n < 8 + (int) sizeof *inner
+            || n < 8 + inner->ihl * 4 + ICMP_MINLEN
+            || inner->protocol != IPPROTO_ICMP)
+            return 0;
+        quoted = icmp + 8 + inner->ihl * 4;
+        if (quoted[0] != ICMP_ECHO)
+            return 0;
+    }
+    else if (s->family == AF_INET6
+             && (r->icmpType == ICMP6_DST_UNREACH
+                 || r->icmpType == ICMP6_TIME_EXCEEDED))
+    {
+        /* 8 byte ICMPv6 header, 40 byte IPv6 header, then our request. */
+        if (n < 8 + 40 + ICMP_MINLEN || icmp[8 + 6] != IPPROTO_ICMPV6)
+            return 0;
+        quoted = icmp + 8 + 40;
+        if (quoted[0] != ICMP6_ECHO_REQUEST)
+            return 0;
+    }
+    else
+        return 0;
+
+    id = ntohs(*(const uint16_t *) (quoted + 4));
+    if (id != s->ident)
+        return 0;
+    r->seq = ntohs(*(const uint16_t *) (quoted + 6));
+    r->isError = true;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_error_str
+| Responsibility : Text for an ICMP error reply
+| Parameters : int family, const pingReply *r
+| Return : static string
+----------------------------------------------------------------------------------------*/
+static const char *ping_error_str (int family, const pingReply *r)
+{
+    if (family == AF_INET)
+    {
+        if (r->icmpType == ICMP_TIME_EXCEEDED)
+            return "Time to live exceeded";
+        switch (r->icmpCode)
+        {
+            case ICMP_NET_UNREACH:  return "Destination Net Unreachable";
+            case ICMP_HOST_UNREACH: return "Destination Host Unreachable";
+            case ICMP_PROT_UNREACH: return "Destination Protocol Unreachable";
+            case ICMP_PORT_UNREACH: return "Destination Port Unreachable";
+            case ICMP_FRAG_NEEDED:  return "Frag needed and DF set";
+            default:                return "Destination Unreachable";
+        }
+    }
+    if (r->icmpType == ICMP6_TIME_EXCEEDED)
+        return "Time exceeded: Hop limit";
+    switch (r->icmpCode)
+    {
+        case ICMP6_DST_UNREACH_NOROUTE: return "Destination unreachable: No route";
+        case ICMP6_DST_UNREACH_ADMIN:   return "Destination unreachable: Administratively prohibited";
+        case ICMP6_DST_UNREACH_ADDR:    return "Destination unreachable: Address unreachable";
+        case ICMP6_DST_UNREACH_NOPORT:  return "Destination unreachable: Port unreachable";
+        default:                        return "Destination unreachable";
+    }
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_print_ipopt
+| Responsibility : Print the record route or timestamp option of a reply
+| Parameters : const pingReply *r : reply
+|              void (*fPtr)(char *buff): function pointer for display purpose
+----------------------------------------------------------------------------------------*/
+static void ping_print_ipopt (const pingReply *r, void (*fPtr)(char *buff))
+{
+    char line[BUFSIZ], addr[INET_ADDRSTRLEN];
+    const uint8_t *opt = r->ipopt;
+    int left = r->ipoptLen, len, i, ptr;
+    uint32_t ts, prev = 0;
+    bool first;
+
+    while (left > 0)
+    {
+        if (opt[0] == IPOPT_EOL)
+            break;
+        if (opt[0] == IPOPT_NOP)
+        {
+            opt++;
+            left--;
+            continue;
+        }
+        if (left < 2 || opt[1] < 2 || opt[1] > left)
+            break;
+        len = opt[1];
+        ptr = (len > 2) ? opt[2] : 0;
+
+        if (opt[0] == IPOPT_RR && len >= 3)
+        {
+            first = true;
+            for (i = 3; i + 4 <= len && i + 4 <= ptr - 1; i += 4)
+            {
+                inet_ntop(AF_INET, opt + i, addr, sizeof addr);
+                snprintf(line, sizeof line, "%s\t%s\n", first ? "RR: " : "",
+                         addr);
+                (*fPtr)(line);
+                first = false;
+            }
+        }
+        else if (opt[0] == IPOPT_TS && len >= 4)
+        {
+            bool withAddr = (opt[3] & 0x0f) != IPOPT_TS_TSONLY;
+            int step = withAddr ? 8 : 4;
+
+            first = true;
+            for (i = 4; i + step <= len && i + step <= ptr - 1; i += step)
+            {
+                if (withAddr)
+                {
+                    inet_ntop(AF_INET, opt + i, addr, sizeof addr);
+                    memcpy(&ts, opt + i + 4, 4);
+                }
+                else
+                    memcpy(&ts, opt + i, 4);
+                ts = ntohl(ts);
+                snprintf(line, sizeof line, "%s\t%s%s%u %s\n",
+                         first ? "TS: " : "", withAddr ? addr : "",
+                         withAddr ? "\t" : "",
+                         first ? ts : ts - prev, first ? "absolute" : "");
+                (*fPtr)(line);
+                prev = ts;
+                first = false;
+            }
+        }
+        opt += len;
+        left -= len;
+    }
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_set_ipopt
+| Responsibility : Ask for the record route or timestamp IP option
+| Parameters : pingSocket *s : IPv4 socket
+|              pingEntry *p : ping options
+| Return : true on success
+----------------------------------------------------------------------------------------*/
+static bool ping_set_ipopt (pingSocket *s, const pingEntry *p)
+{
+    uint8_t opt[PING_IPOPT_LEN];
+    int len;
+
+    memset(opt, 0, sizeof opt);
+    if (p->recordRoute)
+    {
+        opt[0] = IPOPT_NOP;
+        opt[1] = IPOPT_RR;
+        opt[2] = PING_IPOPT_LEN - 1;
+        opt[3] = IPOPT_MINOFF;
+        len = PING_IPOPT_LEN;
+    }
+    else if (p->includeTimestamp || p->includeTimestampAddress)
+    {
+        opt[0] = IPOPT_TS;
+        opt[1] = p->includeTimestamp ? PING_IPOPT_LEN : 36;
+        opt[2] = 5;
+        opt[3] = p->includeTimestamp ? IPOPT_TS_TSONLY : IPOPT_TS_TSANDADDR;
+        len = opt[1];
+    }
+    else
+        return true;
+
+    if (setsockopt(s->fd, IPPROTO_IP, IP_OPTIONS, opt, len) < 0)
+    {
+        VLOG_ERR("Failed to set IP options: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_resolve
+| Responsibility : Resolve a target name or address
+| Parameters : const char *target, int family
+|              struct sockaddr_storage *addr, socklen_t *len : result
+| Return : true on success
+----------------------------------------------------------------------------------------*/
+static bool ping_resolve (const char *target, int family,
+                          struct sockaddr_storage *addr, socklen_t *len)
+{
+    struct addrinfo hints, *res;
+
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_RAW;
+    if (ping_netns_getaddrinfo(target, &hints, &res) != 0 || !res)
+        return false;
+    memcpy(addr, res->ai_addr, res->ai_addrlen);
+    *len = res->ai_addrlen;
+    freeaddrinfo(res);
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_addr_str
+| Responsibility : Printable address of a sockaddr
+----------------------------------------------------------------------------------------*/
+static const char *ping_addr_str (const struct sockaddr_storage *ss,
+                                  char *buf, size_t len)
+{
+    if (ss->ss_family == AF_INET)
+        return inet_ntop(AF_INET, &((struct sockaddr_in *) ss)->sin_addr,
+                         buf, len);
+    return inet_ntop(AF_INET6, &((struct sockaddr_in6 *) ss)->sin6_addr,
+                     buf, len);
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_stats_add
+| Responsibility : Account one round trip time
+----------------------------------------------------------------------------------------*/
+static void ping_stats_add (pingStats *st, double rtt)
+{
+    if (!st->received || rtt < st->minRtt)
+        st->minRtt = rtt;
+    if (rtt > st->maxRtt)
+        st->maxRtt = rtt;
+    st->sumRtt += rtt;
+    st->sumRtt2 += rtt * rtt;
+    st->received++;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_stats_mdev
+| Responsibility : Mean deviation of the round trip times
+----------------------------------------------------------------------------------------*/
+double ping_stats_mdev (const pingStats *st)
+{
+    double avg, var;
+
+    if (!st->received)
+        return 0;
+    avg = st->sumRtt / st->received;
+    var = st->sumRtt2 / st->received - avg * avg;
+    return var > 0 ? sqrt(var) : 0;
+}
+
 /*---------------------------------------------------------------------------------------
 | Name : ping_main
-| Responsibility : Based on values passed in the structure, construct ping command
-|                  and perform ping functionality
+| Responsibility : Based on values passed in the structure, send echo requests
+|                  to the target and report the replies
 | Parameters : pingEntry* p : pointer to ping structure,
 |              void (*fptr)(char *buff): function pointer for display purpose
 | Return : returns true on successful execution, false for any error encountered
 ----------------------------------------------------------------------------------------*/
 bool ping_main (pingEntry *p, void (*fPtr)(char *buff))
 {
-    char output[BUFSIZ], buffer[BUFSIZ];
-    char *target = buffer;
-    int len = 0;
-    FILE *fp = NULL;
+    char line[BUFSIZ], addr[INET6_ADDRSTRLEN], from[INET6_ADDRSTRLEN];
+    struct sockaddr_storage to;
+    socklen_t tolen;
+    pingSocket s;
+    pingReply r;
+    pingStats st;
+    struct pollfd pfd;
+    double *sentAt = NULL;
+    uint8_t *seen = NULL, *packet = NULL;
+    double start, now, nextSend, deadline, rtt;
+    uint32_t errors = 0, seq = 0;
+    int len, rc, wait, tos;
 
     if (!fPtr)
     {
@@ -55,72 +754,310 @@ bool ping_main (pingEntry *p, void (*fPtr)(char *buff))
         return false;
     }
 
-    /* Executing the command in the "swns" namespace, as the
-                interfaces visible in vtysh are from "swns" */
-    len += sprintf(target+len, "%s ", SWNS_EXEC);
+    if (!p->pingRepetitions)
+        p->pingRepetitions = PING_DEF_COUNT;
+    if (!p->pingDataSize)
+        p->pingDataSize = PING_DEF_SIZE;
+    if (!p->pingTimeout)
+        p->pingTimeout = PING_DEF_TIMEOUT;
+    if (!p->pingInterval)
+        p->pingInterval = PING_DEF_INTERVAL;
 
-    /* Append default cmd either ping4 or ping6 */
-    if (p->isIpv4)
-        len += sprintf(target+len, "%s ", PING4_DEF_CMD);
-    else
-        len += sprintf(target+len, "%s ", PING6_DEF_CMD);
+    if (!p->pingTarget
+        || !ping_resolve(p->pingTarget, p->isIpv4 ? AF_INET : AF_INET6,
+                         &to, &tolen))
+    {
+        snprintf(line, sizeof line, "ping: unknown host %s\n",
+                 p->pingTarget ? p->pingTarget : "");
+        (*fPtr)(line);
+        return true;
+    }
 
-    /* Append Target address */
-    if (p->pingTarget)
-        len += sprintf(target+len, "%s", p->pingTarget);
+    if (!ping_open(&s, to.ss_family))
+        return false;
+    tos = p->pingTos;
+    if (s.family == AF_INET && tos
+        && setsockopt(s.fd, IPPROTO_IP, IP_TOS, &tos, sizeof tos) < 0)
+        VLOG_ERR("Failed to set TOS: %s", strerror(errno));
+    if (s.family == AF_INET && !ping_set_ipopt(&s, p))
+    {
+        close(s.fd);
+        return false;
+    }
 
-    /* Append value repetitions(count) */
-    if (!p->pingRepetitions)
-        p->pingRepetitions = PING_DEF_COUNT;
+    len = ICMP_MINLEN + p->pingDataSize;
+    packet = calloc(1, len);
+    sentAt = calloc(p->pingRepetitions, sizeof *sentAt);
+    seen = calloc(p->pingRepetitions, 1);
+    if (!packet || !sentAt || !seen)
+    {
+        VLOG_ERR("Out of memory");
+        free(packet);
+        free(sentAt);
+        free(seen);
+        close(s.fd);
+        return false;
+    }
+    ping_fill(packet + ICMP_MINLEN, p->pingDataSize, p->pingDataFill);
 
-    len += sprintf(target+len, " -c %d", p->pingRepetitions);
+    ping_addr_str(&to, addr, sizeof addr);
+    snprintf(line, sizeof line, "PING %s (%s) %d(%d) bytes of data.\n",
+             p->pingTarget, addr, p->pingDataSize,
+             len + (s.family == AF_INET ? 20 : 40));
+    (*fPtr)(line);
 
-    /* Append value of packet size */
-    if (!p->pingDataSize)
-        p->pingDataSize = PING_DEF_SIZE;
+    memset(&st, 0, sizeof st);
+    pfd.fd = s.fd;
+    pfd.events = POLLIN;
+    start = nextSend = ping_now();
+    deadline = 0;
+
+    for (;;)
+    {
+        now = ping_now();
+        if (seq < p->pingRepetitions && now >= nextSend)
+        {
+            sentAt[seq] = now;
+            ping_send(&s, (struct sockaddr *) &to, tolen, seq + 1, packet,
+                      len);
+            st.sent = ++seq;
+            nextSend += p->pingInterval * 1000.0;
+            if (seq == p->pingRepetitions)
+                deadline = now + p->pingTimeout * 1000.0;
+        }
 
-    len += sprintf(target+len, " -s %d", p->pingDataSize);
+        if (seq == p->pingRepetitions
+            && (st.received + errors >= seq || now >= deadline))
+            break;
 
-    /* Append value of Interval */
-    if (p->pingInterval)
-        len += sprintf(target+len, " -i %d", p->pingInterval);
+        wait = (int) ((seq < p->pingRepetitions ? nextSend : deadline) - now);
+        rc = poll(&pfd, 1, wait > 0 ? wait : 0);
+        if (rc < 0 && errno != EINTR)
+            break;
+        if (rc <= 0)
+            continue;
 
-    /* Append value of datafill */
-    if (p->pingDataFill)
-        len += sprintf(target+len, " -p %s", p->pingDataFill);
+        while ((rc = ping_recv(&s, &r)) >= 0)
+        {
+            if (rc == 0 || r.seq == 0 || r.seq > seq)
+                continue;
+            ping_addr_str(&r.from, from, sizeof from);
 
-    /* Ping4 options */
-    if (p->isIpv4)
+            if (r.isError)
+            {
+                errors++;
+                snprintf(line, sizeof line, "From %s icmp_seq=%u %s\n",
+                         from, r.seq, ping_error_str(s.family, &r));
+                (*fPtr)(line);
+                continue;
+            }
+
+            rtt = ping_now() - sentAt[r.seq - 1];
+            if (r.ttl >= 0)
+                snprintf(line, sizeof line,
+                         "%d bytes from %s: icmp_seq=%u ttl=%d time=%.3f ms%s\n",
+                         r.len, from, r.seq, r.ttl, rtt,
+                         seen[r.seq - 1] ? " (DUP!)" : "");
+            else
+                snprintf(line, sizeof line,
+                         "%d bytes from %s: icmp_seq=%u time=%.3f ms%s\n",
+                         r.len, from, r.seq, rtt,
+                         seen[r.seq - 1] ? " (DUP!)" : "");
+            (*fPtr)(line);
+            if (r.ipoptLen)
+                ping_print_ipopt(&r, fPtr);
+
+            if (!seen[r.seq - 1])
+            {
+                seen[r.seq - 1] = 1;
+                ping_stats_add(&st, rtt);
+            }
+        }
+    }
+
+    snprintf(line, sizeof line, "\n--- %s ping statistics ---\n",
+             p->pingTarget);
+    (*fPtr)(line);
+    if (errors)
+        snprintf(line, sizeof line,
+                 "%u packets transmitted, %u received, +%u errors, "
+                 "%u%% packet loss, time %.0fms\n",
+                 st.sent, st.received, errors,
+                 st.sent ? (st.sent - st.received) * 100 / st.sent : 0,
+                 ping_now() - start);
+    else
+        snprintf(line, sizeof line,
+                 "%u packets transmitted, %u received, "
+                 "%u%% packet loss, time %.0fms\n",
+                 st.sent, st.received,
+                 st.sent ? (st.sent - st.received) * 100 / st.sent : 0,
+                 ping_now() - start);
+    (*fPtr)(line);
+    if (st.received)
     {
-        /* Append value of timeout */
-        if (!p->pingTimeout)
-            p->pingTimeout = PING_DEF_TIMEOUT;
-        len += sprintf(target+len, " -W %d", p->pingTimeout);
+        snprintf(line, sizeof line,
+                 "rtt min/avg/max/mdev = %.3f/%.3f/%.3f/%.3f ms\n",
+                 st.minRtt, st.sumRtt / st.received, st.maxRtt,
+                 ping_stats_mdev(&st));
+        (*fPtr)(line);
+    }
 
-        /* Append value of tos */
-        if (p->pingTos)
-            len += sprintf(target+len, " -T %d", p->pingTos);
+    free(packet);
+    free(sentAt);
+    free(seen);
+    close(s.fd);
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : ping_sweep
+| Responsibility : Probe all targets of a sweep concurrently from one poll
+|                  loop.  Every round sends one echo request to each target,
+|                  in bursts of PING_SWEEP_BURST so replies are drained while
+|                  sending, and rounds start pingInterval seconds apart.
+| Parameters : pingSweepEntry *p : targets, options and per-target statistics
+| Return : returns true on successful execution, false for any error encountered
+----------------------------------------------------------------------------------------*/
+bool ping_sweep (pingSweepEntry *p)
+{
+    pingSocket socks[2];
+    bool used[2] = { false, false };
+    struct pollfd pfd[2];
+    pingReply r;
+    double *sentAt;
+    uint8_t *packet;
+    double now, roundStart, deadline = 0, rtt;
+    uint32_t total, next = 0, done = 0, received = 0, i;
+    int len, nfds = 0, k, rc, wait;
 
-        /* Ping4 ip-options */
-        if (p->includeTimestamp)
-            len += sprintf(target+len, " --ip-timestamp=tsonly ");
-        else if (p->includeTimestampAddress)
-            len += sprintf(target+len, " --ip-timestamp=tsaddr ");
-        else if (p->recordRoute)
-            len += sprintf(target+len, " -R ");
+    if (!p || !p->nTargets)
+    {
+        VLOG_ERR("Nothing to sweep");
+        return false;
     }
 
-    fp = popen(buffer,"r");
-    if (fp)
+    if (!p->pingRepetitions)
+        p->pingRepetitions = 1;
+    if (!p->pingDataSize)
+        p->pingDataSize = PING_DEF_SIZE;
+    if (!p->pingTimeout)
+        p->pingTimeout = PING_DEF_TIMEOUT;
+    if (!p->pingInterval)
+        p->pingInterval = PING_DEF_INTERVAL;
+
+    /* Sequence numbers are probe indexes, so they must fit in 16 bits. */
+    total = p->nTargets * p->pingRepetitions;
+    if (total >= 0xffff)
     {
-        while ( fgets( output, BUFSIZ, fp ) != NULL )
-            (*fPtr)(output);
+        VLOG_ERR("Too many probes in sweep: %u", total);
+        return false;
     }
-    else
+
+    for (i = 0; i < p->nTargets; i++)
+        used[p->targets[i].ss_family == AF_INET6] = true;
+    for (k = 0; k < 2; k++)
     {
-        VLOG_ERR("Failed to open pipe stream");
+        if (!used[k])
+            continue;
+        if (!ping_open(&socks[k], k ? AF_INET6 : AF_INET))
+        {
+            while (--nfds >= 0)
+                close(pfd[nfds].fd);
+            return false;
+        }
+        pfd[nfds].fd = socks[k].fd;
+        pfd[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    len = ICMP_MINLEN + p->pingDataSize;
+    packet = calloc(1, len);
+    sentAt = calloc(total, sizeof *sentAt);
+    if (!packet || !sentAt)
+    {
+        VLOG_ERR("Out of memory");
+        free(packet);
+        free(sentAt);
+        for (k = 0; k < nfds; k++)
+            close(pfd[k].fd);
         return false;
     }
-    pclose(fp);
+    ping_fill(packet + ICMP_MINLEN, p->pingDataSize, NULL);
+    memset(p->stats, 0, p->nTargets * sizeof *p->stats);
+
+    roundStart = ping_now();
+    for (;;)
+    {
+        now = ping_now();
+
+        /* Next burst of the current round, or start of the next round. */
+        if (next < total
+            && now >= roundStart + (next / p->nTargets) * p->pingInterval * 1000.0)
+        {
+            uint32_t end = next + PING_SWEEP_BURST;
+            uint32_t roundEnd = (next / p->nTargets + 1) * p->nTargets;
+
+            if (end > roundEnd)
+                end = roundEnd;
+            for (; next < end; next++)
+            {
+                struct sockaddr_storage *to = &p->targets[next % p->nTargets];
+                pingSocket *s = &socks[to->ss_family == AF_INET6];
+
+                sentAt[next] = ping_now();
+                ping_send(s, (struct sockaddr *) to,
+                          to->ss_family == AF_INET6
+                          ? sizeof (struct sockaddr_in6)
+                          : sizeof (struct sockaddr_in),
+                          next + 1, packet, len);
+                p->stats[next % p->nTargets].sent++;
+            }
+            if (next == total)
+                deadline = ping_now() + p->pingTimeout * 1000.0;
+        }
+
+        if (next == total && (done >= total || now >= deadline))
+            break;
+
+        if (next < total && next % p->nTargets)
+            wait = 0;   /* rest of this round's bursts */
+        else if (next < total)
+            wait = (int) (roundStart + (next / p->nTargets)
+                          * p->pingInterval * 1000.0 - now);
+        else
+            wait = (int) (deadline - now);
+
+        rc = poll(pfd, nfds, wait > 0 ? wait : 0);
+        if (rc < 0 && errno != EINTR)
+            break;
+        if (rc <= 0)
+            continue;
+
+        for (k = 0; k < 2; k++)
+        {
+            if (!used[k])
+                continue;
+            while ((rc = ping_recv(&socks[k], &r)) >= 0)
+            {
+                if (rc == 0 || r.seq == 0 || r.seq > next || sentAt[r.seq - 1] < 0)
+                    continue;
+                rtt = ping_now() - sentAt[r.seq - 1];
+                sentAt[r.seq - 1] = -1;     /* answered */
+                done++;
+                if (r.isError)
+                    continue;
+                received++;
+                ping_stats_add(&p->stats[(r.seq - 1) % p->nTargets], rtt);
+            }
+        }
+    }
+
+    VLOG_DBG("Sweep of %u targets: %u probes, %u replies",
+             p->nTargets, total, received);
+
+    free(packet);
+    free(sentAt);
+    for (k = 0; k < nfds; k++)
+        close(pfd[k].fd);
     return true;
 }
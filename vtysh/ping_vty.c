@@ -24,7 +24,9 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <arpa/inet.h>
 #include "command.h"
+#include "memory.h"
 #include "vtysh/vtysh.h"
 #include "ping.h"
 #include "openvswitch/vlog.h"
@@ -279,7 +281,7 @@ DEFUN (cli_ping,
         return CMD_SUCCESS;
     }
 
-    /* Wrapper for popen, output is printed by printOutput function */
+    /* Output is printed by printPingOutput function */
     if (!ping_main(&p, printPingOutput))
     {
        VLOG_ERR("Call to handler failed");
@@ -349,7 +351,7 @@ DEFUN (cli_ping6,
         return CMD_SUCCESS;
     }
 
-    /* Wrapper for popen, output is printed by printOutput function */
+    /* Output is printed by printPingOutput function */
     if (!ping_main(&p, printPingOutput))
     {
        VLOG_ERR("Call to handler failed");
@@ -358,9 +360,258 @@ DEFUN (cli_ping6,
     return CMD_SUCCESS;
 }
 
+/*-----------------------------------------------------------------------------
+| Name : pingSweepPrefix
+| Responsibility : Expand an IPv4 prefix into its host addresses
+| Parameters : const char *value : prefix
+|              pingSweepEntry *p : entry whose targets are set
+| Return : CMD_SUCCESS for success , CMD_WARNING for failure
+-----------------------------------------------------------------------------*/
+static int pingSweepPrefix (const char *value, pingSweepEntry *p)
+{
+    char buf[INET_ADDRSTRLEN + 4];
+    char *slash;
+    struct in_addr addr;
+    struct sockaddr_in *sin;
+    uint32_t base, first, last, host;
+    int len;
+
+    strncpy(buf, value, sizeof buf - 1);
+    buf[sizeof buf - 1] = '\0';
+    slash = strchr(buf, '/');
+    if (!slash)
+        return CMD_WARNING;
+    *slash = '\0';
+    len = atoi(slash + 1);
+    if (inet_pton(AF_INET, buf, &addr) <= 0 || len < 0 || len > 32)
+    {
+        vty_out (vty, "Invalid IPv4 prefix. %s", VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    base = len ? ntohl(addr.s_addr) & (0xffffffffU << (32 - len)) : 0;
+    last = len ? base | ~(0xffffffffU << (32 - len)) : 0xffffffffU;
+    first = base;
+    if (len < 31)
+    {
+        /* Skip the network and broadcast addresses. */
+        first++;
+        last--;
+    }
+    if (last - first + 1 > PING_SWEEP_MAX_TARGETS || len < 22)
+    {
+        vty_out (vty, "Sweep is limited to %d hosts. %s",
+                 PING_SWEEP_MAX_TARGETS, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    p->nTargets = last - first + 1;
+    p->targets = XCALLOC (MTYPE_TMP, p->nTargets * sizeof *p->targets);
+    for (host = first; ; host++)
+    {
+        sin = (struct sockaddr_in *) &p->targets[host - first];
+        sin->sin_family = AF_INET;
+        sin->sin_addr.s_addr = htonl(host);
+        if (host == last)
+            break;
+    }
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+| Name : pingSweepHosts
+| Responsibility : Parse a comma separated list of IPv4/IPv6 addresses
+| Parameters : const char *value : address list
+|              pingSweepEntry *p : entry whose targets are set
+| Return : CMD_SUCCESS for success , CMD_WARNING for failure
+-----------------------------------------------------------------------------*/
+static int pingSweepHosts (const char *value, pingSweepEntry *p)
+{
+    char *list, *tok, *save = NULL;
+    struct sockaddr_storage *ss;
+    const char *c;
+    uint32_t n = 1;
+
+    for (c = value; *c; c++)
+        if (*c == ',')
+            n++;
+    if (n > PING_SWEEP_MAX_TARGETS)
+    {
+        vty_out (vty, "Sweep is limited to %d hosts. %s",
+                 PING_SWEEP_MAX_TARGETS, VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+
+    p->targets = XCALLOC (MTYPE_TMP, n * sizeof *p->targets);
+    list = XSTRDUP (MTYPE_TMP, value);
+    for (tok = strtok_r(list, ",", &save); tok;
+         tok = strtok_r(NULL, ",", &save))
+    {
+        ss = &p->targets[p->nTargets];
+        if (inet_pton(AF_INET, tok,
+                      &((struct sockaddr_in *) ss)->sin_addr) > 0)
+            ss->ss_family = AF_INET;
+        else if (inet_pton(AF_INET6, tok,
+                           &((struct sockaddr_in6 *) ss)->sin6_addr) > 0)
+            ss->ss_family = AF_INET6;
+        else
+        {
+            vty_out (vty, "Invalid address %s. %s", tok, VTY_NEWLINE);
+            XFREE (MTYPE_TMP, list);
+            return CMD_WARNING;
+        }
+        p->nTargets++;
+    }
+    XFREE (MTYPE_TMP, list);
+
+    if (!p->nTargets)
+    {
+        vty_out (vty, "No address to ping. %s", VTY_NEWLINE);
+        return CMD_WARNING;
+    }
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+| Name : pingSweepExec
+| Responsibility : Run a sweep over the targets in p and print per-target
+|                  statistics
+| Parameters : pingSweepEntry *p : targets, other fields zero
+|              const char *argv[] : repetitions, timeout, interval and
+|                                   datagram-size tokens
+| Return : CMD_SUCCESS
+-----------------------------------------------------------------------------*/
+static int pingSweepExec (pingSweepEntry *p, const char *argv[])
+{
+    char addr[INET6_ADDRSTRLEN];
+    const struct sockaddr_storage *ss;
+    const pingStats *st;
+    uint32_t i, reachable = 0;
+
+    if (argv[0])
+        p->pingRepetitions = atoi(argv[0]);
+    if (argv[1])
+        p->pingTimeout = atoi(argv[1]);
+    if (argv[2])
+        p->pingInterval = atoi(argv[2]);
+    if (argv[3])
+        p->pingDataSize = atoi(argv[3]);
+
+    p->stats = XCALLOC (MTYPE_TMP, p->nTargets * sizeof *p->stats);
+
+    if (!ping_sweep(p))
+    {
+        VLOG_ERR("Call to sweep handler failed");
+        vty_out (vty, "Ping sweep failed. %s", VTY_NEWLINE);
+    }
+    else
+    {
+        vty_out (vty, "%-39s %5s %5s %5s %9s %9s %9s %9s%s",
+                 "Target", "Sent", "Recv", "Loss", "Min(ms)", "Avg(ms)",
+                 "Max(ms)", "Mdev(ms)", VTY_NEWLINE);
+        for (i = 0; i < p->nTargets; i++)
+        {
+            ss = &p->targets[i];
+            st = &p->stats[i];
+            inet_ntop(ss->ss_family,
+                      ss->ss_family == AF_INET
+                      ? (const void *) &((const struct sockaddr_in *) ss)->sin_addr
+                      : (const void *) &((const struct sockaddr_in6 *) ss)->sin6_addr,
+                      addr, sizeof addr);
+            if (st->received)
+            {
+                reachable++;
+                vty_out (vty, "%-39s %5u %5u %4u%% %9.3f %9.3f %9.3f %9.3f%s",
+                         addr, st->sent, st->received,
+                         (st->sent - st->received) * 100 / st->sent,
+                         st->minRtt, st->sumRtt / st->received, st->maxRtt,
+                         ping_stats_mdev(st), VTY_NEWLINE);
+            }
+            else
+                vty_out (vty, "%-39s %5u %5u %4u%% %9s %9s %9s %9s%s",
+                         addr, st->sent, 0, 100, "-", "-", "-", "-",
+                         VTY_NEWLINE);
+        }
+        vty_out (vty, "%s%u of %u targets reachable%s", VTY_NEWLINE,
+                 reachable, p->nTargets, VTY_NEWLINE);
+    }
+
+    XFREE (MTYPE_TMP, p->stats);
+    XFREE (MTYPE_TMP, p->targets);
+    return CMD_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------
+| Defun for ping sweep
+| Responsibility : Ping all hosts of a prefix or an address list at once
+-----------------------------------------------------------------------------*/
+DEFUN (cli_ping_sweep_prefix,
+       cli_ping_sweep_prefix_cmd,
+    "ping sweep prefix A.B.C.D/M"
+    " { repetitions <1-10> | timeout <1-60> | interval <1-60>"
+    " | datagram-size <100-65399> }",
+    PING_STR
+    PING_SWEEP
+    PING_SWEEP_PREFIX
+    INPUT_SWEEP_PREFIX
+    PING_COUNT
+    INPUT_SWEEP_COUNT
+    PING_TIMEOUT
+    INPUT_TIMEOUT
+    PING_INTERVAL
+    INPUT_INTERVAL
+    PING_DSIZE
+    INPUT_DSIZE
+    )
+{
+    pingSweepEntry p;
+    memset (&p, 0, sizeof (struct pingSweepEntry_t));
+
+    if (pingSweepPrefix(argv[0], &p) != CMD_SUCCESS)
+    {
+        VLOG_ERR("Decoding of token sweep prefix failed");
+        return CMD_SUCCESS;
+    }
+    return pingSweepExec(&p, &argv[1]);
+}
+
+DEFUN (cli_ping_sweep_hosts,
+       cli_ping_sweep_hosts_cmd,
+    "ping sweep hosts WORD"
+    " { repetitions <1-10> | timeout <1-60> | interval <1-60>"
+    " | datagram-size <100-65399> }",
+    PING_STR
+    PING_SWEEP
+    PING_SWEEP_HOSTS
+    INPUT_SWEEP_HOSTS
+    PING_COUNT
+    INPUT_SWEEP_COUNT
+    PING_TIMEOUT
+    INPUT_TIMEOUT
+    PING_INTERVAL
+    INPUT_INTERVAL
+    PING_DSIZE
+    INPUT_DSIZE
+    )
+{
+    pingSweepEntry p;
+    memset (&p, 0, sizeof (struct pingSweepEntry_t));
+
+    if (pingSweepHosts(argv[0], &p) != CMD_SUCCESS)
+    {
+        VLOG_ERR("Decoding of token sweep hosts failed");
+        if (p.targets)
+            XFREE (MTYPE_TMP, p.targets);
+        return CMD_SUCCESS;
+    }
+    return pingSweepExec(&p, &argv[1]);
+}
+
  /* Install Ping related vty commands. */
 void ping_vty_init (void)
 {
     install_element (ENABLE_NODE, &cli_ping_cmd);
     install_element (ENABLE_NODE, &cli_ping6_cmd);
+    install_element (ENABLE_NODE, &cli_ping_sweep_prefix_cmd);
+    install_element (ENABLE_NODE, &cli_ping_sweep_hosts_cmd);
 }
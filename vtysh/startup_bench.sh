@@ -0,0 +1,29 @@
+#!/bin/sh
+# Times vtysh start up, with the command trees parsed at build time by
+# cmdtree.pl and with the command strings parsed as they are installed.
+# usage: startup_bench.sh [vtysh [runs]]
+#
+# vtysh runs in --dryrun mode: it registers its commands, reads its
+# configuration and exits.
+
+vtysh=${1:-vtysh}
+runs=${2:-100}
+
+run() {
+    i=0
+    while [ $i -lt $runs ]; do
+        "$vtysh" --dryrun > /dev/null 2>&1
+        i=$((i + 1))
+    done
+}
+
+bench() {
+    start=$(date +%s%N)
+    run
+    end=$(date +%s%N)
+    echo "$1: $(( (end - start) / runs / 1000 )) us per start"
+}
+
+bench "precompiled"
+export VTYSH_PARSE_COMMANDS=1
+bench "parsed     "
@@ -28,6 +28,8 @@
 #define _TRACEROUTE_VTY_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
 
 #define TRACEROUTE_STR \
 "Traceroute Utility\n"
@@ -71,11 +73,9 @@
 #define TRACE_DEF_MAXTTL                30
 #define TRACE_DEF_WAIT                  3
 
-#define SWNS_EXEC                       "/sbin/ip netns exec swns"
-
-/* default traceroute cmd */
-#define TRACEROUTE4_DEF_CMD             "traceroute"
-#define TRACEROUTE6_DEF_CMD             "traceroute6"
+/* upper bounds accepted by the CLI */
+#define TRACE_MAX_HOPS                  255
+#define TRACE_MAX_PROBES                5
 
 /*defining the type of arguments passing through the cli*/
 typedef enum {
@@ -101,8 +101,30 @@ typedef struct tracerouteEntry_t {
     char *tracerouteLoosesourceIp;
 } tracerouteEntry;
 
+/* one probe of a hop, rtt < 0 when nothing came back */
+typedef struct tracerouteProbe_t {
+    struct sockaddr_storage from;
+    double rtt;
+    uint8_t icmpType;
+    uint8_t icmpCode;
+} tracerouteProbe;
+
+typedef struct tracerouteHop_t {
+    uint8_t ttl;
+    tracerouteProbe probe[TRACE_MAX_PROBES];
+} tracerouteHop;
+
+/* result of a trace, hop[0] is the minimum TTL */
+typedef struct tracerouteResult_t {
+    struct sockaddr_storage target;
+    int nHops;
+    bool reached;
+    tracerouteHop hop[TRACE_MAX_HOPS];
+} tracerouteResult;
+
 /*prototypes of the functions*/
 void printOutput(char *);
+bool traceroute_run(tracerouteEntry *, tracerouteResult *);
 bool traceroute_handler(tracerouteEntry *, void (*fPtr)(char *));
 int decodeTracerouteParam(const char*, arguments, tracerouteEntry *);
 void traceroute_vty_init(void);
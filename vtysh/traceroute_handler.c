@@ -21,115 +21,610 @@
  * Purpose: To perform traceroute functionality
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include <arpa/inet.h>
 #include "traceroute.h"
+#include "ping.h"
 #include "command.h"
+#include "memory.h"
 #include "vtysh/vtysh.h"
 #include "openvswitch/vlog.h"
 
 VLOG_DEFINE_THIS_MODULE(traceroute_handler);
 
+/* UDP payload of a probe, 60 byte IPv4 packets as traceroute sends. */
+#define TRACE_PAYLOAD_LEN       32
+
+/* Sockets and addresses of one trace.  Every probe goes out with the same
+ * addresses and ports so that ECMP hashing keeps them on one path; probes
+ * are told apart by their UDP checksum, which routers quote back. */
+typedef struct traceCtx_t {
+    int family;
+    int sendFd;         /* raw UDP, we build the UDP header */
+    int recvFd;         /* raw ICMP or ICMPv6 */
+    int portFd;         /* UDP socket owning our source port */
+    uint16_t sport;
+    uint16_t dport;
+    bool lsrr;
+    struct sockaddr_storage src;
+    struct sockaddr_storage dst;
+    socklen_t dstLen;
+} traceCtx;
+
 /*---------------------------------------------------------------------------------------
-| Name : traceroute_handler
-| Responsibility :construct traceroute command and perform traceroute functionality
-| Parameters : tracerouteEntry* p : pointer to traceroute structure,
-|              void (*fptr)(char *buff): function pointer for display purpose
-| Return : returns true on successful execution, false for any error encountered
+| Name : trace_now
+| Responsibility : Monotonic clock in milliseconds
 ----------------------------------------------------------------------------------------*/
-bool traceroute_handler(tracerouteEntry *p, void (*fPtr)(char *buff))
+static double trace_now (void)
 {
-    char output[BUFSIZ],buffer[BUFSIZ];
-    char *target = buffer;
-    int len = 0;
-    FILE *fp = NULL;
+    struct timespec ts;
 
-    if(!fPtr)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_sum
+| Responsibility : Add bytes to a one's complement sum of 16 bit words
+----------------------------------------------------------------------------------------*/
+static uint32_t trace_sum (uint32_t sum, const void *data, int len)
+{
+    const uint8_t *b = data;
+
+    for (; len > 1; len -= 2, b += 2)
+        sum += (b[0] << 8) | b[1];
+    if (len)
+        sum += b[0] << 8;
+    return sum;
+}
+
+static uint16_t trace_fold (uint32_t sum)
+{
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return sum;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_build
+| Responsibility : Build the UDP datagram of a probe.  The first payload
+|                  word is chosen so that the UDP checksum equals the probe
+|                  id, Paris traceroute style.
+| Parameters : traceCtx *c : trace
+|              uint16_t id : probe id, 1 to 0xfffe
+|              uint8_t *pkt : UDP header and payload
+| Return : datagram length
+----------------------------------------------------------------------------------------*/
+static int trace_build (const traceCtx *c, uint16_t id, uint8_t *pkt)
+{
+    int len = 8 + TRACE_PAYLOAD_LEN;
+    uint8_t pseudo[40];
+    uint32_t sum;
+    uint16_t fix;
+    int plen;
+
+    memset(pkt, 0, len);
+    *(uint16_t *) (pkt + 0) = htons(c->sport);
+    *(uint16_t *) (pkt + 2) = htons(c->dport);
+    *(uint16_t *) (pkt + 4) = htons(len);
+    memset(pkt + 10, 'T', TRACE_PAYLOAD_LEN - 2);
+
+    memset(pseudo, 0, sizeof pseudo);
+    if (c->family == AF_INET)
     {
-        VLOG_ERR("function pointer passed is null");
-        return false;
+        memcpy(pseudo, &((struct sockaddr_in *) &c->src)->sin_addr, 4);
+        memcpy(pseudo + 4, &((struct sockaddr_in *) &c->dst)->sin_addr, 4);
+        pseudo[9] = IPPROTO_UDP;
+        *(uint16_t *) (pseudo + 10) = htons(len);
+        plen = 12;
     }
-    if(!p)
+    else
     {
-        VLOG_ERR("Pointer to traceroute structure is null");
-        return false;
+        memcpy(pseudo, &((struct sockaddr_in6 *) &c->src)->sin6_addr, 16);
+        memcpy(pseudo + 16, &((struct sockaddr_in6 *) &c->dst)->sin6_addr, 16);
+        *(uint16_t *) (pseudo + 34) = htons(len);
+        pseudo[39] = IPPROTO_UDP;
+        plen = 40;
     }
 
-    /* Executing the command in the "swns" namespace, as the \
-    interfaces visible in vtysh are from "swns" */
-    len += sprintf(target+len, "%s ", SWNS_EXEC);
+    sum = trace_fold(trace_sum(trace_sum(0, pseudo, plen), pkt, len));
+    /* fold(sum + fix) must be ~id, so fix = ~id - sum. */
+    fix = trace_fold((uint32_t) (uint16_t) ~id + (uint16_t) ~sum);
+    pkt[8] = fix >> 8;
+    pkt[9] = fix & 0xff;
+    *(uint16_t *) (pkt + 6) = htons(id);
+    return len;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_send
+| Responsibility : Send one probe with the given TTL or hop limit
+| Return : true when the probe left
+----------------------------------------------------------------------------------------*/
+static bool trace_send (traceCtx *c, uint16_t id, int ttl)
+{
+    uint8_t pkt[8 + TRACE_PAYLOAD_LEN];
+    struct sockaddr_storage to = c->dst;
+    int len = trace_build(c, id, pkt);
 
-    /* Append default cmd either traceroute4 or traceroute6 */
-    if(p->isIpv4)
+    if (c->family == AF_INET)
     {
-        len += sprintf(target+len, "%s ", TRACEROUTE4_DEF_CMD);
+        ((struct sockaddr_in *) &to)->sin_port = 0;
+        setsockopt(c->sendFd, IPPROTO_IP, IP_TTL, &ttl, sizeof ttl);
     }
     else
     {
-        len += sprintf(target+len, "%s ", TRACEROUTE6_DEF_CMD);
+        ((struct sockaddr_in6 *) &to)->sin6_port = 0;
+        setsockopt(c->sendFd, IPPROTO_IPV6, IPV6_UNICAST_HOPS, &ttl,
+                   sizeof ttl);
     }
+    return sendto(c->sendFd, pkt, len, 0, (struct sockaddr *) &to,
+                  c->dstLen) == len;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_recv
+| Responsibility : Read one ICMP message and match it against our probes
+| Parameters : traceCtx *c : trace
+|              tracerouteProbe *pr : filled with sender, type and code
+| Return : probe id, 0 for a foreign message, -1 when nothing is queued
+----------------------------------------------------------------------------------------*/
+static int trace_recv (traceCtx *c, tracerouteProbe *pr)
+{
+    uint8_t buf[1500];
+    const uint8_t *icmp, *inner, *udp;
+    socklen_t fromLen = sizeof pr->from;
+    ssize_t n;
+    int left;
 
-    /* Append Target address */
-    if(p->tracerouteTarget)
+    /* The output compares senders, so leave no stale bytes behind. */
+    memset(&pr->from, 0, sizeof pr->from);
+    n = recvfrom(c->recvFd, buf, sizeof buf, MSG_DONTWAIT,
+                 (struct sockaddr *) &pr->from, &fromLen);
+    if (n < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    if (c->family == AF_INET)
     {
-        len += sprintf(target+len, "%s", p->tracerouteTarget);
+        struct ip *ip = (struct ip *) buf, *iip;
+
+        if (n < (ssize_t) sizeof *ip || ip->ip_hl * 4 > n)
+            return 0;
+        icmp = buf + ip->ip_hl * 4;
+        left = n - ip->ip_hl * 4;
+        if (left < 8 + 20 + 8
+            || (icmp[0] != ICMP_TIME_EXCEEDED && icmp[0] != ICMP_DEST_UNREACH))
+            return 0;
+        inner = icmp + 8;
+        iip = (struct ip *) inner;
+        if (iip->ip_p != IPPROTO_UDP || 8 + iip->ip_hl * 4 + 8 > left)
+            return 0;
+        if (!c->lsrr && iip->ip_dst.s_addr
+            != ((struct sockaddr_in *) &c->dst)->sin_addr.s_addr)
+            return 0;
+        udp = inner + iip->ip_hl * 4;
     }
-    /* Append the value of destination port */
-    if(!p->tracerouteDstport)
+    else
     {
-        p->tracerouteDstport = TRACE_DEF_PORT;
+        struct ip6_hdr *iip;
+
+        icmp = buf;
+        if (n < 8 + 40 + 8
+            || (icmp[0] != ICMP6_TIME_EXCEEDED && icmp[0] != ICMP6_DST_UNREACH))
+            return 0;
+        iip = (struct ip6_hdr *) (icmp + 8);
+        if (iip->ip6_nxt != IPPROTO_UDP
+            || memcmp(&iip->ip6_dst,
+                      &((struct sockaddr_in6 *) &c->dst)->sin6_addr, 16))
+            return 0;
+        udp = icmp + 8 + 40;
     }
-    len += sprintf(target+len, " -p %d", p->tracerouteDstport);
 
-    /* Append the value of max TTL */
-    if(!p->tracerouteMaxttl)
+    if (ntohs(*(uint16_t *) (udp + 0)) != c->sport
+        || ntohs(*(uint16_t *) (udp + 2)) != c->dport)
+        return 0;
+    pr->icmpType = icmp[0];
+    pr->icmpCode = icmp[1];
+    return ntohs(*(uint16_t *) (udp + 6));
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_is_final
+| Responsibility : Whether an ICMP message ends the path (any unreachable)
+|                  and whether it means the destination was reached
+----------------------------------------------------------------------------------------*/
+static bool trace_is_final (int family, const tracerouteProbe *pr,
+                            bool *reached)
+{
+    if (family == AF_INET)
     {
-        p->tracerouteMaxttl = TRACE_DEF_MAXTTL;
+        *reached = (pr->icmpType == ICMP_DEST_UNREACH
+                    && pr->icmpCode == ICMP_PORT_UNREACH);
+        return pr->icmpType == ICMP_DEST_UNREACH;
     }
-    len += sprintf(target+len, " -m %d", p->tracerouteMaxttl);
+    *reached = (pr->icmpType == ICMP6_DST_UNREACH
+                && pr->icmpCode == ICMP6_DST_UNREACH_NOPORT);
+    return pr->icmpType == ICMP6_DST_UNREACH;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_open
+| Responsibility : Resolve the target and open the trace sockets in swns
+| Return : true on success
+----------------------------------------------------------------------------------------*/
+static bool trace_open (traceCtx *c, tracerouteEntry *p,
+                        tracerouteResult *r)
+{
+    struct addrinfo hints, *res;
+    struct sockaddr_storage via;
+    socklen_t len;
+
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = p->isIpv4 ? AF_INET : AF_INET6;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (ping_netns_getaddrinfo(p->tracerouteTarget, &hints, &res) != 0
+        || !res)
+        return false;
+    memcpy(&c->dst, res->ai_addr, res->ai_addrlen);
+    c->dstLen = res->ai_addrlen;
+    freeaddrinfo(res);
+    r->target = c->dst;
+    c->family = c->dst.ss_family;
+    c->dport = p->tracerouteDstport;
 
-    /* Append the value of probes */
-    if(!p->tracerouteProbes)
+    /* With loose source routing the first hop is the gateway. */
+    via = c->dst;
+    if (c->family == AF_INET && p->tracerouteLoosesourceIp)
     {
-        p->tracerouteProbes = TRACE_DEF_PROBES;
+        uint8_t opt[12] = { IPOPT_NOP, IPOPT_LSRR, 11, IPOPT_MINOFF };
+        struct in_addr gw;
+
+        if (inet_pton(AF_INET, p->tracerouteLoosesourceIp, &gw) <= 0)
+            return false;
+        memcpy(opt + 4, &gw, 4);
+        memcpy(opt + 8, &((struct sockaddr_in *) &c->dst)->sin_addr, 4);
+        ((struct sockaddr_in *) &via)->sin_addr = gw;
+        c->lsrr = true;
+
+        c->sendFd = ping_netns_socket(c->family, SOCK_RAW, IPPROTO_UDP);
+        if (c->sendFd < 0
+            || setsockopt(c->sendFd, IPPROTO_IP, IP_OPTIONS, opt,
+                          sizeof opt) < 0)
+            return false;
     }
-    len += sprintf(target+len, " -q %d", p->tracerouteProbes);
+    else
+        c->sendFd = ping_netns_socket(c->family, SOCK_RAW, IPPROTO_UDP);
+    if (c->sendFd < 0)
+        return false;
 
-    /* Append the value of wait time */
-    if(!p->tracerouteTimeout)
+    c->recvFd = ping_netns_socket(c->family, SOCK_RAW,
+                                  c->family == AF_INET ? IPPROTO_ICMP
+                                                       : IPPROTO_ICMPV6);
+    if (c->recvFd < 0)
+        return false;
+    if (c->family == AF_INET6)
     {
-        p->tracerouteTimeout = TRACE_DEF_WAIT;
+        struct icmp6_filter filter;
+
+        ICMP6_FILTER_SETBLOCKALL(&filter);
+        ICMP6_FILTER_SETPASS(ICMP6_DST_UNREACH, &filter);
+        ICMP6_FILTER_SETPASS(ICMP6_TIME_EXCEEDED, &filter);
+        setsockopt(c->recvFd, IPPROTO_ICMPV6, ICMP6_FILTER, &filter,
+                   sizeof filter);
     }
-    len += sprintf(target+len, " -w %d", p->tracerouteTimeout);
 
-    /* Traceroute4 options */
-    if(p->isIpv4)
+    /* A connected UDP socket reserves the source port and tells us the
+     * source address the kernel picks, which the checksum covers. */
+    c->portFd = ping_netns_socket(c->family, SOCK_DGRAM, IPPROTO_UDP);
+    if (c->portFd < 0)
+        return false;
+    if (c->family == AF_INET)
+        ((struct sockaddr_in *) &via)->sin_port = htons(c->dport);
+    else
+        ((struct sockaddr_in6 *) &via)->sin6_port = htons(c->dport);
+    len = sizeof c->src;
+    if (connect(c->portFd, (struct sockaddr *) &via, c->dstLen) < 0
+        || getsockname(c->portFd, (struct sockaddr *) &c->src, &len) < 0)
+        return false;
+    c->sport = (c->family == AF_INET)
+               ? ntohs(((struct sockaddr_in *) &c->src)->sin_port)
+               : ntohs(((struct sockaddr_in6 *) &c->src)->sin6_port);
+    return true;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : traceroute_run
+| Responsibility : Trace the path to p->tracerouteTarget.  The probes of all
+|                  TTLs are sent at once, those of one TTL back to back so
+|                  that the ICMP rate limit of the destination is spent on
+|                  its own hop first.  Answers are collected from one socket
+|                  until every probe up to the last hop is answered or the
+|                  timeout expires.
+| Parameters : tracerouteEntry* p : options, zero values take the defaults
+|              tracerouteResult *r : per-hop results; r->target has
+|                                    family AF_UNSPEC if the target did
+|                                    not resolve
+| Return : true when the trace ran, false on a setup error (errno is set)
+----------------------------------------------------------------------------------------*/
+bool traceroute_run (tracerouteEntry *p, tracerouteResult *r)
+{
+    traceCtx c;
+    struct pollfd pfd;
+    tracerouteProbe pr;
+    double *sentAt, now, deadline;
+    int minTtl, nTtl, nProbes, probes, last, id, h, k, err;
+    bool reached, ok = false;
+
+    if (!p->tracerouteDstport)
+        p->tracerouteDstport = TRACE_DEF_PORT;
+    if (!p->tracerouteMaxttl)
+        p->tracerouteMaxttl = TRACE_DEF_MAXTTL;
+    if (!p->tracerouteMinttl || !p->isIpv4)
+        p->tracerouteMinttl = TRACE_DEF_MINTTL;
+    if (!p->tracerouteProbes || p->tracerouteProbes > TRACE_MAX_PROBES)
+        p->tracerouteProbes = TRACE_DEF_PROBES;
+    if (!p->tracerouteTimeout)
+        p->tracerouteTimeout = TRACE_DEF_WAIT;
+
+    memset(r, 0, sizeof *r);
+    minTtl = p->tracerouteMinttl;
+    nTtl = (p->tracerouteMaxttl >= minTtl)
+           ? p->tracerouteMaxttl - minTtl + 1 : 0;
+    probes = p->tracerouteProbes;
+    nProbes = nTtl * probes;
+    for (h = 0; h < nTtl; h++)
     {
-        /* Append the value of min TTL */
-        if(!p->tracerouteMinttl)
+        r->hop[h].ttl = minTtl + h;
+        for (k = 0; k < probes; k++)
+            r->hop[h].probe[k].rtt = -1;
+    }
+
+    memset(&c, 0, sizeof c);
+    c.sendFd = c.recvFd = c.portFd = -1;
+    sentAt = XCALLOC(MTYPE_TMP, (nProbes + 1) * sizeof *sentAt);
+    if (!trace_open(&c, p, r))
+        goto out;
+
+    /* Hops past the first one that ends the path are not reported. */
+    last = nTtl;
+    pfd.fd = c.recvFd;
+    pfd.events = POLLIN;
+
+    for (h = 0; h < nTtl; h++)
+        for (k = 0; k < probes; k++)
         {
-            p->tracerouteMinttl = TRACE_DEF_MINTTL;
+            id = k * nTtl + h + 1;
+            if (trace_send(&c, id, minTtl + h))
+                sentAt[id - 1] = trace_now();
         }
-        len += sprintf(target+len, " -f %d", p->tracerouteMinttl);
+    deadline = trace_now() + p->tracerouteTimeout * 1000.0;
+
+    for (;;)
+    {
+        bool pending = false;
+
+        now = trace_now();
+        for (id = 0; id < nProbes && !pending; id++)
+            pending = (id % nTtl < last && sentAt[id] > 0);
+        if (!pending || now >= deadline)
+            break;
+
+        k = (int) (deadline - now);
+        if (poll(&pfd, 1, k > 0 ? k : 0) <= 0)
+            continue;
 
-        /* Append the IP of loosesourceroute */
-        if(p->tracerouteLoosesourceIp)
+        while ((id = trace_recv(&c, &pr)) >= 0)
         {
-            len += sprintf(target+len, " -g %s", p->tracerouteLoosesourceIp);
+            if (id == 0 || id > nProbes || sentAt[id - 1] <= 0)
+                continue;
+            h = (id - 1) % nTtl;
+            k = (id - 1) / nTtl;
+            pr.rtt = trace_now() - sentAt[id - 1];
+            sentAt[id - 1] = -1;            /* answered */
+            r->hop[h].probe[k] = pr;
+            if (trace_is_final(c.family, &pr, &reached) && h + 1 <= last)
+            {
+                last = h + 1;
+                r->reached = reached;
+            }
         }
     }
-    fp = popen(buffer,"r");
+    r->nHops = last;
+    ok = true;
 
-    if(fp)
+out:
+    err = errno;
+    if (c.sendFd >= 0)
+        close(c.sendFd);
+    if (c.recvFd >= 0)
+        close(c.recvFd);
+    if (c.portFd >= 0)
+        close(c.portFd);
+    XFREE(MTYPE_TMP, sentAt);
+    errno = err;
+    return ok;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_same_addr
+| Responsibility : Whether two probes were answered from the same address
+----------------------------------------------------------------------------------------*/
+static bool trace_same_addr (const struct sockaddr_storage *a,
+                             const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family)
+        return false;
+    if (a->ss_family == AF_INET)
+        return ((const struct sockaddr_in *) a)->sin_addr.s_addr
+               == ((const struct sockaddr_in *) b)->sin_addr.s_addr;
+    return !memcmp(&((const struct sockaddr_in6 *) a)->sin6_addr,
+                   &((const struct sockaddr_in6 *) b)->sin6_addr,
+                   sizeof (struct in6_addr));
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : trace_annotation
+| Responsibility : traceroute style flag for an unreachable that did not
+|                  come from the destination port
+----------------------------------------------------------------------------------------*/
+static const char *trace_annotation (int family, const tracerouteProbe *pr)
+{
+    static char buf[8];
+
+    if (family == AF_INET)
     {
-        while ( fgets( output, BUFSIZ, fp ) != NULL )
-            (*fPtr)(output);
+        if (pr->icmpType != ICMP_DEST_UNREACH)
+            return "";
+        switch (pr->icmpCode)
+        {
+        case ICMP_PORT_UNREACH:     return "";
+        case ICMP_NET_UNREACH:
+        case ICMP_NET_UNKNOWN:
+        case ICMP_NET_ANO:
+        case ICMP_NET_UNR_TOS:      return " !N";
+        case ICMP_HOST_UNREACH:
+        case ICMP_HOST_UNKNOWN:
+        case ICMP_HOST_ANO:
+        case ICMP_HOST_UNR_TOS:     return " !H";
+        case ICMP_PROT_UNREACH:     return " !P";
+        case ICMP_FRAG_NEEDED:      return " !F";
+        case ICMP_SR_FAILED:        return " !S";
+        case ICMP_PKT_FILTERED:     return " !X";
+        default:                    break;
+        }
     }
     else
     {
-        VLOG_ERR("Failed to open pipe stream");
+        if (pr->icmpType != ICMP6_DST_UNREACH)
+            return "";
+        switch (pr->icmpCode)
+        {
+        case ICMP6_DST_UNREACH_NOPORT:  return "";
+        case ICMP6_DST_UNREACH_NOROUTE: return " !N";
+        case ICMP6_DST_UNREACH_ADMIN:   return " !X";
+        case ICMP6_DST_UNREACH_ADDR:    return " !H";
+        default:                        break;
+        }
+    }
+    snprintf(buf, sizeof buf, " !%u", pr->icmpCode);
+    return buf;
+}
+
+/*---------------------------------------------------------------------------------------
+| Name : traceroute_handler
+| Responsibility : perform traceroute and print one line per hop
+| Parameters : tracerouteEntry* p : pointer to traceroute structure,
+|              void (*fptr)(char *buff): function pointer for display purpose
+| Return : returns true on successful execution, false for any error encountered
+----------------------------------------------------------------------------------------*/
+bool traceroute_handler(tracerouteEntry *p, void (*fPtr)(char *buff))
+{
+    char line[BUFSIZ], addr[INET6_ADDRSTRLEN];
+    tracerouteResult *r;
+    const struct sockaddr_storage *prev;
+    int h, k, len;
+    bool ok;
+
+    if(!fPtr)
+    {
+        VLOG_ERR("function pointer passed is null");
+        return false;
+    }
+    if(!p)
+    {
+        VLOG_ERR("Pointer to traceroute structure is null");
         return false;
     }
-    pclose(fp);
+
+    r = XCALLOC(MTYPE_TMP, sizeof *r);
+    ok = traceroute_run(p, r);
+    if (!ok)
+    {
+        if (r->target.ss_family == AF_UNSPEC)
+            snprintf(line, sizeof line, "%s: unknown host %s",
+                     p->isIpv4 ? "traceroute" : "traceroute6",
+                     p->tracerouteTarget);
+        else
+            snprintf(line, sizeof line, "%s: %s",
+                     p->isIpv4 ? "traceroute" : "traceroute6",
+                     strerror(errno));
+        VLOG_ERR("Traceroute to %s failed", p->tracerouteTarget);
+        (*fPtr)(line);
+        XFREE(MTYPE_TMP, r);
+        return false;
+    }
+
+    if (r->target.ss_family == AF_INET)
+    {
+        inet_ntop(AF_INET, &((struct sockaddr_in *) &r->target)->sin_addr,
+                  addr, sizeof addr);
+        snprintf(line, sizeof line, "traceroute to %s (%s), %d hops min, "
+                 "%d hops max, %d sec. timeout, %d probes",
+                 p->tracerouteTarget, addr, p->tracerouteMinttl,
+                 p->tracerouteMaxttl, p->tracerouteTimeout,
+                 p->tracerouteProbes);
+    }
+    else
+    {
+        inet_ntop(AF_INET6, &((struct sockaddr_in6 *) &r->target)->sin6_addr,
+                  addr, sizeof addr);
+        snprintf(line, sizeof line, "traceroute to %s (%s), %d hops max, "
+                 "%d sec. timeout, %d probes", p->tracerouteTarget, addr,
+                 p->tracerouteMaxttl, p->tracerouteTimeout,
+                 p->tracerouteProbes);
+    }
+    (*fPtr)(line);
+
+    for (h = 0; h < r->nHops; h++)
+    {
+        len = snprintf(line, sizeof line, "%3d ", r->hop[h].ttl);
+        prev = NULL;
+        for (k = 0; k < p->tracerouteProbes; k++)
+        {
+            const tracerouteProbe *pr = &r->hop[h].probe[k];
+
+            if (pr->rtt < 0)
+            {
+                len += snprintf(line + len, sizeof line - len, "  *");
+                continue;
+            }
+            if (!prev || !trace_same_addr(prev, &pr->from))
+            {
+                if (pr->from.ss_family == AF_INET)
+                    inet_ntop(AF_INET,
+                              &((struct sockaddr_in *) &pr->from)->sin_addr,
+                              addr, sizeof addr);
+                else
+                    inet_ntop(AF_INET6,
+                              &((struct sockaddr_in6 *) &pr->from)->sin6_addr,
+                              addr, sizeof addr);
+                len += snprintf(line + len, sizeof line - len, "  %s", addr);
+                prev = &pr->from;
+            }
+            len += snprintf(line + len, sizeof line - len, "  %.3fms%s",
+                            pr->rtt, trace_annotation(r->target.ss_family, pr));
+        }
+        (*fPtr)(line);
+    }
+
+    XFREE(MTYPE_TMP, r);
     return true;
 }
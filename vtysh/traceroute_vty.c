@@ -39,7 +39,7 @@ VLOG_DEFINE_THIS_MODULE(traceroute_vty);
 -----------------------------------------------------------------------------*/
 void printOutput( char * buff)
 {
-    vty_out(vty, "%s %s", buff, VTY_NEWLINE);
+    vty_out(vty, "%s%s", buff, VTY_NEWLINE);
 }
 
 /*-----------------------------------------------------------------------------
@@ -254,7 +254,7 @@ DEFUN (cli_traceroute,
         return CMD_SUCCESS;
     }
 
-    /* handler for popen, output is printed by printOutput function */
+    /* Output is printed by printOutput function */
     if(!traceroute_handler(&p, printOutput))
     {
         VLOG_ERR("Call to handler failed");
@@ -345,7 +345,7 @@ DEFUN (cli_traceroute_ipoption,
         return CMD_SUCCESS;
     }
 
-    /* handler for popen, output is printed by printOutput function */
+    /* Output is printed by printOutput function */
     if(!traceroute_handler(&p, printOutput))
     {
         VLOG_ERR("Call to handler failed");
@@ -416,7 +416,7 @@ DEFUN (cli_traceroute6,
         return CMD_SUCCESS;
     }
 
-   /* handler for popen, output is printed by printOutput function */
+   /* Output is printed by printOutput function */
     if(!traceroute_handler(&p, printOutput))
     {
         VLOG_ERR("Call to handler failed");
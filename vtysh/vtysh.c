@@ -61,6 +61,8 @@
 #include "intf_vty.h"
 #include "vswitch-idl.h"
 #include "smap.h"
+#include "shash.h"
+#include "dynamic-string.h"
 #include "lldp_vty.h"
 #include "vrf_vty.h"
 #include "neighbor_vty.h"
@@ -92,6 +94,7 @@ int enable_mininet_test_prompt = 0;
 extern struct ovsdb_idl *idl;
 int vtysh_show_startup = 0;
 
+static int vtysh_alias_execute(vector vline);
 #endif
 
 
@@ -358,6 +361,15 @@ vtysh_execute_func (const char *line, int pager)
    if (vline == NULL)
       return CMD_SUCCESS;
 
+#ifdef ENABLE_OVSDB
+   if (vty->node == CONFIG_NODE
+       && (ret = vtysh_alias_execute (vline)) != CMD_ERR_NO_MATCH)
+   {
+      cmd_free_strvec (vline);
+      return ret;
+   }
+#endif
+
    saved_ret = ret = cmd_execute_command (vline, vty, &cmd, 1);
    saved_node = vty->node;
 
@@ -371,6 +383,14 @@ vtysh_execute_func (const char *line, int pager)
          && vty->node > CONFIG_NODE)
    {
       vty->node = node_parent(vty->node);
+#ifdef ENABLE_OVSDB
+      if (vty->node == CONFIG_NODE
+          && (ret = vtysh_alias_execute (vline)) != CMD_ERR_NO_MATCH)
+      {
+         tried++;
+         continue;
+      }
+#endif
       ret = cmd_execute_command (vline, vty, &cmd, 1);
       tried++;
    }
@@ -2669,6 +2689,33 @@ DEFUN_HIDDEN (vtysh_show_context_client_list,
    vtysh_context_table_list_clients (vty);
    return CMD_SUCCESS;
 }
+
+DEFUN_HIDDEN (vtysh_show_cli_statistics,
+              vtysh_show_cli_statistics_cmd,
+              "show cli statistics",
+              SHOW_STR
+              "Command line interface\n"
+              "Command latency and OVSDB lock statistics\n")
+{
+   struct ds ds = DS_EMPTY_INITIALIZER;
+
+   vtysh_cli_stats_format (&ds);
+   vty_out (vty, "%s", ds_cstr (&ds));
+   ds_destroy (&ds);
+   return CMD_SUCCESS;
+}
+
+DEFUN_HIDDEN (vtysh_clear_cli_statistics,
+              vtysh_clear_cli_statistics_cmd,
+              "clear cli statistics",
+              CLEAR_STR
+              "Command line interface\n"
+              "Command latency and OVSDB lock statistics\n")
+{
+   cmd_stats_clear ();
+   vtysh_ovsdb_lock_stats_clear ();
+   return CMD_SUCCESS;
+}
 #else
 ALIAS (vtysh_write_terminal,
       vtysh_show_running_config_cmd,
@@ -3715,14 +3762,225 @@ vtysh_periodic_refresh(void)
   return;
 }
 
-int vtysh_alias_count = 0;
-struct vtysh_alias_data *vtysh_aliases[VTYSH_MAX_ALIAS_SUPPORTED] = {NULL};
+/* Alias name -> struct vtysh_alias_data. */
+static struct shash vtysh_aliases = SHASH_INITIALIZER(&vtysh_aliases);
+static const struct ovsdb_idl_table_class *const vtysh_aliases_tables[] = {
+    &ovsrec_table_cli_alias,
+};
+static struct vtysh_idl_cache vtysh_aliases_cache =
+    VTYSH_IDL_CACHE_INITIALIZER(vtysh_aliases_tables);
+static unsigned int vtysh_aliases_generation;
 char vtysh_alias_cmd_help_string[] = VTYSH_ALIAS_CMD_HELPSTRING;
 
+int vtysh_alias_string_to_int(char *str);
+
+/*
+ * Function       : vtysh_alias_add_token
+ * Responsibility : Appends a literal or $N token to an alias command
+ * Parameters     : command, argument number (0 for literal), text, length
+ * Return         : void
+ */
+static void
+vtysh_alias_add_token(vector command, int arg, const char *text, size_t len)
+{
+   struct vtysh_alias_token *token;
+
+   if (len == 0)
+   {
+      return;
+   }
+   token = xmalloc(sizeof *token);
+   token->arg = arg;
+   token->text = xmemdup0(text, len);
+   vector_set_index(command, vector_active(command), token);
+}
+
+/*
+ * Function       : vtysh_alias_free_commands
+ * Responsibility : Frees the precompiled commands of an alias
+ * Parameters     : alias
+ * Return         : void
+ */
+static void
+vtysh_alias_free_commands(struct vtysh_alias_data *alias)
+{
+   unsigned int i, j;
+   vector command;
+   struct vtysh_alias_token *token;
+
+   if (alias->commands == NULL)
+   {
+      return;
+   }
+   for (i = 0; i < vector_active(alias->commands); i++)
+   {
+      command = vector_slot(alias->commands, i);
+      for (j = 0; j < vector_active(command); j++)
+      {
+         token = vector_slot(command, j);
+         free(token->text);
+         free(token);
+      }
+      vector_free(command);
+   }
+   vector_free(alias->commands);
+   alias->commands = NULL;
+   free(alias->definition);
+   alias->definition = NULL;
+}
+
+/*
+ * Function       : vtysh_alias_compile
+ * Responsibility : Splits an alias definition into its ";" separated
+ *                  commands, and each command into literal text and
+ *                  $N argument tokens, so that running the alias only
+ *                  has to paste the arguments in
+ * Parameters     : alias, definition
+ * Return         : void
+ */
+static void
+vtysh_alias_compile(struct vtysh_alias_data *alias, const char *definition)
+{
+   const char *start = definition;
+   const char *p = definition;
+   vector command;
+   int arg;
+
+   vtysh_alias_free_commands(alias);
+   alias->definition = xstrdup(definition);
+   alias->commands = vector_init(1);
+   command = vector_init(1);
+
+   for (;;)
+   {
+      if (*p == '$'
+          && (arg = vtysh_alias_string_to_int(CONST_CAST(char *, p + 1))) > 0)
+      {
+         vtysh_alias_add_token(command, 0, start, p - start);
+         for (start = p++; isdigit((unsigned char) *p); p++)
+         {
+            continue;
+         }
+         vtysh_alias_add_token(command, arg, start, p - start);
+         start = p;
+      }
+      else if (*p == ';' || *p == '\0')
+      {
+         vtysh_alias_add_token(command, 0, start, p - start);
+         vector_set_index(alias->commands, vector_active(alias->commands),
+                          command);
+         if (*p == '\0')
+         {
+            break;
+         }
+         command = vector_init(1);
+         start = ++p;
+      }
+      else
+      {
+         p++;
+      }
+   }
+}
+
+/*
+ * Function       : vtysh_alias_expand
+ * Responsibility : Builds the command lines an alias runs for the given
+ *                  arguments.  Arguments no $N refers to are appended to
+ *                  the last command.
+ * Parameters     : alias, argc/argv
+ * Return         : vector of command line strings, to be freed by caller
+ */
+static vector
+vtysh_alias_expand(const struct vtysh_alias_data *alias, int argc,
+                   const char *argv[])
+{
+   vector lines = vector_init(1);
+   char line[VTYSH_MAX_ALIAS_LIST_LEN];
+   const struct vtysh_alias_token *token;
+   unsigned int i, j, n_commands = vector_active(alias->commands);
+   int k, max_arg = 0;
+   size_t len;
+
+   for (i = 0; i < n_commands; i++)
+   {
+      vector command = vector_slot(alias->commands, i);
+
+      line[0] = '\0';
+      for (j = 0; j < vector_active(command); j++)
+      {
+         token = vector_slot(command, j);
+         if (token->arg && token->arg <= argc)
+         {
+            strncat(line, argv[token->arg - 1],
+                    sizeof line - strlen(line) - 1);
+            max_arg = MAX(max_arg, token->arg);
+         }
+         else
+         {
+            strncat(line, token->text, sizeof line - strlen(line) - 1);
+         }
+      }
+      if (i == n_commands - 1)
+      {
+         for (k = max_arg; k < argc; k++)
+         {
+            len = strlen(line);
+            snprintf(line + len, sizeof line - len, " %s", argv[k]);
+         }
+      }
+
+      len = strspn(line, " ");
+      if (line[len] != '\0')
+      {
+         vector_set_index(lines, vector_active(lines), xstrdup(line + len));
+      }
+   }
+   return lines;
+}
+
+/*
+ * Function       : vtysh_alias_install
+ * Responsibility : Creates an alias and installs its commands, with and
+ *                  without arguments, in the config node
+ * Parameters     : alias name, definition
+ * Return         : the alias
+ */
+static struct vtysh_alias_data *
+vtysh_alias_install(const char *name, const char *definition)
+{
+   struct vtysh_alias_data *alias = xzalloc(sizeof *alias);
+
+   ovs_strlcpy(alias->alias_def_str, name, sizeof alias->alias_def_str);
+   snprintf(alias->alias_def_str_with_args,
+            sizeof alias->alias_def_str_with_args, "%s .LINE",
+            alias->alias_def_str);
+   vtysh_alias_compile(alias, definition);
+
+   alias->alias_cmd_element.string = alias->alias_def_str;
+   alias->alias_cmd_element.func = vtysh_alias_callback;
+   alias->alias_cmd_element.doc = vtysh_alias_cmd_help_string;
+   alias->alias_cmd_element.attr = CMD_ATTR_NOLOCK;
+   alias->alias_cmd_element.daemon = 0;
+   alias->alias_cmd_element_with_args.string =
+       alias->alias_def_str_with_args;
+   alias->alias_cmd_element_with_args.func = vtysh_alias_callback;
+   alias->alias_cmd_element_with_args.doc = vtysh_alias_cmd_help_string;
+   alias->alias_cmd_element_with_args.attr = CMD_ATTR_NOLOCK;
+   alias->alias_cmd_element_with_args.daemon = 0;
+
+   install_element(CONFIG_NODE, &alias->alias_cmd_element);
+   install_element(CONFIG_NODE, &alias->alias_cmd_element_with_args);
+   shash_add(&vtysh_aliases, alias->alias_def_str, alias);
+
+   return alias;
+}
+
 
 /*
-  * Function       : vtysh_alias_load_alias_table
-  * Responsibility : Reloads the alias information from ovsdb
+  * Function       : vty_refresh_aliases
+  * Responsibility : Reconciles the aliases with the CLI_Alias table,
+  *                  once per change to that table
   * Parameters     : void
   * Return         : success/failure
  */
@@ -3730,97 +3988,47 @@ int
 vty_refresh_aliases(void)
 {
     const struct ovsrec_cli_alias *alias_row = NULL;
-    int i = 0;
-    bool alias_exist = false;
-    static int refresh_count = 0;
+    struct vtysh_alias_data *alias;
+    struct shash_node *node, *next;
 
-    refresh_count = (refresh_count + 1) % 100;
+    if (vtysh_idl_cache_check(&vtysh_aliases_cache))
+    {
+        return CMD_SUCCESS;
+    }
+    vtysh_aliases_generation++;
 
     OVSREC_CLI_ALIAS_FOR_EACH(alias_row, idl)
     {
-        alias_exist = false;
-        for (i = 0; i < vtysh_alias_count; i++)
+        alias = shash_find_data(&vtysh_aliases, alias_row->alias_name);
+        if (alias == NULL)
         {
-            if (vtysh_aliases[i]->refresh_count == refresh_count)
+            if (shash_count(&vtysh_aliases) >= VTYSH_MAX_ALIAS_SUPPORTED
+                || strlen(alias_row->alias_name) > VTYSH_MAX_ALIAS_DEF_LEN)
             {
                 continue;
             }
-            if (strcmp(vtysh_aliases[i]->alias_def_str,
-                    alias_row->alias_name) == 0)
-            {
-                vtysh_aliases[i]->refresh_count = refresh_count;
-                alias_exist = true;
-                break;
-            }
+            alias = vtysh_alias_install(alias_row->alias_name,
+                                        alias_row->alias_definition);
         }
-        if (true == alias_exist)
+        else if (strcmp(alias->definition, alias_row->alias_definition))
         {
-            continue;
+            vtysh_alias_compile(alias, alias_row->alias_definition);
         }
-
-        vtysh_aliases[vtysh_alias_count] =
-            (struct vtysh_alias_data*) malloc(sizeof(struct vtysh_alias_data));
-        memset(vtysh_aliases[vtysh_alias_count], 0,
-                sizeof(struct vtysh_alias_data));
-
-        strncpy(vtysh_aliases[vtysh_alias_count]->alias_def_str,
-                alias_row->alias_name, VTYSH_MAX_ALIAS_DEF_LEN);
-
-        strncpy(vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args,
-                vtysh_aliases[vtysh_alias_count]->alias_def_str,
-                VTYSH_MAX_ALIAS_DEF_LEN);
-        strcat(vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args,
-                " .LINE");
-
-        /* Prepare the command element & install the command in config node */
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element.string =
-            vtysh_aliases[vtysh_alias_count]->alias_def_str;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element.func   =
-            vtysh_alias_callback;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element.doc    =
-            vtysh_alias_cmd_help_string;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element.attr   =
-            CMD_ATTR_NOLOCK;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element.daemon = 0;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.string =
-            vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.func =
-            vtysh_alias_callback;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.doc =
-            vtysh_alias_cmd_help_string;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.attr =
-            CMD_ATTR_NOLOCK;
-        vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.daemon = 0;
-
-        /* install the new commands with alias definition as token */
-        install_element(CONFIG_NODE,
-               &vtysh_aliases[vtysh_alias_count]->alias_cmd_element);
-        install_element(CONFIG_NODE,
-               &vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args);
-        vtysh_aliases[vtysh_alias_count]->refresh_count = refresh_count;
-        vtysh_alias_count++;
+        alias->generation = vtysh_aliases_generation;
     }
 
-    for (i = 0; i < vtysh_alias_count; i++)
+    SHASH_FOR_EACH_SAFE(node, next, &vtysh_aliases)
     {
-        if (vtysh_aliases[i]->refresh_count != refresh_count)
+        alias = node->data;
+        if (alias->generation != vtysh_aliases_generation)
         {
-            vtysh_aliases[i]->alias_cmd_element.attr |= CMD_ATTR_HIDDEN;
-            vtysh_aliases[i]->alias_cmd_element.attr |= CMD_ATTR_NOT_ENABLED;
-            vtysh_aliases[i]->alias_cmd_element.attr |= CMD_ATTR_DISABLED;
-            vtysh_aliases[i]->alias_cmd_element_with_args.attr |=
-                CMD_ATTR_HIDDEN;
-            vtysh_aliases[i]->alias_cmd_element_with_args.attr |=
-                CMD_ATTR_NOT_ENABLED;
-            vtysh_aliases[i]->alias_cmd_element_with_args.attr |=
-                CMD_ATTR_DISABLED;
+            alias->alias_cmd_element.attr |= CMD_ATTR_DISABLED;
+            alias->alias_cmd_element_with_args.attr |= CMD_ATTR_DISABLED;
             //TODO :
             /* free cannot be done as cmd element is still referred by vector
                */
-            //free(vtysh_aliases[i]);
-            vtysh_aliases[i] = vtysh_aliases[vtysh_alias_count-1];
-            vtysh_aliases[vtysh_alias_count-1] = NULL;
-            vtysh_alias_count--;
+            vtysh_alias_free_commands(alias);
+            shash_delete(&vtysh_aliases, node);
         }
     }
 
@@ -3915,43 +4123,29 @@ DEFUN (vtysh_alias_cli,
 {
    int i = 0, ret_val = 0;
    char alias_list_str[VTYSH_MAX_ALIAS_LIST_LEN] = {0};
+   struct vtysh_alias_data *alias;
 
    if (argc == 0) return CMD_WARNING;
 
    /* Check if it is alias deletion */
    if (vty_flags & CMD_FLAG_NO_CMD)
    {
-      int found = 0;
-
-      for (i = 0; i < vtysh_alias_count; i++)
-      {
-         if(NULL == vtysh_aliases[i])
-         {
-            assert(0);
-            /* Data integrity failure */
-         }
-         if(strcmp(vtysh_aliases[i]->alias_def_str, argv[0]) == 0)
-         {
-            vtysh_alias_delete_alias(vtysh_aliases[i]->alias_def_str);
-            cmd_terminate_node_element(&vtysh_aliases[i]->alias_cmd_element, ELEMENT);
-            cmd_terminate_node_element(&vtysh_aliases[i]->alias_cmd_element_with_args, ELEMENT);
-            free(vtysh_aliases[i]);
-            vtysh_aliases[i] = vtysh_aliases[vtysh_alias_count-1];
-            vtysh_aliases[vtysh_alias_count-1] = NULL;
-            vtysh_alias_count--;
-            found = 1;
-            break;
-         }
-      }
-      if (0 == found)
+      alias = shash_find_data(&vtysh_aliases, argv[0]);
+      if (alias == NULL)
       {
          vty_out(vty, VTYSH_ERROR_ALIAS_NOT_FOUND, argv[0]);
          return CMD_SUCCESS;
       }
+      vtysh_alias_delete_alias(alias->alias_def_str);
+      cmd_terminate_node_element(&alias->alias_cmd_element, ELEMENT);
+      cmd_terminate_node_element(&alias->alias_cmd_element_with_args, ELEMENT);
+      shash_find_and_delete(&vtysh_aliases, alias->alias_def_str);
+      vtysh_alias_free_commands(alias);
+      free(alias);
       return CMD_SUCCESS;
    }
 
-   if (vtysh_alias_count >= VTYSH_MAX_ALIAS_SUPPORTED)
+   if (shash_count(&vtysh_aliases) >= VTYSH_MAX_ALIAS_SUPPORTED)
    {
       vty_out(vty, VTYSH_ERROR_MAX_ALIASES_EXCEEDED);
       return CMD_SUCCESS;
@@ -3971,31 +4165,12 @@ DEFUN (vtysh_alias_cli,
       return CMD_SUCCESS;
    }
 
-   if(NULL != vtysh_aliases[vtysh_alias_count])
-   {
-      assert(0);
-      /* Data integrity failure */
-      free(vtysh_aliases[vtysh_alias_count]);
-   }
-   vtysh_aliases[vtysh_alias_count] =
-       (struct vtysh_alias_data*) malloc(sizeof(struct vtysh_alias_data));
-   memset(vtysh_aliases[vtysh_alias_count], 0,
-           sizeof(struct vtysh_alias_data));
-
-   strncpy(vtysh_aliases[vtysh_alias_count]->alias_def_str, argv[0],
-           VTYSH_MAX_ALIAS_DEF_LEN);
-   strncpy(vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args, argv[0],
-         VTYSH_MAX_ALIAS_DEF_LEN_WITH_ARGS);
-   strcat(vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args, " .LINE");
-
    for (i = 1; i < argc; i++)
    {
       /* Read each args, and append to the command string */
       if(VTYSH_MAX_ALIAS_LIST_LEN <=
               strlen(alias_list_str) + strlen(argv[i]) + 2)
       {
-         free(vtysh_aliases[vtysh_alias_count]);
-         vtysh_aliases[vtysh_alias_count] = NULL;
          vty_out(vty, VTYSH_ERROR_MAX_ALIAS_LEN_EXCEEDED);
          return CMD_SUCCESS;
       }
@@ -4003,35 +4178,10 @@ DEFUN (vtysh_alias_cli,
       strcat(alias_list_str, " ");
    }
 
-   /* Prepare the command element and install the command in config node */
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element.string =
-       vtysh_aliases[vtysh_alias_count]->alias_def_str;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element.func =
-       vtysh_alias_callback;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element.doc =
-       vtysh_alias_cmd_help_string;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element.attr = CMD_ATTR_NOLOCK;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element.daemon = 0;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.string =
-       vtysh_aliases[vtysh_alias_count]->alias_def_str_with_args;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.func =
-       vtysh_alias_callback;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.doc =
-       vtysh_alias_cmd_help_string;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.attr =
-       CMD_ATTR_NOLOCK;
-   vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args.daemon = 0;
-
-   vtysh_alias_save_alias(vtysh_aliases[vtysh_alias_count]->alias_def_str,
-                           alias_list_str);
+   vtysh_alias_save_alias(CONST_CAST(char *, argv[0]), alias_list_str);
 
    /* install the new commands with alias definition as token */
-   install_element(CONFIG_NODE,
-           &vtysh_aliases[vtysh_alias_count]->alias_cmd_element);
-   install_element(CONFIG_NODE,
-           &vtysh_aliases[vtysh_alias_count]->alias_cmd_element_with_args);
-
-   vtysh_alias_count++;
+   vtysh_alias_install(argv[0], alias_list_str);
 
    return CMD_SUCCESS;
 }
@@ -4075,133 +4225,103 @@ vtysh_alias_string_to_int(char *str)
 
 
 /*
- * Function       : vtysh_alias_callback
- * Responsibility : Generic Callback function for Aliases
- * Parameters     : cmd element, vty, argc/argv, flags
- * Return         : cmd error
+ * Function       : vtysh_alias_run
+ * Responsibility : Runs the commands of an alias
+ * Parameters     : vty, alias name, argc/argv
+ * Return         : CMD_ERR_NO_MATCH if there is no such alias
  */
-int
-vtysh_alias_callback(struct cmd_element *self, struct vty *vty,
-      int vty_flags, int argc, const char *argv[])
+static int
+vtysh_alias_run(struct vty *vty, const char *name, int argc,
+                const char *argv[])
 {
-   char cmd_now[VTYSH_MAX_ALIAS_LIST_LEN] = {0};
-   int len = 0, i = 0;
-   char *found_cmd = NULL;
-   int arg_count = 0, max_arg_count = 0;
-   char current_cmd[VTYSH_MAX_ALIAS_LIST_LEN] = {0};
+   const struct vtysh_alias_data *alias;
    char *prev_buf = vty->buf;
-   const struct ovsrec_cli_alias *alias_row = NULL;
+   int prev_length = vty->length;
+   vector lines = NULL;
+   size_t len = strlen(name);
+   unsigned int i;
 
-   for(len = 0; len <= vty->length && vty->buf[len] != ' '; len++)
+   /* vty_command() takes the OVSDB lock for each command, so expand them
+    * all before, while the OVSDB thread cannot refresh the alias. */
+   VTYSH_OVSDB_LOCK;
+   alias = shash_find_data(&vtysh_aliases, name);
+   if (alias != NULL)
    {
-      cmd_now[len] = vty->buf[len];
+      lines = vtysh_alias_expand(alias, argc, argv);
    }
-   cmd_now[len] = '\0';
+   VTYSH_OVSDB_UNLOCK;
 
-   OVSREC_CLI_ALIAS_FOR_EACH (alias_row, idl)
+   if (lines == NULL)
    {
-      if(strcmp(alias_row->alias_name, cmd_now) == 0)
-      {
-         found_cmd = alias_row->alias_definition;
-         break;
-      }
+      return CMD_ERR_NO_MATCH;
    }
 
-   if(NULL == found_cmd)
+   for (i = 0; i < vector_active(lines); i++)
    {
-      vty_out(vty, VTYSH_ERROR_ALIAS_NOT_FOUND, cmd_now);
-      return CMD_SUCCESS;
-   }
+      char *strt = vector_slot(lines, i);
 
-   for(len = 0, i = 0;
-           len <= VTYSH_MAX_ALIAS_LIST_LEN && found_cmd[len] != '\0'; len++)
-   {
-      if(found_cmd[len] == '$')
+      if ((strncmp(name, strt, len) == 0) &&
+            (strt[len] == ' ' || strt[len] == '\0'))
       {
-         arg_count = vtysh_alias_string_to_int(&(found_cmd[len+1]));
-         if( (arg_count != 0) &&( arg_count <= argc))
-         {
-            strcat(current_cmd, argv[arg_count-1]);
-            strcat(current_cmd, " ");
-            i+= strlen(current_cmd);
-            if(max_arg_count < arg_count)
-            {
-               max_arg_count = arg_count;
-            }
-            while(arg_count)
-            {
-               len++;
-               arg_count/=10;
-            }
-         }
-         else
-         {
-            current_cmd[i++] = found_cmd[len];
-         }
+         vty_out(vty, VTYSH_ERROR_ALIAS_LOOP_ALIAS);
+         break;
       }
-      else if (found_cmd[len] == ';')
-      {
-         /* Execute the command */
-         char *strt = current_cmd;
+      vty->buf = strt;
+      vty->length = strlen(strt);
+      vty_command (vty, vty->buf);
+   }
+   vty->buf = prev_buf;
+   vty->length = prev_length;
 
-         while(*strt == ' ')
-         {
-            strt++;
-            if(*strt == '\0') break;
-         }
+   for (i = 0; i < vector_active(lines); i++)
+   {
+      free(vector_slot(lines, i));
+   }
+   vector_free(lines);
+   return CMD_SUCCESS;
+}
 
-         if((strncmp(cmd_now, strt, strlen(cmd_now)) == 0) &&
-               (*(strt + strlen(cmd_now) + 1) == ' ' ||
-                       *(strt + strlen(cmd_now) + 1) == '\0'))
-         {
-            vty_out(vty, VTYSH_ERROR_ALIAS_LOOP_ALIAS);
-            return CMD_SUCCESS;
-         }
-         vty->buf = strt;
-         vty->length = strlen(strt);
-         //vty_out(vty, "Executing the command \"%s\" %s", strt, VTY_NEWLINE);
-         vty_command (vty, vty->buf);
+/*
+ * Function       : vtysh_alias_execute
+ * Responsibility : Runs a CONFIG_NODE command line whose first word names
+ *                  an alias.  Looking the name up spares matching the line
+ *                  against every command of the node, which the aliases
+ *                  are installed in
+ * Parameters     : command line vector
+ * Return         : CMD_ERR_NO_MATCH if it names no alias
+ */
+static int
+vtysh_alias_execute(vector vline)
+{
+   return vtysh_alias_run(vty, vector_slot(vline, 0),
+                          vector_active(vline) - 1,
+                          (const char **) vline->index + 1);
+}
 
-         memset(current_cmd, 0, VTYSH_MAX_ALIAS_LIST_LEN);
-         i = 0;
-      }
-      else
-      {
-         current_cmd[i++] = found_cmd[len];
-      }
-   }
+/*
+ * Function       : vtysh_alias_callback
+ * Responsibility : Generic Callback function for Aliases, for the lines
+ *                  vtysh_alias_execute() did not take, such as those that
+ *                  abbreviate the alias name
+ * Parameters     : cmd element, vty, argc/argv, flags
+ * Return         : cmd error
+ */
+int
+vtysh_alias_callback(struct cmd_element *self, struct vty *vty,
+      int vty_flags, int argc, const char *argv[])
+{
+   char name[VTYSH_MAX_ALIAS_DEF_LEN + 1];
+   size_t len = strcspn(self->string, " ");
 
-   max_arg_count++; /* To find unused args */
+   /* Both commands of an alias start with its name. */
+   len = MIN(len, VTYSH_MAX_ALIAS_DEF_LEN);
+   memcpy(name, self->string, len);
+   name[len] = '\0';
 
-   while(argc >= max_arg_count)
+   if (vtysh_alias_run(vty, name, argc, argv) == CMD_ERR_NO_MATCH)
    {
-      strcat(current_cmd, " ");
-      strcat(current_cmd, argv[max_arg_count - 1]);
-      max_arg_count++;
-   }
-   if(current_cmd[0] != 0)
-   {
-      /* Execute the command */
-      char *strt = current_cmd;
-
-      while(*strt == ' ')
-      {
-         strt++;
-         if(*strt == '\0') break;
-      }
-      if((strncmp(cmd_now, strt, strlen(cmd_now)) == 0) &&
-            (*(strt + strlen(cmd_now) + 1) == ' ' ||
-                    *(strt + strlen(cmd_now) + 1) == '\0'))
-      {
-         vty_out(vty, VTYSH_ERROR_ALIAS_LOOP_ALIAS);
-         return CMD_SUCCESS;
-      }
-      //vty_out(vty, "Executing the command \"%s\" \n", current_cmd);
-      vty->buf = strt;
-      vty->length = strlen(strt);
-      vty_command (vty, vty->buf);
+      vty_out(vty, VTYSH_ERROR_ALIAS_NOT_FOUND, name);
    }
-   vty->buf = prev_buf;
    return CMD_SUCCESS;
 }
 
@@ -4281,8 +4401,6 @@ alias_vty_init()
    install_element(CONFIG_NODE, &vtysh_alias_cli_cmd);
    install_element(CONFIG_NODE, &no_vtysh_alias_cli_cmd);
    install_element(ENABLE_NODE, &vtysh_show_alias_cli_cmd);
-
-   vtysh_alias_count = 0;
 }
 
 int is_valid_ip_address(const char *ip_value)
@@ -4421,6 +4539,8 @@ vtysh_init_vty (void)
 #ifdef ENABLE_OVSDB
   install_element (VIEW_NODE, &vtysh_show_context_client_list_cmd);
   install_element (ENABLE_NODE, &vtysh_show_context_client_list_cmd);
+  install_element (ENABLE_NODE, &vtysh_show_cli_statistics_cmd);
+  install_element (ENABLE_NODE, &vtysh_clear_cli_statistics_cmd);
   install_element(CONFIG_NODE, &vtysh_demo_mac_tok_cmd);
 
    install_element (CONFIG_NODE, &vtysh_dhcp_server_cmd);
@@ -4605,6 +4725,9 @@ vtysh_init_vty (void)
   install_element (ENABLE_NODE, &show_startup_config_cmd);
   install_element (ENABLE_NODE, &show_startup_config_json_cmd);
   install_element (ENABLE_NODE, &vtysh_show_session_timeout_cli_cmd);
+
+  /* Memory statistics of vtysh itself. */
+  memory_init_local ();
 #endif /* ENABLE_OVSDB */
 
 #ifndef ENABLE_OVSDB
@@ -48,12 +48,22 @@
 #define VTYSH_MAX_ALIAS_DEF_LEN_WITH_ARGS   40
 #define VTYSH_MAX_ALIAS_LIST_LEN 400
 
+/* One piece of a precompiled alias command: literal text, or with arg
+ * set, the alias argument $arg, whose "$arg" text is used when the alias
+ * is run with fewer arguments. */
+struct vtysh_alias_token {
+   int arg;
+   char *text;
+};
+
 struct vtysh_alias_data {
-   char alias_def_str[VTYSH_MAX_ALIAS_DEF_LEN];
+   char alias_def_str[VTYSH_MAX_ALIAS_DEF_LEN + 1];
    struct cmd_element alias_cmd_element;
    char alias_def_str_with_args[VTYSH_MAX_ALIAS_DEF_LEN_WITH_ARGS];
    struct cmd_element alias_cmd_element_with_args;
-   int  refresh_count;
+   unsigned int generation;      /* Last refresh that saw the alias. */
+   char *definition;             /* Definition the commands come from. */
+   vector commands;              /* Of vectors of struct vtysh_alias_token. */
 };
 
 #define VTYSH_ALIAS_CMD_HELPSTRING            "Execute \"show aliases\" to list the command list\nArguments to replace $1, $2 etc.\n"
@@ -119,6 +129,10 @@ extern int vtysh_show_startup;
 
 void vtysh_init_vty (void);
 void vtysh_init_cmd (void);
+
+/* Token trees of the vtysh commands, generated by cmdtree.pl. */
+extern const struct cmd_tree_entry vtysh_cmd_tree[];
+extern const unsigned int vtysh_cmd_tree_size;
 extern int vtysh_connect_all (const char *optional_daemon_name);
 void vtysh_readline_init (void);
 void vtysh_user_init (void);
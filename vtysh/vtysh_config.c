@@ -26,11 +26,15 @@ Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 #include "command.h"
 #include "linklist.h"
 #include "memory.h"
+#include "hash.h"
 
 #include "vtysh/vtysh.h"
 
 vector configvec;
 
+/* Name index of the sections in each configvec list, same slots. */
+static vector confighash;
+
 extern int vtysh_writeconfig_integrated;
 
 struct config
@@ -41,6 +45,10 @@ struct config
   /* Configuration string line. */
   struct list *line;
 
+  /* Lines added by config_add_line_uniq, NULL until the first one.
+     The strings are owned by line. */
+  struct hash *uniq;
+
   /* Configuration can be nest. */
   struct config *config;
 
@@ -50,6 +58,9 @@ struct config
 
 struct list *config_top;
 
+/* Unique lines of config_top. */
+static struct hash *config_top_uniq;
+
 int
 line_cmp (char *c1, char *c2)
 {
@@ -76,9 +87,38 @@ config_cmp (struct config *c1, struct config *c2)
   return strcmp (c1->name, c2->name);
 }
 
+static unsigned int
+config_hash_key (void *p)
+{
+  struct config *config = p;
+  return string_hash_make (config->name);
+}
+
+static int
+config_hash_cmp (const void *p1, const void *p2)
+{
+  const struct config *c1 = p1;
+  const struct config *c2 = p2;
+  return strcmp (c1->name, c2->name) == 0;
+}
+
+static unsigned int
+line_hash_key (void *p)
+{
+  return string_hash_make (p);
+}
+
+static int
+line_hash_cmp (const void *p1, const void *p2)
+{
+  return strcmp (p1, p2) == 0;
+}
+
 void
 config_del (struct config* config)
 {
+  if (config->uniq)
+    hash_free (config->uniq);
   list_delete (config->line);
   if (config->name)
     XFREE (MTYPE_VTYSH_CONFIG_LINE, config->name);
@@ -89,11 +129,9 @@ struct config *
 config_get (int index, const char *line)
 {
   struct config *config;
-  struct config *config_loop;
+  struct config key;
   struct list *master;
-  struct listnode *node, *nnode;
-
-  config = config_loop = NULL;
+  struct hash *names;
 
   master = vector_lookup_ensure (configvec, index);
 
@@ -104,13 +142,17 @@ config_get (int index, const char *line)
       master->cmp = (int (*)(void *, void *)) config_cmp;
       vector_set_index (configvec, index, master);
     }
-  
-  for (ALL_LIST_ELEMENTS (master, node, nnode, config_loop))
+
+  names = vector_lookup_ensure (confighash, index);
+  if (! names)
     {
-      if (strcmp (config_loop->name, line) == 0)
-	config = config_loop;
+      names = hash_create (config_hash_key, config_hash_cmp);
+      vector_set_index (confighash, index, names);
     }
 
+  key.name = (char *) line;
+  config = hash_lookup (names, &key);
+
   if (! config)
     {
       config = config_new ();
@@ -120,6 +162,7 @@ config_get (int index, const char *line)
       config->name = XSTRDUP (MTYPE_VTYSH_CONFIG_LINE, line);
       config->index = index;
       listnode_add (master, config);
+      hash_get (names, config, hash_alloc_intern);
     }
   return config;
 }
@@ -130,18 +173,71 @@ config_add_line (struct list *config, const char *line)
   listnode_add (config, XSTRDUP (MTYPE_VTYSH_CONFIG_LINE, line));
 }
 
+/* Add line to a section unless it is already there.  The lines are
+   appended here and sorted once by config_sort_lines at dump time. */
 void
-config_add_line_uniq (struct list *config, const char *line)
+config_add_line_uniq (struct config *config, const char *line)
 {
-  struct listnode *node, *nnode;
-  char *pnt;
+  char *copy;
 
-  for (ALL_LIST_ELEMENTS (config, node, nnode, pnt))
-    {
-      if (strcmp (pnt, line) == 0)
-	return;
-    }
-  listnode_add_sort (config, XSTRDUP (MTYPE_VTYSH_CONFIG_LINE, line));
+  if (! config->uniq)
+    config->uniq = hash_create (line_hash_key, line_hash_cmp);
+  else if (hash_lookup (config->uniq, (void *) line))
+    return;
+
+  copy = XSTRDUP (MTYPE_VTYSH_CONFIG_LINE, line);
+  listnode_add (config->line, copy);
+  hash_get (config->uniq, copy, hash_alloc_intern);
+}
+
+/* Same for config_top.  The few unique lines there are slotted in
+   among the plain ones, so keep inserting them in place. */
+static void
+config_add_top_uniq (const char *line)
+{
+  char *copy;
+
+  if (! config_top_uniq)
+    config_top_uniq = hash_create (line_hash_key, line_hash_cmp);
+  else if (hash_lookup (config_top_uniq, (void *) line))
+    return;
+
+  copy = XSTRDUP (MTYPE_VTYSH_CONFIG_LINE, line);
+  listnode_add_sort (config_top, copy);
+  hash_get (config_top_uniq, copy, hash_alloc_intern);
+}
+
+static int
+config_line_qsort_cmp (const void *p1, const void *p2)
+{
+  return strcmp (*(char * const *) p1, *(char * const *) p2);
+}
+
+/* Put the lines of a section holding only unique lines into the
+   order listnode_add_sort would have given them. */
+static void
+config_sort_lines (struct config *config)
+{
+  struct listnode *node;
+  char **lines;
+  unsigned int i;
+
+  if (! config->uniq || listcount (config->line) < 2)
+    return;
+
+  lines = XMALLOC (MTYPE_TMP, listcount (config->line) * sizeof (char *));
+
+  i = 0;
+  for (node = listhead (config->line); node; node = listnextnode (node))
+    lines[i++] = listgetdata (node);
+
+  qsort (lines, i, sizeof (char *), config_line_qsort_cmp);
+
+  i = 0;
+  for (node = listhead (config->line); node; node = listnextnode (node))
+    node->data = lines[i++];
+
+  XFREE (MTYPE_TMP, lines);
 }
 
 void
@@ -181,7 +277,7 @@ vtysh_config_parse_line (const char *line)
 	  else if (config->index == RMAP_NODE ||
 	           config->index == INTERFACE_NODE ||
 		   config->index == VTY_NODE)
-	    config_add_line_uniq (config->line, line);
+	    config_add_line_uniq (config, line);
 	  else
 	    config_add_line (config->line, line);
 	}
@@ -264,7 +360,7 @@ vtysh_config_parse_line (const char *line)
 	  if (strncmp (line, "log", strlen ("log")) == 0
 	      || strncmp (line, "hostname", strlen ("hostname")) == 0
 	     )
-	    config_add_line_uniq (config_top, line);
+	    config_add_top_uniq (line);
 	  else
 	    config_add_line (config_top, line);
 	  config = NULL;
@@ -329,6 +425,8 @@ vtysh_config_dump (FILE *fp)
       {
 	for (ALL_LIST_ELEMENTS (master, node, nnode, config))
 	  {
+	    config_sort_lines (config);
+
 	    fprintf (fp, "%s\n", config->name);
 	    fflush (fp);
 
@@ -356,7 +454,18 @@ vtysh_config_dump (FILE *fp)
 	list_delete (master);
 	vector_slot (configvec, i) = NULL;
       }
+  for (i = 0; i < vector_active (confighash); i++)
+    if (vector_slot (confighash, i) != NULL)
+      {
+	hash_free (vector_slot (confighash, i));
+	vector_slot (confighash, i) = NULL;
+      }
   list_delete_all_node (config_top);
+  if (config_top_uniq)
+    {
+      hash_free (config_top_uniq);
+      config_top_uniq = NULL;
+    }
 }
 
 /* Read up configuration file from file_name. */
@@ -441,4 +550,5 @@ vtysh_config_init ()
   config_top = list_new ();
   config_top->del = (void (*) (void *))line_del;
   configvec = vector_init (1);
+  confighash = vector_init (1);
 }
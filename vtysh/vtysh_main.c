@@ -362,6 +362,11 @@ main (int argc, char **argv, char **env)
   /* Signal and others. */
   vtysh_signal_init ();
 
+  /* Use the command trees parsed at build time, unless told to parse
+     the command strings as they are installed. */
+  if (getenv("VTYSH_PARSE_COMMANDS") == NULL)
+    cmd_tree_load (vtysh_cmd_tree, vtysh_cmd_tree_size);
+
   /* Make vty structure and register commands. */
   vtysh_init_vty ();
   vtysh_init_cmd ();
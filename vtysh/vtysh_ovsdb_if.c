@@ -31,6 +31,7 @@
 #include "vswitch-idl.h"
 #include "util.h"
 #include "unixctl.h"
+#include "dynamic-string.h"
 #include "config.h"
 #include "command-line.h"
 #include "daemon.h"
@@ -59,9 +60,19 @@
 #include "latch.h"
 #include "lib/vty_utils.h"
 #include "intf_vty.h"
+#include "lldp_vty.h"
+#include "lacp_vty.h"
+#include "bgp_vty.h"
 
 #define TMOUT_POLL_INTERVAL 20
 
+/* The IDLs generated with the FOR_EACH_TRACKED iterators keep a change
+ * seqno per table, so that a vtysh_idl_cache only goes stale when one of
+ * its own tables changes.  Older ones only have the seqno of the IDL. */
+#ifdef OVSREC_INTERFACE_FOR_EACH_TRACKED
+#define VTYSH_IDL_TABLE_SEQNOS 1
+#endif
+
 int64_t timeout_start;
 struct termios tp;
 
@@ -84,15 +95,30 @@ static void
 vtysh_run()
 {
     ovsdb_idl_run (idl);
+    unixctl_server_run(appctl);
 }
 
 static void
 vtysh_wait(void)
 {
     ovsdb_idl_wait (idl);
+    unixctl_server_wait(appctl);
     latch_wait (&ovsdb_latch);
 }
 
+/* Tracks the rows of the table of 'column', which must be monitored
+ * already, because the IDL only moves the seqno of a table on row
+ * deletions when the table is tracked.  Tracking a monitored column does
+ * not change what is fetched.  The IDL only allows it before the first
+ * ovsdb_idl_run(). */
+static void
+vtysh_idl_track(const struct ovsdb_idl_column *column)
+{
+#ifdef VTYSH_IDL_TABLE_SEQNOS
+    ovsdb_idl_track_add_column(idl, column);
+#endif
+}
+
 static void
 bgp_ovsdb_init()
 {
@@ -110,6 +136,7 @@ bgp_ovsdb_init()
     ovsdb_idl_add_column(idl, &ovsrec_bgp_router_col_other_config);
     ovsdb_idl_add_column(idl, &ovsrec_bgp_router_col_status);
     ovsdb_idl_add_column(idl, &ovsrec_bgp_router_col_external_ids);
+    vtysh_idl_track(&ovsrec_bgp_router_col_bgp_neighbors);
 
     /* BGP neighbor table. */
     ovsdb_idl_add_table(idl, &ovsrec_table_bgp_neighbor);
@@ -160,6 +187,12 @@ bgp_ovsdb_init()
     ovsdb_idl_add_column(idl, &ovsrec_bgp_route_col_vrf);
     ovsdb_idl_add_column(idl, &ovsrec_bgp_route_col_path_attributes);
     ovsdb_idl_add_column(idl, &ovsrec_bgp_route_col_peer);
+    /* The BGP RIB cache in bgp_vty.c decodes the changed rows. */
+    vtysh_idl_track(&ovsrec_bgp_route_col_prefix);
+    vtysh_idl_track(&ovsrec_bgp_route_col_bgp_nexthops);
+    vtysh_idl_track(&ovsrec_bgp_route_col_address_family);
+    vtysh_idl_track(&ovsrec_bgp_route_col_path_attributes);
+    vtysh_idl_track(&ovsrec_bgp_route_col_peer);
 
     /* BGP Nexthop table. */
     ovsdb_idl_add_table(idl, &ovsrec_table_bgp_nexthop);
@@ -173,6 +206,7 @@ l3routes_ovsdb_init()
 {
     ovsdb_idl_add_table(idl, &ovsrec_table_vrf);
     ovsdb_idl_add_column(idl, &ovsrec_vrf_col_name);
+    vtysh_idl_track(&ovsrec_vrf_col_name);
     ovsdb_idl_add_table(idl, &ovsrec_table_nexthop);
     ovsdb_idl_add_column(idl, &ovsrec_nexthop_col_ip_address);
     ovsdb_idl_add_column(idl, &ovsrec_nexthop_col_selected);
@@ -223,6 +257,7 @@ policy_ovsdb_init ()
     ovsdb_idl_add_column(idl, &ovsrec_prefix_list_col_name);
     ovsdb_idl_add_column(idl, &ovsrec_prefix_list_col_prefix_list_entries);
     ovsdb_idl_add_column(idl, &ovsrec_prefix_list_col_description);
+    vtysh_idl_track(&ovsrec_prefix_list_col_name);
     ovsdb_idl_add_table(idl, &ovsrec_table_prefix_list_entry);
     ovsdb_idl_add_column(idl, &ovsrec_prefix_list_entry_col_action);
     ovsdb_idl_add_column(idl, &ovsrec_prefix_list_entry_col_prefix);
@@ -231,6 +266,7 @@ policy_ovsdb_init ()
     ovsdb_idl_add_table(idl, &ovsrec_table_route_map);
     ovsdb_idl_add_column(idl, &ovsrec_route_map_col_name);
     ovsdb_idl_add_column(idl, &ovsrec_route_map_col_route_map_entries);
+    vtysh_idl_track(&ovsrec_route_map_col_name);
     ovsdb_idl_add_table(idl, &ovsrec_table_route_map_entry);
     ovsdb_idl_add_column(idl, &ovsrec_route_map_entry_col_description);
     ovsdb_idl_add_column(idl, &ovsrec_route_map_entry_col_action);
@@ -270,10 +306,12 @@ intf_ovsdb_init()
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_pm_info);
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_error);
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_lacp_status);
+    vtysh_idl_track(&ovsrec_interface_col_name);
     ovsdb_idl_add_table(idl, &ovsrec_table_vrf);
     ovsdb_idl_add_column(idl, &ovsrec_vrf_col_ports);
     ovsdb_idl_add_table(idl, &ovsrec_table_port);
     ovsdb_idl_add_column(idl, &ovsrec_port_col_name);
+    vtysh_idl_track(&ovsrec_port_col_name);
 }
 
 /***********************************************************
@@ -288,6 +326,7 @@ alias_ovsdb_init()
     ovsdb_idl_add_table(idl, &ovsrec_table_cli_alias);
     ovsdb_idl_add_column(idl, &ovsrec_cli_alias_col_alias_name);
     ovsdb_idl_add_column(idl, &ovsrec_cli_alias_col_alias_definition);
+    vtysh_idl_track(&ovsrec_cli_alias_col_alias_name);
 
     return;
 }
@@ -368,6 +407,15 @@ dhcp_tftp_ovsdb_init()
     ovsdb_idl_add_column(idl, &ovsrec_dhcpsrv_match_col_option_number);
     ovsdb_idl_add_column(idl, &ovsrec_dhcpsrv_match_col_option_value);
 
+    /* For the index of ranges and static hosts in dhcp_tftp_vty.c. */
+    vtysh_idl_track(&ovsrec_vrf_col_dhcp_server);
+    vtysh_idl_track(&ovsrec_dhcp_server_col_ranges);
+    vtysh_idl_track(&ovsrec_dhcpsrv_range_col_name);
+    vtysh_idl_track(&ovsrec_dhcpsrv_range_col_start_ip_address);
+    vtysh_idl_track(&ovsrec_dhcpsrv_range_col_end_ip_address);
+    vtysh_idl_track(&ovsrec_dhcpsrv_range_col_set_tag);
+    vtysh_idl_track(&ovsrec_dhcpsrv_range_col_match_tags);
+    vtysh_idl_track(&ovsrec_dhcpsrv_static_host_col_ip_address);
 }
 
 /***********************************************************
@@ -459,6 +507,7 @@ vlan_ovsdb_init()
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_internal_usage);
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_external_ids);
     ovsdb_idl_add_column(idl, &ovsrec_vlan_col_other_config);
+    vtysh_idl_track(&ovsrec_vlan_col_id);
 }
 
 static void
@@ -574,6 +623,98 @@ ops_vtysh_exit(struct unixctl_conn *conn, int argc OVS_UNUSED,
     unixctl_command_reply(conn, NULL);
 }
 
+static void
+cli_stats_put_histogram(struct ds *ds, const char *name,
+                        const struct usec_histogram *h)
+{
+    ds_put_format(ds, "  %-12s %10lu %10lu %10lu %10lu\n", name, h->count,
+                  usec_histogram_percentile(h, 50),
+                  usec_histogram_percentile(h, 99), h->max);
+}
+
+static int
+cli_stats_cmp(const void *a_, const void *b_)
+{
+    const struct cmd_stats *a = *(const struct cmd_stats **) a_;
+    const struct cmd_stats *b = *(const struct cmd_stats **) b_;
+
+    return a->calls < b->calls ? 1 : a->calls > b->calls ? -1 : 0;
+}
+
+/* Formats the statistics of the commands executed so far, most called
+ * first, and of the OVSDB lock into 'ds'.  Called with the OVSDB lock
+ * held, which cmd_stats_vec is only changed under.  The counters of
+ * commands that run without the lock are updated outside it, so they
+ * may be read mid-update. */
+void
+vtysh_cli_stats_format(struct ds *ds)
+{
+    static const char *thread_names[VTYSH_LOCK_N_THREADS] = {
+        [VTYSH_LOCK_CLI] = "cli",
+        [VTYSH_LOCK_OVSDB] = "ovsdb",
+    };
+    size_t n_cmds = cmd_stats_vec ? vector_active(cmd_stats_vec) : 0;
+    const struct cmd_stats **all = xmalloc((n_cmds + 1) * sizeof *all);
+    size_t i, n = 0;
+
+    for (i = 0; i < n_cmds; i++) {
+        const struct cmd_stats *stats = vector_slot(cmd_stats_vec, i);
+
+        if (stats && stats->calls) {
+            all[n++] = stats;
+        }
+    }
+    qsort(all, n, sizeof *all, cli_stats_cmp);
+
+    for (i = 0; i < n; i++) {
+        const struct cmd_stats *stats = all[i];
+
+        ds_put_format(ds, "Command: %s\n", stats->cmd->string);
+        ds_put_format(ds, "  Calls: %lu  Errors: %lu  Output bytes: %llu\n",
+                      stats->calls, stats->errors, stats->output_bytes);
+        ds_put_format(ds, "  %-12s %10s %10s %10s %10s\n", "usec",
+                      "Count", "p50", "p99", "Max");
+        cli_stats_put_histogram(ds, "parse", &stats->parse);
+        cli_stats_put_histogram(ds, "lock wait", &stats->lock_wait);
+        cli_stats_put_histogram(ds, "handler", &stats->handler);
+        cli_stats_put_histogram(ds, "commit", &stats->commit);
+        ds_put_char(ds, '\n');
+    }
+    free(all);
+
+    ds_put_format(ds, "OVSDB lock\n");
+    ds_put_format(ds, "  %-12s %10s %10s\n", "Thread", "Acquired",
+                  "Contended");
+    for (i = 0; i < VTYSH_LOCK_N_THREADS; i++) {
+        ds_put_format(ds, "  %-12s %10lu %10lu\n", thread_names[i],
+                      vtysh_ovsdb_lock_stats[i].acquired,
+                      vtysh_ovsdb_lock_stats[i].contended);
+    }
+    ds_put_format(ds, "  %-12s %10s %10s %10s %10s\n", "usec",
+                  "Count", "p50", "p99", "Max");
+    for (i = 0; i < VTYSH_LOCK_N_THREADS; i++) {
+        char name[32];
+
+        snprintf(name, sizeof name, "%s wait", thread_names[i]);
+        cli_stats_put_histogram(ds, name, &vtysh_ovsdb_lock_stats[i].wait);
+        snprintf(name, sizeof name, "%s hold", thread_names[i]);
+        cli_stats_put_histogram(ds, name, &vtysh_ovsdb_lock_stats[i].hold);
+    }
+}
+
+/* "ovs-appctl cli/show-statistics", run in vtysh_ovsdb_main_thread()
+ * with the OVSDB lock held. */
+static void
+ops_vtysh_show_cli_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                         const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    vtysh_cli_stats_format(&ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
 /* The init for the ovsdb integration called in vtysh main function. */
 void
 vtysh_ovsdb_init(int argc, char *argv[], char *db_name)
@@ -599,6 +740,8 @@ vtysh_ovsdb_init(int argc, char *argv[], char *db_name)
     }
 
     unixctl_command_register("exit", "", 0, 0, ops_vtysh_exit, &exiting);
+    unixctl_command_register("cli/show-statistics", "", 0, 0,
+                             ops_vtysh_show_cli_stats, NULL);
 
     ovsdb_init(ovsdb_sock);
     vtysh_ovsdb_lib_init();
@@ -834,8 +977,10 @@ ovsdb_idl_txn_status cli_do_config_finish(struct ovsdb_idl_txn* status_txn)
     }
 
     enum ovsdb_idl_txn_status status;
+    long long int start = time_usec();
 
     status = ovsdb_idl_txn_commit_block(status_txn);
+    cmd_stats_commit(time_usec() - start);
     ovsdb_idl_txn_destroy(status_txn);
     status_txn = NULL;
 
@@ -959,6 +1104,267 @@ vtysh_ovsdb_mac_match(const char *str)
     return 0;
 }
 
+/* Names of the objects offered when completing variable tokens, sorted
+ * with strcmp() so that the names starting with a prefix are found with
+ * a binary search.  Each index is rebuilt from the IDL the first time it
+ * is used after one of its tables changes. */
+enum completion_index {
+    COMPLETION_IFNAME,
+    COMPLETION_LAG,
+    COMPLETION_VLAN,
+    COMPLETION_VRF,
+    COMPLETION_BGP_NEIGHBOR,
+    COMPLETION_PREFIX_LIST,
+    COMPLETION_ROUTE_MAP,
+    COMPLETION_MAX
+};
+
+struct completion_names {
+    char **names;
+    size_t n;
+    size_t allocated;
+    struct vtysh_idl_cache cache;
+};
+
+/* The tables each index is built from. */
+static const struct ovsdb_idl_table_class *const completion_ifname_tables[] = {
+    &ovsrec_table_interface, &ovsrec_table_port,
+};
+static const struct ovsdb_idl_table_class *const completion_lag_tables[] = {
+    &ovsrec_table_port,
+};
+static const struct ovsdb_idl_table_class *const completion_vlan_tables[] = {
+    &ovsrec_table_vlan,
+};
+static const struct ovsdb_idl_table_class *const completion_vrf_tables[] = {
+    &ovsrec_table_vrf,
+};
+static const struct ovsdb_idl_table_class *const completion_bgp_tables[] = {
+    &ovsrec_table_bgp_router,
+};
+static const struct ovsdb_idl_table_class *const completion_plist_tables[] = {
+    &ovsrec_table_prefix_list,
+};
+static const struct ovsdb_idl_table_class *const completion_rmap_tables[] = {
+    &ovsrec_table_route_map,
+};
+
+static struct completion_names completion_names[COMPLETION_MAX] = {
+    [COMPLETION_IFNAME] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_ifname_tables) },
+    [COMPLETION_LAG] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_lag_tables) },
+    [COMPLETION_VLAN] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_vlan_tables) },
+    [COMPLETION_VRF] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_vrf_tables) },
+    [COMPLETION_BGP_NEIGHBOR] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_bgp_tables) },
+    [COMPLETION_PREFIX_LIST] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_plist_tables) },
+    [COMPLETION_ROUTE_MAP] = {
+        .cache = VTYSH_IDL_CACHE_INITIALIZER(completion_rmap_tables) },
+};
+
+/* Which index completes a variable token, by the token and the word
+ * before it.  A keyword matches when the word before is an abbreviation
+ * of it, and a NULL keyword matches any word. */
+static const struct completion_rule {
+    const char *keyword;
+    const char *varname;
+    enum completion_index index;
+} completion_rules[] = {
+    { NULL, "IFNAME", COMPLETION_IFNAME },
+    { "lag", "<1-2000>", COMPLETION_LAG },
+    { "vlan", "<1-4094>", COMPLETION_VLAN },
+    { "vlan", "VLANID", COMPLETION_VLAN },
+    { "access", "<1-4094>", COMPLETION_VLAN },
+    { "allowed", "<1-4094>", COMPLETION_VLAN },
+    { "native", "<1-4094>", COMPLETION_VLAN },
+    { "vrf", "VRF_NAME", COMPLETION_VRF },
+    { "attach", "VRF_NAME", COMPLETION_VRF },
+    { "neighbors", "A.B.C.D", COMPLETION_BGP_NEIGHBOR },
+    { "neighbors", "X:X::X:X", COMPLETION_BGP_NEIGHBOR },
+    { "neighbors", "WORD", COMPLETION_BGP_NEIGHBOR },
+    { "prefix-list", "WORD", COMPLETION_PREFIX_LIST },
+    { "route-map", "WORD", COMPLETION_ROUTE_MAP },
+};
+
+static void
+completion_names_add(struct completion_names *cn, const char *name)
+{
+    if (cn->n >= cn->allocated) {
+        cn->names = x2nrealloc(cn->names, &cn->allocated,
+                               sizeof *cn->names);
+    }
+    cn->names[cn->n++] = xstrdup(name);
+}
+
+static int
+completion_names_cmp(const void *a_, const void *b_)
+{
+    const char *const *a = a_;
+    const char *const *b = b_;
+
+    return strcmp(*a, *b);
+}
+
+/* Refills 'cn' with the names of the objects of kind 'index' in the IDL.
+ * The caller must hold the OVSDB lock. */
+static void
+completion_names_build(struct completion_names *cn,
+                       enum completion_index index)
+{
+    const struct ovsrec_interface *intf_row;
+    const struct ovsrec_port *port_row;
+    const struct ovsrec_vlan *vlan_row;
+    const struct ovsrec_vrf *vrf_row;
+    const struct ovsrec_bgp_router *bgp_row;
+    const struct ovsrec_prefix_list *plist_row;
+    const struct ovsrec_route_map *rmap_row;
+    char buf[32];
+    size_t i, n;
+
+    for (i = 0; i < cn->n; i++) {
+        free(cn->names[i]);
+    }
+    cn->n = 0;
+
+    switch (index) {
+    case COMPLETION_IFNAME:
+        /* The names vtysh_ovsdb_interface_match() accepts. */
+        OVSREC_INTERFACE_FOR_EACH (intf_row, idl) {
+            completion_names_add(cn, intf_row->name);
+        }
+        OVSREC_PORT_FOR_EACH (port_row, idl) {
+            completion_names_add(cn, port_row->name);
+        }
+        break;
+
+    case COMPLETION_LAG:
+        OVSREC_PORT_FOR_EACH (port_row, idl) {
+            if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX,
+                        LAG_PORT_NAME_PREFIX_LENGTH) == 0
+                && port_row->name[LAG_PORT_NAME_PREFIX_LENGTH] != '\0') {
+                completion_names_add(cn, &port_row->name
+                                     [LAG_PORT_NAME_PREFIX_LENGTH]);
+            }
+        }
+        break;
+
+    case COMPLETION_VLAN:
+        OVSREC_VLAN_FOR_EACH (vlan_row, idl) {
+            snprintf(buf, sizeof buf, "%"PRId64, vlan_row->id);
+            completion_names_add(cn, buf);
+        }
+        break;
+
+    case COMPLETION_VRF:
+        OVSREC_VRF_FOR_EACH (vrf_row, idl) {
+            completion_names_add(cn, vrf_row->name);
+        }
+        break;
+
+    case COMPLETION_BGP_NEIGHBOR:
+        OVSREC_BGP_ROUTER_FOR_EACH (bgp_row, idl) {
+            for (i = 0; i < bgp_row->n_bgp_neighbors; i++) {
+                completion_names_add(cn, bgp_row->key_bgp_neighbors[i]);
+            }
+        }
+        break;
+
+    case COMPLETION_PREFIX_LIST:
+        OVSREC_PREFIX_LIST_FOR_EACH (plist_row, idl) {
+            completion_names_add(cn, plist_row->name);
+        }
+        break;
+
+    case COMPLETION_ROUTE_MAP:
+        OVSREC_ROUTE_MAP_FOR_EACH (rmap_row, idl) {
+            completion_names_add(cn, rmap_row->name);
+        }
+        break;
+
+    case COMPLETION_MAX:
+    default:
+        break;
+    }
+
+    /* Sort, dropping the names that are both an interface and a port,
+     * or a neighbor of more than one router. */
+    qsort(cn->names, cn->n, sizeof *cn->names, completion_names_cmp);
+    for (i = n = 0; i < cn->n; i++) {
+        if (n > 0 && !strcmp(cn->names[n - 1], cn->names[i])) {
+            free(cn->names[i]);
+        } else {
+            cn->names[n++] = cn->names[i];
+        }
+    }
+    cn->n = n;
+}
+
+/* Points '*names' at the names in 'cn' starting with 'prefix' and returns
+ * how many there are, in O(log n) plus the number of names found. */
+static size_t
+completion_names_find(const struct completion_names *cn, const char *prefix,
+                      const char *const **names)
+{
+    size_t len = strlen(prefix);
+    size_t lo = 0, hi = cn->n;
+
+    /* The first name not less than 'prefix'. */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (strcmp(cn->names[mid], prefix) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (hi = lo; hi < cn->n && !strncmp(cn->names[hi], prefix, len); hi++) {
+        continue;
+    }
+
+    *names = (const char *const *) cn->names + lo;
+    return hi - lo;
+}
+
+/* Completes the variable token 'varname' after the word 'keyword' with
+ * the names of existing objects, see lib_vtysh_ovsdb_complete.  The names
+ * stay valid until the next call. */
+static unsigned int
+vtysh_ovsdb_complete(const char *keyword, const char *varname,
+                     const char *prefix, const char *const **names)
+{
+    const struct completion_rule *rule;
+    struct completion_names *cn;
+
+    for (rule = completion_rules;
+         rule < &completion_rules[ARRAY_SIZE(completion_rules)]; rule++) {
+        if (!strcmp(rule->varname, varname)
+            && (!rule->keyword
+                || (keyword && !strncmp(keyword, rule->keyword,
+                                        strlen(keyword))))) {
+            break;
+        }
+    }
+    if (rule == &completion_rules[ARRAY_SIZE(completion_rules)]) {
+        return 0;
+    }
+
+    /* Only this thread rebuilds the indexes, so 'cn' can be searched
+     * outside the lock. */
+    cn = &completion_names[rule->index];
+    VTYSH_OVSDB_LOCK;
+    if (!vtysh_idl_cache_check(&cn->cache)) {
+        completion_names_build(cn, rule->index);
+    }
+    VTYSH_OVSDB_UNLOCK;
+
+    return completion_names_find(cn, prefix, names);
+}
+
 /* Check if the input string matches the given regex. */
 int
 vtysh_regex_match(const char *regString, const char *inp)
@@ -1000,6 +1406,7 @@ vtysh_ovsdb_main_thread(void *arg)
 
     /* Detach thread to avoid memory leak upon exit. */
     pthread_detach(pthread_self());
+    vtysh_ovsdb_lock_set_thread();
 
     vtysh_exit = false;
     next_poll_msec = time_msec() + (TMOUT_POLL_INTERVAL * 1000);
@@ -1013,6 +1420,21 @@ vtysh_ovsdb_main_thread(void *arg)
            ovsdb_idl_run. */
         vtysh_run();
 
+        /* Feed the interface rate sampler, the LLDP neighbor cache
+           and the BGP RIB cache on every IDL change. */
+        if (ovsdb_idl_get_seqno(idl) != idl_seqno) {
+            idl_seqno = ovsdb_idl_get_seqno(idl);
+            intf_rates_sample();
+            lldp_neighbors_sync();
+            bgp_rib_refresh();
+        }
+#ifdef VTYSH_IDL_TABLE_SEQNOS
+        /* The BGP RIB cache took the tracked rows it needs above.  The
+           other caches use the table seqnos, and the DHCP index the
+           tracked rows of the command holding the lock. */
+        ovsdb_idl_track_clear(idl);
+#endif
+
         /* This function adds the file descriptor for the
            DB to monitor using poll_fd_wait. */
         vtysh_wait();
@@ -1252,6 +1674,93 @@ check_if_internal_vlan(const struct ovsrec_vlan *vlan_row)
     return (l3port != NULL) ? true : false;
 }
 
+/* The seqno of the tables 'cache' is built from.  A change sets the seqno
+ * of its table above that of every table, so the largest one moves
+ * whenever one of the tables changes. */
+static unsigned int
+vtysh_idl_cache_seqno(const struct vtysh_idl_cache *cache)
+{
+#ifdef VTYSH_IDL_TABLE_SEQNOS
+    unsigned int seqno = 0;
+    size_t i;
+
+    for (i = 0; i < cache->n_tables; i++) {
+        seqno = MAX(seqno, ovsdb_idl_table_get_seqno(idl, cache->tables[i]));
+    }
+    return seqno;
+#else
+    return ovsdb_idl_get_seqno(idl);
+#endif
+}
+
+/* Returns true if none of the tables of 'cache' changed since it was last
+ * made current.  Otherwise makes it current and returns false, for the
+ * caller to rebuild it.  The caller must hold the OVSDB lock. */
+bool
+vtysh_idl_cache_check(struct vtysh_idl_cache *cache)
+{
+    unsigned int seqno = vtysh_idl_cache_seqno(cache);
+
+    if (cache->valid && cache->seqno == seqno) {
+        return true;
+    }
+    cache->valid = true;
+    cache->seqno = seqno;
+    return false;
+}
+
+/* Takes the changes made to the tables of 'cache' so far as already in
+ * it, for a caller that applied its own changes to the cache.  The caller
+ * must hold the OVSDB lock. */
+void
+vtysh_idl_cache_update(struct vtysh_idl_cache *cache)
+{
+    cache->seqno = vtysh_idl_cache_seqno(cache);
+}
+
+/* Returns the number of rows of 'table', one of the tables of 'cache',
+ * inserted, modified or deleted since 'cache' was last made current, or
+ * SIZE_MAX if the IDL does not keep track of its changed rows.  The caller
+ * must hold the OVSDB lock. */
+size_t
+vtysh_idl_cache_changed_rows(const struct vtysh_idl_cache *cache,
+                             const struct ovsdb_idl_table_class *table)
+{
+#ifdef VTYSH_IDL_TABLE_SEQNOS
+    const struct ovsdb_idl_row *row;
+    size_t n = 0;
+
+    for (row = ovsdb_idl_track_get_first(idl, table); row;
+         row = ovsdb_idl_track_get_next(row)) {
+        if (ovsdb_idl_row_get_seqno(row, OVSDB_IDL_CHANGE_INSERT)
+            > cache->seqno
+            || ovsdb_idl_row_get_seqno(row, OVSDB_IDL_CHANGE_MODIFY)
+            > cache->seqno
+            || ovsdb_idl_row_get_seqno(row, OVSDB_IDL_CHANGE_DELETE)
+            > cache->seqno) {
+            n++;
+        }
+    }
+    return n;
+#else
+    return SIZE_MAX;
+#endif
+}
+
+/* Makes the next vtysh_idl_cache_check() on 'cache' return false. */
+void
+vtysh_idl_cache_invalidate(struct vtysh_idl_cache *cache)
+{
+    cache->valid = false;
+}
+
+/* The IDL seqno, for the help strings memoized by the lib. */
+static unsigned int
+vtysh_ovsdb_seqno(void)
+{
+    return ovsdb_idl_get_seqno(idl);
+}
+
 /* Init the vtysh lib routines. */
 void
 vtysh_ovsdb_lib_init()
@@ -1260,6 +1769,8 @@ vtysh_ovsdb_lib_init()
     lib_vtysh_ovsdb_port_match = &vtysh_ovsdb_port_match;
     lib_vtysh_ovsdb_vlan_match = &vtysh_ovsdb_vlan_match;
     lib_vtysh_ovsdb_mac_match = &vtysh_ovsdb_mac_match;
+    lib_vtysh_ovsdb_seqno = &vtysh_ovsdb_seqno;
+    lib_vtysh_ovsdb_complete = &vtysh_ovsdb_complete;
 }
 
 /* Wrapper for changing the help text for commands. */
@@ -42,6 +42,9 @@ void vtysh_ovsdb_exit(void);
 
 void vtysh_ovsdb_lib_init(void);
 
+struct ds;
+void vtysh_cli_stats_format(struct ds *ds);
+
 int vtysh_ovsdb_interface_match(const char *str);
 
 int vtysh_ovsdb_port_match(const char *str);
@@ -62,5 +65,29 @@ bool check_port_in_vrf(const char *port_name);
 
 bool vtysh_ovsdb_is_loaded(void);
 
+struct ovsdb_idl_table_class;
+
+/* Data decoded from the IDL rows of some tables, valid until one of
+ * those tables changes.  vtysh_ovsdb_init() must track each of the
+ * tables, see vtysh_idl_track(). */
+struct vtysh_idl_cache {
+    const struct ovsdb_idl_table_class *const *tables;
+    size_t n_tables;
+    bool valid;
+    unsigned int seqno;         /* Tables' seqno when last made current. */
+};
+
+#define VTYSH_IDL_CACHE_INITIALIZER(TABLES) \
+    { TABLES, ARRAY_SIZE(TABLES), false, 0 }
+
+bool vtysh_idl_cache_check(struct vtysh_idl_cache *cache);
+
+void vtysh_idl_cache_update(struct vtysh_idl_cache *cache);
+
+size_t vtysh_idl_cache_changed_rows(const struct vtysh_idl_cache *cache,
+                                    const struct ovsdb_idl_table_class *table);
+
+void vtysh_idl_cache_invalidate(struct vtysh_idl_cache *cache);
+
 void utils_vtysh_rl_describe_output(struct vty* vty, vector describe, int width);
 #endif /* VTYSH_OVSDB_IF_H */
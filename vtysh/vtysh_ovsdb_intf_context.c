@@ -63,6 +63,7 @@ typedef struct vtysh_ovsdb_intf_cfg_struct
 char intfcontextclientname[] = "vtysh_intf_context_clientcallback";
 static vtysh_ret_val
 vtysh_ovsdb_intftable_parse_l3config(const char *if_name,
+                                     const struct intf_join *join,
                                      vtysh_ovsdb_cbmsg_ptr p_msg,
                                      bool interfaceNameWritten);
 
@@ -111,6 +112,138 @@ const struct ovsrec_port* port_lookup(const char *if_name,
     return NULL;
 }
 
+/*-----------------------------------------------------------------------------
+| Function : intf_join_get
+| Responsibility : Find or add the join entry of a name
+| Parameters :
+|   struct shash *join : join built by intf_join_build
+|   const char *name : interface or port name
+| Return : join entry
+-----------------------------------------------------------------------------*/
+static struct intf_join *
+intf_join_get(struct shash *join, const char *name)
+{
+  struct intf_join *entry;
+
+  entry = shash_find_data(join, name);
+  if (entry == NULL)
+  {
+    entry = xzalloc(sizeof *entry);
+    shash_add(join, name, entry);
+  }
+  return entry;
+}
+
+/*-----------------------------------------------------------------------------
+| Function : intf_join_build
+| Responsibility : Join the Port, VRF and Bridge rows to interface and port
+|                  names in one pass over each table, so renderers do not
+|                  rescan them for every interface
+| Parameters :
+|   struct shash *join : initialized shash to fill
+|   const struct ovsdb_idl *idl : IDL for vtysh
+| Return : void
+-----------------------------------------------------------------------------*/
+void
+intf_join_build(struct shash *join, const struct ovsdb_idl *idl)
+{
+  const struct ovsrec_system *ovs_row;
+  const struct ovsrec_port *port_row;
+  const struct ovsrec_vrf *vrf_row;
+  const struct ovsrec_bridge *br_row;
+  struct intf_join *entry;
+  size_t i, j, k;
+
+  OVSREC_PORT_FOR_EACH(port_row, idl)
+  {
+    intf_join_get(join, port_row->name)->port = port_row;
+
+    if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX,
+                LAG_PORT_NAME_PREFIX_LENGTH) == 0)
+    {
+      for (k = 0; k < port_row->n_interfaces; k++)
+      {
+        entry = intf_join_get(join, port_row->interfaces[k]->name);
+        if (entry->lag == NULL)
+        {
+          entry->lag = port_row;
+        }
+      }
+    }
+  }
+
+  ovs_row = ovsrec_system_first(idl);
+  if (ovs_row == NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < ovs_row->n_vrfs; i++)
+  {
+    vrf_row = ovs_row->vrfs[i];
+    for (j = 0; j < vrf_row->n_ports; j++)
+    {
+      port_row = vrf_row->ports[j];
+      entry = intf_join_get(join, port_row->name);
+      entry->port_in_vrf = entry->in_vrf = true;
+      if (entry->vrf == NULL)
+      {
+        entry->vrf = vrf_row;
+      }
+      for (k = 0; k < port_row->n_interfaces; k++)
+      {
+        intf_join_get(join, port_row->interfaces[k]->name)->in_vrf = true;
+      }
+    }
+  }
+
+  for (i = 0; i < ovs_row->n_bridges; i++)
+  {
+    br_row = ovs_row->bridges[i];
+    for (j = 0; j < br_row->n_ports; j++)
+    {
+      port_row = br_row->ports[j];
+      entry = intf_join_get(join, port_row->name);
+      entry->port_in_bridge = entry->in_bridge = true;
+      for (k = 0; k < port_row->n_interfaces; k++)
+      {
+        intf_join_get(join, port_row->interfaces[k]->name)->in_bridge = true;
+      }
+    }
+  }
+}
+
+/*-----------------------------------------------------------------------------
+| Function : intf_join_find
+| Responsibility : Lookup the join entry of a name
+| Parameters :
+|   const struct shash *join : join built by intf_join_build
+|   const char *name : interface or port name
+| Return : join entry, an empty one if nothing refers to name
+-----------------------------------------------------------------------------*/
+const struct intf_join *
+intf_join_find(const struct shash *join, const char *name)
+{
+  static const struct intf_join empty;
+  const struct intf_join *entry;
+
+  entry = shash_find_data(join, name);
+  return entry ? entry : &empty;
+}
+
+/*-----------------------------------------------------------------------------
+| Function : intf_join_destroy
+| Responsibility : Free a join built by intf_join_build
+| Parameters :
+|   struct shash *join : join to free
+| Return : void
+-----------------------------------------------------------------------------*/
+void
+intf_join_destroy(struct shash *join)
+{
+  shash_destroy_free_data(join);
+}
+
 /*-----------------------------------------------------------------------------
 | Function : vtysh_ovsdb_intftable_parse_lacp_othercfg
 | Responsibility : parse other_config in intf table to display lacp config
@@ -155,32 +288,20 @@ vtysh_ovsdb_intftable_parse_lacp_othercfg(const struct smap *ifrow_config,
 |                     p_msg : vtysh_ovsdb_cbmsg_ptr data
 |                  intf_cfg : pointer of type vtysh_ovsdb_intf_cfg
 |                   if_name : interface name
+|                      join : join entry of the interface
 | Return : void
 -----------------------------------------------------------------------------*/
 static vtysh_ret_val
 vtysh_ovsdb_intftable_print_lag(vtysh_ovsdb_cbmsg_ptr p_msg,
                                 vtysh_ovsdb_intf_cfg *intf_cfg,
-                                const char *if_name)
+                                const char *if_name,
+                                const struct intf_join *join)
 {
-  const struct ovsrec_port *port_row = NULL;
-  const struct ovsrec_interface *if_row = NULL;
-  int k=0;
-
-   OVSREC_PORT_FOR_EACH(port_row, p_msg->idl)
-   {
-     if (strncmp(port_row->name, LAG_PORT_NAME_PREFIX, LAG_PORT_NAME_PREFIX_LENGTH) == 0)
-     {
-        for (k = 0; k < port_row->n_interfaces; k++)
-        {
-           if_row = port_row->interfaces[k];
-           if(strcmp(if_name, if_row->name) == 0)
-           {
-             PRINT_INTERFACE_NAME(intf_cfg->disp_intf_cfg, p_msg, if_name)
-             vtysh_ovsdb_cli_print(p_msg, "%4s%s %d", " ", "lag", atoi(&port_row->name[LAG_PORT_NAME_PREFIX_LENGTH]));
-           }
-        }
-     }
-   }
+  if (join->lag)
+  {
+    PRINT_INTERFACE_NAME(intf_cfg->disp_intf_cfg, p_msg, if_name)
+    vtysh_ovsdb_cli_print(p_msg, "%4s%s %d", " ", "lag", atoi(&join->lag->name[LAG_PORT_NAME_PREFIX_LENGTH]));
+  }
 
   return e_vtysh_ok;
 }
@@ -314,7 +435,12 @@ vtysh_intf_context_clientcallback(void *p_private)
 {
    vtysh_ovsdb_cbmsg_ptr p_msg = (vtysh_ovsdb_cbmsg *)p_private;
    const struct ovsrec_interface *ifrow;
+   const struct intf_join *join;
    const char *cur_state =NULL;
+   struct shash intf_join;
+
+   shash_init(&intf_join);
+   intf_join_build(&intf_join, p_msg->idl);
 
    OVSREC_INTERFACE_FOR_EACH(ifrow, p_msg->idl)
    {
@@ -428,10 +554,13 @@ vtysh_intf_context_clientcallback(void *p_private)
      }
      vtysh_ovsdb_intftable_parse_lacp_othercfg(&ifrow->other_config, p_msg,
                                                &intfcfg, ifrow->name);
-     vtysh_ovsdb_intftable_print_lag(p_msg, &intfcfg, ifrow->name);
-     vtysh_ovsdb_intftable_parse_l3config(ifrow->name, p_msg, intfcfg.disp_intf_cfg);
+     join = intf_join_find(&intf_join, ifrow->name);
+     vtysh_ovsdb_intftable_print_lag(p_msg, &intfcfg, ifrow->name, join);
+     vtysh_ovsdb_intftable_parse_l3config(ifrow->name, join, p_msg,
+                                          intfcfg.disp_intf_cfg);
    }
 
+   intf_join_destroy(&intf_join);
    return e_vtysh_ok;
 }
 
@@ -439,18 +568,16 @@ vtysh_intf_context_clientcallback(void *p_private)
 | Function : vtysh_ovsdb_intftable_parse_vlan
 | Responsibility : Used for VLAN related config
 | Parameters :
-|     const char *if_name           : Name of interface
+|     const struct ovsrec_port *port_row : Port of the interface
 |     vtysh_ovsdb_cbmsg_ptr p_msg   : Used for idl operations
 | Return : vtysh_ret_val
 -----------------------------------------------------------------------------*/
 static vtysh_ret_val
-vtysh_ovsdb_intftable_parse_vlan(const char *if_name,
+vtysh_ovsdb_intftable_parse_vlan(const struct ovsrec_port *port_row,
                                  vtysh_ovsdb_cbmsg_ptr p_msg)
 {
-    const struct ovsrec_port *port_row;
     int i;
 
-    port_row = port_lookup(if_name, p_msg->idl);
     if (port_row == NULL)
     {
         return e_vtysh_ok;
@@ -512,6 +639,7 @@ vtysh_ovsdb_intftable_parse_vlan(const char *if_name,
 | Responsibility : Used for VRF related config
 | Parameters :
 |     const char *if_name           : Name of interface
+|     const struct intf_join *join  : Join entry of the interface
 |     vtysh_ovsdb_cbmsg_ptr p_msg   : Used for idl operations
 |     bool interfaceNameWritten     : Check if "interface x" has already been
 |                                     written
@@ -519,6 +647,7 @@ vtysh_ovsdb_intftable_parse_vlan(const char *if_name,
 -----------------------------------------------------------------------------*/
 static vtysh_ret_val
 vtysh_ovsdb_intftable_parse_l3config(const char *if_name,
+                                     const struct intf_join *join,
                                      vtysh_ovsdb_cbmsg_ptr p_msg,
                                      bool interfaceNameWritten)
 {
@@ -526,19 +655,19 @@ vtysh_ovsdb_intftable_parse_l3config(const char *if_name,
   const struct ovsrec_vrf *vrf_row;
   size_t i;
 
-  port_row = port_lookup(if_name, p_msg->idl);
+  port_row = join->port;
   if (!port_row) {
     return e_vtysh_ok;
   }
-  if (!check_iface_in_vrf(if_name)) {
+  if (!join->in_vrf) {
     if (!interfaceNameWritten) {
       vtysh_ovsdb_cli_print(p_msg, "interface %s", if_name);
     }
     vtysh_ovsdb_cli_print(p_msg, "%4s%s", "", "no routing");
-    vtysh_ovsdb_intftable_parse_vlan(if_name, p_msg);
+    vtysh_ovsdb_intftable_parse_vlan(port_row, p_msg);
   }
-  if (check_iface_in_vrf(if_name)) {
-    vrf_row = port_vrf_match(p_msg->idl, port_row);
+  if (join->in_vrf) {
+    vrf_row = join->vrf;
     if (NULL != vrf_row) {
       if (display_l3_info(port_row, vrf_row)) {
         if (!interfaceNameWritten) {
@@ -33,4 +33,22 @@ const struct ovsrec_port* port_lookup(const char *if_name, const struct ovsdb_id
 
 bool display_l3_info(const struct ovsrec_port *port_row,const struct ovsrec_vrf *vrf_row);
 
+/* Port, VRF, LAG and bridge rows that refer to one interface or port
+ * name, joined once per command by intf_join_build(). */
+struct intf_join
+{
+  const struct ovsrec_port *port;   /* Port of this name. */
+  const struct ovsrec_vrf *vrf;     /* VRF holding port. */
+  const struct ovsrec_port *lag;    /* LAG port holding the interface. */
+  bool port_in_vrf;                 /* Same as check_port_in_vrf(). */
+  bool in_vrf;                      /* Same as check_iface_in_vrf(). */
+  bool port_in_bridge;              /* Same as check_port_in_bridge(). */
+  bool in_bridge;                   /* Same as check_iface_in_bridge(). */
+};
+
+void intf_join_build(struct shash *join, const struct ovsdb_idl *idl);
+const struct intf_join *intf_join_find(const struct shash *join,
+                                       const char *name);
+void intf_join_destroy(struct shash *join);
+
 #endif /* VTYSH_OVSDB_INTF_CONTEXT_H */
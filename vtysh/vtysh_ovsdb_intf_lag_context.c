@@ -40,20 +40,16 @@ char intflagcontextclientname[] = "vtysh_intf_lag_context_clientcallback";
 | Function : vtysh_ovsdb_intftable_parse_vlan
 | Responsibility : Used for VLAN related config
 | Parameters :
-|     const char *if_name           : Name of interface
+|     const struct ovsrec_port *port_row : LAG port
 |     vtysh_ovsdb_cbmsg_ptr p_msg   : Used for idl operations
-|     bool interfaceNameWritten     : Check if "interface x" has already been
-|                                     written
 | Return : vtysh_ret_val
 -----------------------------------------------------------------------------*/
 static vtysh_ret_val
-vtysh_ovsdb_porttable_parse_vlan(const char *if_name,
+vtysh_ovsdb_porttable_parse_vlan(const struct ovsrec_port *port_row,
                                  vtysh_ovsdb_cbmsg_ptr p_msg)
 {
-    const struct ovsrec_port *port_row;
     int i;
 
-    port_row = port_lookup(if_name, p_msg->idl);
     if (port_row == NULL)
     {
         return e_vtysh_ok;
@@ -133,7 +129,7 @@ vtysh_intf_lag_context_clientcallback(void *p_private)
       if (check_port_in_bridge(port_row->name))
       {
           vtysh_ovsdb_cli_print(p_msg, "%4s%s", "", "no routing");
-          vtysh_ovsdb_porttable_parse_vlan(port_row->name, p_msg);
+          vtysh_ovsdb_porttable_parse_vlan(port_row, p_msg);
       }
       data = port_row->lacp;
       if(data && strcmp(data, OVSREC_PORT_LACP_OFF) != 0)